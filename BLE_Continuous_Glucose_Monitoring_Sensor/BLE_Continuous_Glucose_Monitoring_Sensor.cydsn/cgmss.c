@@ -175,28 +175,7 @@ Return:
 ******************************************************************************/
 uint16 CgmsCrc(uint8 length, uint8 *dataPtr)
 {
-    uint8  bit, byte;
-    uint16 data, crc = CYBLE_CGMS_CRC_SEED;
-    
-    for(byte = 0; byte < length; byte++)
-    {
-        data = (uint16) dataPtr[byte];
-        for(bit = 0u; bit < 8u; bit++)
-        {
-            if(0u != ((crc ^ data) & 0x0001u))
-            {
-                crc = (crc >> 1u) ^ CYBLE_CGMS_CRC_POLY;
-            }
-            else
-            {
-                crc >>= 1u;
-            }
-            
-            data >>= 1u;
-        }
-    }
-
-    return(crc);
+    return(CRC_CcittUpdate(CYBLE_CGMS_CRC_SEED, dataPtr, length));
 }
 
 
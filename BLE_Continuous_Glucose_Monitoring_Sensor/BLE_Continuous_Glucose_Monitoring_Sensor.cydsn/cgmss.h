@@ -34,7 +34,6 @@ typedef uint16 sfloat;
 #define CGMS_FLAG_RACP (0x02u)
 
 #define CYBLE_CGMS_CRC_SEED (0xFFFFu) /* CRC-CCITT initial seed value */
-#define CYBLE_CGMS_CRC_POLY (0x8408u) /* CRC-CCITT polynomial is D16+D12+D5+1 in reverse order */
 
 #define CYBLE_CGMS_SSTM_SIZE    (9u)
 #define CYBLE_CGMS_CRC_SIZE     (2u)
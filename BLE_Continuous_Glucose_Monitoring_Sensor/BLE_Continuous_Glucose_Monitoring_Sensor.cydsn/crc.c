@@ -0,0 +1,135 @@
+/*******************************************************************************
+* File Name: crc.c
+*
+* Version 1.0
+*
+* Description:
+*  Provides the table-driven CRC-CCITT (polynomial x^16 + x^12 + x^5 + 1,
+*  reflected) calculation.
+*
+********************************************************************************
+* Copyright 2016, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include "crc.h"
+
+
+#if (0u != CRC_CCITT_NIBBLE_TABLE)
+
+/* CRC of the every 4-bit value */
+static const uint16 CYCODE crcCcittTable[16u] =
+{
+    0x0000u, 0x1081u, 0x2102u, 0x3183u, 0x4204u, 0x5285u, 0x6306u, 0x7387u,
+    0x8408u, 0x9489u, 0xA50Au, 0xB58Bu, 0xC60Cu, 0xD68Du, 0xE70Eu, 0xF78Fu
+};
+
+#else
+
+/* CRC of the every 8-bit value */
+static const uint16 CYCODE crcCcittTable[256u] =
+{
+    0x0000u, 0x1189u, 0x2312u, 0x329Bu, 0x4624u, 0x57ADu, 0x6536u, 0x74BFu,
+    0x8C48u, 0x9DC1u, 0xAF5Au, 0xBED3u, 0xCA6Cu, 0xDBE5u, 0xE97Eu, 0xF8F7u,
+    0x1081u, 0x0108u, 0x3393u, 0x221Au, 0x56A5u, 0x472Cu, 0x75B7u, 0x643Eu,
+    0x9CC9u, 0x8D40u, 0xBFDBu, 0xAE52u, 0xDAEDu, 0xCB64u, 0xF9FFu, 0xE876u,
+    0x2102u, 0x308Bu, 0x0210u, 0x1399u, 0x6726u, 0x76AFu, 0x4434u, 0x55BDu,
+    0xAD4Au, 0xBCC3u, 0x8E58u, 0x9FD1u, 0xEB6Eu, 0xFAE7u, 0xC87Cu, 0xD9F5u,
+    0x3183u, 0x200Au, 0x1291u, 0x0318u, 0x77A7u, 0x662Eu, 0x54B5u, 0x453Cu,
+    0xBDCBu, 0xAC42u, 0x9ED9u, 0x8F50u, 0xFBEFu, 0xEA66u, 0xD8FDu, 0xC974u,
+    0x4204u, 0x538Du, 0x6116u, 0x709Fu, 0x0420u, 0x15A9u, 0x2732u, 0x36BBu,
+    0xCE4Cu, 0xDFC5u, 0xED5Eu, 0xFCD7u, 0x8868u, 0x99E1u, 0xAB7Au, 0xBAF3u,
+    0x5285u, 0x430Cu, 0x7197u, 0x601Eu, 0x14A1u, 0x0528u, 0x37B3u, 0x263Au,
+    0xDECDu, 0xCF44u, 0xFDDFu, 0xEC56u, 0x98E9u, 0x8960u, 0xBBFBu, 0xAA72u,
+    0x6306u, 0x728Fu, 0x4014u, 0x519Du, 0x2522u, 0x34ABu, 0x0630u, 0x17B9u,
+    0xEF4Eu, 0xFEC7u, 0xCC5Cu, 0xDDD5u, 0xA96Au, 0xB8E3u, 0x8A78u, 0x9BF1u,
+    0x7387u, 0x620Eu, 0x5095u, 0x411Cu, 0x35A3u, 0x242Au, 0x16B1u, 0x0738u,
+    0xFFCFu, 0xEE46u, 0xDCDDu, 0xCD54u, 0xB9EBu, 0xA862u, 0x9AF9u, 0x8B70u,
+    0x8408u, 0x9581u, 0xA71Au, 0xB693u, 0xC22Cu, 0xD3A5u, 0xE13Eu, 0xF0B7u,
+    0x0840u, 0x19C9u, 0x2B52u, 0x3ADBu, 0x4E64u, 0x5FEDu, 0x6D76u, 0x7CFFu,
+    0x9489u, 0x8500u, 0xB79Bu, 0xA612u, 0xD2ADu, 0xC324u, 0xF1BFu, 0xE036u,
+    0x18C1u, 0x0948u, 0x3BD3u, 0x2A5Au, 0x5EE5u, 0x4F6Cu, 0x7DF7u, 0x6C7Eu,
+    0xA50Au, 0xB483u, 0x8618u, 0x9791u, 0xE32Eu, 0xF2A7u, 0xC03Cu, 0xD1B5u,
+    0x2942u, 0x38CBu, 0x0A50u, 0x1BD9u, 0x6F66u, 0x7EEFu, 0x4C74u, 0x5DFDu,
+    0xB58Bu, 0xA402u, 0x9699u, 0x8710u, 0xF3AFu, 0xE226u, 0xD0BDu, 0xC134u,
+    0x39C3u, 0x284Au, 0x1AD1u, 0x0B58u, 0x7FE7u, 0x6E6Eu, 0x5CF5u, 0x4D7Cu,
+    0xC60Cu, 0xD785u, 0xE51Eu, 0xF497u, 0x8028u, 0x91A1u, 0xA33Au, 0xB2B3u,
+    0x4A44u, 0x5BCDu, 0x6956u, 0x78DFu, 0x0C60u, 0x1DE9u, 0x2F72u, 0x3EFBu,
+    0xD68Du, 0xC704u, 0xF59Fu, 0xE416u, 0x90A9u, 0x8120u, 0xB3BBu, 0xA232u,
+    0x5AC5u, 0x4B4Cu, 0x79D7u, 0x685Eu, 0x1CE1u, 0x0D68u, 0x3FF3u, 0x2E7Au,
+    0xE70Eu, 0xF687u, 0xC41Cu, 0xD595u, 0xA12Au, 0xB0A3u, 0x8238u, 0x93B1u,
+    0x6B46u, 0x7ACFu, 0x4854u, 0x59DDu, 0x2D62u, 0x3CEBu, 0x0E70u, 0x1FF9u,
+    0xF78Fu, 0xE606u, 0xD49Du, 0xC514u, 0xB1ABu, 0xA022u, 0x92B9u, 0x8330u,
+    0x7BC7u, 0x6A4Eu, 0x58D5u, 0x495Cu, 0x3DE3u, 0x2C6Au, 0x1EF1u, 0x0F78u
+};
+
+#endif /* (0u != CRC_CCITT_NIBBLE_TABLE) */
+
+
+/*******************************************************************************
+* Function Name: CRC_CcittUpdate
+********************************************************************************
+*
+* Summary:
+*  Continues the CRC-CCITT calculation over the next part of the data. The
+*  result is not inverted, so it can be passed to the next call.
+*
+* Parameters:
+*  crc:
+*     The CRC of the previous data or CRC_CCITT_INITIAL_VALUE
+*  buffer:
+*     The buffer containing the data to compute the CRC for
+*  size:
+*     The number of bytes in the buffer
+*
+* Returns:
+*  Updated 16 bit CRC
+*
+*******************************************************************************/
+uint16 CRC_CcittUpdate(uint16 crc, const uint8 buffer[], uint32 size)
+{
+    const uint8 *dataPtr = buffer;
+
+    while (0u != size)
+    {
+    #if (0u != CRC_CCITT_NIBBLE_TABLE)
+        crc = (crc >> 4u) ^ crcCcittTable[(crc ^ *dataPtr) & 0x0Fu];
+        crc = (crc >> 4u) ^ crcCcittTable[(crc ^ ((uint32) *dataPtr >> 4u)) & 0x0Fu];
+    #else
+        crc = (crc >> 8u) ^ crcCcittTable[(crc ^ *dataPtr) & 0xFFu];
+    #endif /* (0u != CRC_CCITT_NIBBLE_TABLE) */
+
+        dataPtr++;
+        size--;
+    }
+
+    return (crc);
+}
+
+
+/*******************************************************************************
+* Function Name: CRC_CcittCalc
+********************************************************************************
+*
+* Summary:
+*  Computes the CRC-CCITT of the buffer with the initial value 0xFFFF.
+*
+* Parameters:
+*  buffer:
+*     The buffer containing the data to compute the CRC for
+*  size:
+*     The number of bytes in the buffer
+*
+* Returns:
+*  16 bit CRC
+*
+*******************************************************************************/
+uint16 CRC_CcittCalc(const uint8 buffer[], uint32 size)
+{
+    return (CRC_CcittUpdate(CRC_CCITT_INITIAL_VALUE, buffer, size));
+}
+
+
+/* [] END OF FILE */
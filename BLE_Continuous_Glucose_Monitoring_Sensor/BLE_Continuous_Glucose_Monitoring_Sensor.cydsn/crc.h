@@ -0,0 +1,47 @@
+/*******************************************************************************
+* File Name: crc.h
+*
+* Version 1.0
+*
+* Description:
+*  Contains the function prototypes and constants of the table-driven
+*  CRC-CCITT calculation.
+*
+********************************************************************************
+* Copyright 2016, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(CRC_H)
+#define CRC_H
+
+#include "cytypes.h"
+
+
+/***************************************
+*        Constants
+***************************************/
+#define CRC_CCITT_POLYNOMIAL        (0x8408u)       /* x^16 + x^12 + x^5 + 1 in reverse order */
+#define CRC_CCITT_INITIAL_VALUE     (0xFFFFu)
+
+/* Set to 1u, here or on the compiler command line, to use the 16-entry
+* (32 bytes) nibble table instead of the 256-entry (512 bytes) byte table.
+* Saves flash at cost of the speed.
+*/
+#if !defined(CRC_CCITT_NIBBLE_TABLE)
+    #define CRC_CCITT_NIBBLE_TABLE  (0u)
+#endif /* !defined(CRC_CCITT_NIBBLE_TABLE) */
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+uint16 CRC_CcittUpdate(uint16 crc, const uint8 buffer[], uint32 size);
+uint16 CRC_CcittCalc(const uint8 buffer[], uint32 size);
+
+#endif /* !defined(CRC_H) */
+
+
+/* [] END OF FILE */
@@ -21,6 +21,7 @@
 #include <stdio.h>
 
 #include "debug.h"
+#include "crc.h"
 
 /* Profile specific includes */
 #include "cgmss.h"
@@ -0,0 +1,2132 @@
+/*******************************************************************************
+* File Name: lowpan.c
+*
+* Version: 1.0
+*
+* Description:
+*  This file contains the IPv6 over BLE (RFC 7668) adaptation layer. IPv6
+*  headers are compressed with the stateless 6LoWPAN IPHC (RFC 6282): the
+*  link-local addresses derived from the BLE device addresses and the UDP
+*  ports 0xF0B0 - 0xF0BF are elided, so the 48 byte IPv6 and UDP headers
+*  shrink to 6 bytes. Every IPv6 packet is sent as one SDU of the IPSP L2CAP
+*  channel, the channel segments it, so there is no 6LoWPAN fragmentation.
+*
+*  UDP datagrams are delivered to the callbacks bound to the ports, ICMPv6
+*  echo requests are answered. Packets for other destinations are dropped:
+*  the nodes have the link-local addresses only, which are not forwarded, and
+*  the PSoC 4 BLE stack keeps a single connection, so there is no other link
+*  to forward to.
+*
+*  The receive credits of the channels follow the free pool packets: the
+*  peers together hold no more credits than the free packets can take, and
+*  the credits are returned as the upper layers free the packets.
+*
+*  The SDUs are sent through the queue of the link: they wait there while the
+*  peer has too few credits or the stack has no free buffers, and are written
+*  back to back as soon as the stack completes a write, so the short packets
+*  go out together in one connection event.
+*
+* Hardware Dependency:
+*  CY8CKIT-042 BLE
+*
+********************************************************************************
+* Copyright 2016, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#include "main.h"
+#include "lowpan.h"
+#include <string.h>
+
+
+/***************************************
+*        Internal Constants
+***************************************/
+#define LOWPAN_DISPATCH_IPV6        (0x41u)     /* Uncompressed IPv6 header follows */
+#define LOWPAN_DISPATCH_IPHC        (0x60u)
+#define LOWPAN_DISPATCH_IPHC_MASK   (0xE0u)
+
+/* First IPHC byte: 0 1 1 TF(2) NH HLIM(2) */
+#define LOWPAN_IPHC_TF_MASK         (0x18u)
+#define LOWPAN_IPHC_TF_INLINE       (0x00u)     /* ECN, DSCP and flow label, 4 bytes */
+#define LOWPAN_IPHC_TF_ECN_FL       (0x08u)     /* ECN and flow label, 3 bytes      */
+#define LOWPAN_IPHC_TF_ECN_DSCP     (0x10u)     /* ECN and DSCP, 1 byte             */
+#define LOWPAN_IPHC_TF_ELIDED       (0x18u)
+#define LOWPAN_IPHC_NH              (0x04u)     /* Next header is NHC encoded       */
+#define LOWPAN_IPHC_HLIM_MASK       (0x03u)
+#define LOWPAN_IPHC_HLIM_INLINE     (0x00u)
+#define LOWPAN_IPHC_HLIM_1          (0x01u)
+#define LOWPAN_IPHC_HLIM_64         (0x02u)
+#define LOWPAN_IPHC_HLIM_255        (0x03u)
+
+/* Second IPHC byte: CID SAC SAM(2) M DAC DAM(2) */
+#define LOWPAN_IPHC_CID             (0x80u)
+#define LOWPAN_IPHC_SAC             (0x40u)
+#define LOWPAN_IPHC_SAM_SHIFT       (4u)
+#define LOWPAN_IPHC_M               (0x08u)
+#define LOWPAN_IPHC_DAC             (0x04u)
+#define LOWPAN_IPHC_AM_MASK         (0x03u)
+#define LOWPAN_IPHC_AM_FULL         (0x00u)     /* 128 bits inline                          */
+#define LOWPAN_IPHC_AM_IID          (0x01u)     /* fe80::IID, 64 bits inline                 */
+#define LOWPAN_IPHC_AM_SHORT        (0x02u)     /* fe80::ff:fe00:XXXX, 16 bits inline        */
+#define LOWPAN_IPHC_AM_ELIDED       (0x03u)     /* fe80::IID of the link-layer address       */
+#define LOWPAN_IPHC_MCAST_48        (0x01u)     /* ffXX::00XX:XXXX:XXXX, 48 bits inline      */
+#define LOWPAN_IPHC_MCAST_32        (0x02u)     /* ffXX::00XX:XXXX, 32 bits inline           */
+#define LOWPAN_IPHC_MCAST_8         (0x03u)     /* ff02::00XX, 8 bits inline                 */
+
+/* UDP next header compression: 1 1 1 1 0 C P(2) */
+#define LOWPAN_NHC_UDP              (0xF0u)
+#define LOWPAN_NHC_UDP_MASK         (0xF8u)
+#define LOWPAN_NHC_UDP_C            (0x04u)     /* Checksum elided, not accepted            */
+#define LOWPAN_NHC_UDP_PORTS_MASK   (0x03u)
+#define LOWPAN_NHC_UDP_PORTS_FULL   (0x00u)
+#define LOWPAN_NHC_UDP_PORTS_DST8   (0x01u)     /* Destination 0xF0XX                       */
+#define LOWPAN_NHC_UDP_PORTS_SRC8   (0x02u)     /* Source 0xF0XX                            */
+#define LOWPAN_NHC_UDP_PORTS_4      (0x03u)     /* Both 0xF0BX                              */
+#define LOWPAN_UDP_PORT_8BIT_BASE   (0xF000u)
+
+#define LOWPAN_ICMPV6_ECHO_REQUEST  (128u)
+#define LOWPAN_ICMPV6_ECHO_REPLY    (129u)
+#define LOWPAN_ICMPV6_HEADER_SIZE   (4u)
+#define LOWPAN_ICMPV6_CHECKSUM_INDX (2u)
+#define LOWPAN_UDP_CHECKSUM_INDX    (6u)
+
+#define LOWPAN_CID_NONE             (0u)        /* L2CAP never allocates CID 0 */
+
+
+/***************************************
+*        Internal Data Types
+***************************************/
+typedef struct
+{
+    uint8  trafficClass;
+    uint32 flowLabel;
+    uint8  nextHeader;
+    uint8  hopLimit;
+    LOWPAN_IPV6_ADDR_T srcAddr;
+    LOWPAN_IPV6_ADDR_T dstAddr;
+} LOWPAN_IPV6_HDR_T;
+
+/* SDU waiting to be sent, it holds a packet reference */
+typedef struct
+{
+    LOWPAN_PKT_T *pkt;
+    uint16 offset;
+    uint16 length;
+} LOWPAN_TX_ENTRY_T;
+
+typedef struct
+{
+    uint8  bdHandle;
+    uint16 lCid;
+    uint8  peerIid[LOWPAN_IID_SIZE];   /* Interface ID of the peer device address */
+    uint16 peerMtu;
+    uint16 peerMps;
+    uint16 rxCredits;                   /* Credits the peer holds to send to this device */
+    uint16 txCredits;                   /* Credits this device holds to send to the peer */
+    uint8  txHead;
+    uint8  txCount;
+    LOWPAN_TX_ENTRY_T txQueue[LOWPAN_TX_QUEUE_SIZE];
+} LOWPAN_LINK_T;
+
+typedef struct
+{
+    uint16 port;
+    LOWPAN_UDP_CALLBACK_T callback;
+} LOWPAN_SOCKET_T;
+
+/* Bounds-checked walk through the received frame */
+typedef struct
+{
+    const uint8 *ptr;
+    uint16 remaining;
+    uint32 error;
+} LOWPAN_READER_T;
+
+
+/***************************************
+*        Internal Variables
+***************************************/
+static LOWPAN_LINK_T lowpanLink[LOWPAN_MAX_LINKS];
+static LOWPAN_SOCKET_T lowpanSocket[LOWPAN_MAX_SOCKETS];
+static uint8 lowpanLocalIid[LOWPAN_IID_SIZE];
+
+/* Packet buffers, shared by reference between the receive and the send paths */
+static LOWPAN_PKT_T lowpanPkt[LOWPAN_PKT_COUNT];
+
+
+/***************************************
+*        Internal Function Prototypes
+***************************************/
+static void Lowpan_MakeIid(const CYBLE_GAP_BD_ADDR_T *bdAddr, uint8 iid[]);
+static uint8 Lowpan_FindLink(uint16 lCid);
+#if (LOWPAN_MAX_LINKS > 1u)
+static uint8 Lowpan_FindPeer(const uint8 iid[]);
+#endif /* (LOWPAN_MAX_LINKS > 1u) */
+static uint8 Lowpan_Route(const LOWPAN_IPV6_ADDR_T *dstAddr);
+static void Lowpan_ClearLink(uint8 link);
+static uint16 Lowpan_RxCreditShare(uint8 linkCount);
+static uint16 Lowpan_RxCreditsFree(void);
+static void Lowpan_ReturnRxCredits(void);
+static CYBLE_API_RESULT_T Lowpan_Transmit(uint8 link, LOWPAN_PKT_T *pkt);
+static uint32 Lowpan_TxNext(uint8 link);
+static uint32 Lowpan_IsLinkLocal(const LOWPAN_IPV6_ADDR_T *addr);
+static uint32 Lowpan_IsLocalAddr(const LOWPAN_IPV6_ADDR_T *addr);
+static void Lowpan_Read(LOWPAN_READER_T *reader, uint8 data[], uint16 size);
+static uint8 Lowpan_ReadByte(LOWPAN_READER_T *reader);
+static void Lowpan_ReadAddr(LOWPAN_READER_T *reader, uint8 mode, const uint8 linkIid[], LOWPAN_IPV6_ADDR_T *addr);
+static void Lowpan_ReadMcastAddr(LOWPAN_READER_T *reader, uint8 mode, LOWPAN_IPV6_ADDR_T *addr);
+static uint32 Lowpan_Decompress(LOWPAN_READER_T *reader, uint8 link, LOWPAN_IPV6_HDR_T *hdr, uint8 udpHeader[]);
+static uint8 Lowpan_CompressAddr(const LOWPAN_IPV6_ADDR_T *addr, const uint8 linkIid[], uint8 **ptr);
+static uint8 Lowpan_CompressMcastAddr(const LOWPAN_IPV6_ADDR_T *addr, uint8 **ptr);
+static uint16 Lowpan_Checksum(const LOWPAN_IPV6_HDR_T *hdr, const uint8 head[], uint16 headLength,
+                              const uint8 data[], uint16 dataLength);
+static void Lowpan_SetChecksum(const LOWPAN_IPV6_HDR_T *hdr, uint8 head[], uint16 headLength,
+                               const uint8 data[], uint16 dataLength);
+static void Lowpan_Input(uint8 link, const LOWPAN_IPV6_HDR_T *hdr, const uint8 udpHeader[], LOWPAN_PKT_T *pkt);
+static CYBLE_API_RESULT_T Lowpan_Output(uint8 link, const LOWPAN_IPV6_HDR_T *hdr, const uint8 head[],
+                                        uint16 headLength, LOWPAN_PKT_T *pkt);
+
+
+/*******************************************************************************
+* Function Name: Lowpan_Start()
+********************************************************************************
+*
+* Summary:
+*  Initializes the adaptation layer. Call after CYBLE_EVT_STACK_ON, the
+*  interface ID of the local link-local address is made from the device address.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Lowpan_Start(void)
+{
+    CYBLE_GAP_BD_ADDR_T localAddr;
+    uint32 i;
+
+    localAddr.type = 0u;
+    CyBle_GetDeviceAddress(&localAddr);
+    Lowpan_MakeIid(&localAddr, lowpanLocalIid);
+
+    for(i = 0u; i < LOWPAN_MAX_LINKS; i++)
+    {
+        lowpanLink[i].lCid = LOWPAN_CID_NONE;
+        lowpanLink[i].txCount = 0u;
+    }
+    for(i = 0u; i < LOWPAN_MAX_SOCKETS; i++)
+    {
+        lowpanSocket[i].callback = NULL;
+    }
+    for(i = 0u; i < LOWPAN_PKT_COUNT; i++)
+    {
+        lowpanPkt[i].refCount = 0u;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_LinkOpen()
+********************************************************************************
+*
+* Summary:
+*  Attaches the connected IPSP L2CAP channel to the IPv6 interface.
+*
+* Parameters:
+*  bdHandle - the peer device handle
+*  lCid - the local CID of the channel
+*  rxCredits - the credits given to the peer in the connection request or
+*              response, see Lowpan_GetRxCredits()
+*  peerParam - the MTU, MPS and credits of the peer
+*
+* Return:
+*  The link number or LOWPAN_LINK_NONE if all links are in use.
+*
+*******************************************************************************/
+uint8 Lowpan_LinkOpen(uint8 bdHandle, uint16 lCid, uint16 rxCredits,
+                      const CYBLE_L2CAP_CBFC_CONNECT_PARAM_T *peerParam)
+{
+    CYBLE_GAP_BD_ADDR_T peerAddr;
+    uint8 link = Lowpan_FindLink(LOWPAN_CID_NONE);
+
+    if(link != LOWPAN_LINK_NONE)
+    {
+        if(CyBle_GapGetPeerBdAddr(bdHandle, &peerAddr) != CYBLE_ERROR_OK)
+        {
+            link = LOWPAN_LINK_NONE;
+        }
+        else
+        {
+            lowpanLink[link].bdHandle = bdHandle;
+            lowpanLink[link].lCid = lCid;
+            Lowpan_MakeIid(&peerAddr, lowpanLink[link].peerIid);
+            lowpanLink[link].peerMtu = peerParam->mtu;
+            lowpanLink[link].peerMps = (peerParam->mps != 0u) ? peerParam->mps : CYBLE_L2CAP_MPS;
+            lowpanLink[link].rxCredits = rxCredits;
+            lowpanLink[link].txCredits = peerParam->credit;
+            lowpanLink[link].txCount = 0u;
+        }
+    }
+
+    return(link);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_LinkClose()
+********************************************************************************
+*
+* Summary:
+*  Detaches the disconnected IPSP L2CAP channel.
+*
+* Parameters:
+*  lCid - the local CID of the channel
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Lowpan_LinkClose(uint16 lCid)
+{
+    uint8 link = Lowpan_FindLink(lCid);
+
+    if((lCid != LOWPAN_CID_NONE) && (link != LOWPAN_LINK_NONE))
+    {
+        Lowpan_ClearLink(link);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_DeviceClose()
+********************************************************************************
+*
+* Summary:
+*  Detaches all channels of the disconnected peer device, the SDUs waiting for
+*  the credits are dropped.
+*
+* Parameters:
+*  bdHandle - the peer device handle
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Lowpan_DeviceClose(uint8 bdHandle)
+{
+    uint32 i;
+
+    for(i = 0u; i < LOWPAN_MAX_LINKS; i++)
+    {
+        if((lowpanLink[i].bdHandle == bdHandle) && (lowpanLink[i].lCid != LOWPAN_CID_NONE))
+        {
+            Lowpan_ClearLink((uint8)i);
+        }
+    }
+}
+
+
+#if (LOWPAN_MAX_LINKS > 1u)
+/*******************************************************************************
+* Function Name: Lowpan_FindDevice()
+********************************************************************************
+*
+* Summary:
+*  Finds the link to the device, the Router uses it to connect every node once.
+*
+* Parameters:
+*  bdAddr - the device address
+*
+* Return:
+*  The link number or LOWPAN_LINK_NONE if the device has no open link.
+*
+*******************************************************************************/
+uint8 Lowpan_FindDevice(const CYBLE_GAP_BD_ADDR_T *bdAddr)
+{
+    uint8 iid[LOWPAN_IID_SIZE];
+
+    Lowpan_MakeIid(bdAddr, iid);
+
+    return(Lowpan_FindPeer(iid));
+}
+#endif /* (LOWPAN_MAX_LINKS > 1u) */
+
+
+/*******************************************************************************
+* Function Name: Lowpan_GetLinkCount()
+********************************************************************************
+*
+* Summary:
+*  Counts the open links.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The number of open links.
+*
+*******************************************************************************/
+uint8 Lowpan_GetLinkCount(void)
+{
+    uint8 count = 0u;
+    uint32 i;
+
+    for(i = 0u; i < LOWPAN_MAX_LINKS; i++)
+    {
+        if(lowpanLink[i].lCid != LOWPAN_CID_NONE)
+        {
+            count++;
+        }
+    }
+
+    return(count);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_GetPeerAddr()
+********************************************************************************
+*
+* Summary:
+*  Gets the link-local address of the peer device of the link.
+*
+* Parameters:
+*  link - the link number
+*  addr - the address output
+*
+* Return:
+*  Not zero value when the link is open.
+*
+*******************************************************************************/
+uint32 Lowpan_GetPeerAddr(uint8 link, LOWPAN_IPV6_ADDR_T *addr)
+{
+    uint32 linkOpen = 0u;
+
+    if((link < LOWPAN_MAX_LINKS) && (lowpanLink[link].lCid != LOWPAN_CID_NONE))
+    {
+        (void)memset(addr->addr, 0, LOWPAN_IPV6_ADDR_SIZE);
+        addr->addr[0u] = 0xFEu;
+        addr->addr[1u] = 0x80u;
+        (void)memcpy(&addr->addr[LOWPAN_IPV6_ADDR_SIZE - LOWPAN_IID_SIZE], lowpanLink[link].peerIid, LOWPAN_IID_SIZE);
+        linkOpen = 1u;
+    }
+
+    return(linkOpen);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_GetLocalAddr()
+********************************************************************************
+*
+* Summary:
+*  Gets the link-local address of the device.
+*
+* Parameters:
+*  addr - the address output
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Lowpan_GetLocalAddr(LOWPAN_IPV6_ADDR_T *addr)
+{
+    (void)memset(addr->addr, 0, LOWPAN_IPV6_ADDR_SIZE);
+    addr->addr[0u] = 0xFEu;
+    addr->addr[1u] = 0x80u;
+    (void)memcpy(&addr->addr[LOWPAN_IPV6_ADDR_SIZE - LOWPAN_IID_SIZE], lowpanLocalIid, LOWPAN_IID_SIZE);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_Receive()
+********************************************************************************
+*
+* Summary:
+*  Processes the SDU received on the IPSP channel, call on
+*  CYBLE_EVT_L2CAP_CBFC_DATA_READ. The stack reuses its buffer after the event,
+*  so the SDU is copied once into a pool packet, the upper layers get the
+*  packet by reference. The packet is decompressed and passed to the UDP port,
+*  to the ICMPv6 echo. The SDU is dropped when the pool is empty.
+*  The peer spent the credits of the SDU, they are returned when the packet
+*  is freed.
+*
+* Parameters:
+*  lCid - the local CID of the channel
+*  data - the received SDU
+*  length - the SDU length
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Lowpan_Receive(uint16 lCid, const uint8 data[], uint16 length)
+{
+    LOWPAN_IPV6_HDR_T hdr;
+    LOWPAN_READER_T reader;
+    LOWPAN_PKT_T *pkt = NULL;
+    uint8 udpHeader[LOWPAN_UDP_HEADER_SIZE];
+    uint8 ipv6Header[LOWPAN_IPV6_HEADER_SIZE];
+    uint8 link = Lowpan_FindLink(lCid);
+    uint16 credits;
+    uint32 udpPresent = 0u;
+
+    reader.error = 0u;
+    if((link == LOWPAN_LINK_NONE) || (lCid == LOWPAN_CID_NONE) || (length == 0u) || (length > CYBLE_L2CAP_MTU))
+    {
+        reader.error = 1u;
+    }
+    else
+    {
+        credits = LOWPAN_CREDITS(length, CYBLE_L2CAP_MPS);
+        lowpanLink[link].rxCredits = (lowpanLink[link].rxCredits > credits) ?
+                                     (lowpanLink[link].rxCredits - credits) : 0u;
+
+        pkt = Lowpan_PktAlloc();
+        if(pkt == NULL)
+        {
+            reader.error = 1u;
+        }
+        else
+        {
+            (void)memcpy(&pkt->buffer[LOWPAN_PKT_HEADROOM], data, length);
+            reader.ptr = &pkt->buffer[LOWPAN_PKT_HEADROOM];
+            reader.remaining = length;
+        }
+    }
+
+    if(reader.error != 0u)
+    {
+        /* Dropped */
+    }
+    else if(data[0u] == LOWPAN_DISPATCH_IPV6)
+    {
+        (void)Lowpan_ReadByte(&reader);
+        Lowpan_Read(&reader, ipv6Header, LOWPAN_IPV6_HEADER_SIZE);
+        hdr.trafficClass = (uint8)((uint8)(ipv6Header[0u] << 4u) | (ipv6Header[1u] >> 4u));
+        hdr.flowLabel = ((uint32)(ipv6Header[1u] & 0x0Fu) << 16u) | ((uint32)ipv6Header[2u] << 8u) | ipv6Header[3u];
+        hdr.nextHeader = ipv6Header[6u];
+        hdr.hopLimit = ipv6Header[7u];
+        (void)memcpy(hdr.srcAddr.addr, &ipv6Header[8u], LOWPAN_IPV6_ADDR_SIZE);
+        (void)memcpy(hdr.dstAddr.addr, &ipv6Header[8u + LOWPAN_IPV6_ADDR_SIZE], LOWPAN_IPV6_ADDR_SIZE);
+    }
+    else if((data[0u] & LOWPAN_DISPATCH_IPHC_MASK) == LOWPAN_DISPATCH_IPHC)
+    {
+        udpPresent = Lowpan_Decompress(&reader, link, &hdr, udpHeader);
+    }
+    else
+    {
+        reader.error = 1u;
+    }
+
+    if((reader.error == 0u) && (udpPresent == 0u) && (hdr.nextHeader == LOWPAN_NEXT_HEADER_UDP))
+    {
+        /* UDP header was sent inline, its length must match the packet */
+        Lowpan_Read(&reader, udpHeader, LOWPAN_UDP_HEADER_SIZE);
+        if((((uint16)((uint16)udpHeader[4u] << 8u)) | udpHeader[5u]) != (reader.remaining + LOWPAN_UDP_HEADER_SIZE))
+        {
+            reader.error = 1u;
+        }
+        udpPresent = 1u;
+    }
+
+    if(reader.error == 0u)
+    {
+        /* The decompressed headers stay in front of the data as the headroom */
+        pkt->offset = (uint16)(reader.ptr - pkt->buffer);
+        pkt->length = reader.remaining;
+        Lowpan_Input(link, &hdr, (udpPresent != 0u) ? udpHeader : NULL, pkt);
+    }
+    else
+    {
+        DBG_PRINTF("Lowpan: dropped SDU, lCid=%d, len=%d \r\n", lCid, length);
+    }
+
+    if(pkt != NULL)
+    {
+        Lowpan_PktFree(pkt);
+    }
+    else
+    {
+        /* Nothing was taken from the pool, the credits of the dropped SDU go back */
+        Lowpan_ReturnRxCredits();
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_GetRxCredits()
+********************************************************************************
+*
+* Summary:
+*  Gets the initial credits for the new IPSP channel: the share of the free
+*  pool packets of the links open now, no more than the credits the open links
+*  do not hold.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The credits for the L2CAP connection request or response.
+*
+*******************************************************************************/
+uint16 Lowpan_GetRxCredits(void)
+{
+    uint16 share = Lowpan_RxCreditShare(Lowpan_GetLinkCount());
+    uint16 available = Lowpan_RxCreditsFree();
+
+    return((share < available) ? share : available);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_RxCreditLow()
+********************************************************************************
+*
+* Summary:
+*  Handles the credits of the peer reaching the low watermark, call on
+*  CYBLE_EVT_L2CAP_CBFC_RX_CREDIT_IND. The credits counted by the stack
+*  replace the local count and the peer gets its share of the free packets.
+*
+* Parameters:
+*  lCid - the local CID of the channel
+*  credit - the credits the peer holds
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Lowpan_RxCreditLow(uint16 lCid, uint16 credit)
+{
+    uint8 link = Lowpan_FindLink(lCid);
+
+    if((lCid != LOWPAN_CID_NONE) && (link != LOWPAN_LINK_NONE))
+    {
+        lowpanLink[link].rxCredits = credit;
+        Lowpan_ReturnRxCredits();
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_TxCredit()
+********************************************************************************
+*
+* Summary:
+*  Adds the credits returned by the peer and sends the SDUs waiting for them,
+*  call on CYBLE_EVT_L2CAP_CBFC_TX_CREDIT_IND.
+*
+* Parameters:
+*  lCid - the local CID of the channel
+*  credit - the returned credits
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Lowpan_TxCredit(uint16 lCid, uint16 credit)
+{
+    uint8 link = Lowpan_FindLink(lCid);
+
+    if((lCid != LOWPAN_CID_NONE) && (link != LOWPAN_LINK_NONE))
+    {
+        lowpanLink[link].txCredits = ((0xFFFFu - lowpanLink[link].txCredits) > credit) ?
+                                     (lowpanLink[link].txCredits + credit) : 0xFFFFu;
+        while(Lowpan_TxNext(link) != 0u)
+        {
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_TxReady()
+********************************************************************************
+*
+* Summary:
+*  Feeds the queued SDUs to the stack, call on
+*  CYBLE_EVT_L2CAP_CBFC_DATA_WRITE_IND and on CYBLE_EVT_STACK_BUSY_STATUS when
+*  the stack becomes free. The links take turns one SDU at a time until the
+*  stack is busy or the queues are empty, so the controller gets the SDUs
+*  of all the links in one go.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Lowpan_TxReady(void)
+{
+    uint32 sent;
+    uint32 i;
+
+    do
+    {
+        sent = 0u;
+        for(i = 0u; i < LOWPAN_MAX_LINKS; i++)
+        {
+            if(lowpanLink[i].lCid != LOWPAN_CID_NONE)
+            {
+                sent |= Lowpan_TxNext((uint8)i);
+            }
+        }
+    }
+    while(sent != 0u);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_UdpBind()
+********************************************************************************
+*
+* Summary:
+*  Registers the callback that receives the datagrams sent to the UDP port.
+*
+* Parameters:
+*  port - the local UDP port
+*  callback - the datagram handler
+*
+* Return:
+*  CYBLE_ERROR_OK or CYBLE_ERROR_INSUFFICIENT_RESOURCES if all sockets are in use.
+*
+*******************************************************************************/
+CYBLE_API_RESULT_T Lowpan_UdpBind(uint16 port, LOWPAN_UDP_CALLBACK_T callback)
+{
+    CYBLE_API_RESULT_T apiResult = CYBLE_ERROR_INSUFFICIENT_RESOURCES;
+    uint32 i;
+
+    Lowpan_UdpClose(port);
+    for(i = 0u; (i < LOWPAN_MAX_SOCKETS) && (apiResult != CYBLE_ERROR_OK); i++)
+    {
+        if(lowpanSocket[i].callback == NULL)
+        {
+            lowpanSocket[i].port = port;
+            lowpanSocket[i].callback = callback;
+            apiResult = CYBLE_ERROR_OK;
+        }
+    }
+
+    return(apiResult);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_UdpClose()
+********************************************************************************
+*
+* Summary:
+*  Stops delivering the datagrams sent to the UDP port.
+*
+* Parameters:
+*  port - the local UDP port
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Lowpan_UdpClose(uint16 port)
+{
+    uint32 i;
+
+    for(i = 0u; i < LOWPAN_MAX_SOCKETS; i++)
+    {
+        if(lowpanSocket[i].port == port)
+        {
+            lowpanSocket[i].callback = NULL;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_UdpSend()
+********************************************************************************
+*
+* Summary:
+*  Sends the payload of the packet as the UDP datagram. The headers are written
+*  into the headroom in front of the payload and the packet is sent from the
+*  pool buffer, the payload is not copied. The link is chosen by the interface
+*  ID of the destination, other destinations go to the first open link.
+*
+* Parameters:
+*  srcPort - the local UDP port
+*  dstAddr - the destination address
+*  dstPort - the destination UDP port
+*  pkt - the packet, the caller still owns its reference. The queued packet
+*        must not be changed until it is sent, allocate a new one.
+*
+* Return:
+*  The CyBle_L2capChannelDataWrite() result, CYBLE_ERROR_OK when the datagram
+*  is queued, CYBLE_ERROR_NO_CONNECTION if no link is open,
+*  CYBLE_ERROR_INVALID_PARAMETER if the payload is too long or
+*  CYBLE_ERROR_INSUFFICIENT_RESOURCES if the queue of the link is full.
+*
+*******************************************************************************/
+CYBLE_API_RESULT_T Lowpan_UdpSend(uint16 srcPort, const LOWPAN_IPV6_ADDR_T *dstAddr, uint16 dstPort,
+                                  LOWPAN_PKT_T *pkt)
+{
+    LOWPAN_IPV6_HDR_T hdr;
+    uint8 udpHeader[LOWPAN_UDP_HEADER_SIZE];
+    uint8 link = Lowpan_Route(dstAddr);
+    CYBLE_API_RESULT_T apiResult;
+
+    if((pkt->length > LOWPAN_UDP_MAX_PAYLOAD) || (pkt->offset < LOWPAN_PKT_HEADROOM))
+    {
+        apiResult = CYBLE_ERROR_INVALID_PARAMETER;
+    }
+    else if(link == LOWPAN_LINK_NONE)
+    {
+        apiResult = CYBLE_ERROR_NO_CONNECTION;
+    }
+    else
+    {
+        hdr.trafficClass = 0u;
+        hdr.flowLabel = 0u;
+        hdr.nextHeader = LOWPAN_NEXT_HEADER_UDP;
+        hdr.hopLimit = LOWPAN_HOP_LIMIT;
+        Lowpan_GetLocalAddr(&hdr.srcAddr);
+        hdr.dstAddr = *dstAddr;
+
+        udpHeader[0u] = HI8(srcPort);
+        udpHeader[1u] = LO8(srcPort);
+        udpHeader[2u] = HI8(dstPort);
+        udpHeader[3u] = LO8(dstPort);
+        udpHeader[4u] = HI8(pkt->length + LOWPAN_UDP_HEADER_SIZE);
+        udpHeader[5u] = LO8(pkt->length + LOWPAN_UDP_HEADER_SIZE);
+        Lowpan_SetChecksum(&hdr, udpHeader, LOWPAN_UDP_HEADER_SIZE, LOWPAN_PKT_PAYLOAD(pkt), pkt->length);
+
+        apiResult = Lowpan_Output(link, &hdr, udpHeader, LOWPAN_UDP_HEADER_SIZE, pkt);
+    }
+
+    return(apiResult);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_UdpSendTo()
+********************************************************************************
+*
+* Summary:
+*  Sends the UDP datagram from the application buffer, the data is copied into
+*  a pool packet. Use Lowpan_UdpSend() to build the payload in place.
+*
+* Parameters:
+*  srcPort - the local UDP port
+*  dstAddr - the destination address
+*  dstPort - the destination UDP port
+*  data - the datagram payload
+*  length - the payload length, up to LOWPAN_UDP_MAX_PAYLOAD
+*
+* Return:
+*  The Lowpan_UdpSend() result or CYBLE_ERROR_MEMORY_ALLOCATION_FAILED if the
+*  pool is empty.
+*
+*******************************************************************************/
+CYBLE_API_RESULT_T Lowpan_UdpSendTo(uint16 srcPort, const LOWPAN_IPV6_ADDR_T *dstAddr, uint16 dstPort,
+                                    const uint8 data[], uint16 length)
+{
+    LOWPAN_PKT_T *pkt;
+    CYBLE_API_RESULT_T apiResult;
+
+    if(length > LOWPAN_UDP_MAX_PAYLOAD)
+    {
+        apiResult = CYBLE_ERROR_INVALID_PARAMETER;
+    }
+    else
+    {
+        pkt = Lowpan_PktAlloc();
+        if(pkt == NULL)
+        {
+            apiResult = CYBLE_ERROR_MEMORY_ALLOCATION_FAILED;
+        }
+        else
+        {
+            (void)memcpy(LOWPAN_PKT_PAYLOAD(pkt), data, length);
+            pkt->length = length;
+            apiResult = Lowpan_UdpSend(srcPort, dstAddr, dstPort, pkt);
+            Lowpan_PktFree(pkt);
+        }
+    }
+
+    return(apiResult);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_PktAlloc()
+********************************************************************************
+*
+* Summary:
+*  Takes a free packet from the pool. The payload starts after the headroom
+*  and is empty.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The packet with one reference or NULL if the pool is empty.
+*
+*******************************************************************************/
+LOWPAN_PKT_T *Lowpan_PktAlloc(void)
+{
+    LOWPAN_PKT_T *pkt = NULL;
+    uint32 i;
+
+    for(i = 0u; (i < LOWPAN_PKT_COUNT) && (pkt == NULL); i++)
+    {
+        if(lowpanPkt[i].refCount == 0u)
+        {
+            pkt = &lowpanPkt[i];
+            pkt->refCount = 1u;
+            pkt->offset = LOWPAN_PKT_HEADROOM;
+            pkt->length = 0u;
+        }
+    }
+
+    return(pkt);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_PktRef()
+********************************************************************************
+*
+* Summary:
+*  Adds a reference to the packet, a UDP callback calls it to keep the packet
+*  after return.
+*
+* Parameters:
+*  pkt - the packet
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Lowpan_PktRef(LOWPAN_PKT_T *pkt)
+{
+    pkt->refCount++;
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_PktFree()
+********************************************************************************
+*
+* Summary:
+*  Drops a reference to the packet, the last one returns it to the pool and
+*  the peers get the credits for it.
+*
+* Parameters:
+*  pkt - the packet
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Lowpan_PktFree(LOWPAN_PKT_T *pkt)
+{
+    if(pkt->refCount != 0u)
+    {
+        pkt->refCount--;
+        if(pkt->refCount == 0u)
+        {
+            Lowpan_ReturnRxCredits();
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_GetFreePktCount()
+********************************************************************************
+*
+* Summary:
+*  Counts the free packets of the pool.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The number of free packets.
+*
+*******************************************************************************/
+uint8 Lowpan_GetFreePktCount(void)
+{
+    uint8 count = 0u;
+    uint32 i;
+
+    for(i = 0u; i < LOWPAN_PKT_COUNT; i++)
+    {
+        if(lowpanPkt[i].refCount == 0u)
+        {
+            count++;
+        }
+    }
+
+    return(count);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_MakeIid()
+********************************************************************************
+*
+* Summary:
+*  Makes the 64-bit interface ID from the 48-bit device address as RFC 2464
+*  does for Ethernet. The Universal/Local bit is cleared for the public address
+*  and set for the random one (RFC 7668).
+*
+* Parameters:
+*  bdAddr - the device address
+*  iid - the interface ID output
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void Lowpan_MakeIid(const CYBLE_GAP_BD_ADDR_T *bdAddr, uint8 iid[])
+{
+    /* Device address is stored LSB first */
+    iid[0u] = bdAddr->bdAddr[5u];
+    iid[1u] = bdAddr->bdAddr[4u];
+    iid[2u] = bdAddr->bdAddr[3u];
+    iid[3u] = 0xFFu;
+    iid[4u] = 0xFEu;
+    iid[5u] = bdAddr->bdAddr[2u];
+    iid[6u] = bdAddr->bdAddr[1u];
+    iid[7u] = bdAddr->bdAddr[0u];
+
+    if(bdAddr->type == 0u)
+    {
+        iid[0u] &= (uint8)~0x02u;
+    }
+    else
+    {
+        iid[0u] |= 0x02u;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_FindLink()
+********************************************************************************
+*
+* Summary:
+*  Finds the link of the L2CAP channel.
+*
+* Parameters:
+*  lCid - the local CID, LOWPAN_CID_NONE finds a free link
+*
+* Return:
+*  The link number or LOWPAN_LINK_NONE.
+*
+*******************************************************************************/
+static uint8 Lowpan_FindLink(uint16 lCid)
+{
+    uint8 link;
+
+    for(link = 0u; (link < LOWPAN_MAX_LINKS) && (lowpanLink[link].lCid != lCid); link++)
+    {
+    }
+
+    return((link < LOWPAN_MAX_LINKS) ? link : LOWPAN_LINK_NONE);
+}
+
+
+#if (LOWPAN_MAX_LINKS > 1u)
+/*******************************************************************************
+* Function Name: Lowpan_FindPeer()
+********************************************************************************
+*
+* Summary:
+*  Finds the open link whose peer has the interface ID. The link-local address
+*  of an IPSP node is formed from its device address.
+*
+* Parameters:
+*  iid - the interface ID
+*
+* Return:
+*  The link number or LOWPAN_LINK_NONE.
+*
+*******************************************************************************/
+static uint8 Lowpan_FindPeer(const uint8 iid[])
+{
+    uint8 link;
+
+    for(link = 0u; link < LOWPAN_MAX_LINKS; link++)
+    {
+        /* Last byte differs first between the devices of one vendor */
+        if((lowpanLink[link].peerIid[LOWPAN_IID_SIZE - 1u] == iid[LOWPAN_IID_SIZE - 1u]) &&
+           (lowpanLink[link].lCid != LOWPAN_CID_NONE) &&
+           (memcmp(lowpanLink[link].peerIid, iid, LOWPAN_IID_SIZE) == 0))
+        {
+            break;
+        }
+    }
+
+    return((link < LOWPAN_MAX_LINKS) ? link : LOWPAN_LINK_NONE);
+}
+#endif /* (LOWPAN_MAX_LINKS > 1u) */
+
+
+/*******************************************************************************
+* Function Name: Lowpan_Route()
+********************************************************************************
+*
+* Summary:
+*  Chooses the link for the destination: the one whose peer owns the unicast
+*  address, otherwise the first open link. A single link carries every packet.
+*
+* Parameters:
+*  dstAddr - the destination address
+*
+* Return:
+*  The link number or LOWPAN_LINK_NONE if no link is open.
+*
+*******************************************************************************/
+static uint8 Lowpan_Route(const LOWPAN_IPV6_ADDR_T *dstAddr)
+{
+    uint8 route = LOWPAN_LINK_NONE;
+
+#if (LOWPAN_MAX_LINKS > 1u)
+    if(dstAddr->addr[0u] != 0xFFu)
+    {
+        route = Lowpan_FindPeer(&dstAddr->addr[LOWPAN_IPV6_ADDR_SIZE - LOWPAN_IID_SIZE]);
+    }
+#else
+    (void)dstAddr;
+#endif /* (LOWPAN_MAX_LINKS > 1u) */
+    if(route == LOWPAN_LINK_NONE)
+    {
+        for(route = 0u; (route < LOWPAN_MAX_LINKS) && (lowpanLink[route].lCid == LOWPAN_CID_NONE); route++)
+        {
+        }
+        if(route == LOWPAN_MAX_LINKS)
+        {
+            route = LOWPAN_LINK_NONE;
+        }
+    }
+
+    return(route);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_ClearLink()
+********************************************************************************
+*
+* Summary:
+*  Closes the link and drops the SDUs waiting for the credits.
+*
+* Parameters:
+*  link - the link number
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void Lowpan_ClearLink(uint8 link)
+{
+    LOWPAN_LINK_T *lowpanLinkPtr = &lowpanLink[link];
+
+    lowpanLinkPtr->lCid = LOWPAN_CID_NONE;
+    while(lowpanLinkPtr->txCount != 0u)
+    {
+        lowpanLinkPtr->txCount--;
+        Lowpan_PktFree(lowpanLinkPtr->txQueue[lowpanLinkPtr->txHead].pkt);
+        lowpanLinkPtr->txHead = (uint8)((lowpanLinkPtr->txHead + 1u) % LOWPAN_TX_QUEUE_SIZE);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_RxCreditShare()
+********************************************************************************
+*
+* Summary:
+*  Splits the credits of the free pool packets between the links, every free
+*  packet takes one SDU of the longest length.
+*
+* Parameters:
+*  linkCount - the number of links sharing the packets
+*
+* Return:
+*  The credits of one link.
+*
+*******************************************************************************/
+static uint16 Lowpan_RxCreditShare(uint8 linkCount)
+{
+    uint32 credits = (uint32)Lowpan_GetFreePktCount() * LOWPAN_SDU_CREDITS;
+
+#if (LOWPAN_MAX_LINKS > 1u)
+    if(linkCount > 1u)
+    {
+        credits /= linkCount;
+    }
+#else
+    (void)linkCount;
+#endif /* (LOWPAN_MAX_LINKS > 1u) */
+
+    return((credits < 0xFFFFu) ? (uint16)credits : 0xFFFFu);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_RxCreditsFree()
+********************************************************************************
+*
+* Summary:
+*  Gets the credits of the free pool packets that no peer holds. The credits
+*  of all the peers together never exceed the free packets.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The credits that can be given to the peers.
+*
+*******************************************************************************/
+static uint16 Lowpan_RxCreditsFree(void)
+{
+    uint32 credits = (uint32)Lowpan_GetFreePktCount() * LOWPAN_SDU_CREDITS;
+    uint32 i;
+
+    for(i = 0u; i < LOWPAN_MAX_LINKS; i++)
+    {
+        if(lowpanLink[i].lCid != LOWPAN_CID_NONE)
+        {
+            credits = (credits > lowpanLink[i].rxCredits) ? (credits - lowpanLink[i].rxCredits) : 0u;
+        }
+    }
+
+    return((credits < 0xFFFFu) ? (uint16)credits : 0xFFFFu);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_ReturnRxCredits()
+********************************************************************************
+*
+* Summary:
+*  Tops up the credits of every peer to its share of the free pool packets.
+*  The credits are returned in the steps of one SDU, so the packets consumed
+*  one by one do not cost a credit packet each, and at once when the peer
+*  cannot send the longest SDU. No more credits are given than the free
+*  packets take.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void Lowpan_ReturnRxCredits(void)
+{
+    uint16 share = Lowpan_RxCreditShare(Lowpan_GetLinkCount());
+    uint16 available = Lowpan_RxCreditsFree();
+    uint16 credit;
+    uint32 i;
+
+    for(i = 0u; i < LOWPAN_MAX_LINKS; i++)
+    {
+        if((lowpanLink[i].lCid != LOWPAN_CID_NONE) && (lowpanLink[i].rxCredits < share) && (available != 0u))
+        {
+            credit = share - lowpanLink[i].rxCredits;
+            if(credit > available)
+            {
+                credit = available;
+            }
+            if(((credit >= LOWPAN_SDU_CREDITS) || (lowpanLink[i].rxCredits < LOWPAN_SDU_CREDITS)) &&
+               (CyBle_L2capCbfcSendFlowControlCredit(lowpanLink[i].lCid, credit) == CYBLE_ERROR_OK))
+            {
+                lowpanLink[i].rxCredits += credit;
+                available -= credit;
+            }
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_Transmit()
+********************************************************************************
+*
+* Summary:
+*  Writes the SDU to the channel when no earlier SDU waits, the peer has given
+*  the credits for all its LE-frames and the stack is free. Otherwise, or when
+*  the stack has no buffer for it, the SDU is queued in order.
+*
+* Parameters:
+*  link - the link number
+*  pkt - the packet, its payload is the SDU
+*
+* Return:
+*  The CyBle_L2capChannelDataWrite() result, CYBLE_ERROR_OK when the SDU is
+*  queued or CYBLE_ERROR_INSUFFICIENT_RESOURCES if the queue is full.
+*
+*******************************************************************************/
+static CYBLE_API_RESULT_T Lowpan_Transmit(uint8 link, LOWPAN_PKT_T *pkt)
+{
+    LOWPAN_LINK_T *lowpanLinkPtr = &lowpanLink[link];
+    LOWPAN_TX_ENTRY_T *entry;
+    uint16 credits = LOWPAN_CREDITS(pkt->length, lowpanLinkPtr->peerMps);
+    uint32 queue = 1u;
+    CYBLE_API_RESULT_T apiResult = CYBLE_ERROR_OK;
+
+    if((lowpanLinkPtr->txCount == 0u) && (lowpanLinkPtr->txCredits >= credits) &&
+       (CyBle_GattGetBusyStatus() == CYBLE_STACK_STATE_FREE))
+    {
+        apiResult = CyBle_L2capChannelDataWrite(lowpanLinkPtr->bdHandle, lowpanLinkPtr->lCid,
+                                                LOWPAN_PKT_PAYLOAD(pkt), pkt->length);
+        if(apiResult == CYBLE_ERROR_OK)
+        {
+            lowpanLinkPtr->txCredits -= credits;
+        }
+        queue = (uint32)(apiResult == CYBLE_ERROR_MEMORY_ALLOCATION_FAILED);
+    }
+
+    if(queue == 0u)
+    {
+        /* Written or failed */
+    }
+    else if(lowpanLinkPtr->txCount < LOWPAN_TX_QUEUE_SIZE)
+    {
+        entry = &lowpanLinkPtr->txQueue[(lowpanLinkPtr->txHead + lowpanLinkPtr->txCount) % LOWPAN_TX_QUEUE_SIZE];
+        entry->pkt = pkt;
+        entry->offset = pkt->offset;
+        entry->length = pkt->length;
+        Lowpan_PktRef(pkt);
+        lowpanLinkPtr->txCount++;
+        apiResult = CYBLE_ERROR_OK;
+    }
+    else
+    {
+        apiResult = CYBLE_ERROR_INSUFFICIENT_RESOURCES;
+    }
+
+    return(apiResult);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_TxNext()
+********************************************************************************
+*
+* Summary:
+*  Writes the first queued SDU of the link when the peer has given the credits
+*  and the stack is free. The SDU stays queued when the stack has no buffer
+*  for it, it is dropped on the other errors.
+*
+* Parameters:
+*  link - the link number
+*
+* Return:
+*  Not zero value when the SDU left the queue.
+*
+*******************************************************************************/
+static uint32 Lowpan_TxNext(uint8 link)
+{
+    LOWPAN_LINK_T *lowpanLinkPtr = &lowpanLink[link];
+    LOWPAN_TX_ENTRY_T *entry = &lowpanLinkPtr->txQueue[lowpanLinkPtr->txHead];
+    uint16 credits;
+    uint32 sent = 0u;
+    CYBLE_API_RESULT_T apiResult;
+
+    if((lowpanLinkPtr->txCount != 0u) && (CyBle_GattGetBusyStatus() == CYBLE_STACK_STATE_FREE))
+    {
+        credits = LOWPAN_CREDITS(entry->length, lowpanLinkPtr->peerMps);
+        if(lowpanLinkPtr->txCredits >= credits)
+        {
+            apiResult = CyBle_L2capChannelDataWrite(lowpanLinkPtr->bdHandle, lowpanLinkPtr->lCid,
+                                                    &entry->pkt->buffer[entry->offset], entry->length);
+            if(apiResult == CYBLE_ERROR_OK)
+            {
+                lowpanLinkPtr->txCredits -= credits;
+                sent = 1u;
+            }
+            else if(apiResult != CYBLE_ERROR_MEMORY_ALLOCATION_FAILED)
+            {
+                DBG_PRINTF("Lowpan: dropped queued SDU, lCid=%d, error=%d \r\n", lowpanLinkPtr->lCid, apiResult);
+                sent = 1u;
+            }
+            else
+            {
+                /* Retried when the stack completes a write */
+            }
+        }
+    }
+
+    if(sent != 0u)
+    {
+        lowpanLinkPtr->txHead = (uint8)((lowpanLinkPtr->txHead + 1u) % LOWPAN_TX_QUEUE_SIZE);
+        lowpanLinkPtr->txCount--;
+        Lowpan_PktFree(entry->pkt);
+    }
+
+    return(sent);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_IsLinkLocal()
+********************************************************************************
+*
+* Summary:
+*  Checks whether the address is the fe80::/64 unicast one.
+*
+* Parameters:
+*  addr - the address
+*
+* Return:
+*  Not zero value for the link-local address.
+*
+*******************************************************************************/
+static uint32 Lowpan_IsLinkLocal(const LOWPAN_IPV6_ADDR_T *addr)
+{
+    static const uint8 CYCODE linkLocalPrefix[LOWPAN_IID_SIZE] = {0xFEu, 0x80u, 0u, 0u, 0u, 0u, 0u, 0u};
+
+    return((uint32)(memcmp(addr->addr, linkLocalPrefix, LOWPAN_IID_SIZE) == 0));
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_IsLocalAddr()
+********************************************************************************
+*
+* Summary:
+*  Checks whether the packet to the address is for this device: a unicast
+*  address with the local interface ID or the all-nodes multicast.
+*
+* Parameters:
+*  addr - the destination address
+*
+* Return:
+*  Not zero value for the local address.
+*
+*******************************************************************************/
+static uint32 Lowpan_IsLocalAddr(const LOWPAN_IPV6_ADDR_T *addr)
+{
+    static const uint8 CYCODE allNodes[LOWPAN_IPV6_ADDR_SIZE] =
+        {0xFFu, 0x02u, 0u, 0u, 0u, 0u, 0u, 0u, 0u, 0u, 0u, 0u, 0u, 0u, 0u, 0x01u};
+
+    return((uint32)(((addr->addr[0u] != 0xFFu) &&
+                     (memcmp(&addr->addr[LOWPAN_IPV6_ADDR_SIZE - LOWPAN_IID_SIZE], lowpanLocalIid, LOWPAN_IID_SIZE) == 0)) ||
+                    (memcmp(addr->addr, allNodes, LOWPAN_IPV6_ADDR_SIZE) == 0)));
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_Read()
+********************************************************************************
+*
+* Summary:
+*  Takes the next bytes of the received frame. Reading past the end of the
+*  frame sets the error and returns zeros.
+*
+* Parameters:
+*  reader - the frame reader
+*  data - the bytes output
+*  size - the number of bytes
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void Lowpan_Read(LOWPAN_READER_T *reader, uint8 data[], uint16 size)
+{
+    if(size > reader->remaining)
+    {
+        reader->error = 1u;
+        (void)memset(data, 0, size);
+    }
+    else
+    {
+        (void)memcpy(data, reader->ptr, size);
+        reader->ptr += size;
+        reader->remaining -= size;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_ReadByte()
+********************************************************************************
+*
+* Summary:
+*  Takes the next byte of the received frame.
+*
+* Parameters:
+*  reader - the frame reader
+*
+* Return:
+*  The byte, zero past the end of the frame.
+*
+*******************************************************************************/
+static uint8 Lowpan_ReadByte(LOWPAN_READER_T *reader)
+{
+    uint8 byte;
+
+    Lowpan_Read(reader, &byte, 1u);
+
+    return(byte);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_ReadAddr()
+********************************************************************************
+*
+* Summary:
+*  Decompresses the stateless unicast address.
+*
+* Parameters:
+*  reader - the frame reader
+*  mode - the SAM or DAM field
+*  linkIid - the interface ID of the link-layer address of the address owner
+*  addr - the address output
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void Lowpan_ReadAddr(LOWPAN_READER_T *reader, uint8 mode, const uint8 linkIid[], LOWPAN_IPV6_ADDR_T *addr)
+{
+    uint8 *iid = &addr->addr[LOWPAN_IPV6_ADDR_SIZE - LOWPAN_IID_SIZE];
+
+    (void)memset(addr->addr, 0, LOWPAN_IPV6_ADDR_SIZE);
+    if(mode == LOWPAN_IPHC_AM_FULL)
+    {
+        Lowpan_Read(reader, addr->addr, LOWPAN_IPV6_ADDR_SIZE);
+    }
+    else
+    {
+        addr->addr[0u] = 0xFEu;
+        addr->addr[1u] = 0x80u;
+        if(mode == LOWPAN_IPHC_AM_IID)
+        {
+            Lowpan_Read(reader, iid, LOWPAN_IID_SIZE);
+        }
+        else if(mode == LOWPAN_IPHC_AM_SHORT)
+        {
+            iid[3u] = 0xFFu;
+            iid[4u] = 0xFEu;
+            Lowpan_Read(reader, &iid[6u], 2u);
+        }
+        else
+        {
+            (void)memcpy(iid, linkIid, LOWPAN_IID_SIZE);
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_ReadMcastAddr()
+********************************************************************************
+*
+* Summary:
+*  Decompresses the stateless multicast address.
+*
+* Parameters:
+*  reader - the frame reader
+*  mode - the DAM field
+*  addr - the address output
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void Lowpan_ReadMcastAddr(LOWPAN_READER_T *reader, uint8 mode, LOWPAN_IPV6_ADDR_T *addr)
+{
+    (void)memset(addr->addr, 0, LOWPAN_IPV6_ADDR_SIZE);
+    addr->addr[0u] = 0xFFu;
+    if(mode == LOWPAN_IPHC_AM_FULL)
+    {
+        Lowpan_Read(reader, addr->addr, LOWPAN_IPV6_ADDR_SIZE);
+    }
+    else if(mode == LOWPAN_IPHC_MCAST_48)
+    {
+        addr->addr[1u] = Lowpan_ReadByte(reader);
+        Lowpan_Read(reader, &addr->addr[11u], 5u);
+    }
+    else if(mode == LOWPAN_IPHC_MCAST_32)
+    {
+        addr->addr[1u] = Lowpan_ReadByte(reader);
+        Lowpan_Read(reader, &addr->addr[13u], 3u);
+    }
+    else
+    {
+        addr->addr[1u] = 0x02u;
+        addr->addr[15u] = Lowpan_ReadByte(reader);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_Decompress()
+********************************************************************************
+*
+* Summary:
+*  Decompresses the IPHC header and the UDP NHC header that may follow it.
+*  Context based compression is not used on IPSP links, such packets are
+*  dropped.
+*
+* Parameters:
+*  reader - the frame reader at the IPHC dispatch
+*  link - the link the frame arrived on
+*  hdr - the IPv6 header output
+*  udpHeader - the UDP header output
+*
+* Return:
+*  Not zero value when the UDP header was decompressed.
+*
+*******************************************************************************/
+static uint32 Lowpan_Decompress(LOWPAN_READER_T *reader, uint8 link, LOWPAN_IPV6_HDR_T *hdr, uint8 udpHeader[])
+{
+    uint8 iphc0 = Lowpan_ReadByte(reader);
+    uint8 iphc1 = Lowpan_ReadByte(reader);
+    uint8 tf[4u];
+    uint8 nhc;
+    uint8 ports;
+    uint32 udpPresent = 0u;
+
+    if((iphc1 & (LOWPAN_IPHC_CID | LOWPAN_IPHC_SAC | LOWPAN_IPHC_DAC)) != 0u)
+    {
+        reader->error = 1u;
+    }
+
+    /* Traffic class is ECN(2) DSCP(6) inline, DSCP(6) ECN(2) in the IPv6 header */
+    hdr->trafficClass = 0u;
+    hdr->flowLabel = 0u;
+    switch(iphc0 & LOWPAN_IPHC_TF_MASK)
+    {
+        case LOWPAN_IPHC_TF_INLINE:
+            Lowpan_Read(reader, tf, 4u);
+            hdr->trafficClass = (uint8)((uint8)(tf[0u] << 2u) | (tf[0u] >> 6u));
+            hdr->flowLabel = ((uint32)(tf[1u] & 0x0Fu) << 16u) | ((uint32)tf[2u] << 8u) | tf[3u];
+            break;
+        case LOWPAN_IPHC_TF_ECN_FL:
+            Lowpan_Read(reader, tf, 3u);
+            hdr->trafficClass = (uint8)(tf[0u] >> 6u);
+            hdr->flowLabel = ((uint32)(tf[0u] & 0x0Fu) << 16u) | ((uint32)tf[1u] << 8u) | tf[2u];
+            break;
+        case LOWPAN_IPHC_TF_ECN_DSCP:
+            tf[0u] = Lowpan_ReadByte(reader);
+            hdr->trafficClass = (uint8)((uint8)(tf[0u] << 2u) | (tf[0u] >> 6u));
+            break;
+        default:
+            break;
+    }
+
+    hdr->nextHeader = ((iphc0 & LOWPAN_IPHC_NH) != 0u) ? LOWPAN_NEXT_HEADER_UDP : Lowpan_ReadByte(reader);
+
+    switch(iphc0 & LOWPAN_IPHC_HLIM_MASK)
+    {
+        case LOWPAN_IPHC_HLIM_1:
+            hdr->hopLimit = 1u;
+            break;
+        case LOWPAN_IPHC_HLIM_64:
+            hdr->hopLimit = 64u;
+            break;
+        case LOWPAN_IPHC_HLIM_255:
+            hdr->hopLimit = 255u;
+            break;
+        default:
+            hdr->hopLimit = Lowpan_ReadByte(reader);
+            break;
+    }
+
+    /* Elided addresses come from the link-layer addresses: the peer sent it to this device */
+    Lowpan_ReadAddr(reader, (iphc1 >> LOWPAN_IPHC_SAM_SHIFT) & LOWPAN_IPHC_AM_MASK, lowpanLink[link].peerIid,
+                    &hdr->srcAddr);
+    if((iphc1 & LOWPAN_IPHC_M) != 0u)
+    {
+        Lowpan_ReadMcastAddr(reader, iphc1 & LOWPAN_IPHC_AM_MASK, &hdr->dstAddr);
+    }
+    else
+    {
+        Lowpan_ReadAddr(reader, iphc1 & LOWPAN_IPHC_AM_MASK, lowpanLocalIid, &hdr->dstAddr);
+    }
+
+    if((iphc0 & LOWPAN_IPHC_NH) != 0u)
+    {
+        nhc = Lowpan_ReadByte(reader);
+        if(((nhc & LOWPAN_NHC_UDP_MASK) != LOWPAN_NHC_UDP) || ((nhc & LOWPAN_NHC_UDP_C) != 0u))
+        {
+            reader->error = 1u;
+        }
+
+        ports = nhc & LOWPAN_NHC_UDP_PORTS_MASK;
+        if(ports == LOWPAN_NHC_UDP_PORTS_4)
+        {
+            tf[0u] = Lowpan_ReadByte(reader);
+            udpHeader[0u] = HI8(LOWPAN_UDP_PORT_SHORT_BASE);
+            udpHeader[1u] = LO8(LOWPAN_UDP_PORT_SHORT_BASE) | (tf[0u] >> 4u);
+            udpHeader[2u] = HI8(LOWPAN_UDP_PORT_SHORT_BASE);
+            udpHeader[3u] = LO8(LOWPAN_UDP_PORT_SHORT_BASE) | (tf[0u] & 0x0Fu);
+        }
+        else
+        {
+            if(ports == LOWPAN_NHC_UDP_PORTS_SRC8)
+            {
+                udpHeader[0u] = HI8(LOWPAN_UDP_PORT_8BIT_BASE);
+                udpHeader[1u] = Lowpan_ReadByte(reader);
+            }
+            else
+            {
+                Lowpan_Read(reader, &udpHeader[0u], 2u);
+            }
+            if(ports == LOWPAN_NHC_UDP_PORTS_DST8)
+            {
+                udpHeader[2u] = HI8(LOWPAN_UDP_PORT_8BIT_BASE);
+                udpHeader[3u] = Lowpan_ReadByte(reader);
+            }
+            else
+            {
+                Lowpan_Read(reader, &udpHeader[2u], 2u);
+            }
+        }
+        Lowpan_Read(reader, &udpHeader[LOWPAN_UDP_CHECKSUM_INDX], 2u);
+
+        /* Length is elided, the rest of the frame is the payload */
+        udpHeader[4u] = HI8(reader->remaining + LOWPAN_UDP_HEADER_SIZE);
+        udpHeader[5u] = LO8(reader->remaining + LOWPAN_UDP_HEADER_SIZE);
+        udpPresent = 1u;
+    }
+
+    return(udpPresent);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_CompressAddr()
+********************************************************************************
+*
+* Summary:
+*  Compresses the unicast address and writes its inline part.
+*
+* Parameters:
+*  addr - the address
+*  linkIid - the interface ID of the link-layer address of the address owner
+*  ptr - the write pointer, advanced past the inline part
+*
+* Return:
+*  The SAM or DAM field.
+*
+*******************************************************************************/
+static uint8 Lowpan_CompressAddr(const LOWPAN_IPV6_ADDR_T *addr, const uint8 linkIid[], uint8 **ptr)
+{
+    static const uint8 CYCODE shortIid[6u] = {0u, 0u, 0u, 0xFFu, 0xFEu, 0u};
+    const uint8 *iid = &addr->addr[LOWPAN_IPV6_ADDR_SIZE - LOWPAN_IID_SIZE];
+    uint8 mode;
+
+    if(Lowpan_IsLinkLocal(addr) == 0u)
+    {
+        (void)memcpy(*ptr, addr->addr, LOWPAN_IPV6_ADDR_SIZE);
+        *ptr += LOWPAN_IPV6_ADDR_SIZE;
+        mode = LOWPAN_IPHC_AM_FULL;
+    }
+    else if(memcmp(iid, linkIid, LOWPAN_IID_SIZE) == 0)
+    {
+        mode = LOWPAN_IPHC_AM_ELIDED;
+    }
+    else if(memcmp(iid, shortIid, sizeof(shortIid)) == 0)
+    {
+        (void)memcpy(*ptr, &iid[6u], 2u);
+        *ptr += 2u;
+        mode = LOWPAN_IPHC_AM_SHORT;
+    }
+    else
+    {
+        (void)memcpy(*ptr, iid, LOWPAN_IID_SIZE);
+        *ptr += LOWPAN_IID_SIZE;
+        mode = LOWPAN_IPHC_AM_IID;
+    }
+
+    return(mode);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_CompressMcastAddr()
+********************************************************************************
+*
+* Summary:
+*  Compresses the multicast address and writes its inline part.
+*
+* Parameters:
+*  addr - the address
+*  ptr - the write pointer, advanced past the inline part
+*
+* Return:
+*  The DAM field.
+*
+*******************************************************************************/
+static uint8 Lowpan_CompressMcastAddr(const LOWPAN_IPV6_ADDR_T *addr, uint8 **ptr)
+{
+    uint8 zeros;
+    uint8 mode;
+
+    /* Count the zero bytes after the flags and scope */
+    for(zeros = 0u; ((2u + zeros) < (LOWPAN_IPV6_ADDR_SIZE - 1u)) && (addr->addr[2u + zeros] == 0u); zeros++)
+    {
+    }
+
+    if((addr->addr[1u] == 0x02u) && (zeros >= 13u))
+    {
+        **ptr = addr->addr[15u];
+        *ptr += 1u;
+        mode = LOWPAN_IPHC_MCAST_8;
+    }
+    else if(zeros >= 11u)
+    {
+        **ptr = addr->addr[1u];
+        (void)memcpy(*ptr + 1u, &addr->addr[13u], 3u);
+        *ptr += 4u;
+        mode = LOWPAN_IPHC_MCAST_32;
+    }
+    else if(zeros >= 9u)
+    {
+        **ptr = addr->addr[1u];
+        (void)memcpy(*ptr + 1u, &addr->addr[11u], 5u);
+        *ptr += 6u;
+        mode = LOWPAN_IPHC_MCAST_48;
+    }
+    else
+    {
+        (void)memcpy(*ptr, addr->addr, LOWPAN_IPV6_ADDR_SIZE);
+        *ptr += LOWPAN_IPV6_ADDR_SIZE;
+        mode = LOWPAN_IPHC_AM_FULL;
+    }
+
+    return(mode);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_Checksum()
+********************************************************************************
+*
+* Summary:
+*  Computes the UDP or ICMPv6 checksum: the one's complement sum of the IPv6
+*  pseudo-header, the upper-layer header and the data. Summing a packet with
+*  its checksum gives zero.
+*
+* Parameters:
+*  hdr - the IPv6 header
+*  head - the upper-layer header, even length
+*  headLength - the upper-layer header length
+*  data - the data following the upper-layer header
+*  dataLength - the data length
+*
+* Return:
+*  The checksum.
+*
+*******************************************************************************/
+static uint16 Lowpan_Checksum(const LOWPAN_IPV6_HDR_T *hdr, const uint8 head[], uint16 headLength,
+                              const uint8 data[], uint16 dataLength)
+{
+    uint32 sum = (uint32)headLength + dataLength + hdr->nextHeader;
+    const uint8 *ptr;
+    uint32 i;
+
+    for(i = 0u; i < LOWPAN_IPV6_ADDR_SIZE; i += 2u)
+    {
+        sum += ((uint32)hdr->srcAddr.addr[i] << 8u) | hdr->srcAddr.addr[i + 1u];
+        sum += ((uint32)hdr->dstAddr.addr[i] << 8u) | hdr->dstAddr.addr[i + 1u];
+    }
+    for(i = 0u; i < headLength; i += 2u)
+    {
+        sum += ((uint32)head[i] << 8u) | head[i + 1u];
+    }
+
+    /* The 16-bit words are added as they come, the carries are folded once at the end */
+    for(ptr = data; dataLength > 1u; dataLength -= 2u)
+    {
+        sum += ((uint32)ptr[0u] << 8u) | ptr[1u];
+        ptr += 2u;
+    }
+    if(dataLength != 0u)
+    {
+        sum += (uint32)ptr[0u] << 8u;
+    }
+
+    sum = (sum & 0xFFFFu) + (sum >> 16u);
+    sum = (sum & 0xFFFFu) + (sum >> 16u);
+
+    return((uint16)~sum);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_SetChecksum()
+********************************************************************************
+*
+* Summary:
+*  Fills in the checksum of the UDP or ICMPv6 header of the packet being sent.
+*
+* Parameters:
+*  hdr - the IPv6 header
+*  head - the UDP or ICMPv6 header
+*  headLength - the UDP or ICMPv6 header length
+*  data - the data following the upper-layer header
+*  dataLength - the data length
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void Lowpan_SetChecksum(const LOWPAN_IPV6_HDR_T *hdr, uint8 head[], uint16 headLength,
+                               const uint8 data[], uint16 dataLength)
+{
+    uint8 checksumIndx;
+    uint16 checksum;
+
+    checksumIndx = (hdr->nextHeader == LOWPAN_NEXT_HEADER_UDP) ? LOWPAN_UDP_CHECKSUM_INDX : LOWPAN_ICMPV6_CHECKSUM_INDX;
+    head[checksumIndx] = 0u;
+    head[checksumIndx + 1u] = 0u;
+    checksum = Lowpan_Checksum(hdr, head, headLength, data, dataLength);
+    if((checksum == 0u) && (hdr->nextHeader == LOWPAN_NEXT_HEADER_UDP))
+    {
+        /* Zero UDP checksum means no checksum */
+        checksum = 0xFFFFu;
+    }
+    head[checksumIndx] = HI8(checksum);
+    head[checksumIndx + 1u] = LO8(checksum);
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_Input()
+********************************************************************************
+*
+* Summary:
+*  Delivers the decompressed packet: UDP datagrams to the bound ports, ICMPv6
+*  echo requests are answered from the same packet. Packets for other
+*  destinations and packets with the wrong checksum are dropped.
+*
+* Parameters:
+*  link - the link the packet arrived on
+*  hdr - the IPv6 header
+*  udpHeader - the UDP header, NULL for other next headers
+*  pkt - the packet, its payload is the upper-layer data
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void Lowpan_Input(uint8 link, const LOWPAN_IPV6_HDR_T *hdr, const uint8 udpHeader[], LOWPAN_PKT_T *pkt)
+{
+    LOWPAN_UDP_INFO_T info;
+    LOWPAN_IPV6_HDR_T replyHdr;
+    uint8 *data = LOWPAN_PKT_PAYLOAD(pkt);
+    uint16 checksum;
+    uint32 i;
+
+    if(Lowpan_IsLocalAddr(&hdr->dstAddr) == 0u)
+    {
+        DBG_PRINTF("Lowpan: not for this device \r\n");
+    }
+    else if(udpHeader != NULL)
+    {
+        if(Lowpan_Checksum(hdr, udpHeader, LOWPAN_UDP_HEADER_SIZE, data, pkt->length) != 0u)
+        {
+            DBG_PRINTF("Lowpan: UDP checksum error \r\n");
+        }
+        else
+        {
+            info.srcAddr = hdr->srcAddr;
+            info.dstAddr = hdr->dstAddr;
+            info.srcPort = ((uint16)((uint16)udpHeader[0u] << 8u)) | udpHeader[1u];
+            info.dstPort = ((uint16)((uint16)udpHeader[2u] << 8u)) | udpHeader[3u];
+            info.link = link;
+
+            for(i = 0u; i < LOWPAN_MAX_SOCKETS; i++)
+            {
+                if((lowpanSocket[i].callback != NULL) && (lowpanSocket[i].port == info.dstPort))
+                {
+                    lowpanSocket[i].callback(&info, pkt);
+                }
+            }
+        }
+    }
+    else if((hdr->nextHeader == LOWPAN_NEXT_HEADER_ICMPV6) && (pkt->length >= LOWPAN_ICMPV6_HEADER_SIZE) &&
+            (data[0u] == LOWPAN_ICMPV6_ECHO_REQUEST) &&
+            (Lowpan_Checksum(hdr, NULL, 0u, data, pkt->length) == 0u))
+    {
+        replyHdr = *hdr;
+        replyHdr.hopLimit = LOWPAN_HOP_LIMIT;
+        replyHdr.dstAddr = hdr->srcAddr;
+        Lowpan_GetLocalAddr(&replyHdr.srcAddr);
+
+        /* Identifier, sequence number and data are echoed in place */
+        data[0u] = LOWPAN_ICMPV6_ECHO_REPLY;
+        data[LOWPAN_ICMPV6_CHECKSUM_INDX] = 0u;
+        data[LOWPAN_ICMPV6_CHECKSUM_INDX + 1u] = 0u;
+        checksum = Lowpan_Checksum(&replyHdr, NULL, 0u, data, pkt->length);
+        data[LOWPAN_ICMPV6_CHECKSUM_INDX] = HI8(checksum);
+        data[LOWPAN_ICMPV6_CHECKSUM_INDX + 1u] = LO8(checksum);
+        (void)Lowpan_Output(link, &replyHdr, NULL, 0u, pkt);
+    }
+    else
+    {
+        DBG_PRINTF("Lowpan: next header %d is not supported \r\n", hdr->nextHeader);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Lowpan_Output()
+********************************************************************************
+*
+* Summary:
+*  Compresses the headers into the headroom in front of the payload and sends
+*  the packet as one SDU of the link straight from the pool buffer or queues
+*  it until the peer returns the credits.
+*
+* Parameters:
+*  link - the link to send the packet on
+*  hdr - the IPv6 header
+*  head - the UDP header with the checksum, NULL when the upper-layer header
+*         is in the payload
+*  headLength - the UDP header length or zero
+*  pkt - the packet, the stack copies it before the function returns, the
+*        queue holds a reference
+*
+* Return:
+*  The Lowpan_Transmit() result.
+*
+*******************************************************************************/
+static CYBLE_API_RESULT_T Lowpan_Output(uint8 link, const LOWPAN_IPV6_HDR_T *hdr, const uint8 head[],
+                                        uint16 headLength, LOWPAN_PKT_T *pkt)
+{
+    uint8 header[LOWPAN_HEADER_MAX_SIZE];
+    uint8 *ptr = &header[2u];
+    uint8 iphc0 = LOWPAN_DISPATCH_IPHC;
+    uint8 iphc1 = 0u;
+    uint16 headerLength;
+    uint16 srcPort;
+    uint16 dstPort;
+    CYBLE_API_RESULT_T apiResult;
+
+    if((hdr->trafficClass == 0u) && (hdr->flowLabel == 0u))
+    {
+        iphc0 |= LOWPAN_IPHC_TF_ELIDED;
+    }
+    else
+    {
+        ptr[0u] = (uint8)((uint8)(hdr->trafficClass >> 2u) | (uint8)(hdr->trafficClass << 6u));
+        ptr[1u] = (uint8)((hdr->flowLabel >> 16u) & 0x0Fu);
+        ptr[2u] = (uint8)(hdr->flowLabel >> 8u);
+        ptr[3u] = (uint8)hdr->flowLabel;
+        ptr += 4u;
+    }
+
+    if(hdr->nextHeader == LOWPAN_NEXT_HEADER_UDP)
+    {
+        iphc0 |= LOWPAN_IPHC_NH;
+    }
+    else
+    {
+        *ptr++ = hdr->nextHeader;
+    }
+
+    switch(hdr->hopLimit)
+    {
+        case 1u:
+            iphc0 |= LOWPAN_IPHC_HLIM_1;
+            break;
+        case 64u:
+            iphc0 |= LOWPAN_IPHC_HLIM_64;
+            break;
+        case 255u:
+            iphc0 |= LOWPAN_IPHC_HLIM_255;
+            break;
+        default:
+            *ptr++ = hdr->hopLimit;
+            break;
+    }
+
+    /* Source is elided when it is this device, destination when it is the peer of the link */
+    iphc1 |= (uint8)(Lowpan_CompressAddr(&hdr->srcAddr, lowpanLocalIid, &ptr) << LOWPAN_IPHC_SAM_SHIFT);
+    if(hdr->dstAddr.addr[0u] == 0xFFu)
+    {
+        iphc1 |= LOWPAN_IPHC_M | Lowpan_CompressMcastAddr(&hdr->dstAddr, &ptr);
+    }
+    else
+    {
+        iphc1 |= Lowpan_CompressAddr(&hdr->dstAddr, lowpanLink[link].peerIid, &ptr);
+    }
+
+    if(headLength != 0u)
+    {
+        srcPort = ((uint16)((uint16)head[0u] << 8u)) | head[1u];
+        dstPort = ((uint16)((uint16)head[2u] << 8u)) | head[3u];
+        if(((srcPort & 0xFFF0u) == LOWPAN_UDP_PORT_SHORT_BASE) && ((dstPort & 0xFFF0u) == LOWPAN_UDP_PORT_SHORT_BASE))
+        {
+            *ptr++ = LOWPAN_NHC_UDP | LOWPAN_NHC_UDP_PORTS_4;
+            *ptr++ = (uint8)((uint8)(head[1u] << 4u) | (head[3u] & 0x0Fu));
+        }
+        else if((dstPort & 0xFF00u) == LOWPAN_UDP_PORT_8BIT_BASE)
+        {
+            *ptr++ = LOWPAN_NHC_UDP | LOWPAN_NHC_UDP_PORTS_DST8;
+            *ptr++ = head[0u];
+            *ptr++ = head[1u];
+            *ptr++ = head[3u];
+        }
+        else if((srcPort & 0xFF00u) == LOWPAN_UDP_PORT_8BIT_BASE)
+        {
+            *ptr++ = LOWPAN_NHC_UDP | LOWPAN_NHC_UDP_PORTS_SRC8;
+            *ptr++ = head[1u];
+            *ptr++ = head[2u];
+            *ptr++ = head[3u];
+        }
+        else
+        {
+            *ptr++ = LOWPAN_NHC_UDP | LOWPAN_NHC_UDP_PORTS_FULL;
+            (void)memcpy(ptr, head, 4u);
+            ptr += 4u;
+        }
+        *ptr++ = head[LOWPAN_UDP_CHECKSUM_INDX];
+        *ptr++ = head[LOWPAN_UDP_CHECKSUM_INDX + 1u];
+    }
+    else
+    {
+        /* The upper-layer header is in the payload */
+    }
+    header[0u] = iphc0;
+    header[1u] = iphc1;
+    headerLength = (uint16)(ptr - header);
+
+    if((((uint32)headerLength + pkt->length) > CYBLE_L2CAP_MTU) ||
+       (((uint32)headerLength + pkt->length) > lowpanLink[link].peerMtu))
+    {
+        apiResult = CYBLE_ERROR_INVALID_PARAMETER;
+    }
+    else
+    {
+        /* Headroom holds the longest header, only the header is copied */
+        pkt->offset -= headerLength;
+        pkt->length += headerLength;
+        (void)memcpy(LOWPAN_PKT_PAYLOAD(pkt), header, headerLength);
+
+        apiResult = Lowpan_Transmit(link, pkt);
+
+        /* Payload is left as it was for the caller */
+        pkt->offset += headerLength;
+        pkt->length -= headerLength;
+    }
+
+    return(apiResult);
+}
+
+
+/* [] END OF FILE */
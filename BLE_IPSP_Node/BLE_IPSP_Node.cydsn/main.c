@@ -5,12 +5,14 @@
 *
 * Description:
 *  This example demonstrates how to setup an IPv6 communication infrastructure 
-*  between two devices over a BLE transport using L2CAP channel. Creation 
-*  and transmission of IPv6 packets over BLE is not part of this example.
+*  between two devices over a BLE transport using L2CAP channel. IPv6 packets
+*  are carried over the channel with 6LoWPAN header compression (lowpan.c).
 *
-*  Router sends generated packets with different content to Node in the loop 
-*  and validate them with the afterwards received data packet. Node simply wraps
-*  received data coming from Node, back to the Router.
+*  Router sends UDP datagrams with different content to the Node echo port in
+*  the loop and validate them with the afterwards received datagram. Node sends
+*  every datagram received on the echo port back to its source and answers
+*  ICMPv6 echo requests, so it can also be pinged from the Linux 6LoWPAN
+*  interface.
 *
 * Note:
 *
@@ -31,14 +33,44 @@ uint16 connIntv = CYBLE_GAPP_CONNECTION_INTERVAL_MIN;   /* in milliseconds / 1.2
 bool l2capConnected = false;
 bool l2capReadReceived = false;
 
-uint8 ipv6LoopbackBuffer[L2CAP_MAX_LEN];
-uint16 ipv6LoopbackLength = L2CAP_MAX_LEN; 
+/* Datagram received on the echo port and its source */
+static LOWPAN_PKT_T *udpEchoPkt = NULL;
+static LOWPAN_IPV6_ADDR_T udpEchoAddr;
+static uint16 udpEchoPort;
 
 
 /* L2CAP Channel ID and parameters for the peer device */
 CYBLE_L2CAP_CBFC_CONN_IND_PARAM_T l2capParameters;
 
 
+/*******************************************************************************
+* Function Name: UdpEchoCallBack()
+********************************************************************************
+*
+* Summary:
+*  Receives the datagrams sent to the echo port. The packet is kept and sent 
+*  back from the main loop without copying the payload.
+*
+* Parameters:
+*  info - the datagram addresses and ports
+*  pkt - the received packet
+*
+*******************************************************************************/
+static void UdpEchoCallBack(const LOWPAN_UDP_INFO_T *info, LOWPAN_PKT_T *pkt)
+{
+    if(udpEchoPkt != NULL)
+    {
+        /* Previous datagram was not sent yet */
+        Lowpan_PktFree(udpEchoPkt);
+    }
+    Lowpan_PktRef(pkt);
+    udpEchoPkt = pkt;
+    udpEchoAddr = info->srcAddr;
+    udpEchoPort = info->srcPort;
+    l2capReadReceived = true;
+}
+
+
 /*******************************************************************************
 * Function Name: AppCallBack()
 ********************************************************************************
@@ -76,6 +108,8 @@ void AppCallBack(uint32 event, void* eventParam)
             {
                 DBG_PRINTF("CyBle_L2capCbfcRegisterPsm API Error: %d \r\n", apiResult);
             }
+            Lowpan_Start();
+            (void)Lowpan_UdpBind(UDP_ECHO_PORT, UdpEchoCallBack);
 
             /* Enter into discoverable mode so that remote can search it. */
             apiResult = CyBle_GappStartAdvertisement(CYBLE_ADVERTISING_FAST);
@@ -105,6 +139,11 @@ void AppCallBack(uint32 event, void* eventParam)
         #if(DEBUG_UART_FULL)
             DBG_PRINTF("CYBLE_EVT_STACK_BUSY_STATUS: %x\r\n", CyBle_GattGetBusyStatus());
         #endif /* DEBUG_UART_FULL */
+            if(CyBle_GattGetBusyStatus() == CYBLE_STACK_STATE_FREE)
+            {
+                /* The stack has buffers again, send the queued SDUs */
+                Lowpan_TxReady();
+            }
             break;
             
         /**********************************************************
@@ -211,10 +250,12 @@ void AppCallBack(uint32 event, void* eventParam)
                 CYBLE_L2CAP_CBFC_CONNECT_PARAM_T connParam;
                 connParam.mtu    = CYBLE_L2CAP_MTU;
                 connParam.mps    = CYBLE_L2CAP_MPS;
-                connParam.credit = LE_DATA_CREDITS_IPSP;
+                connParam.credit = Lowpan_GetRxCredits();
                 apiResult = CyBle_L2capCbfcConnectRsp(l2capParameters.lCid,
                                 CYBLE_L2CAP_CONNECTION_SUCCESSFUL, &connParam);
                 DBG_PRINTF("SUCCESSFUL \r\n"); 
+                (void)Lowpan_LinkOpen(l2capParameters.bdHandle, l2capParameters.lCid, connParam.credit,
+                                      &l2capParameters.connParam);
                 l2capConnected = true;
             }
             else
@@ -231,6 +272,7 @@ void AppCallBack(uint32 event, void* eventParam)
 
         case CYBLE_EVT_L2CAP_CBFC_DISCONN_IND:
             DBG_PRINTF("CYBLE_EVT_L2CAP_CBFC_DISCONN_IND: lCid=%d \r\n", *(uint16 *)eventParam);
+            Lowpan_LinkClose(*(uint16 *)eventParam);
             l2capConnected = false;
             break;
 
@@ -250,17 +292,11 @@ void AppCallBack(uint32 event, void* eventParam)
                 }
             #endif /* DEBUG_UART_FULL */
                 DBG_PRINTF("\r\n");
-                /* Data is received from Router. Copy the data to a memory buffer */
-                if(rxDataParam->rxDataLength <= L2CAP_MAX_LEN)
+                /* IPv6 packet is received from Router */
+                if(rxDataParam->result == CYBLE_L2CAP_RESULT_SUCCESS)
                 {
-                    ipv6LoopbackLength = rxDataParam->rxDataLength;
+                    Lowpan_Receive(rxDataParam->lCid, rxDataParam->rxData, rxDataParam->rxDataLength);
                 }
-                else
-                {
-                    ipv6LoopbackLength = L2CAP_MAX_LEN;
-                }
-                memcpy(ipv6LoopbackBuffer, rxDataParam->rxData, ipv6LoopbackLength);
-                l2capReadReceived = true;
             }
             break;
 
@@ -272,22 +308,27 @@ void AppCallBack(uint32 event, void* eventParam)
                     rxCreditParam->credit);
 
                 /* This event informs that receive credits reached the low mark. 
-                 * If the device expects more data to receive, send more credits back to the peer device.
+                 * The peer gets its share of the free packet buffers back.
                  */
-                apiResult = CyBle_L2capCbfcSendFlowControlCredit(rxCreditParam->lCid, LE_DATA_CREDITS_IPSP);
-                if(apiResult != CYBLE_ERROR_OK)
-                {
-                    DBG_PRINTF("CyBle_L2capCbfcSendFlowControlCredit API Error: %d \r\n", apiResult);
-                }
+                Lowpan_RxCreditLow(rxCreditParam->lCid, rxCreditParam->credit);
             }
             break;
 
         /* Following events are required to send data */
         case CYBLE_EVT_L2CAP_CBFC_TX_CREDIT_IND:
-            DBG_PRINTF("CYBLE_EVT_L2CAP_CBFC_TX_CREDIT_IND: lCid=%d, result=%d, credit=%d \r\n", 
-                ((CYBLE_L2CAP_CBFC_LOW_TX_CREDIT_PARAM_T *)eventParam)->lCid,
-                ((CYBLE_L2CAP_CBFC_LOW_TX_CREDIT_PARAM_T *)eventParam)->result,
-                ((CYBLE_L2CAP_CBFC_LOW_TX_CREDIT_PARAM_T *)eventParam)->credit);
+            {
+                CYBLE_L2CAP_CBFC_LOW_TX_CREDIT_PARAM_T *txCreditParam = (CYBLE_L2CAP_CBFC_LOW_TX_CREDIT_PARAM_T *)eventParam;
+                DBG_PRINTF("CYBLE_EVT_L2CAP_CBFC_TX_CREDIT_IND: lCid=%d, result=%d, credit=%d \r\n", 
+                    txCreditParam->lCid,
+                    txCreditParam->result,
+                    txCreditParam->credit);
+
+                /* The peer returned credits, the queued SDUs are sent */
+                if(txCreditParam->result == CYBLE_L2CAP_RESULT_SUCCESS)
+                {
+                    Lowpan_TxCredit(txCreditParam->lCid, txCreditParam->credit);
+                }
+            }
             break;
         
         case CYBLE_EVT_L2CAP_CBFC_DATA_WRITE_IND:
@@ -299,6 +340,8 @@ void AppCallBack(uint32 event, void* eventParam)
                     writeDataParam->result);
             }
             #endif /* DEBUG_UART_FULL */
+            /* The stack has taken the SDU, the queued ones follow in the same connection event */
+            Lowpan_TxReady();
             break;
 
         /**********************************************************
@@ -524,14 +567,15 @@ int main()
 
         if((CyBle_GetState() == CYBLE_STATE_CONNECTED) && (l2capConnected == true))
         {
-            /* Keep sending the data to the router, until TX credits are over */
-            if((cyBle_busyStatus == 0u) && (l2capReadReceived == true))
+            /* Send the received datagram back to its source, it is queued while the stack is busy */
+            if(l2capReadReceived == true)
             {
                 UpdateLedState();
                 l2capReadReceived = false;
-                apiResult = CyBle_L2capChannelDataWrite(l2capParameters.bdHandle,
-                                l2capParameters.lCid, ipv6LoopbackBuffer, ipv6LoopbackLength);
-                DBG_PRINTF("-> CyBle_L2capChannelDataWrite API result: %d \r\n", apiResult);
+                apiResult = Lowpan_UdpSend(UDP_ECHO_PORT, &udpEchoAddr, udpEchoPort, udpEchoPkt);
+                Lowpan_PktFree(udpEchoPkt);
+                udpEchoPkt = NULL;
+                DBG_PRINTF("-> Lowpan_UdpSend API result: %d \r\n", apiResult);
                 UpdateLedState();
             }
         }
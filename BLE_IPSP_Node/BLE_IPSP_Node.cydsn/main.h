@@ -16,6 +16,7 @@
 
 #include <project.h>
 #include <stdio.h>
+#include "lowpan.h"
 
 #define ENABLED                     (1u)
 #define DISABLED                    (0u)
@@ -35,12 +36,17 @@
 #define LED_OFF                     (1u)
 
 /* IPSP defines */
-#define LE_DATA_CREDITS_IPSP         (1000u)
-/* Set the watermark to half of the total credits to be used */
-#define LE_WATER_MARK_IPSP           (LE_DATA_CREDITS_IPSP/2u)
+/* The credits are given by Lowpan_GetRxCredits() and returned as the packets
+* are freed, the low mark is reached when the peer cannot send the longest SDU.
+*/
+#define LE_WATER_MARK_IPSP           (LOWPAN_SDU_CREDITS)
 
 #define L2CAP_MAX_LEN                (CYBLE_L2CAP_MTU - 2u)
 
+/* UDP port of the Node echo service and of the Router test client */
+#define UDP_ECHO_PORT                (0xF0B7u)
+#define UDP_CLIENT_PORT              (0xF0B1u)
+
 
 /***************************************
 *        External Function Prototypes
@@ -0,0 +1,160 @@
+/*******************************************************************************
+* File Name: lowpan.h
+*
+* Version 1.0
+*
+* Description:
+*  Contains the function prototypes and constants of the IPv6 over BLE
+*  (RFC 7668) adaptation layer: 6LoWPAN IPHC header compression (RFC 6282),
+*  UDP, ICMPv6 echo, the table of the IPSP L2CAP channels and the credit
+*  based flow control of the channels.
+*
+********************************************************************************
+* Copyright 2016, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#if !defined(LOWPAN_H)
+#define LOWPAN_H
+
+#include <project.h>
+
+
+/***************************************
+* Conditional Compilation Parameters
+***************************************/
+#if !defined(LOWPAN_MAX_LINKS)
+    #define LOWPAN_MAX_LINKS        (1u)        /* IPSP channels open at the same time */
+#endif /* !defined(LOWPAN_MAX_LINKS) */
+
+#if !defined(LOWPAN_MAX_SOCKETS)
+    #define LOWPAN_MAX_SOCKETS      (2u)        /* Bound UDP ports */
+#endif /* !defined(LOWPAN_MAX_SOCKETS) */
+
+#if !defined(LOWPAN_PKT_COUNT)
+    #define LOWPAN_PKT_COUNT        (2u)        /* Packet buffers of the pool */
+#endif /* !defined(LOWPAN_PKT_COUNT) */
+
+#if !defined(LOWPAN_TX_QUEUE_SIZE)
+    #define LOWPAN_TX_QUEUE_SIZE    (4u)        /* SDUs waiting to be sent, per link */
+#endif /* !defined(LOWPAN_TX_QUEUE_SIZE) */
+
+
+/***************************************
+*           API Constants
+***************************************/
+#define LOWPAN_IPV6_ADDR_SIZE       (16u)
+#define LOWPAN_IID_SIZE             (8u)
+#define LOWPAN_IPV6_HEADER_SIZE     (40u)
+#define LOWPAN_UDP_HEADER_SIZE      (8u)
+
+/* IPv6 requires every link to carry 1280 byte packets, IPSP has no 6LoWPAN
+* fragmentation: the L2CAP channel segments the SDU instead.
+*/
+#define LOWPAN_IPV6_MTU             (1280u)
+#define LOWPAN_MTU                  ((CYBLE_L2CAP_MTU < LOWPAN_IPV6_MTU) ? CYBLE_L2CAP_MTU : LOWPAN_IPV6_MTU)
+#define LOWPAN_UDP_MAX_PAYLOAD      (LOWPAN_MTU - LOWPAN_IPV6_HEADER_SIZE - LOWPAN_UDP_HEADER_SIZE)
+
+#define LOWPAN_NEXT_HEADER_UDP      (17u)
+#define LOWPAN_NEXT_HEADER_ICMPV6   (58u)
+#define LOWPAN_HOP_LIMIT            (64u)
+
+/* UDP ports 0xF0B0 - 0xF0BF are compressed to 4 bits each */
+#define LOWPAN_UDP_PORT_SHORT_BASE  (0xF0B0u)
+
+#define LOWPAN_LINK_NONE            (0xFFu)
+
+/* IPHC, inline traffic class, next header and hop limit, both full addresses and UDP NHC */
+#define LOWPAN_HEADER_MAX_SIZE      (2u + 4u + 1u + 1u + (2u * LOWPAN_IPV6_ADDR_SIZE) + 7u)
+
+/* Space in front of the payload for the compressed headers */
+#define LOWPAN_PKT_HEADROOM         (LOWPAN_HEADER_MAX_SIZE)
+
+/* The SDU length field is sent in the first LE-frame of the SDU */
+#define LOWPAN_SDU_LENGTH_SIZE      (2u)
+
+/* Credits the peer spends on the longest SDU, one pool packet holds it */
+#define LOWPAN_SDU_CREDITS          (LOWPAN_CREDITS(CYBLE_L2CAP_MTU, CYBLE_L2CAP_MPS))
+
+
+/***************************************
+*        Data Types
+***************************************/
+typedef struct
+{
+    uint8 addr[LOWPAN_IPV6_ADDR_SIZE];
+} LOWPAN_IPV6_ADDR_T;
+
+/* Datagram delivered to the bound UDP port */
+typedef struct
+{
+    LOWPAN_IPV6_ADDR_T srcAddr;
+    LOWPAN_IPV6_ADDR_T dstAddr;
+    uint16 srcPort;
+    uint16 dstPort;
+    uint8  link;                    /* Link the datagram arrived on */
+} LOWPAN_UDP_INFO_T;
+
+/* Packet buffer of the pool. Received packets are handed to the upper layers
+* by reference, the headers are written into the headroom on send.
+*/
+typedef struct
+{
+    uint8  refCount;
+    uint16 offset;                  /* Payload start in the buffer */
+    uint16 length;                  /* Payload length */
+    uint8  buffer[LOWPAN_PKT_HEADROOM + CYBLE_L2CAP_MTU];
+} LOWPAN_PKT_T;
+
+/* The packet is valid until return, call Lowpan_PktRef() to keep it */
+typedef void (* LOWPAN_UDP_CALLBACK_T)(const LOWPAN_UDP_INFO_T *info, LOWPAN_PKT_T *pkt);
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+void Lowpan_Start(void);
+uint8 Lowpan_LinkOpen(uint8 bdHandle, uint16 lCid, uint16 rxCredits,
+                      const CYBLE_L2CAP_CBFC_CONNECT_PARAM_T *peerParam);
+void Lowpan_LinkClose(uint16 lCid);
+void Lowpan_DeviceClose(uint8 bdHandle);
+#if (LOWPAN_MAX_LINKS > 1u)
+uint8 Lowpan_FindDevice(const CYBLE_GAP_BD_ADDR_T *bdAddr);
+#endif /* (LOWPAN_MAX_LINKS > 1u) */
+uint8 Lowpan_GetLinkCount(void);
+uint32 Lowpan_GetPeerAddr(uint8 link, LOWPAN_IPV6_ADDR_T *addr);
+void Lowpan_GetLocalAddr(LOWPAN_IPV6_ADDR_T *addr);
+void Lowpan_Receive(uint16 lCid, const uint8 data[], uint16 length);
+uint16 Lowpan_GetRxCredits(void);
+void Lowpan_RxCreditLow(uint16 lCid, uint16 credit);
+void Lowpan_TxCredit(uint16 lCid, uint16 credit);
+void Lowpan_TxReady(void);
+
+CYBLE_API_RESULT_T Lowpan_UdpBind(uint16 port, LOWPAN_UDP_CALLBACK_T callback);
+void Lowpan_UdpClose(uint16 port);
+CYBLE_API_RESULT_T Lowpan_UdpSend(uint16 srcPort, const LOWPAN_IPV6_ADDR_T *dstAddr, uint16 dstPort,
+                                  LOWPAN_PKT_T *pkt);
+CYBLE_API_RESULT_T Lowpan_UdpSendTo(uint16 srcPort, const LOWPAN_IPV6_ADDR_T *dstAddr, uint16 dstPort,
+                                    const uint8 data[], uint16 length);
+
+LOWPAN_PKT_T *Lowpan_PktAlloc(void);
+void Lowpan_PktRef(LOWPAN_PKT_T *pkt);
+void Lowpan_PktFree(LOWPAN_PKT_T *pkt);
+uint8 Lowpan_GetFreePktCount(void);
+
+
+/***************************************
+*        Macros
+***************************************/
+#define LOWPAN_PKT_PAYLOAD(pkt)     (&(pkt)->buffer[(pkt)->offset])
+
+/* LE-frames of the SDU, each one takes a credit */
+#define LOWPAN_CREDITS(length, mps) \
+    ((uint16)(((uint32)(length) + LOWPAN_SDU_LENGTH_SIZE + (mps) - 1u) / (mps)))
+
+#endif /* !defined(LOWPAN_H) */
+
+
+/* [] END OF FILE */
@@ -4,12 +4,17 @@
 * Version: 1.0
 *
 *  This example demonstrates how to setup an IPv6 communication infrastructure 
-*  between two devices over a BLE transport using L2CAP channel. Creation 
-*  and transmission of IPv6 packets over BLE is not part of this example.
+*  between two devices over a BLE transport using L2CAP channel. IPv6 packets
+*  are carried over the channel with 6LoWPAN header compression (lowpan.c).
 *
-*  Router sends generated packets with different content to Node in the loop 
-*  and validate them with the afterwards received data packet. Node simply wraps
-*  received data coming from the Node, back to the Router.
+*  Router connects the Node advertising IPSS on its own, up to
+*  ROUTER_MAX_NODES of them. It does not forward the packets between the
+*  Nodes: the PSoC 4 BLE stack keeps a single connection and the Nodes have
+*  the link-local addresses only.
+*
+*  Router sends UDP datagrams with different content to the Node echo port in
+*  the loop and validate them with the afterwards received datagram. Node sends
+*  every datagram received on the echo port back to its source.
 *
 * Note:
 *
@@ -37,7 +42,9 @@ uint8 deviceN = 0u;
 
 uint8 state = STATE_INIT;
 
-static uint16 ipv6LoopbackBuffer[L2CAP_MAX_LEN/2];
+static uint16 udpTestFirst;                 /* First counter value of the datagram sent */
+static uint8 ipspLink = LOWPAN_LINK_NONE;
+static uint16 ipspRxCredits;                /* Credits given in the connection request */
 
 uint8 custom_command = 0u;
 
@@ -86,6 +93,44 @@ uint32 CheckAdvPacketForServiceUuid(CYBLE_GAPC_ADV_REPORT_T *eventParam, uint16
 }
 
 
+/*******************************************************************************
+* Function Name: UdpTestCallBack()
+********************************************************************************
+*
+* Summary:
+*  Receives the datagrams echoed by Node to the test client port and 
+*  validates the counter pattern in the received packet.
+*
+* Parameters:
+*  info - the datagram addresses and ports
+*  pkt - the received packet
+*
+*******************************************************************************/
+static void UdpTestCallBack(const LOWPAN_UDP_INFO_T *info, LOWPAN_PKT_T *pkt)
+{
+    const uint8 *data = LOWPAN_PKT_PAYLOAD(pkt);
+    uint16 counter = udpTestFirst;
+    uint16 i = 0u;
+
+    if((info->srcPort == UDP_ECHO_PORT) && (pkt->length == UDP_TEST_DATA_LEN))
+    {
+        for(i = 0u; (i < UDP_TEST_DATA_LEN) && (CyBle_Get16ByPtr(&data[i]) == counter); i += 2u)
+        {
+            counter++;
+        }
+    }
+    if(i != UDP_TEST_DATA_LEN)
+    {
+        DBG_PRINTF("Wraparound failed \r\n");
+    }
+    else
+    {
+        /* Send new datagram to Node though IPSP channel */
+        custom_command = '1';
+    }
+}
+
+
 /*******************************************************************************
 * Function Name: AppCallBack()
 ********************************************************************************
@@ -105,12 +150,14 @@ uint32 CheckAdvPacketForServiceUuid(CYBLE_GAPC_ADV_REPORT_T *eventParam, uint16
 * IPSP protocol multiplexer for L2CAP is registered and the initial Receive 
 * Credit Low Mark for Based Flow Control mode is set after CYBLE_EVT_STACK_ON
 * event.
+* Every device that advertises IPSS is connected automatically while there is
+* a free link, the 'z' and 'c' commands connect the selected device.
 * When GAP connection is established, after CYBLE_EVT_GATT_CONNECT_IND event, 
 * Router automatically initiates an L2CAP LE credit based connection with a PSM
 * set to LE_PSM_IPSP.
-* Use '1' command to generate and send first Data packet to Node though IPSP 
+* Use '1' command to generate and send first UDP datagram to Node though IPSP 
 * channel. Sent data will be compared with the received data in response packed 
-* after CYBLE_EVT_L2CAP_CBFC_DATA_READ event. When no failure observed, new 
+* in UdpTestCallBack(). When no failure observed, new 
 * packed will be generated and send to Node. Otherwise transfer will be stopped
 * and "Wraparound failed" message will indicate failure.
 *
@@ -137,6 +184,8 @@ void AppCallback(uint32 event, void* eventParam)
             {
                 DBG_PRINTF("CyBle_L2capCbfcRegisterPsm API Error: %d \r\n", apiResult);
             }
+            Lowpan_Start();
+            (void)Lowpan_UdpBind(UDP_CLIENT_PORT, UdpTestCallBack);
             
             /* Start Limited Discovery */
             apiResult = CyBle_GapcStartScan(CYBLE_SCANNING_FAST);                   
@@ -169,6 +218,11 @@ void AppCallback(uint32 event, void* eventParam)
         #if(DEBUG_UART_FULL)  
             DBG_PRINTF("CYBLE_EVT_STACK_BUSY_STATUS: %x\r\n", CyBle_GattGetBusyStatus());
         #endif /* DEBUG_UART_FULL */
+            if(CyBle_GattGetBusyStatus() == CYBLE_STACK_STATE_FREE)
+            {
+                /* The stack has buffers again, send the queued SDUs */
+                Lowpan_TxReady();
+            }
             break;
             
         /**********************************************************
@@ -203,6 +257,13 @@ void AppCallback(uint32 event, void* eventParam)
                         advDevices++;
                     }
                 }
+                /* Connect the new node while there is a free link */
+                if((i < advDevices) && (state != STATE_CONNECTING) && (ROUTER_CAN_CONNECT(&peerAddr[i]) != 0u))
+                {
+                    deviceN = (uint8)i;
+                    state = STATE_CONNECTING;
+                    CyBle_GapcStopScan();
+                }
                 for(i = CYBLE_GAP_BD_ADDR_SIZE; i > 0u; i--)
                 {
                     DBG_PRINTF("%2.2x", advReport->peerBdAddr[i-1]);
@@ -230,6 +291,13 @@ void AppCallback(uint32 event, void* eventParam)
                     if(apiResult != CYBLE_ERROR_OK)
                     {
                         DBG_PRINTF("ConnectDevice API Error: %x \r\n", apiResult);
+                        /* No connection is coming, look for the node again */
+                        state = STATE_DISCONNECTED;
+                        apiResult = CyBle_GapcStartScan(CYBLE_SCANNING_FAST);
+                        if(apiResult != CYBLE_ERROR_OK)
+                        {
+                            DBG_PRINTF("StartScan API Error: %xd \r\n", apiResult);
+                        }
                     }
                 }
                 else
@@ -290,6 +358,8 @@ void AppCallback(uint32 event, void* eventParam)
             break;
         case CYBLE_EVT_GAP_DEVICE_DISCONNECTED:
             DBG_PRINTF("CYBLE_EVT_GAP_DEVICE_DISCONNECTED: %x\r\n", *(uint8 *)eventParam);
+            Lowpan_DeviceClose(cyBle_connHandle.bdHandle);
+            state = STATE_DISCONNECTED;
             apiResult = CyBle_GapcStartScan(CYBLE_SCANNING_FAST);                   /* Start Limited Discovery */
             if(apiResult != CYBLE_ERROR_OK)
             {
@@ -316,8 +386,10 @@ void AppCallback(uint32 event, void* eventParam)
                 {
                     CYBLE_L2CAP_MTU,         /* MTU size of this device */
                     CYBLE_L2CAP_MPS,         /* MPS size of this device */
-                    LE_DATA_CREDITS_IPSP     /* Initial Credits given to peer device for Tx */
+                    0u                       /* Initial Credits given to peer device for Tx */
                 };
+                ipspRxCredits = Lowpan_GetRxCredits();
+                cbfcConnParameters.credit = ipspRxCredits;
                 apiResult = CyBle_L2capCbfcConnectReq(cyBle_connHandle.bdHandle, CYBLE_L2CAP_PSM_LE_PSM_IPSP, 
                                       CYBLE_L2CAP_PSM_LE_PSM_IPSP, &cbfcConnParameters);
                 if(apiResult != CYBLE_ERROR_OK)
@@ -353,11 +425,30 @@ void AppCallback(uint32 event, void* eventParam)
                 l2capParameters.connParam.mtu,
                 l2capParameters.connParam.mps,
                 l2capParameters.connParam.credit);
-            l2capConnected = true;
+            if(l2capParameters.response == CYBLE_L2CAP_CONNECTION_SUCCESSFUL)
+            {
+                ipspLink = Lowpan_LinkOpen(l2capParameters.bdHandle, l2capParameters.lCid, ipspRxCredits,
+                                           &l2capParameters.connParam);
+                l2capConnected = true;
+                state = STATE_CONNECTED;
+            #if (ROUTER_MAX_NODES > 1u)
+                if(Lowpan_GetLinkCount() < ROUTER_MAX_NODES)
+                {
+                    /* Look for more nodes */
+                    apiResult = CyBle_GapcStartScan(CYBLE_SCANNING_FAST);
+                    if(apiResult != CYBLE_ERROR_OK)
+                    {
+                        DBG_PRINTF("StartScan API Error: %xd \r\n", apiResult);
+                    }
+                }
+            #endif /* (ROUTER_MAX_NODES > 1u) */
+            }
             break;
 
         case CYBLE_EVT_L2CAP_CBFC_DISCONN_IND:
             DBG_PRINTF("CYBLE_EVT_L2CAP_CBFC_DISCONN_IND: %d \r\n", *(uint16 *)eventParam);
+            Lowpan_LinkClose(*(uint16 *)eventParam);
+            ipspLink = LOWPAN_LINK_NONE;
             l2capConnected = false;
             break;
 
@@ -377,15 +468,10 @@ void AppCallback(uint32 event, void* eventParam)
                 }
             #endif /* DEBUG_UART_FULL */
                 DBG_PRINTF("\r\n");
-                /* Data is received from Node, validate the content */
-                if(memcmp(((uint8 *)ipv6LoopbackBuffer), rxDataParam->rxData, L2CAP_MAX_LEN) != 0u)
-                {
-                    DBG_PRINTF("Wraparound failed \r\n");
-                }
-                else
+                /* IPv6 packet is received from Node, the datagram is validated in UdpTestCallBack() */
+                if(rxDataParam->result == CYBLE_L2CAP_RESULT_SUCCESS)
                 {
-                    /* Send new Data packet to Node though IPSP channel  */
-                    custom_command = '1';
+                    Lowpan_Receive(rxDataParam->lCid, rxDataParam->rxData, rxDataParam->rxDataLength);
                 }
             }
             break;
@@ -397,23 +483,28 @@ void AppCallback(uint32 event, void* eventParam)
                     rxCreditParam->lCid,
                     rxCreditParam->credit);
 
-                /* This event informs that receive credits reached low mark. 
-                 * If the device expects more data to receive, send more credits back to the peer device.
+                /* This event informs that receive credits reached the low mark. 
+                 * The peer gets its share of the free packet buffers back.
                  */
-                apiResult = CyBle_L2capCbfcSendFlowControlCredit(rxCreditParam->lCid, LE_DATA_CREDITS_IPSP);
-                if(apiResult != CYBLE_ERROR_OK)
-                {
-                    DBG_PRINTF("CyBle_L2capCbfcSendFlowControlCredit API Error: %d \r\n", apiResult);
-                }
+                Lowpan_RxCreditLow(rxCreditParam->lCid, rxCreditParam->credit);
             }
             break;
 
         /* Following events are required, to send data */
         case CYBLE_EVT_L2CAP_CBFC_TX_CREDIT_IND:
-            DBG_PRINTF("CYBLE_EVT_L2CAP_CBFC_TX_CREDIT_IND: lCid=%d, result=%d, credit=%d \r\n", 
-                ((CYBLE_L2CAP_CBFC_LOW_TX_CREDIT_PARAM_T *)eventParam)->lCid,
-                ((CYBLE_L2CAP_CBFC_LOW_TX_CREDIT_PARAM_T *)eventParam)->result,
-                ((CYBLE_L2CAP_CBFC_LOW_TX_CREDIT_PARAM_T *)eventParam)->credit);
+            {
+                CYBLE_L2CAP_CBFC_LOW_TX_CREDIT_PARAM_T *txCreditParam = (CYBLE_L2CAP_CBFC_LOW_TX_CREDIT_PARAM_T *)eventParam;
+                DBG_PRINTF("CYBLE_EVT_L2CAP_CBFC_TX_CREDIT_IND: lCid=%d, result=%d, credit=%d \r\n", 
+                    txCreditParam->lCid,
+                    txCreditParam->result,
+                    txCreditParam->credit);
+
+                /* The peer returned credits, the queued SDUs are sent */
+                if(txCreditParam->result == CYBLE_L2CAP_RESULT_SUCCESS)
+                {
+                    Lowpan_TxCredit(txCreditParam->lCid, txCreditParam->credit);
+                }
+            }
             break;
         
         case CYBLE_EVT_L2CAP_CBFC_DATA_WRITE_IND:
@@ -423,6 +514,8 @@ void AppCallback(uint32 event, void* eventParam)
                 DBG_PRINTF("CYBLE_EVT_L2CAP_CBFC_DATA_WRITE_IND: lCid=%d \r\n", writeDataParam->lCid);
             }
             #endif /* DEBUG_UART_FULL */
+            /* The stack has taken the SDU, the queued ones follow in the same connection event */
+            Lowpan_TxReady();
             break;
             
         /**********************************************************
@@ -652,7 +745,7 @@ int main()
         /* To achieve low power in the device */
         LowPowerImplementation();
         
-        if(((command = UART_DEB_UartGetChar()) != 0) || ((custom_command != 0) && (cyBle_busyStatus == 0u)))
+        if(((command = UART_DEB_UartGetChar()) != 0) || (custom_command != 0))
         {
             if(custom_command != 0u)
             {
@@ -701,30 +794,46 @@ int main()
                     /**********************************************************
                     *               L2Cap Commands (WrapAround)
                     ***********************************************************/
-                case '1':                   /* Send Data packet to node though IPSP channel */
+                case '1':                   /* Send UDP datagram to node though IPSP channel */
                     {
                         static uint16 counter = 0;
                         static uint16 repeats = 0;
+                        LOWPAN_IPV6_ADDR_T nodeAddr;
+                        LOWPAN_PKT_T *pkt;
                         uint16 i;
                         
-                        DBG_PRINTF("-> CyBle_L2capChannelDataWrite #%d \r\n", repeats++);
+                        if(Lowpan_GetPeerAddr(ipspLink, &nodeAddr) == 0u)
+                        {
+                            DBG_PRINTF("IPSP channel is not connected \r\n");
+                            break;
+                        }
+                        pkt = Lowpan_PktAlloc();
+                        if(pkt == NULL)
+                        {
+                            DBG_PRINTF("No free packet \r\n");
+                            break;
+                        }
+                        DBG_PRINTF("-> Lowpan_UdpSend #%d \r\n", repeats++);
                         (void)repeats;
                     #if(DEBUG_UART_FULL)  
                         DBG_PRINTF(", Data:");
                     #endif /* DEBUG_UART_FULL */
-                        /* Fill output buffer by counter */
-                        for(i = 0u; i < L2CAP_MAX_LEN / 2u; i++)
+                        /* Fill the packet payload by counter */
+                        udpTestFirst = counter;
+                        for(i = 0u; i < UDP_TEST_DATA_LEN; i += 2u)
                         {
-                            ipv6LoopbackBuffer[i] = counter++;
+                            CyBle_Set16ByPtr(&LOWPAN_PKT_PAYLOAD(pkt)[i], counter);
                         #if(DEBUG_UART_FULL)  
-                            DBG_PRINTF("%4.4x", ipv6LoopbackBuffer[i]);
+                            DBG_PRINTF("%4.4x", counter);
                         #endif /* DEBUG_UART_FULL */
+                            counter++;
                         }
-                        apiResult = CyBle_L2capChannelDataWrite(cyBle_connHandle.bdHandle,
-                                        l2capParameters.lCid, (uint8 *)ipv6LoopbackBuffer, L2CAP_MAX_LEN);
+                        pkt->length = UDP_TEST_DATA_LEN;
+                        apiResult = Lowpan_UdpSend(UDP_CLIENT_PORT, &nodeAddr, UDP_ECHO_PORT, pkt);
+                        Lowpan_PktFree(pkt);
                         if(apiResult != CYBLE_ERROR_OK)
                         {
-                            DBG_PRINTF("CyBle_L2capChannelDataWrite API Error: %x \r\n", apiResult);
+                            DBG_PRINTF("Lowpan_UdpSend API Error: %x \r\n", apiResult);
                         }
                     }
                     break;
@@ -737,7 +846,7 @@ int main()
                     DBG_PRINTF(" \'d\' - Send disconnect request to peer device.\r\n");
                     DBG_PRINTF(" \'v\' - Cancel connection request.\r\n");
                     DBG_PRINTF(" \'s\' - Start discovery procedure.\r\n");
-                    DBG_PRINTF(" \'1\' - Send Data packet to Node though IPSP channel.\r\n");
+                    DBG_PRINTF(" \'1\' - Send UDP datagram to Node though IPSP channel.\r\n");
                     break;
             }
         }
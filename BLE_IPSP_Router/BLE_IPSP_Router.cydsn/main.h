@@ -26,6 +26,16 @@
 #define DEBUG_UART_ENABLED          ENABLED
 #define DEBUG_UART_FULL             DISABLED
 
+/* Nodes served at the same time, each one over its own connection. The PSoC 4
+* BLE stack keeps a single connection (cyBle_connHandle), so the Router serves
+* one Node. Raising the value needs a stack with more connections, and the
+* forwarding between the Nodes needs a routable prefix as well.
+*/
+#define ROUTER_MAX_NODES            (1u)
+#define LOWPAN_MAX_LINKS            ROUTER_MAX_NODES
+
+#include "lowpan.h"
+
 
 /***************************************
 *           API Constants
@@ -43,12 +53,18 @@
 #define STATE_CONNECTED              3u
 
 /* IPSP defines */
-#define LE_DATA_CREDITS_IPSP         (1000u)
-/* Set the watermark to half of the total credits to be used */
-#define LE_WATER_MARK_IPSP           (LE_DATA_CREDITS_IPSP/2u)
+/* The credits are given by Lowpan_GetRxCredits() and returned as the packets
+* are freed, the low mark is reached when the peer cannot send the longest SDU.
+*/
+#define LE_WATER_MARK_IPSP           (LOWPAN_SDU_CREDITS)
 
 #define L2CAP_MAX_LEN                (CYBLE_L2CAP_MTU - 2u)
 
+/* UDP port of the Node echo service and of the Router test client */
+#define UDP_ECHO_PORT                (0xF0B7u)
+#define UDP_CLIENT_PORT              (0xF0B1u)
+#define UDP_TEST_DATA_LEN            (LOWPAN_UDP_MAX_PAYLOAD & ~1u)
+
 
 /***************************************
 *        External Function Prototypes
@@ -68,5 +84,13 @@ void UpdateLedState(void);
     #define DBG_PRINTF(...)
 #endif /* (DEBUG_UART_ENABLED == ENABLED) */
 
+/* The advertising node is connected while a link is free, every node once */
+#if (ROUTER_MAX_NODES > 1u)
+    #define ROUTER_CAN_CONNECT(bdAddr)  ((uint32)((Lowpan_GetLinkCount() < ROUTER_MAX_NODES) && \
+                                         (Lowpan_FindDevice(bdAddr) == LOWPAN_LINK_NONE)))
+#else
+    #define ROUTER_CAN_CONNECT(bdAddr)  ((uint32)(Lowpan_GetLinkCount() == 0u))
+#endif /* (ROUTER_MAX_NODES > 1u) */
+
 
 /* [] END OF FILE */
@@ -0,0 +1,538 @@
+/*******************************************************************************
+* File Name: emi_spi_nor.c
+*
+* Version: 1.50
+*
+* Description:
+*  Provides the external memory backend for the SPI NOR flash parts on the
+*  EMI_SPIM component. The command and data bytes are moved by polling the
+*  SPI FIFOs; the page program and sector erase cycles are polled from
+*  EMI_BackendProcess() without blocking. The polling is timed by the SysTick,
+*  which runs free, without the interrupt.
+*
+* Hardware Dependency:
+*  CY8CKIT-042 BLE
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#include "emi_backend.h"
+#include <project.h>
+
+#if (EMI_BACKEND == EMI_BACKEND_SPI_NOR)
+
+#define EMI_SPI_FIFO_DEPTH                  (8u)
+#define EMI_SPI_DUMMY_BYTE                  (0xFFu)
+#define EMI_SPI_CMD_SIZE                    (1u)
+#define EMI_SPI_CS_ACTIVE                   (0u)
+#define EMI_SPI_CS_INACTIVE                 (1u)
+
+#define EMI_XFER_STATE_READ                 (3u)    /* Data read, completed at once */
+
+/* State of the operation in flight */
+static uint8 *emiXferBuffer;
+static uint32 emiXferAddr;
+static uint32 emiXferOffset;
+static uint32 emiXferSize;
+static uint32 emiXferChunkSize;
+static uint32 emiXferState = EMI_XFER_STATE_IDLE;
+
+/* Time of the erase or program cycle in SYSCLK cycles */
+static uint32 emiXferMark;
+static uint32 emiXferElapsed;
+static uint32 emiXferTimeout;
+
+static void     EMI_SpiTransfer(const uint8 txData[], uint8 rxData[], uint32 size);
+static void     EMI_SpiCommand(const uint8 txData[], uint32 size);
+static void     EMI_SpiSetAddr(uint8 buffer[], uint8 cmd, uint32 dataAddr);
+static uint8    EMI_SpiReadStatus(void);
+static void     EMI_SpiStartCycle(uint32 state, uint32 timeoutMs);
+static uint32   EMI_SpiCycleTimedOut(void);
+static void     EMI_SpiEraseSector(uint32 dataAddr);
+static cystatus EMI_SpiProgramChunk(void);
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendStart
+********************************************************************************
+*
+* Summary:
+*  Starts the SPI master and wakes the memory from the deep power-down mode.
+*  Starts the SysTick as the free running SYSCLK counter; the transfer
+*  statistics use it the same way.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*******************************************************************************/
+void EMI_BackendStart(void)
+{
+    uint8 cmd = EMI_SPI_NOR_CMD_RELEASE_POWER_DOWN;
+
+    CySysTickSetClockSource(CY_SYS_SYST_CSR_CLK_SRC_SYSCLK);
+    CySysTickSetReload(EMI_SPI_NOR_SYSTICK_MASK);
+    CySysTickClear();
+    CySysTickEnable();
+    CySysTickDisableInterrupt();
+
+    EMI_CS_Write(EMI_SPI_CS_INACTIVE);
+    EMI_SPIM_Start();
+
+    EMI_SpiCommand(&cmd, EMI_SPI_CMD_SIZE);
+
+    emiXferState = EMI_XFER_STATE_IDLE;
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_SpiTransfer
+********************************************************************************
+*
+* Summary:
+*  Moves the bytes over the SPI bus while the chip select is active. The TX
+*  FIFO is kept full, but never ahead of the RX FIFO by more than its depth.
+*
+* Parameters:
+*  const uint8 txData[]: Bytes to send, or NULL to send the dummy bytes.
+*  uint8 rxData[]:       Buffer for the received bytes, or NULL.
+*  uint32 size:          Number of the bytes.
+*
+* Return:
+*  None
+*******************************************************************************/
+static void EMI_SpiTransfer(const uint8 txData[], uint8 rxData[], uint32 size)
+{
+    uint32 txCount = 0u;
+    uint32 rxCount = 0u;
+    uint32 rxByte;
+
+    while (rxCount < size)
+    {
+        if ((txCount < size) && ((txCount - rxCount) < EMI_SPI_FIFO_DEPTH))
+        {
+            EMI_SPIM_SpiUartWriteTxData((NULL != txData) ? txData[txCount] : EMI_SPI_DUMMY_BYTE);
+            txCount++;
+        }
+
+        if (0u != EMI_SPIM_SpiUartGetRxBufferSize())
+        {
+            rxByte = EMI_SPIM_SpiUartReadRxData();
+            if (NULL != rxData)
+            {
+                rxData[rxCount] = (uint8) rxByte;
+            }
+            rxCount++;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_SpiCommand
+********************************************************************************
+*
+* Summary:
+*  Sends the command with its parameters in the single chip select cycle.
+*
+* Parameters:
+*  const uint8 txData[]: The command and parameters.
+*  uint32 size:          Number of the bytes.
+*
+* Return:
+*  None
+*******************************************************************************/
+static void EMI_SpiCommand(const uint8 txData[], uint32 size)
+{
+    EMI_CS_Write(EMI_SPI_CS_ACTIVE);
+    EMI_SpiTransfer(txData, NULL, size);
+    EMI_CS_Write(EMI_SPI_CS_INACTIVE);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_SpiSetAddr
+********************************************************************************
+*
+* Summary:
+*  Places the command and the 3-byte memory address to the EMI_DATA_INDX bytes
+*  of the buffer.
+*
+* Parameters:
+*  uint8 buffer[]:  The buffer.
+*  uint8 cmd:       The command.
+*  uint32 dataAddr: The memory address.
+*
+* Return:
+*  None
+*******************************************************************************/
+static void EMI_SpiSetAddr(uint8 buffer[], uint8 cmd, uint32 dataAddr)
+{
+    buffer[EMI_CMD_INDX     ] = cmd;
+    buffer[EMI_CMD_INDX + 1u] = (uint8) (dataAddr >> 16u);
+    buffer[EMI_CMD_INDX + 2u] = (uint8) (dataAddr >> 8u);
+    buffer[EMI_CMD_INDX + 3u] = (uint8) dataAddr;
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_SpiReadStatus
+********************************************************************************
+*
+* Summary:
+*  Reads the status register of the memory.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The status register.
+*******************************************************************************/
+static uint8 EMI_SpiReadStatus(void)
+{
+    uint8 buffer[2u] = {EMI_SPI_NOR_CMD_READ_STATUS, EMI_SPI_DUMMY_BYTE};
+
+    EMI_CS_Write(EMI_SPI_CS_ACTIVE);
+    EMI_SpiTransfer(buffer, buffer, sizeof(buffer));
+    EMI_CS_Write(EMI_SPI_CS_INACTIVE);
+
+    return (buffer[1u]);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_SpiStartCycle
+********************************************************************************
+*
+* Summary:
+*  Starts timing the erase or program cycle the memory was given.
+*
+* Parameters:
+*  uint32 state:     EMI_XFER_STATE_ERASE or EMI_XFER_STATE_PROGRAM.
+*  uint32 timeoutMs: Maximum time of the cycle.
+*
+* Return:
+*  None
+*******************************************************************************/
+static void EMI_SpiStartCycle(uint32 state, uint32 timeoutMs)
+{
+    emiXferMark = CySysTickGetValue();
+    emiXferElapsed = 0u;
+    emiXferTimeout = timeoutMs * EMI_SPI_NOR_SYSCLK_PER_MS;
+    emiXferState = state;
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_SpiCycleTimedOut
+********************************************************************************
+*
+* Summary:
+*  Adds the time since the previous poll to the cycle time. The SysTick wraps
+*  in about 350 ms at 48 MHz; the polls are closer than that, a longer gap only
+*  makes the timeout later.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Non-zero if the cycle took longer than its maximum time.
+*******************************************************************************/
+static uint32 EMI_SpiCycleTimedOut(void)
+{
+    uint32 now = CySysTickGetValue();
+
+    /* SysTick counts down */
+    emiXferElapsed += (emiXferMark - now) & EMI_SPI_NOR_SYSTICK_MASK;
+    emiXferMark = now;
+
+    return ((uint32) (emiXferElapsed > emiXferTimeout));
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_SpiEraseSector
+********************************************************************************
+*
+* Summary:
+*  Starts the erase of the sector containing the address.
+*
+* Parameters:
+*  uint32 dataAddr: The memory address.
+*
+* Return:
+*  None
+*******************************************************************************/
+static void EMI_SpiEraseSector(uint32 dataAddr)
+{
+    uint8 cmd = EMI_SPI_NOR_CMD_WRITE_ENABLE;
+    uint8 erase[EMI_DATA_INDX];
+
+    EMI_SpiSetAddr(erase, EMI_SPI_NOR_CMD_SECTOR_ERASE, dataAddr - (dataAddr % EMI_ERASE_SIZE));
+
+    EMI_SpiCommand(&cmd, EMI_SPI_CMD_SIZE);
+    EMI_SpiCommand(erase, EMI_DATA_INDX);
+
+    EMI_SpiStartCycle(EMI_XFER_STATE_ERASE, EMI_SPI_NOR_ERASE_MAX_MS);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_SpiProgramChunk
+********************************************************************************
+*
+* Summary:
+*  Starts the page program of the next chunk of the operation in flight. The
+*  chunk never crosses the page boundary. The command and address bytes are
+*  placed right before the chunk data, over the bytes that were already
+*  programmed with the previous chunk, so no data is moved.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  CYRET_STARTED if the chunk is started, CYRET_SUCCESS if no data is left.
+*******************************************************************************/
+static cystatus EMI_SpiProgramChunk(void)
+{
+    cystatus status = CYRET_SUCCESS;
+    uint8  cmd = EMI_SPI_NOR_CMD_WRITE_ENABLE;
+    uint32 pageLeft = EMI_EXTERNAL_MEMORY_PAGE_SIZE - (emiXferAddr % EMI_EXTERNAL_MEMORY_PAGE_SIZE);
+
+    emiXferChunkSize = emiXferSize - emiXferOffset;
+    if (emiXferChunkSize > pageLeft)
+    {
+        emiXferChunkSize = pageLeft;
+    }
+
+    if (0u != emiXferChunkSize)
+    {
+        EMI_SpiSetAddr(&emiXferBuffer[emiXferOffset], EMI_SPI_NOR_CMD_PAGE_PROGRAM, emiXferAddr);
+
+        EMI_SpiCommand(&cmd, EMI_SPI_CMD_SIZE);
+        EMI_SpiCommand(&emiXferBuffer[emiXferOffset], emiXferChunkSize + EMI_DATA_INDX);
+
+        EMI_SpiStartCycle(EMI_XFER_STATE_PROGRAM, EMI_SPI_NOR_PROGRAM_MAX_MS);
+        status = CYRET_STARTED;
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendStartWrite
+********************************************************************************
+*
+* Summary:
+*  Starts the write of the data to the memory. The page program only clears
+*  bits, so the area must be erased before it is written, unless the same data
+*  is written again.
+*
+* Parameters:
+*  uint32 dataAddr:   The memory address.
+*  uint8 buffer[]:    EMI_DATA_INDX bytes for the command and address followed
+*                     by the data.
+*  uint32 dataSize:   Size of the data.
+*  uint32 eraseFirst: Non-zero to erase the sector containing the data first.
+*
+* Return:
+*  None
+*******************************************************************************/
+void EMI_BackendStartWrite(uint32 dataAddr, uint8 buffer[], uint32 dataSize, uint32 eraseFirst)
+{
+    emiXferBuffer    = buffer;
+    emiXferAddr      = dataAddr;
+    emiXferOffset    = 0u;
+    emiXferSize      = dataSize;
+    emiXferChunkSize = 0u;
+
+    if (0u != eraseFirst)
+    {
+        EMI_SpiEraseSector(dataAddr);
+    }
+    else if (CYRET_STARTED != EMI_SpiProgramChunk())
+    {
+        /* Nothing to write, completed on the next EMI_BackendProcess() */
+        emiXferState = EMI_XFER_STATE_READ;
+    }
+    else
+    {
+        /* Page program is started */
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendStartErase
+********************************************************************************
+*
+* Summary:
+*  Starts the erase of the sector.
+*
+* Parameters:
+*  uint32 dataAddr: The sector address.
+*
+* Return:
+*  None
+*******************************************************************************/
+void EMI_BackendStartErase(uint32 dataAddr)
+{
+    emiXferAddr      = dataAddr;
+    emiXferOffset    = 0u;
+    emiXferSize      = EMI_NO_DATA_SIZE;
+    emiXferChunkSize = 0u;
+
+    EMI_SpiEraseSector(dataAddr);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendStartRead
+********************************************************************************
+*
+* Summary:
+*  Reads the data from the memory. The read is completed before the function
+*  returns; it is reported on the next EMI_BackendProcess() call.
+*
+* Parameters:
+*  uint32 dataAddr: The memory address.
+*  uint8 buffer[]:  EMI_DATA_INDX bytes for the command and address.
+*  uint8 *data:     Buffer that receives the data.
+*  uint32 dataSize: Size of the data.
+*
+* Return:
+*  None
+*******************************************************************************/
+void EMI_BackendStartRead(uint32 dataAddr, uint8 buffer[], uint8 *data, uint32 dataSize)
+{
+    EMI_SpiSetAddr(buffer, EMI_SPI_NOR_CMD_READ, dataAddr);
+
+    EMI_CS_Write(EMI_SPI_CS_ACTIVE);
+    EMI_SpiTransfer(buffer, NULL, EMI_DATA_INDX);
+    EMI_SpiTransfer(NULL, data, dataSize);
+    EMI_CS_Write(EMI_SPI_CS_INACTIVE);
+
+    emiXferState = EMI_XFER_STATE_READ;
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendProcess
+********************************************************************************
+*
+* Summary:
+*  Advances the operation in flight. Polls the write-in-progress bit of the
+*  memory after the sector erase or page program and starts the next page
+*  program when it is cleared.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Status
+*     Value               Description
+*    CYRET_STARTED           Operation is in progress
+*    CYRET_SUCCESS           Operation completed
+*    CYRET_TIMEOUT           Memory did not complete the erase or program
+*                            within its maximum time
+*******************************************************************************/
+cystatus EMI_BackendProcess(void)
+{
+    cystatus status = CYRET_STARTED;
+
+    switch (emiXferState)
+    {
+        case EMI_XFER_STATE_ERASE:
+        case EMI_XFER_STATE_PROGRAM:
+            if (0u == (EMI_SpiReadStatus() & EMI_SPI_NOR_STATUS_WIP))
+            {
+                emiXferOffset += emiXferChunkSize;
+                emiXferAddr   += emiXferChunkSize;
+                emiXferChunkSize = 0u;
+
+                status = EMI_SpiProgramChunk();
+            }
+            else if (0u != EMI_SpiCycleTimedOut())
+            {
+                status = CYRET_TIMEOUT;
+            }
+            else
+            {
+                /* Cycle is in progress */
+            }
+            break;
+
+        case EMI_XFER_STATE_READ:
+            status = CYRET_SUCCESS;
+            break;
+
+        default:
+            status = CYRET_INVALID_STATE;
+            break;
+    }
+
+    if (CYRET_STARTED != status)
+    {
+        emiXferState = EMI_XFER_STATE_IDLE;
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendIsBusy
+********************************************************************************
+*
+* Summary:
+*  Checks whether the memory runs the erase or program cycle. The end of the
+*  cycle does not generate the interrupt, so the caller must not sleep while
+*  waiting for it: EMI_BACKEND_IRQ_WAKEUP is zero.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Non-zero while the erase or page program is in progress.
+*******************************************************************************/
+uint32 EMI_BackendIsBusy(void)
+{
+    return ((uint32) ((EMI_XFER_STATE_ERASE == emiXferState) || (EMI_XFER_STATE_PROGRAM == emiXferState)));
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendIsLastXfer
+********************************************************************************
+*
+* Summary:
+*  Checks whether the memory runs the last erase or page program of the
+*  operation. The memory completes it on its own; the read is completed
+*  before EMI_BackendStartRead() returns.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Non-zero while the last erase or page program is in progress.
+*******************************************************************************/
+uint32 EMI_BackendIsLastXfer(void)
+{
+    return (((EMI_XFER_STATE_ERASE == emiXferState) || (EMI_XFER_STATE_PROGRAM == emiXferState)) &&
+            ((emiXferOffset + emiXferChunkSize) >= emiXferSize));
+}
+
+#endif /* (EMI_BACKEND == EMI_BACKEND_SPI_NOR) */
+
+
+/* [] END OF FILE */
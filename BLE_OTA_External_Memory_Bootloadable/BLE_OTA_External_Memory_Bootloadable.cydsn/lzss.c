@@ -0,0 +1,179 @@
+/*******************************************************************************
+* File Name: lzss.c
+*
+* Version: 1.50
+*
+* Description:
+*  Provides the streaming LZSS decoder. The decoder state is kept between the
+*  calls, so the compressed data is decoded packet by packet straight into the
+*  flash row buffer.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#include "lzss.h"
+
+#if (LZSS_WINDOW_SIZE != 256u)
+    #error The window position of LZSS_DECODER_T wraps as the 8-bit value
+#endif /* (LZSS_WINDOW_SIZE != 256u) */
+
+
+/*******************************************************************************
+* Function Name: LZSS_Init
+********************************************************************************
+*
+* Summary:
+*  Prepares the decoder for the new compressed stream.
+*
+* Parameters:
+*  decoder: The decoder state.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void LZSS_Init(LZSS_DECODER_T *decoder)
+{
+    uint32 i;
+
+    for (i = 0u; i < LZSS_WINDOW_SIZE; i++)
+    {
+        decoder->window[i] = 0u;
+    }
+
+    decoder->windowPos = 0u;
+    decoder->state = LZSS_STATE_FLAGS;
+    decoder->flags = 0u;
+    decoder->items = 0u;
+    decoder->distance = 0u;
+    decoder->copyLeft = 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: LZSS_Decode
+********************************************************************************
+*
+* Summary:
+*  Decodes the compressed data until either the input is used up or the
+*  output buffer is full. The item cut by the end of the input is completed
+*  by the next call.
+*
+* Parameters:
+*  decoder: The decoder state.
+*  in:      The compressed data.
+*  inSize:  The number of bytes in the compressed data.
+*  inUsed:  Returns the number of compressed bytes consumed.
+*  out:     The buffer for the decoded data.
+*  outSize: The free space in the buffer.
+*
+* Return:
+*  The number of decoded bytes put to the buffer.
+*
+*******************************************************************************/
+uint32 LZSS_Decode(LZSS_DECODER_T *decoder, const uint8 in[], uint32 inSize, uint32 *inUsed,
+                   uint8 out[], uint32 outSize)
+{
+    uint32 inPos = 0u;
+    uint32 outPos = 0u;
+    uint8 value;
+
+    while (outPos < outSize)
+    {
+        if (LZSS_STATE_COPY == decoder->state)
+        {
+            value = decoder->window[(uint8) (decoder->windowPos - decoder->distance - 1u)];
+            decoder->window[decoder->windowPos] = value;
+            decoder->windowPos++;
+            out[outPos] = value;
+            outPos++;
+
+            decoder->copyLeft--;
+            if (0u == decoder->copyLeft)
+            {
+                decoder->state = (0u == decoder->items) ? LZSS_STATE_FLAGS : LZSS_STATE_ITEM;
+            }
+        }
+        else if (inPos < inSize)
+        {
+            value = in[inPos];
+            inPos++;
+
+            switch (decoder->state)
+            {
+            case LZSS_STATE_FLAGS:
+                decoder->flags = value;
+                decoder->items = 8u;
+                decoder->state = LZSS_STATE_ITEM;
+                break;
+
+            case LZSS_STATE_ITEM:
+                decoder->items--;
+                if (0u != (decoder->flags & 0x01u))
+                {
+                    decoder->distance = value;
+                    decoder->state = LZSS_STATE_DISTANCE;
+                }
+                else
+                {
+                    decoder->window[decoder->windowPos] = value;
+                    decoder->windowPos++;
+                    out[outPos] = value;
+                    outPos++;
+
+                    if (0u == decoder->items)
+                    {
+                        decoder->state = LZSS_STATE_FLAGS;
+                    }
+                }
+                decoder->flags >>= 1u;
+                break;
+
+            default:
+                /* LZSS_STATE_DISTANCE: the match length follows the distance */
+                decoder->copyLeft = (uint16) value + LZSS_MIN_MATCH;
+                decoder->state = LZSS_STATE_COPY;
+                break;
+            }
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    *inUsed = inPos;
+
+    return (outPos);
+}
+
+
+/*******************************************************************************
+* Function Name: LZSS_IsIdle
+********************************************************************************
+*
+* Summary:
+*  Checks that no item is cut, i.e. the stream may end at this point.
+*
+* Parameters:
+*  decoder: The decoder state.
+*
+* Return:
+*  Non-zero if the decoder is between the items.
+*
+*******************************************************************************/
+uint32 LZSS_IsIdle(const LZSS_DECODER_T *decoder)
+{
+    return ((uint32) ((LZSS_STATE_FLAGS == decoder->state) || (LZSS_STATE_ITEM == decoder->state)));
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,72 @@
+/*******************************************************************************
+* File Name: lzss.h
+*
+* Version: 1.50
+*
+* Description:
+*  Contains the function prototypes and constants of the streaming LZSS
+*  decoder used for the compressed bootloadable images.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#if !defined(LZSS_H)
+#define LZSS_H
+
+#include "cytypes.h"
+
+
+/*******************************************************************************
+* Compressed stream format. The stream is a sequence of groups: a flag byte
+* followed by up to 8 items, bit 0 of the flag byte describes the first item.
+* Flag bit 0 - literal: [1-byte value]
+* Flag bit 1 - match:   [1-byte distance - 1] [1-byte length - 3], copies
+*                       length bytes starting distance bytes back in the output.
+* The matches may refer to anything decoded since LZSS_Init() within the window,
+* so the stream can be cut into packets at any byte.
+*******************************************************************************/
+#define LZSS_WINDOW_SIZE            (256u)          /* Distance range of the matches */
+#define LZSS_MIN_MATCH              (3u)
+#define LZSS_MAX_MATCH              (LZSS_MIN_MATCH + 255u)
+
+#define LZSS_STATE_FLAGS            (0u)            /* Next byte is the flag byte    */
+#define LZSS_STATE_ITEM             (1u)            /* Next byte starts an item      */
+#define LZSS_STATE_DISTANCE         (2u)            /* Next byte is the match length */
+#define LZSS_STATE_COPY             (3u)            /* Match output is not complete  */
+
+
+/***************************************
+*        Data Types
+***************************************/
+typedef struct
+{
+    uint8  window[LZSS_WINDOW_SIZE];                /* The last decoded bytes        */
+    uint8  windowPos;                               /* Where the next byte is put    */
+    uint8  state;
+    uint8  flags;                                   /* Flags of the remaining items  */
+    uint8  items;                                   /* Items left in the group       */
+    uint8  distance;                                /* Match distance - 1            */
+    uint16 copyLeft;                                /* Match bytes not output yet    */
+} LZSS_DECODER_T;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+void   LZSS_Init(LZSS_DECODER_T *decoder);
+uint32 LZSS_Decode(LZSS_DECODER_T *decoder, const uint8 in[], uint32 inSize, uint32 *inUsed,
+                   uint8 out[], uint32 outSize);
+uint32 LZSS_IsIdle(const LZSS_DECODER_T *decoder);
+
+#endif /* !defined(LZSS_H) */
+
+
+/* [] END OF FILE */
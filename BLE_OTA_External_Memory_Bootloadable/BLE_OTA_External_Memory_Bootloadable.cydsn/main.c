@@ -169,6 +169,15 @@ void AppCallBack(uint32 event, void* eventParam)
                 apiResult = CyBle_L2capLeConnectionParamUpdateRequest(cyBle_connHandle.bdHandle, &connUpdateParam);
                 DBG_PRINTF("CyBle_L2capLeConnectionParamUpdateRequest API: 0x%2.2x \r\n", apiResult);
             }
+            #if (CYBLE_DLE_FEATURE_ENABLED)
+                if (bootloadingMode == 1u)
+                {
+                    /* Let a full bootloader packet go in a single link layer PDU */
+                    apiResult = CyBle_GapSetDataLength(cyBle_connHandle.bdHandle,
+                                    CYBLE_LL_MAX_SUPPORTED_TX_PAYLOAD_SIZE, CYBLE_LL_MAX_TX_TIME);
+                    DBG_PRINTF("CyBle_GapSetDataLength API: 0x%2.2x \r\n", apiResult);
+                }
+            #endif /* (CYBLE_DLE_FEATURE_ENABLED) */
             LED_WRITE_MACRO(LED_OFF);
             break;
         case CYBLE_EVT_GAP_DEVICE_DISCONNECTED:
@@ -185,6 +194,13 @@ void AppCallBack(uint32 event, void* eventParam)
         case CYBLE_EVT_GAPC_CONNECTION_UPDATE_COMPLETE:
             DBG_PRINTF("EVT_CONNECTION_UPDATE_COMPLETE: %x \r\n", *(uint8 *)eventParam);
             break;
+        #if (CYBLE_DLE_FEATURE_ENABLED)
+        case CYBLE_EVT_GAP_DATA_LENGTH_CHANGE:
+            DBG_PRINTF("EVT_GAP_DATA_LENGTH_CHANGE: tx=%d, rx=%d \r\n",
+                ((CYBLE_GAP_CONN_DATA_LENGTH_T *)eventParam)->connMaxTxOctets,
+                ((CYBLE_GAP_CONN_DATA_LENGTH_T *)eventParam)->connMaxRxOctets);
+            break;
+        #endif /* (CYBLE_DLE_FEATURE_ENABLED) */
         case CYBLE_EVT_GAPP_ADVERTISEMENT_START_STOP:
             if(CYBLE_STATE_DISCONNECTED == CyBle_GetState())
             {   
@@ -212,6 +228,13 @@ void AppCallBack(uint32 event, void* eventParam)
         case CYBLE_EVT_GATT_CONNECT_IND:
             connHandle = *(CYBLE_CONN_HANDLE_T *)eventParam;
             break;
+        case CYBLE_EVT_GATTS_XCNHG_MTU_REQ:
+            {
+                uint16 mtu;
+                (void)CyBle_GattGetMtuSize(&mtu);
+                DBG_PRINTF("CYBLE_EVT_GATTS_XCNHG_MTU_REQ, final mtu= %d \r\n", mtu);
+            }
+            break;
         case CYBLE_EVT_GATT_DISCONNECT_IND:
             connHandle.bdHandle = 0;
             break;
@@ -25,7 +25,9 @@
 #include "options.h"
 #include "cytypes.h"
 #include "CyFlash.h"
+#include "crc.h"
 #include "ota_optional.h"
+#include "emi_backend.h"
 
 #define BootloaderEmulator_activeApp      (BootloaderEmulator_MD_BTLDB_ACTIVE_0)
 
@@ -33,49 +35,122 @@
 #define ExternalMemoryInterface_H
 
 
+/* Completion callback of the asynchronous external memory operation */
+typedef void (* EMI_CALLBACK_T)(cystatus status, uint32 dataAddr, uint8 *data);
+
 void EMI_Start(void);
 cystatus EMI_SetPointer(uint32 dataAddr);
 cystatus EMI_EraseAll(void);
 cystatus EMI_WriteData(uint32 dataAddr, uint32 dataSize, uint8 *data);
 cystatus EMI_ReadData (uint32 dataAddr, uint32 dataSize, uint8 *data);
+cystatus EMI_EraseData(uint32 dataAddr, uint32 dataSize);
+cystatus EMI_SubmitWrite(uint32 dataAddr, uint32 dataSize, const uint8 *data, EMI_CALLBACK_T callback);
+cystatus EMI_SubmitRead (uint32 dataAddr, uint32 dataSize, uint8 *data, EMI_CALLBACK_T callback);
+void     EMI_Process(void);
+cystatus EMI_WaitForIdle(void);
+void     EMI_ProcessUntilLastXfer(void);
+uint32   EMI_GetQueueCount(void);
+uint16   EMI_DigestAddRow(uint16 row, const uint8 data[]);
+void     EMI_DigestClear(void);
+cystatus EMI_DigestRowMap(uint32 firstRow, uint32 rows, uint8 map[], uint16 *lastRow);
+cystatus EMI_DigestSum(uint16 rows, uint16 baseRow, uint16 *sum, uint32 *dataFlag);
+cystatus EMI_DigestCheckRow(uint16 row, const uint8 data[]);
+uint32   EMI_ImageCrcAddRow(uint32 crc, uint16 row, const uint8 data[]);
+cystatus EMI_ImageCrcCalc(uint16 rows, uint32 deltaImage, uint32 *crc);
+cystatus EMI_PrepareAppRow(uint16 row);
 
 
-#define ENC_BUFFER_SIZE (300)
 #define META_DATA_SIZE  (128)
 #define META_DATA_ADDR  (0)
 
 /*******************************************************************************
 * Communication with External Memory
 *******************************************************************************/
-#define EMI_SIZE_OF_WRITE_BUFFER		    (300u)
-
+#define EMI_SIZE_OF_WRITE_BUFFER		    (EMI_DATA_INDX + CY_FLASH_SIZEOF_ROW)
+#define EMI_QUEUE_SIZE                      (3u)    /* Number of the outstanding operations */
 
-#define EMI_HIGHEST_ADDR_OF_LOW_BLOCK	    (0x0FFFFu)
-#define EMI_HIGHEST_ADDR_OF_HIGH_BLOCK	    (0x1FFFFu)
 
-#define EMI_I2C_SLAVE_ADDR_LOW_64K	        (0x50u)
-#define EMI_I2C_SLAVE_ADDR_HIGH_64K	        (0x51u)
+/*******************************************************************************
+* EMI operation queue
+*******************************************************************************/
+#define EMI_OPERATION_WRITE                 (0u)
+#define EMI_OPERATION_READ                  (1u)
+#define EMI_OPERATION_ERASE                 (2u)
 
-#define EMI_DATA_ADDR_MSB_INDX			    (0u)
-#define EMI_DATA_ADDR_LSB_INDX			    (1u)
-#define EMI_DATA_INDX                       (2u)
+#define EMI_XFER_STATE_BUSY                 (1u)    /* Head request is in the backend */
 
-#define EMI_ADDR_SIZE					    (2u)	/* Size of RAM address in bytes */
-#define EMI_NO_DATA_SIZE                    (0u)
-#define EMI_EXTERNAL_MEMORY_PAGE_SIZE       (64u)
+typedef struct
+{
+    uint8          *data;                           /* Read destination              */
+    EMI_CALLBACK_T  callback;
+    uint32          dataAddr;
+    uint32          dataSize;
+    uint32          operation;
+    uint8           buffer[EMI_SIZE_OF_WRITE_BUFFER];   /* Address and write data    */
+} EMI_REQUEST_T;
 
 
 /*******************************************************************************
 * External Memory Layout
 *******************************************************************************/
+#define EMI_ROUND_UP(size, unit)            ((((size) + (unit)) - 1u) - ((((size) + (unit)) - 1u) % (unit)))
+
+/* Metadata and application image never share an erase sector */
 #define EMI_MD_BASE_ADDR                    (0x00u)
-#define EMI_APP_BASE_ADDR                   (CY_FLASH_SIZEOF_ROW)
+#define EMI_APP_BASE_ADDR                   (EMI_ROUND_UP(CY_FLASH_SIZEOF_ROW, EMI_ERASE_SIZE))
 #define EMI_APP_ABS_ADDR(row)               (EMI_APP_BASE_ADDR + ((row) * CY_FLASH_SIZEOF_ROW))
+#define EMI_ROWS_IN_ERASE                   ((EMI_ERASE_SIZE > CY_FLASH_SIZEOF_ROW) ? \
+                                            (EMI_ERASE_SIZE / CY_FLASH_SIZEOF_ROW) : 1u)
+
+/* Row digests are stored at the end of the external memory, one entry per flash row */
+#define EMI_DIGEST_TABLE_SIZE               (EMI_ROUND_UP(CY_FLASH_NUMBER_ROWS * 2u, EMI_ERASE_SIZE))
+#define EMI_DIGEST_BASE_ADDR                (EMI_MEMORY_SIZE - EMI_DIGEST_TABLE_SIZE)
+#define EMI_DIGEST_MAX_ROWS                 ((((EMI_DIGEST_BASE_ADDR - EMI_APP_BASE_ADDR) / CY_FLASH_SIZEOF_ROW) < \
+                                            CY_FLASH_NUMBER_ROWS) ? \
+                                            ((EMI_DIGEST_BASE_ADDR - EMI_APP_BASE_ADDR) / CY_FLASH_SIZEOF_ROW) : \
+                                            CY_FLASH_NUMBER_ROWS)
+
+/* Image may overwrite the digest table only where no erase is needed */
+#define EMI_APP_MAX_ROWS                    ((EMI_ERASE_SIZE > 1u) ? EMI_DIGEST_MAX_ROWS : \
+                                            ((EMI_MEMORY_SIZE - EMI_APP_BASE_ADDR) / CY_FLASH_SIZEOF_ROW))
+
+/* Metadata sector is erased before each metadata write */
+#define EMI_IS_REWRITTEN_ADDR(addr)         ((addr) < EMI_APP_BASE_ADDR)
+
+/* Only the application image is encrypted */
+#define EMI_IS_ENCRYPTED_ADDR(addr)         (((addr) >= EMI_APP_BASE_ADDR) && ((addr) < EMI_DIGEST_BASE_ADDR))
+
+
+/*******************************************************************************
+* Application Row Digests
+*******************************************************************************/
+#define EMI_DIGEST_SIZE_OF_ENTRY            (2u)
+#define EMI_DIGEST_ENTRIES_IN_ROW           (CY_FLASH_SIZEOF_ROW / EMI_DIGEST_SIZE_OF_ENTRY)
+#define EMI_DIGEST_ROW_ADDR(row)            (EMI_DIGEST_BASE_ADDR + \
+                                            (((row) / EMI_DIGEST_ENTRIES_IN_ROW) * CY_FLASH_SIZEOF_ROW))
+#define EMI_DIGEST_ENTRY_INDX(row)          (((row) % EMI_DIGEST_ENTRIES_IN_ROW) * EMI_DIGEST_SIZE_OF_ENTRY)
+#define EMI_DIGEST_ENTRY_ADDR(row)          (EMI_DIGEST_BASE_ADDR + ((row) * EMI_DIGEST_SIZE_OF_ENTRY))
+
+#define EMI_DIGEST_SUM_MASK                 (0x7FFFu)   /* Sum of the row bytes                          */
+#define EMI_DIGEST_DATA_FLAG                (0x8000u)   /* Row has bytes other than 0x00 and 0xFF        */
+#define EMI_DIGEST_EMPTY                    (0xFFFFu)   /* Row was not received, never a valid digest    */
+
+/* Rows absent from a delta image are taken from the internal flash */
+#define EMI_DIGEST_NO_BASE                  (0xFFFFu)   /* Full image, all rows are in external memory   */
+#define EMI_FLASH_ROW_ADDR(row)             (CY_FLASH_BASE + ((uint32) (row) * CY_FLASH_SIZEOF_ROW))
+#define EMI_DIGEST_BASE_ROW(md, firstRow)   ((EMI_MD_IMAGE_TYPE_DELTA == (md)[EMI_MD_IMAGE_TYPE_ADDR]) ? \
+                                            (firstRow) : EMI_DIGEST_NO_BASE)
 
 
 /*******************************************************************************
 * External Memory Metadata
 *******************************************************************************/
+#define EMI_MD_COPY_ATTEMPTS_ADDR               (EMI_MD_BASE_ADDR + 0x20u)
+#define EMI_MD_IMAGE_CRC_ADDR                   (EMI_MD_BASE_ADDR + 0x1Cu)
+#define EMI_MD_IMAGE_CRC_STATUS_ADDR            (EMI_MD_BASE_ADDR + 0x1Bu)
+#define EMI_MD_IMAGE_TYPE_ADDR                  (EMI_MD_BASE_ADDR + 0x1Au)
+#define EMI_MD_RESUME_STATUS_ADDR               (EMI_MD_BASE_ADDR + 0x19u)
+#define EMI_MD_DIGEST_STATUS_ADDR               (EMI_MD_BASE_ADDR + 0x18u)
 #define EMI_MD_EXTERNAL_MEMORY_PAGE_SIZE_ADDR   (EMI_MD_BASE_ADDR + 0x14u)
 #define EMI_MD_APP_FIRST_ROW_NUM_ADDR           (EMI_MD_BASE_ADDR + 0x10u)
 #define EMI_MD_APP_SIZE_IN_ROWS_ADDR            (EMI_MD_BASE_ADDR + 0x0Cu)
@@ -91,6 +166,29 @@ cystatus EMI_ReadData (uint32 dataAddr, uint32 dataSize, uint8 *data);
 #define EMI_MD_APP_STATUS_LOADED            (0x4Cu)
 #define EMI_MD_APP_STATUS_INVALID           (0x00u)
 
+#define EMI_MD_DIGEST_STATUS_VALID          (0x44u)
+#define EMI_MD_DIGEST_STATUS_INVALID        (0x00u)
+
+#define EMI_MD_RESUME_STATUS_ACTIVE         (0x52u)     /* Update was interrupted, can be resumed */
+#define EMI_MD_RESUME_STATUS_NONE           (0x00u)
+
+#define EMI_MD_IMAGE_TYPE_FULL              (0x00u)
+#define EMI_MD_IMAGE_TYPE_DELTA             (0x64u)     /* Only the changed rows are in external memory */
+
+#define EMI_MD_IMAGE_CRC_STATUS_VALID       (0x43u)     /* Image CRC field holds the image CRC-32 */
+#define EMI_MD_IMAGE_CRC_STATUS_INVALID     (0x00u)
+
+/* Copies to the internal flash that failed the read-back, counted across resets */
+#define EMI_MD_COPY_ATTEMPTS_NONE           (0x00u)
+#define EMI_MD_COPY_ATTEMPTS_ERASED         (0xFFu)     /* Metadata written before the field existed */
+
+/* The image CRC-32 covers every row stored in the external memory, in the row
+* order, each row preceded by its 16-bit row number (LSB first). The rows absent
+* from a delta image are skipped. So the swapped or misplaced rows, that keep the
+* sum of the bytes, change the CRC.
+*/
+#define EMI_IMAGE_CRC_ROW_NUM_SIZE          (2u)
+
 #endif /* ExternalMemoryInterface_H */
 
 #if !defined(BootloaderEmulator_H)
@@ -146,6 +244,11 @@ cystatus EMI_ReadData (uint32 dataAddr, uint32 dataSize, uint8 *data);
 #define BootloaderEmulator_CMD_SYNC_BOOTLOADER_AVAIL  (0u)
 #define BootloaderEmulator_CMD_SEND_DATA_AVAIL        (1u)
 #define BootloaderEmulator_CMD_GET_METADATA           (0u)  /* Not supported  */
+#define BootloaderEmulator_CMD_GET_ROW_MAP_AVAIL      (1u)
+#define BootloaderEmulator_CMD_DELTA_AVAIL            (1u)
+#define BootloaderEmulator_CMD_WINDOW_AVAIL           (1u)
+#define BootloaderEmulator_CMD_COMPRESSED_AVAIL       (1u)
+#define BootloaderEmulator_CMD_GET_PKT_SIZE_AVAIL     (1u)
 
 
 /*******************************************************************************
@@ -227,6 +330,141 @@ typedef struct
 #define BootloaderEmulator_COMMAND_VERIFY       (0x3Au)    /* Compute flash row checksum for verification        */
 #define BootloaderEmulator_COMMAND_EXIT         (0x3Bu)    /* Exits the bootloader & resets the chip             */
 #define BootloaderEmulator_COMMAND_GET_METADATA (0x3Cu)    /* Reports the metadata for a selected application    */
+#define BootloaderEmulator_COMMAND_GET_ROW_MAP  (0x3Du)    /* Reports the rows received before the update stopped */
+#define BootloaderEmulator_COMMAND_DELTA        (0x3Eu)    /* Starts the update that carries only changed rows   */
+#define BootloaderEmulator_COMMAND_WINDOW       (0x3Fu)    /* Starts the windowed transfer of the row fragments  */
+#define BootloaderEmulator_COMMAND_STREAM       (0x40u)    /* Row fragment, acknowledged once per window         */
+#define BootloaderEmulator_COMMAND_WINDOW_STATUS (0x41u)   /* Reports the fragments of the window to send again  */
+#define BootloaderEmulator_COMMAND_COMPRESSED   (0x42u)    /* Starts the transfer of the compressed rows         */
+#define BootloaderEmulator_COMMAND_COMPRESSED_DATA (0x43u) /* Block of compressed rows, decoded and programmed   */
+#define BootloaderEmulator_COMMAND_GET_PKT_SIZE (0x44u)    /* Reports the largest packet of a single ATT write   */
+
+
+/*******************************************************************************
+* Get Row Map command. The host sends 2-byte offset in the row map, the response
+* is [2-byte first flash row] [2-byte image size in rows] [row map bytes], bit n
+* of the row map is set if the image row (8 * offset + n) is already in the
+* external memory. Image row of the application is its flash row minus the first
+* flash row; the bootloadable metadata row follows the last application row.
+* Sent after Enter Bootloader it resumes the interrupted update; otherwise the
+* first Program Row starts a new update.
+*******************************************************************************/
+#define BootloaderEmulator_ROW_MAP_CHUNK_SIZE   (32u)      /* Row map bytes in a response                        */
+#define BootloaderEmulator_ROW_MAP_HEADER_SIZE  (4u)
+
+#define BootloaderEmulator_SESSION_IDLE         (0u)       /* No rows received since Enter Bootloader            */
+#define BootloaderEmulator_SESSION_ACTIVE       (1u)
+
+#define BootloaderEmulator_MD_FLASH_ROW         (CY_FLASH_NUMBER_ROWS - 1u)   /* Bootloadable metadata row     */
+#define BootloaderEmulator_MD_ROW_NONE          (0xFFFFu)  /* Metadata row was not received                      */
+#define BootloaderEmulator_IMAGE_CRC_BROKEN     (0xFFFFu)  /* Rows out of order, the image CRC is read back      */
+
+
+/*******************************************************************************
+* Delta Image command. Sent after Enter Bootloader, before the first Program
+* Row. The host sends [2-byte image size in rows] [4-byte image CRC-32 of the
+* running application] and then only the rows that differ from the running
+* application, always including the bootloadable metadata row. The image CRC-32
+* is computed as the one of the stored image (each row preceded by its 2-byte
+* image row number) over the rows of the running application, the metadata row
+* excluded. The command fails with ERR_CHECKSUM if the running application is
+* not the one the delta was made against; the host should send the full image
+* then. The delta image starts at the first row of the running application.
+*******************************************************************************/
+#define BootloaderEmulator_DELTA_PARAM_SIZE     (6u)
+
+/* Bootloadable metadata of the running application */
+#define BootloaderEmulator_MD_ADDR              (EMI_FLASH_ROW_ADDR(BootloaderEmulator_MD_FLASH_ROW) + \
+                                                BootloaderEmulator_MD_APP_CHECKSUM)
+#define BootloaderEmulator_MD_LAST_BTLDR_ROW    (5u)       /* 4-byte last row of the bootloader                  */
+#define BootloaderEmulator_MD_APP_LENGTH        (9u)       /* 4-byte size of the application in bytes            */
+
+#define BootloaderEmulator_FIRST_ROW_NONE       (0xFFFFu)  /* First row is taken from the first received row     */
+
+
+/*******************************************************************************
+* Windowed transfer. The host sends Window with [1-byte number of fragments in
+* the window] [1-byte array] [2-byte first row of the application]; 0 fragments
+* return to the legacy mode. The first row starts the update if no rows were
+* received yet, as the rows may complete out of order. The response is [1-byte
+* accepted window size] [1-byte sequence number of the first fragment]. The
+* host then sends the Stream packets without waiting for the response:
+* [1-byte sequence] [1-byte array] [2-byte row] [1-byte offset in row] [data].
+* Only the last fragment of the window, or the fragment that completes it, is
+* answered with the window status: [1-byte window base] [missing map], bit n
+* of the map is set if the fragment (base + n) must be sent again. A fragment
+* counts as received once its row is written; the fragments of a row that
+* failed to be written are reported as missing. The base moves to the next
+* window once all fragments are received. A damaged packet is answered with its
+* error code and the window status; the host sends Window Status when the
+* expected status does not arrive. The legacy commands keep working between
+* the windows.
+*******************************************************************************/
+#define BootloaderEmulator_WINDOW_PARAM_SIZE    (4u)
+#define BootloaderEmulator_WINDOW_MAX_SIZE      (32u)      /* Fragments in a window                              */
+#define BootloaderEmulator_WINDOW_MAP_SIZE      ((BootloaderEmulator_WINDOW_MAX_SIZE + 7u) / 8u)
+#define BootloaderEmulator_STREAM_ROWS          (2u)       /* Rows assembled at the same time                    */
+#define BootloaderEmulator_STREAM_ROW_NONE      (0xFFFFu)
+
+#define BootloaderEmulator_STREAM_SEQ_INDX      (0u)
+#define BootloaderEmulator_STREAM_ARRAY_INDX    (1u)
+#define BootloaderEmulator_STREAM_ROW_INDX      (2u)
+#define BootloaderEmulator_STREAM_OFFSET_INDX   (4u)
+#define BootloaderEmulator_STREAM_HEADER_SIZE   (5u)
+
+typedef struct
+{
+    uint16 row;                                 /* Flash row or STREAM_ROW_NONE  */
+    uint16 received;                            /* Row bytes received            */
+    uint8  map[BootloaderEmulator_WINDOW_MAP_SIZE];   /* Fragments held of the window  */
+    uint8  data[CY_FLASH_SIZEOF_ROW];
+} BootloaderEmulator_STREAM_ROW;
+
+
+/*******************************************************************************
+* Compressed transfer. The host sends Compressed with [1-byte array] [2-byte
+* first row] [2-byte number of rows] and then the consecutive rows compressed
+* as one LZSS stream (see lzss.h) in Compressed Data packets of any size. The
+* data is decoded into the row buffer and each completed row is programmed the
+* same way as by Program Row; the response is [2-byte rows left]. The metadata
+* row is usually sent uncompressed with Program Row.
+*******************************************************************************/
+#define BootloaderEmulator_COMPRESSED_PARAM_SIZE (5u)
+
+
+/*******************************************************************************
+* Get Packet Size command. The response is [2-byte packet size] [2-byte ATT MTU]:
+* the largest bootloader packet, header included, that a single Write Without
+* Response carries on the current connection, and the MTU it was derived from.
+* The Prepare Write is not supported, so the host must not send the longer
+* packets; with the 23-byte default MTU the row is split into Send Data packets,
+* with the MTU of 150 bytes or more the whole Program Row fits a single write.
+* The MTU is negotiated by the client, the server accepts up to the GATT MTU set
+* in the BLE component customizer.
+*******************************************************************************/
+#define BootloaderEmulator_ATT_WRITE_HEADER_SIZE (3u)      /* Opcode and attribute handle                        */
+
+
+/*******************************************************************************
+* Transfer statistics, collected when OTA_STATS_ENABLED is YES. The SysTick
+* counts SYSCLK cycles without the interrupt, so a single measurement must be
+* shorter than its 24-bit period (about 350 ms at 48 MHz). The command cycles
+* are counted from the packet reception to the response; the external memory
+* cycles are spent in EMI_Process() between the packets.
+*******************************************************************************/
+#define BootloaderEmulator_STATS_SYSTICK_MASK   (0x00FFFFFFu)
+
+typedef struct
+{
+    uint32 packets;                             /* Packets received from the host                     */
+    uint32 badPackets;                          /* Packets with the length, framing or checksum error */
+    uint32 bytesIn;                             /* Bytes received over the air                        */
+    uint32 bytesOut;                            /* Bytes of the responses                             */
+    uint32 rows;                                /* Rows programmed                                    */
+    uint32 rowCycles;                           /* Cycles spent in programming the rows               */
+    uint32 cmdCycles;                           /* Cycles spent in handling the commands              */
+    uint32 emiCycles;                           /* Cycles spent in the external memory backend        */
+} BootloaderEmulator_STATS;
 
 
 /*******************************************************************************
@@ -261,14 +499,6 @@ typedef struct
 #define BootloaderEmulator_COMMUNICATION_STATE_ACTIVE (1u)
 
 
-/*******************************************************************************
-* BootloaderEmulator_CalcPacketChecksum()
-*******************************************************************************/
-#if(0u != BootloaderEmulator_PACKET_CHECKSUM_CRC)
-    #define BootloaderEmulator_CRC_CCITT_POLYNOMIAL       (0x8408u)       /* x^16 + x^12 + x^5 + 1 */
-    #define BootloaderEmulator_CRC_CCITT_INITIAL_VALUE    (0xffffu)
-#endif /* (0u != BootloaderEmulator_PACKET_CHECKSUM_CRC) */
-
 
 #define BootloaderEmulator_NUMBER_OF_ROWS_IN_ARRAY                ((uint16)(CY_FLASH_SIZEOF_ARRAY/CY_FLASH_SIZEOF_ROW))
 #define BootloaderEmulator_FIRST_ROW_IN_ARRAY                     (0u)
@@ -284,16 +514,27 @@ typedef struct
 
 #if !defined(PROGRAMFLASH_H)
 #define PROGRAMFLASH_H
+
+/* Verified boot is the bootloader option, it stores its marker in SFLASH */
+#if !defined(VERIFIED_BOOT_ENABLED)
+    #define VERIFIED_BOOT_ENABLED   (NO)
+#endif /* !defined(VERIFIED_BOOT_ENABLED) */
     
-#if (ENCRYPTION_ENABLED == YES)
+#if ((ENCRYPTION_ENABLED == YES) || (VERIFIED_BOOT_ENABLED == YES))
 
 #define CY_FLASH_API_OPCODE_WRITE_SFLASH_ROW    (0x18u)
+
+/* SRAM address of the system call parameters as written to CPUSS_SYSARG */
+#if !defined(SF_SRAM_ADDR)
+    #define SF_SRAM_ADDR(ptr)                   ((uint32) (ptr))
+#endif /* !defined(SF_SRAM_ADDR) */
+
 #define WRITE_KEY_ERROR                (1)
 	
 uint32 SF_WriteUserSFlashRow(uint32 rowNum, uint32 rowData[]); 
 
 
-#endif /*(ENCRYPTION_ENABLED == YES)*/
+#endif /* ((ENCRYPTION_ENABLED == YES) || (VERIFIED_BOOT_ENABLED == YES)) */
 
     
 #endif /*PROGRAMFLASH_H*/
@@ -23,7 +23,7 @@
 #include "ota_optional.h"
 #include "debug.h"    
 
-#if (ENCRYPTION_ENABLED == YES)
+#if ((ENCRYPTION_ENABLED == YES) || (VERIFIED_BOOT_ENABLED == YES))
 
 #if (CY_IP_SPCIF_SYNCHRONOUS)
     static CY_SYS_FLASH_CLOCK_BACKUP_STRUCT cySysFlashBackup;
@@ -32,6 +32,13 @@
 static cystatus SF_CySysFlashClockBackup(void);
 static cystatus SF_CySysFlashClockRestore(void);
 static cystatus SF_CySysFlashClockConfig(void);
+
+#endif /* ((ENCRYPTION_ENABLED == YES) || (VERIFIED_BOOT_ENABLED == YES)) */
+
+#if (ENCRYPTION_ENABLED == YES)
+
+static void CR_DeriveNonce(uint32 addr, uint8 * nonce);
+static CYBLE_API_RESULT_T CR_CryptRow(uint32 addr, uint8 * data, uint16 length, uint32 encrypt);
     
 
 /*******************************************************************************
@@ -56,169 +63,164 @@ void CR_Initialization(void)
 
 
 /*******************************************************************************
-* Function Name: CR_Encrypt
+* Function Name: CR_DeriveNonce
 ********************************************************************************
 *
 * Summary:
-*  Encrypts the specified data with the specified key. Prefix 
-*  CR stands for en/decryption to show that it is part of encryption module.
+*  Derives the nonce of the encryption block from the nonce vector and the
+*  external memory address of the block, so every block is encrypted with its
+*  own key stream. Prefix CR stands for en/decryption to show that it is part
+*  of encryption module.
+*
+* Parameters:
+*  uint32 addr:     External memory address of the block.
+*  uint8 * nonce:   Pointer to an array of bytes for the derived nonce output.
+*                   The array length to be allocated by the application is 13
+*                   Bytes.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void CR_DeriveNonce(uint32 addr, uint8 * nonce)
+{
+    CR_ReadNonce(nonce);
+
+    nonce[NONCE_LENGTH - 4u] ^= (uint8) (addr >> 24u);
+    nonce[NONCE_LENGTH - 3u] ^= (uint8) (addr >> 16u);
+    nonce[NONCE_LENGTH - 2u] ^= (uint8) (addr >> 8u);
+    nonce[NONCE_LENGTH - 1u] ^= (uint8) addr;
+}
+
+
+/*******************************************************************************
+* Function Name: CR_CryptRow
+********************************************************************************
+*
+* Summary:
+*  Encrypts or decrypts the row in place. The row is processed in blocks of
+*  the maximum length accepted by the BLE stack AES-CCM API, each block with
+*  the nonce derived from its external memory address. Prefix CR stands for
+*  en/decryption to show that it is part of encryption module.
 *
 * Parameters:
-*  uint8 * plain:       Pointer to an array of bytes to be encrypted. Size of 
-*                       the array should be equal to the value of 'length' 
-*                       parameter.
-*  uint16 length:        Length of the data to be encrypted, in Bytes.
-*  uint8 * key:         Pointer to an array of bytes holding the key. The array 
-*                       length to be allocated by the application should be 16 
-*                       bytes.
-*  uint8 * nonce        Pointer to an array of bytes. The array length to be 
-*                       allocated by the application is 13 Bytes.
-*  uint8 * encrypted:   Pointer to an array of size 'length' where the encrypted 
-*                       data is stored.
-*  uint8 * out_mic:     Pointer to an array of bytes (4 Bytes) to store the   
-*                       Message Integrity Check (MIC) value generated during 
-*                       encryption.                        
+*  uint32 addr:     External memory address of the row.
+*  uint8 * data:    Pointer to the row data.
+*  uint16 length:   Length of the row data, in Bytes.
+*  uint32 encrypt:  Non-zero to encrypt, zero to decrypt.
 *
 * Return:
 *   CYBLE_API_RESULT_T: Return value indicates if the function succeeded or
 *   failed. Following are the possible error codes.
-*   CYBLE_ERROR_OK                    On successful operation.
-*       CYBLE_ERROR_INVALID_PARAMETER     One of the inputs is a null pointer or 
-*									 the 'length' value is invalid	
+*       CYBLE_ERROR_OK                    On successful operation.
+*       CYBLE_ERROR_INVALID_PARAMETER     The data is a null pointer.
+*
 *******************************************************************************/
-CYBLE_API_RESULT_T CR_Encrypt(
-    uint8 * plain, 
-    uint16 length, 
-    uint8 * key, 
-    uint8 * nonce, 
-    uint8 * encrypted, 
-    uint8 * out_mic)
+static CYBLE_API_RESULT_T CR_CryptRow(uint32 addr, uint8 * data, uint16 length, uint32 encrypt)
 {
     CYBLE_API_RESULT_T retval = CYBLE_ERROR_OK;
-    uint16 blockLeft;
-    uint16 blockLength = 0;
-    uint16 offset = 0;
-    uint8 inBuf[EBCRYPTION_BLOCK_LENGTH];
-    uint8 outBuf[EBCRYPTION_BLOCK_LENGTH];
-    
-    /*Input parameters check*/
-    if ((plain == NULL) || (key == NULL) || (nonce == NULL) || \
-        (encrypted == NULL) || out_mic == NULL)
+    uint8 key[KEY_LENGTH];
+    uint8 nonce[NONCE_LENGTH];
+    uint8 mic[MIC_DATA_LENGTH] = {0u};
+    uint8 block[EBCRYPTION_BLOCK_LENGTH];
+    uint16 blockLength;
+    uint16 offset;
+
+    if (data == NULL)
     {
         return (CYBLE_ERROR_INVALID_PARAMETER);
     }
-    
+
     #if (CYDEV_BOOTLOADER_ENABLE == 1)
         if (!encryptionEnabled)
         {
-            memcpy(encrypted,plain,length);
-            DBG_PRINT_TEXT("Encryption skipped");
+            /* Row is stored as plain text */
             return (CYBLE_ERROR_OK);
         }
     #endif /*(CYDEV_BOOTLOADER_ENABLE == 1)*/
-    
-    /* Split plain text in to acceptable number of blocks */  
-    for(offset=0;offset<length;offset+=EBCRYPTION_BLOCK_LENGTH)
+
+    CR_ReadKey(key);
+
+    for (offset = 0u; (offset < length) && (retval != CYBLE_ERROR_INVALID_PARAMETER); offset += blockLength)
     {
+        blockLength = length - offset;
+        if (blockLength > EBCRYPTION_BLOCK_LENGTH)
+        {
+            blockLength = EBCRYPTION_BLOCK_LENGTH;
+        }
 
-        blockLeft = length - offset;
-        blockLength = blockLeft < EBCRYPTION_BLOCK_LENGTH ? blockLeft : EBCRYPTION_BLOCK_LENGTH;
-        memcpy(inBuf, plain+offset, blockLength);
-        retval = CyBle_AesCcmEncrypt(key, nonce, inBuf, blockLength, outBuf, out_mic);
-        
-        /*Do not store MIC and check MIC authorization, due to memory consumption*/
-        if (retval == CYBLE_ERROR_OK || retval == CYBLE_ERROR_MIC_AUTH_FAILED)
+        CR_DeriveNonce(addr + offset, nonce);
+
+        if (0u != encrypt)
         {
-            memcpy(encrypted+offset, outBuf, blockLength);
+            retval = CyBle_AesCcmEncrypt(key, nonce, data + offset, (uint8) blockLength, block, mic);
+        }
+        else
+        {
+            /* MIC authorization is not checked, due to memory consumption */
+            retval = CyBle_AesCcmDecrypt(key, nonce, data + offset, (uint8) blockLength, block, mic);
+        }
+
+        if (retval != CYBLE_ERROR_INVALID_PARAMETER)
+        {
+            /* The stack API does not process data in place */
+            (void) memcpy(data + offset, block, blockLength);
         }
-        
     }
-    return (retval);
+
+    return ((retval == CYBLE_ERROR_INVALID_PARAMETER) ? retval : CYBLE_ERROR_OK);
 }
 
 
 /*******************************************************************************
-* Function Name: CR_Decrypt
+* Function Name: CR_EncryptRow
 ********************************************************************************
 *
 * Summary:
-*  Decrypts the specified data with the specified key. Prefix 
-*  CR stands for en/decryption to show that it is part of encryption module.
+*  Encrypts the row in place with the key stored in SFlash. Prefix CR stands
+*  for en/decryption to show that it is part of encryption module.
 *
 * Parameters:
-*  uint8 * encrypted:   Pointer to an array of bytes to be decrypted. Size of 
-*                       the array should be equal to the value of 'length' 
-*                       parameter.
-*  uint16 length:        Length of the data to be encrypted, in Bytes.
-*  uint8 * key:         Pointer to an array of bytes holding the key. The array 
-*                       length to be allocated by the application should be 16 
-*                       bytes.
-*  uint8 * nonce        Pointer to an array of bytes. The array length to be 
-*                       allocated by the application is 13 Bytes.
-*  uint8 * decrypted:   Pointer to an array of size 'length' where the decrypted 
-*                       data is stored.
-*  uint8 * out_mic:     Pointer to an array of bytes (4 Bytes) to check the MIC 
-*                       value generated during encryption. 
-* 
+*  uint32 addr:     External memory address the row is written to.
+*  uint8 * data:    Pointer to the row data.
+*  uint16 length:   Length of the row data, in Bytes.
+*
 * Return:
 *   CYBLE_API_RESULT_T: Return value indicates if the function succeeded or
 *   failed. Following are the possible error codes.
 *       CYBLE_ERROR_OK                    On successful operation.
-*       CYBLE_ERROR_INVALID_PARAMETER     One of the inputs is a null 
-*		    pointer or the 'length' value is invalid
-*       CYBLE_ERROR_MIC_AUTH_FAILED		Data decryption has been done  
-*		    successfully but MIC based authorization check has failed. This 
-*			error can be ignored if MIC based authorization was not intended.
+*       CYBLE_ERROR_INVALID_PARAMETER     The data is a null pointer.
 *
 *******************************************************************************/
-CYBLE_API_RESULT_T CR_Decrypt(uint8 * encrypted, 
-    uint16 length, 
-    uint8 * key, 
-    uint8 * nonce, 
-    uint8 * decrypted , 
-    uint8 * out_mic)
+CYBLE_API_RESULT_T CR_EncryptRow(uint32 addr, uint8 * data, uint16 length)
 {
-    CYBLE_API_RESULT_T retval = CYBLE_ERROR_OK;
-    uint16 blockLeft;
-    uint16 blockLength = 0;
-    uint16 offset = 0; 
-    uint8 inBuf[EBCRYPTION_BLOCK_LENGTH];
-    uint8 outBuf[EBCRYPTION_BLOCK_LENGTH];
-    
-    /*Input parameters check*/
-    if ((encrypted == NULL) || (key == NULL) || (nonce == NULL) || \
-        (decrypted == NULL) || out_mic == NULL)
-    {
-        return (CYBLE_ERROR_INVALID_PARAMETER);
-    }
-    
-    #if (CYDEV_BOOTLOADER_ENABLE == 1)
-        if (!encryptionEnabled)
-        {
-            DBG_PRINT_TEXT("\r\nDecryption skipped\r\n");
-            memcpy(decrypted,encrypted,length);
-            return (CYBLE_ERROR_OK);
-        }
-    #endif /*(CYDEV_BOOTLOADER_ENABLE == 1)*/
-    
-    /* Split plain text in to acceptable number of blocks */
+    return (CR_CryptRow(addr, data, length, 1u));
+}
 
-    for(offset=0;offset<length;offset+=EBCRYPTION_BLOCK_LENGTH)
-    {
 
-        blockLeft = length - offset;
-        blockLength = blockLeft < EBCRYPTION_BLOCK_LENGTH ? blockLeft : EBCRYPTION_BLOCK_LENGTH;
-        
-        memcpy(inBuf, encrypted+offset, blockLength);
-        
-        retval = CyBle_AesCcmDecrypt(key, nonce, inBuf, blockLength, outBuf, out_mic);
-        
-        if (retval != CYBLE_ERROR_INVALID_PARAMETER)
-        {
-            memcpy(decrypted+offset, outBuf, blockLength);;
-        }
-    }
-    return (retval);
+/*******************************************************************************
+* Function Name: CR_DecryptRow
+********************************************************************************
+*
+* Summary:
+*  Decrypts the row in place with the key stored in SFlash. Prefix CR stands
+*  for en/decryption to show that it is part of encryption module.
+*
+* Parameters:
+*  uint32 addr:     External memory address the row is read from.
+*  uint8 * data:    Pointer to the row data.
+*  uint16 length:   Length of the row data, in Bytes.
+*
+* Return:
+*   CYBLE_API_RESULT_T: Return value indicates if the function succeeded or
+*   failed. Following are the possible error codes.
+*       CYBLE_ERROR_OK                    On successful operation.
+*       CYBLE_ERROR_INVALID_PARAMETER     The data is a null pointer.
+*
+*******************************************************************************/
+CYBLE_API_RESULT_T CR_DecryptRow(uint32 addr, uint8 * data, uint16 length)
+{
+    return (CR_CryptRow(addr, data, length, 0u));
 }
 
 
@@ -382,6 +384,10 @@ void CR_ReadKey(uint8 * key)
     }
 }
 
+#endif /*(ENCRYPTION_ENABLED == YES)*/
+
+
+#if ((ENCRYPTION_ENABLED == YES) || (VERIFIED_BOOT_ENABLED == YES))
 
 /* Function created based on CyFlash.c ver. 4.20 
 *  Modified: comand in in SF_WriteUserSFlashRow to work with SFlash, removed 
@@ -410,7 +416,7 @@ uint32 SF_WriteUserSFlashRow(uint32 rowNum, uint32 rowData[])
     volatile uint32   parameters[(CY_FLASH_SIZEOF_ROW + CY_FLASH_SRAM_ROM_DATA)/4u];
     uint8  interruptState;
     
-    if ((rowNum < CY_FLASH_NUMBER_ROWS) && (rowData != 0u))
+    if ((rowNum < CY_FLASH_NUMBER_ROWS) && (NULL != rowData))
     {
         /* Load Flash Bytes */
         parameters[0u] = (uint32) (CY_FLASH_GET_MACRO_FROM_ROW(rowNum)        << CY_FLASH_PARAM_MACRO_SEL_OFFSET) |
@@ -420,7 +426,7 @@ uint32 SF_WriteUserSFlashRow(uint32 rowNum, uint32 rowData[])
         parameters[1u] = CY_FLASH_SIZEOF_ROW - 1u;
 
         (void)memcpy((void *)&parameters[2u], rowData, CY_FLASH_SIZEOF_ROW);
-        CY_FLASH_CPUSS_SYSARG_REG = (uint32) &parameters[0u];
+        CY_FLASH_CPUSS_SYSARG_REG = SF_SRAM_ADDR(&parameters[0u]);
         CY_FLASH_CPUSS_SYSREQ_REG = CY_FLASH_CPUSS_REQ_START | CY_FLASH_API_OPCODE_LOAD;
         retValue = CY_FLASH_API_RETURN;
         
@@ -447,7 +453,7 @@ uint32 SF_WriteUserSFlashRow(uint32 rowNum, uint32 rowData[])
                 parameters[0u]  = (uint32) (((uint32) CY_FLASH_KEY_TWO(CY_FLASH_API_OPCODE_WRITE_SFLASH_ROW) <<  CY_FLASH_PARAM_KEY_TWO_OFFSET) | CY_FLASH_KEY_ONE);
                 parameters[1u] = (uint32) rowNum;
 
-                CY_FLASH_CPUSS_SYSARG_REG = (uint32) &parameters[0u];
+                CY_FLASH_CPUSS_SYSARG_REG = SF_SRAM_ADDR(&parameters[0u]);
                 CY_FLASH_CPUSS_SYSREQ_REG = CY_FLASH_CPUSS_REQ_START | CY_FLASH_API_OPCODE_WRITE_SFLASH_ROW;
                 retValue = CY_FLASH_API_RETURN;
             }
@@ -492,9 +498,9 @@ static cystatus SF_CySysFlashClockBackup(void)
         parameters[0u] =
                 (uint32) ((CY_FLASH_KEY_TWO(CY_FLASH_API_OPCODE_CLK_BACKUP) <<  CY_FLASH_PARAM_KEY_TWO_OFFSET) |
                         CY_FLASH_KEY_ONE);
-        parameters[1u] = (uint32) &cySysFlashBackup.clockSettings[0u];
+        parameters[1u] = SF_SRAM_ADDR(&cySysFlashBackup.clockSettings[0u]);
     
-        CY_FLASH_CPUSS_SYSARG_REG = (uint32) &parameters[0u];
+        CY_FLASH_CPUSS_SYSARG_REG = SF_SRAM_ADDR(&parameters[0u]);
         CY_FLASH_CPUSS_SYSREQ_REG = CY_FLASH_CPUSS_REQ_START | CY_FLASH_API_OPCODE_CLK_BACKUP;
     #endif /* (CY_IP_SPCIF_SYNCHRONOUS) */
     
@@ -558,8 +564,8 @@ static cystatus SF_CySysFlashClockRestore(void)
 	    parameters[0u] =
 	        (uint32) ((CY_FLASH_KEY_TWO(CY_FLASH_API_OPCODE_CLK_RESTORE) <<  CY_FLASH_PARAM_KEY_TWO_OFFSET) |
 	                    CY_FLASH_KEY_ONE);
-	    parameters[1u] = (uint32) &cySysFlashBackup.clockSettings[0u];
-	    CY_FLASH_CPUSS_SYSARG_REG = (uint32) &parameters[0u];
+	    parameters[1u] = SF_SRAM_ADDR(&cySysFlashBackup.clockSettings[0u]);
+	    CY_FLASH_CPUSS_SYSARG_REG = SF_SRAM_ADDR(&parameters[0u]);
 	    CY_FLASH_CPUSS_SYSREQ_REG = CY_FLASH_CPUSS_REQ_START | CY_FLASH_API_OPCODE_CLK_RESTORE;
 	    retValue = CY_FLASH_API_RETURN;
     #endif /* (CY_IP_SPCIF_SYNCHRONOUS) */
@@ -567,7 +573,7 @@ static cystatus SF_CySysFlashClockRestore(void)
     return (retValue);
 }
 
-#endif /*(ENCRYPTION_ENABLED == YES)*/
+#endif /* ((ENCRYPTION_ENABLED == YES) || (VERIFIED_BOOT_ENABLED == YES)) */
 
 
 /* [] END OF FILE */
@@ -44,10 +44,8 @@ extern uint8 encryptionEnabled;
     #include "cytypes.h"
 
     void CR_Initialization(void);
-    CYBLE_API_RESULT_T CR_Encrypt(uint8 * plain, uint16 length, uint8 * key, \
-        uint8 * nonce, uint8 * encrypted, uint8 * out_mic);
-    CYBLE_API_RESULT_T CR_Decrypt(uint8 * encrypted, uint16 length, uint8 * key, \
-        uint8 * nonce, uint8 * decrypted, uint8 * out_mic);
+    CYBLE_API_RESULT_T CR_EncryptRow(uint32 addr, uint8 * data, uint16 length);
+    CYBLE_API_RESULT_T CR_DecryptRow(uint32 addr, uint8 * data, uint16 length);
     void CR_GenerateKey(uint8 * key);
     void CR_GenerateNonce(uint8 * nonce);
     void CR_ReadNonce(uint8 * nonce);
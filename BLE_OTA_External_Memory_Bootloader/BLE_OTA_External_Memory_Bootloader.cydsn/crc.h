@@ -0,0 +1,64 @@
+/*******************************************************************************
+* File Name: crc.h
+*
+* Version: 1.50
+*
+* Description:
+*  Contains the function prototypes and constants of the table-driven
+*  CRC-CCITT and CRC-32 calculations.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#if !defined(CRC_H)
+#define CRC_H
+
+#include "cytypes.h"
+
+
+/***************************************
+*        Constants
+***************************************/
+#define CRC_CCITT_POLYNOMIAL        (0x8408u)       /* x^16 + x^12 + x^5 + 1 in reverse order */
+#define CRC_CCITT_INITIAL_VALUE     (0xFFFFu)
+
+/* Set to 1u, here or on the compiler command line, to use the 16-entry
+* (32 bytes) nibble table instead of the 256-entry (512 bytes) byte table.
+* Saves flash at cost of the speed.
+*/
+#if !defined(CRC_CCITT_NIBBLE_TABLE)
+    #define CRC_CCITT_NIBBLE_TABLE  (0u)
+#endif /* !defined(CRC_CCITT_NIBBLE_TABLE) */
+
+#define CRC_32_POLYNOMIAL           (0xEDB88320u)   /* IEEE 802.3 polynomial in reverse order */
+#define CRC_32_INITIAL_VALUE        (0xFFFFFFFFu)
+
+/* Set to 1u, here or on the compiler command line, to use the 16-entry
+* (64 bytes) nibble table instead of the 256-entry (1024 bytes) byte table.
+* Saves flash at cost of the speed.
+*/
+#if !defined(CRC_32_NIBBLE_TABLE)
+    #define CRC_32_NIBBLE_TABLE     (0u)
+#endif /* !defined(CRC_32_NIBBLE_TABLE) */
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+uint16 CRC_CcittUpdate(uint16 crc, const uint8 buffer[], uint32 size);
+uint16 CRC_CcittCalc(const uint8 buffer[], uint32 size);
+uint32 CRC_Crc32Update(uint32 crc, const uint8 buffer[], uint32 size);
+uint32 CRC_Crc32Calc(const uint8 buffer[], uint32 size);
+
+#endif /* !defined(CRC_H) */
+
+
+/* [] END OF FILE */
@@ -33,9 +33,44 @@ uint16 rowIdx;
 
 uint16 flashRowTotal;
 
+/* Row that is read from the external memory while the previous one is programmed */
+static uint8  ciRowBuffer[CY_FLASH_SIZEOF_ROW];
+static uint16 ciRowBufferIdx;
+static volatile uint32 ciRowBufferState = CI_ROW_BUFFER_EMPTY;
+static cystatus ciRowBufferStatus;
 
-static uint16 CI_CalcExtMemAppChecksum(void);
+/* Rows of the delta image, the others are already in the flash */
+static uint32 ciDeltaImage;
+static uint8  ciRowMap[CI_ROW_MAP_SIZE];
+
+/* Program Row data kept until the row is read back from the flash */
+static uint8  ciProgramData[CI_COMMAND_PROGRAM_PACKET_DATA_SIZE];
+static uint16 ciProgramFlashRow;
+static uint32 ciProgramPending;
+static uint32 ciProgramRetries;
+
+/* Rows are checked against their digests as they are read */
+static uint32 ciDigestValid;
+
+/* Image CRC-32 of the rows read so far, checked when the copy completes */
+static uint32 ciImageCrcValid;
+static uint32 ciImageCrc;
+
+/* Copy statistics */
+static uint16 ciRowsWritten;
+static uint16 ciRowsUnchanged;      /* Rows that the flash already holds   */
+static uint16 ciRowsAbsent;         /* Rows absent from the delta image    */
+
+
+static cystatus CI_CalcExtMemAppChecksum(uint16 *checksum);
+static uint32 CI_GetImageCrc(void);
 static cystatus CI_WritePacket(uint8 status, uint8 buffer[], uint16 size);
+static void CI_PrefetchRow(uint16 row);
+static void CI_RowReadCallback(cystatus status, uint32 dataAddr, uint8 *data);
+static cystatus CI_ReadRow(uint16 row);
+static uint16 CI_NextImageRow(uint16 row);
+static uint32 CI_VerifyProgrammedRow(void);
+static void CI_AbortCopy(uint32 reason);
 
 
 /*******************************************************************************
@@ -57,6 +92,8 @@ cystatus CyBtldrCommRead(uint8* buffer, uint16 size, uint16* count, uint8 timeOu
     cystatus rspCode  = CYRET_UNKNOWN;
     uint32 rspSize = 0u;
     uint16 appExtMemChecksum;
+    uint16 appCalcChecksum;
+    uint16 rowMapLast;
     
     
     buffer = buffer;
@@ -69,7 +106,12 @@ cystatus CyBtldrCommRead(uint8* buffer, uint16 size, uint16* count, uint8 timeOu
         communicationState = CI_COMMUNICATION_STATE_ACTIVE;
 
         /* Read metadata section from external memory */
-        (void) EMI_ReadData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW , metadata);
+        if (CYRET_SUCCESS != EMI_ReadData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW , metadata))
+        {
+            /* Nothing is known of the external memory image, it is not copied */
+            (void) memset(metadata, 0, CY_FLASH_SIZEOF_ROW);
+            metadata[EMI_MD_APP_STATUS_ADDR] = EMI_MD_APP_STATUS_INVALID;
+        }
 
         appFirstRowNum = ((uint16)((uint16)metadata[EMI_MD_APP_FIRST_ROW_NUM_ADDR + 1u] << 8u)) |
                                         metadata[EMI_MD_APP_FIRST_ROW_NUM_ADDR];
@@ -106,10 +148,41 @@ cystatus CyBtldrCommRead(uint8* buffer, uint16 size, uint16* count, uint8 timeOu
         DBG_PRINT_TEXT("\r\n");
         encryptionEnabled = metadata[EMI_MD_ENCRYPTION_STATUS_ADDR];
 
+        DBG_PRINT_TEXT("\t\t\t Metadata: Image Type: 0x");
+        DBG_PRINT_HEX(metadata[EMI_MD_IMAGE_TYPE_ADDR]);
+        DBG_PRINT_TEXT("\r\n");
+
+        #if (VERIFIED_BOOT_ENABLED == YES)
+            if ((metadata[EMI_MD_APP_STATUS_ADDR] == EMI_MD_APP_STATUS_LOADED) && (0u != VB_IsImageVerified(metadata)))
+            {
+                /* The image passed the full verification on an earlier boot and did not change since */
+                (void) Bootloader_Exit(Bootloader_EXIT_TO_BTLDB);
+            }
+        #endif /* (VERIFIED_BOOT_ENABLED == YES) */
+
+        ciDigestValid = (uint32) (EMI_MD_DIGEST_STATUS_VALID == metadata[EMI_MD_DIGEST_STATUS_ADDR]);
+        ciImageCrcValid = (uint32) (EMI_MD_IMAGE_CRC_STATUS_VALID == metadata[EMI_MD_IMAGE_CRC_STATUS_ADDR]);
+        ciImageCrc = CRC_32_INITIAL_VALUE;
+
+        ciDeltaImage = 0u;
+        if ((EMI_MD_IMAGE_TYPE_DELTA == metadata[EMI_MD_IMAGE_TYPE_ADDR]) &&
+            (EMI_MD_DIGEST_STATUS_VALID == metadata[EMI_MD_DIGEST_STATUS_ADDR]))
+        {
+            /* Only the rows of the delta image are copied */
+            ciDeltaImage = 1u;
+            if (CYRET_SUCCESS != EMI_DigestRowMap(0u, EMI_DIGEST_MAX_ROWS, ciRowMap, &rowMapLast))
+            {
+                /* Rows to copy are not known */
+                CI_AbortCopy(CI_ABORT_COPY_FAILED);
+            }
+        }
+
         /* Check application checksum in the external memory */
-        if (CI_CalcExtMemAppChecksum() != appExtMemChecksum)
+        if ((CYRET_SUCCESS != CI_CalcExtMemAppChecksum(&appCalcChecksum)) || (appCalcChecksum != appExtMemChecksum))
         {
-            /* Mark application as invalid when checksum verification failed */
+            /* Mark application as invalid when checksum verification failed. The
+            * metadata is not written, so the failed read is tried on the next reset.
+            */
             metadata[EMI_MD_APP_STATUS_ADDR] = EMI_MD_APP_STATUS_INVALID;
         }
 
@@ -147,6 +220,11 @@ cystatus CyBtldrCommRead(uint8* buffer, uint16 size, uint16* count, uint8 timeOu
             *******************************************************************/
             if(CYRET_SUCCESS == Bootloader_ValidateBootloadable(Bootloader_EXIT_TO_BTLDB))
             {
+                #if (VERIFIED_BOOT_ENABLED == YES)
+                    /* Both images are verified, let the next boots skip the checksums */
+                    VB_RecordImage(metadata);
+                #endif /* (VERIFIED_BOOT_ENABLED == YES) */
+
                 (void) Bootloader_Exit(Bootloader_EXIT_TO_BTLDB);
             }
             else
@@ -212,10 +290,96 @@ cystatus CyBtldrCommRead(uint8* buffer, uint16 size, uint16* count, uint8 timeOu
     }
     else
     {
-        if (CI_COMMUNICATION_STATE_ACTIVE == communicationState)
+        /* The flash read-back runs while the I2C read of the next row, started
+        * with the Program Row command, is still on the bus.
+        */
+        if ((CI_COMMUNICATION_STATE_ACTIVE == communicationState) && (0u == CI_VerifyProgrammedRow()))
+        {
+            /* Program the row that did not read back again */
+            buffer[CI_CMD_ADDR] = CI_COMMAND_PROGRAM;
+            (void) memcpy(buffer + CI_DATA_ADDR, ciProgramData, CI_COMMAND_PROGRAM_PACKET_DATA_SIZE);
+
+            *count  = CI_COMMAND_PROGRAM_PACKET_SIZE;
+            rspSize = CI_COMMAND_PROGRAM_PACKET_DATA_SIZE;
+            rspCode = CYRET_SUCCESS;
+        }
+        else if (CI_COMMUNICATION_STATE_ACTIVE == communicationState)
         {
+            uint32 rowChanged = 0u;
+            uint16 flashRow;
+
+            /* Find the next row that differs from the one in the flash */
+            while ((0u == rowChanged) && (flashRowTotal >= rowIdx))
+            {
+                uint16 rowsAbsent;
+
+                /* Rows absent from the delta image are left in the flash as they are */
+                rowsAbsent = CI_NextImageRow(rowIdx) - rowIdx;
+                rowIdx += rowsAbsent;
+                appFirstRowNum += rowsAbsent;
+                ciRowsAbsent += rowsAbsent;
+
+                if (flashRowTotal >= rowIdx)
+                {
+                    /* The row is normally read while the previous one was programmed */
+                    if (CYRET_SUCCESS != CI_ReadRow(rowIdx))
+                    {
+                        /* External memory did not answer, the copy is tried again */
+                        CI_AbortCopy(CI_ABORT_COPY_FAILED);
+                    }
+
+                    /* The damaged row is found before it gets to the flash */
+                    if ((0u != ciDigestValid) && (rowIdx < flashRowTotal) &&
+                        (CYRET_SUCCESS != EMI_DigestCheckRow(rowIdx, ciRowBuffer)))
+                    {
+                        /* Read the row again in case the read itself failed */
+                        if (CYRET_SUCCESS != CI_ReadRow(rowIdx))
+                        {
+                            CI_AbortCopy(CI_ABORT_COPY_FAILED);
+                        }
+
+                        if (CYRET_SUCCESS != EMI_DigestCheckRow(rowIdx, ciRowBuffer))
+                        {
+                            CI_AbortCopy(CI_ABORT_IMAGE_DAMAGED);
+                        }
+                    }
+
+                    /* Every row of the image is read once, the unchanged ones too */
+                    if ((0u != ciImageCrcValid) && (rowIdx < flashRowTotal))
+                    {
+                        ciImageCrc = EMI_ImageCrcAddRow(ciImageCrc, rowIdx, ciRowBuffer);
+
+                        /* The bootloadable metadata row is the last one, it is not programmed
+                        * if the rows are swapped or misplaced in the external memory.
+                        */
+                        if (((flashRowTotal - 1u) == rowIdx) && (CI_GetImageCrc() != (uint32) ~ciImageCrc))
+                        {
+                            CI_AbortCopy(CI_ABORT_IMAGE_DAMAGED);
+                        }
+                    }
+
+                    flashRow = ((flashRowTotal - 1u) == rowIdx) ? (uint16) (CY_FLASH_NUMBER_ROWS - 1u) : appFirstRowNum;
+
+                    if (0 != memcmp(ciRowBuffer, (const void *) EMI_FLASH_ROW_ADDR(flashRow), CY_FLASH_SIZEOF_ROW))
+                    {
+                        rowChanged = 1u;
+                    }
+                    else
+                    {
+                        /* The flash already holds the row, do not write it again */
+                        ciRowsUnchanged++;
+                        rowIdx++;
+                        appFirstRowNum++;
+
+                        if (flashRowTotal >= rowIdx)
+                        {
+                            CI_PrefetchRow(CI_NextImageRow(rowIdx));
+                        }
+                    }
+                }
+            }
 
-            if (flashRowTotal >= rowIdx)
+            if (0u != rowChanged)
             {
                 /* Generate Program Row Command */
                 uint16 appFirstRowNumInArray;
@@ -233,7 +397,8 @@ cystatus CyBtldrCommRead(uint8* buffer, uint16 size, uint16* count, uint8 timeOu
                 buffer[CI_DATA_ADDR     ] = CY_FLASH_GET_MACRO_FROM_ROW(appFirstRowNum);
                 buffer[CI_DATA_ADDR + 1u] = LO8(appFirstRowNumInArray);
                 buffer[CI_DATA_ADDR + 2u] = HI8(appFirstRowNumInArray);
-                (void) EMI_ReadData(EMI_APP_ABS_ADDR(rowIdx), CY_FLASH_SIZEOF_ROW, (uint8 *) (buffer + CI_DATA_ADDR + 3u));
+
+                (void) memcpy(buffer + CI_DATA_ADDR + 3u, ciRowBuffer, CY_FLASH_SIZEOF_ROW);
 
                 if((flashRowTotal - 1u)  == rowIdx)
                 {
@@ -243,11 +408,28 @@ cystatus CyBtldrCommRead(uint8* buffer, uint16 size, uint16* count, uint8 timeOu
                     buffer[CI_DATA_ADDR + 2u] = HI8(CY_FLASH_NUMBER_ROWS - 2u - CI_FLASH_ROWS_IN_ARRAY);
                 }
 
+                /* Read back on the next call, after the bootloader programmed the row */
+                (void) memcpy(ciProgramData, buffer + CI_DATA_ADDR, CI_COMMAND_PROGRAM_PACKET_DATA_SIZE);
+                ciProgramFlashRow = ((flashRowTotal - 1u) == rowIdx) ? (uint16) (CY_FLASH_NUMBER_ROWS - 1u) : appFirstRowNum;
+                ciProgramPending = 1u;
+                ciProgramRetries = 0u;
+
                 *count  = CI_COMMAND_PROGRAM_PACKET_SIZE;
                 rspSize = CI_COMMAND_PROGRAM_PACKET_DATA_SIZE;
                 rspCode = CYRET_SUCCESS;
                 rowIdx++;
                 appFirstRowNum++;
+                ciRowsWritten++;
+
+                /* Read the next row while the bootloader programs this one. The
+                * memory address is written first, so the data read is already on
+                * the bus when the flash write takes the CPU.
+                */
+                if (flashRowTotal >= rowIdx)
+                {
+                    CI_PrefetchRow(CI_NextImageRow(rowIdx));
+                    EMI_ProcessUntilLastXfer();
+                }
 
                 DBG_PRINT_TEXT("\r\n");
                 DBG_PRINT_TEXT("CustomInterface:\r\n");
@@ -267,9 +449,21 @@ cystatus CyBtldrCommRead(uint8* buffer, uint16 size, uint16* count, uint8 timeOu
                 /* Schedule Bootloadable application */
 
                 /* Mark bootloadable application as loaded */
-                (void) EMI_ReadData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW , metadata);
+                if (CYRET_SUCCESS != EMI_ReadData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW , metadata))
+                {
+                    /* Rows are in the flash, the copy after the reset only checks them */
+                    CI_AbortCopy(CI_ABORT_COPY_FAILED);
+                }
+
                 metadata[EMI_MD_APP_STATUS_ADDR] = EMI_MD_APP_STATUS_LOADED;
+                metadata[EMI_MD_COPY_ATTEMPTS_ADDR] = EMI_MD_COPY_ATTEMPTS_NONE;
                 (void) EMI_WriteData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW , metadata);
+                (void) EMI_WaitForIdle();
+
+                #if (VERIFIED_BOOT_ENABLED == YES)
+                    /* Every row was checked as it was copied, the application is not checksummed again */
+                    VB_RecordImage(metadata);
+                #endif /* (VERIFIED_BOOT_ENABLED == YES) */
 
                 /* Generate Exit Bootloader Command */
                 buffer[CI_CMD_ADDR] = CI_COMMAND_EXIT;
@@ -281,6 +475,18 @@ cystatus CyBtldrCommRead(uint8* buffer, uint16 size, uint16* count, uint8 timeOu
                 DBG_PRINT_TEXT("BootloaderEmulator:\r\n");
                 DBG_PRINT_TEXT("\tCyBtldrCommRead():\r\n");
                 DBG_PRINT_TEXT("\t\tExit Bootloader:\r\n");
+
+                DBG_PRINT_TEXT("\t\t\t Rows written: 0x");
+                DBG_PRINT_HEX(ciRowsWritten);
+                DBG_PRINT_TEXT("\r\n");
+
+                DBG_PRINT_TEXT("\t\t\t Rows unchanged in flash: 0x");
+                DBG_PRINT_HEX(ciRowsUnchanged);
+                DBG_PRINT_TEXT("\r\n");
+
+                DBG_PRINT_TEXT("\t\t\t Rows absent from delta image: 0x");
+                DBG_PRINT_HEX(ciRowsAbsent);
+                DBG_PRINT_TEXT("\r\n");
             }
 
         }
@@ -310,6 +516,11 @@ void CyBtldrCommStart(void)
 {
     numOfRxedRows = 0u;
     communicationState = CI_COMMUNICATION_STATE_IDLE;
+    ciProgramPending = 0u;
+
+    ciRowsWritten = 0u;
+    ciRowsUnchanged = 0u;
+    ciRowsAbsent = 0u;
 
     EMI_Start();
 
@@ -388,6 +599,11 @@ cystatus CyBtldrCommWrite(uint8* buffer, uint16 size, uint16* count, uint8 timeO
     count = count;
     timeOut = timeOut;
 
+    /* Called when the bootloader completed the command: the row read that ran
+    *  while the row was programmed is completed, the next one is started.
+    */
+    EMI_Process();
+
     DBG_PRINT_TEXT("\r\n");
     DBG_PRINT_TEXT("CustomInterface:\r\n");
     DBG_PRINT_TEXT("\tCyBtldrCommWrite():\r\n");
@@ -419,43 +635,10 @@ static uint16 CI_CalcPacketChecksum(const uint8 buffer[], uint16 size)
 {
     #if(0u != CI_PACKET_CHECKSUM_CRC)
 
-        uint16 crc = CI_CRC_CCITT_INITIAL_VALUE;
-        uint16 tmp;
-        uint8  i;
-        uint16 tmpIndex = size;
-
-        if(0u == size)
-        {
-            crc = ~crc;
-        }
-        else
-        {
-            do
-            {
-                tmp = buffer[tmpIndex - size];
-
-                for (i = 0u; i < 8u; i++)
-                {
-                    if (0u != ((crc & 0x0001u) ^ (tmp & 0x0001u)))
-                    {
-                        crc = (crc >> 1u) ^ CI_CRC_CCITT_POLYNOMIAL;
-                    }
-                    else
-                    {
-                        crc >>= 1u;
-                    }
-
-                    tmp >>= 1u;
-                }
-
-                size--;
-            }
-            while(0u != size);
+        uint16 crc;
 
-            crc = ~crc;
-            tmp = crc;
-            crc = ( uint16 )(crc << 8u) | (tmp >> 8u);
-        }
+        crc = ( uint16 )(~CRC_CcittCalc(buffer, size));
+        crc = ( uint16 )(crc << 8u) | (crc >> 8u);
 
         return(crc);
 
@@ -554,32 +737,322 @@ static cystatus CI_WritePacket(uint8 status, uint8 buffer[], uint16 size)
 }
 
 
-static uint16 CI_CalcExtMemAppChecksum(void)
+/*******************************************************************************
+* Function Name: CI_PrefetchRow
+********************************************************************************
+*
+* Summary:
+*  Starts the asynchronous read of the application row from the external
+*  memory to the row buffer.
+*
+* Parameters:
+*  row:
+*     The application row number in the external memory.
+*
+* Returns:
+*  None
+*
+*******************************************************************************/
+static void CI_PrefetchRow(uint16 row)
+{
+    ciRowBufferIdx = row;
+    ciRowBufferState = CI_ROW_BUFFER_PENDING;
+
+    if (CYRET_SUCCESS != EMI_SubmitRead(EMI_APP_ABS_ADDR(row), CY_FLASH_SIZEOF_ROW, ciRowBuffer, &CI_RowReadCallback))
+    {
+        /* Queue is full, the row is read when it is needed */
+        ciRowBufferState = CI_ROW_BUFFER_EMPTY;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: CI_RowReadCallback
+********************************************************************************
+*
+* Summary:
+*  Completion callback of the row read started by CI_PrefetchRow().
+*
+* Parameters:
+*  status:
+*     Status of the read.
+*  dataAddr:
+*     The external memory address of the row.
+*  data:
+*     The row buffer.
+*
+* Returns:
+*  None
+*
+*******************************************************************************/
+static void CI_RowReadCallback(cystatus status, uint32 dataAddr, uint8 *data)
+{
+    dataAddr = dataAddr;
+    data = data;
+
+    ciRowBufferStatus = status;
+    ciRowBufferState = CI_ROW_BUFFER_READY;
+}
+
+
+/*******************************************************************************
+* Function Name: CI_ReadRow
+********************************************************************************
+*
+* Summary:
+*  Gets the application row to the row buffer. The row that was prefetched is
+*  waited for; any other row is read now. The buffer is consumed, so the next
+*  call for the same row reads it again.
+*
+* Parameters:
+*  row:
+*     The application row number in the external memory.
+*
+* Returns:
+*  Status of the read.
+*
+*******************************************************************************/
+static cystatus CI_ReadRow(uint16 row)
+{
+    if ((CI_ROW_BUFFER_EMPTY == ciRowBufferState) || (ciRowBufferIdx != row))
+    {
+        /* The read of another row must land before the buffer is reused */
+        (void) EMI_WaitForIdle();
+        CI_PrefetchRow(row);
+    }
+    (void) EMI_WaitForIdle();
+
+    if (CI_ROW_BUFFER_READY != ciRowBufferState)
+    {
+        ciRowBufferStatus = CYRET_UNKNOWN;
+    }
+    ciRowBufferState = CI_ROW_BUFFER_EMPTY;
+
+    return (ciRowBufferStatus);
+}
+
+
+/*******************************************************************************
+* Function Name: CI_NextImageRow
+********************************************************************************
+*
+* Summary:
+*  Returns the first row starting from the specified one that has to be copied
+*  to the flash. For the delta image these are the rows received by the
+*  bootloadable and the metadata row; for the full image all rows.
+*
+* Parameters:
+*  row:
+*     The application row number in the external memory.
+*
+* Returns:
+*  The application row number to copy.
+*
+*******************************************************************************/
+static uint16 CI_NextImageRow(uint16 row)
+{
+    if (0u != ciDeltaImage)
+    {
+        while (((row + 1u) < flashRowTotal) && (0u == (ciRowMap[row >> 3u] & (uint8) (1u << (row & 0x07u)))))
+        {
+            row++;
+        }
+    }
+
+    return (row);
+}
+
+
+/*******************************************************************************
+* Function Name: CI_VerifyProgrammedRow
+********************************************************************************
+*
+* Summary:
+*  Compares the last programmed flash row with the data sent to the bootloader.
+*  The copy is aborted if the row does not match after CI_PROGRAM_RETRIES
+*  attempts.
+*
+* Parameters:
+*  None
+*
+* Returns:
+*  Zero if the row must be programmed again.
+*
+*******************************************************************************/
+static uint32 CI_VerifyProgrammedRow(void)
+{
+    uint32 verified = 1u;
+
+    if (0u != ciProgramPending)
+    {
+        if (0 == memcmp(&ciProgramData[CI_COMMAND_PROGRAM_PARAM_SIZE],
+                        (const void *) EMI_FLASH_ROW_ADDR(ciProgramFlashRow), CY_FLASH_SIZEOF_ROW))
+        {
+            ciProgramPending = 0u;
+        }
+        else if (ciProgramRetries < CI_PROGRAM_RETRIES)
+        {
+            ciProgramRetries++;
+            verified = 0u;
+
+            DBG_PRINT_TEXT("\r\n");
+            DBG_PRINT_TEXT("CustomInterface:\r\n");
+            DBG_PRINT_TEXT("\tCI_VerifyProgrammedRow(): mismatch, program again row 0x");
+            DBG_PRINT_HEX(ciProgramFlashRow);
+            DBG_PRINT_TEXT("\r\n");
+        }
+        else
+        {
+            CI_AbortCopy(CI_ABORT_COPY_FAILED);
+        }
+    }
+
+    return (verified);
+}
+
+
+/*******************************************************************************
+* Function Name: CI_AbortCopy
+********************************************************************************
+*
+* Summary:
+*  Stops the copy that can not complete. The flash row that does not read back
+*  or the failed external memory read leaves the external memory image VALID
+*  and the reset starts the copy again; the rows already in the flash are
+*  skipped. The failed copies are counted in the metadata, the image is marked
+*  INVALID after CI_COPY_ATTEMPTS of them. A damaged external memory row or the
+*  image CRC-32 mismatch marks the image INVALID at once. If the metadata can
+*  not be read, the device is only reset.
+*
+* Parameters:
+*  reason:
+*     CI_ABORT_IMAGE_DAMAGED or CI_ABORT_COPY_FAILED.
+*
+* Returns:
+*  Does not return.
+*
+*******************************************************************************/
+static void CI_AbortCopy(uint32 reason)
+{
+    uint8 attempts;
+
+    /* The metadata that did not read is not written back */
+    if (CYRET_SUCCESS == EMI_ReadData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW , metadata))
+    {
+        if (CI_ABORT_IMAGE_DAMAGED == reason)
+        {
+            /* The external memory image does not match its digest or CRC-32 */
+            metadata[EMI_MD_APP_STATUS_ADDR] = EMI_MD_APP_STATUS_INVALID;
+        }
+        else
+        {
+            /* The flash or the external memory failed */
+            attempts = metadata[EMI_MD_COPY_ATTEMPTS_ADDR];
+            if (EMI_MD_COPY_ATTEMPTS_ERASED == attempts)
+            {
+                attempts = EMI_MD_COPY_ATTEMPTS_NONE;
+            }
+            attempts++;
+            metadata[EMI_MD_COPY_ATTEMPTS_ADDR] = attempts;
+
+            if (attempts >= CI_COPY_ATTEMPTS)
+            {
+                metadata[EMI_MD_APP_STATUS_ADDR] = EMI_MD_APP_STATUS_INVALID;
+            }
+        }
+
+        (void) EMI_WriteData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW , metadata);
+        (void) EMI_WaitForIdle();
+    }
+
+    DBG_PRINT_TEXT("\r\n");
+    DBG_PRINT_TEXT("CustomInterface:\r\n");
+    DBG_PRINT_TEXT("\tCI_AbortCopy(): copy failed at row 0x");
+    DBG_PRINT_HEX(rowIdx);
+    DBG_PRINT_TEXT(", reset device\r\n");
+
+    CySoftwareReset();
+}
+
+
+/*******************************************************************************
+* Function Name: CI_GetImageCrc
+********************************************************************************
+*
+* Summary:
+*  Gets the image CRC-32 stored in the external memory metadata.
+*
+* Parameters:
+*  None
+*
+* Returns:
+*  The image CRC-32 of the metadata.
+*
+*******************************************************************************/
+static uint32 CI_GetImageCrc(void)
+{
+    return (((uint32) metadata[EMI_MD_IMAGE_CRC_ADDR + 3u] << 24u) |
+            ((uint32) metadata[EMI_MD_IMAGE_CRC_ADDR + 2u] << 16u) |
+            ((uint32) metadata[EMI_MD_IMAGE_CRC_ADDR + 1u] <<  8u) |
+             (uint32) metadata[EMI_MD_IMAGE_CRC_ADDR]);
+}
+
+
+/*******************************************************************************
+* Function Name: CI_CalcExtMemAppChecksum
+********************************************************************************
+*
+* Summary:
+*  Calculates the checksum of the application in the external memory from the
+*  row digests, or from the rows if the digests are not valid. Uses the
+*  metadata read by the caller.
+*
+* Parameters:
+*  checksum:
+*     The calculated checksum, valid on success.
+*
+* Returns:
+*  CYRET_SUCCESS or the status of the failed external memory read.
+*
+*******************************************************************************/
+static cystatus CI_CalcExtMemAppChecksum(uint16 *checksum)
 {
     uint8  extMemRow[CY_FLASH_SIZEOF_ROW];
     uint16 extMemRowIdx;
     uint16 extMemAppRowsTotal;
     uint16 appExtMemChecksum = 0u;
     uint16 size;
+    uint32 dataFlag;
+    cystatus status = CYRET_SUCCESS;
 
     /* Get total number of the written flash rows to the external memory */
-    (void) EMI_ReadData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW , metadata);
     extMemAppRowsTotal = ((uint16)((uint16)metadata[EMI_MD_APP_SIZE_IN_ROWS_ADDR + 1u] << 8u)) |
                                       metadata[EMI_MD_APP_SIZE_IN_ROWS_ADDR];
 
-    for (extMemRowIdx = 0u; extMemRowIdx < extMemAppRowsTotal; extMemRowIdx++)
+    if (EMI_MD_DIGEST_STATUS_VALID == metadata[EMI_MD_DIGEST_STATUS_ADDR])
     {
-        (void) EMI_ReadData(EMI_APP_ABS_ADDR(extMemRowIdx), CY_FLASH_SIZEOF_ROW, extMemRow);
-
-        size = CY_FLASH_SIZEOF_ROW;
-        while (size > 0u)
+        /* Sum the row digests stored while the application was received */
+        status = EMI_DigestSum(extMemAppRowsTotal, EMI_DIGEST_BASE_ROW(metadata, appFirstRowNum),
+                               &appExtMemChecksum, &dataFlag);
+    }
+    else
+    {
+        /* No digests: read and sum every application row */
+        for (extMemRowIdx = 0u; (CYRET_SUCCESS == status) && (extMemRowIdx < extMemAppRowsTotal); extMemRowIdx++)
         {
-            size--;
-            appExtMemChecksum += extMemRow[size];
+            status = EMI_ReadData(EMI_APP_ABS_ADDR(extMemRowIdx), CY_FLASH_SIZEOF_ROW, extMemRow);
+
+            size = CY_FLASH_SIZEOF_ROW;
+            while (size > 0u)
+            {
+                size--;
+                appExtMemChecksum += extMemRow[size];
+            }
         }
     }
 
     appExtMemChecksum = ( uint16 )1u + ( uint16 )(~appExtMemChecksum);
+    *checksum = appExtMemChecksum;
 
     DBG_PRINT_TEXT("\r\n");
     DBG_PRINT_TEXT("CustomInterface:\r\n");
@@ -590,7 +1063,7 @@ static uint16 CI_CalcExtMemAppChecksum(void)
     DBG_PRINT_HEX(appExtMemChecksum);
     DBG_PRINT_TEXT("\r\n");
 
-    return(appExtMemChecksum);
+    return (status);
 }
 
 
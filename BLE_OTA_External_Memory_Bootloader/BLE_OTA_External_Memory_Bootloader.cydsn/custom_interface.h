@@ -29,8 +29,10 @@
 #include "cytypes.h"
 #include "debug.h"
 #include "CyFlash.h"
+#include "crc.h"
 #include "ota_mandatory.h"
 #include "ota_optional.h"
+#include "verified_boot.h"
 
 void CyBtldrCommStart(void);
 void CyBtldrCommStop(void);
@@ -40,15 +42,6 @@ cystatus CyBtldrCommRead (uint8* buffer, uint16 size, uint16* count, uint8 timeO
 
 extern uint8 encryptionEnabled;
 
-/*******************************************************************************
-* Bootloader_CalcPacketChecksum()
-*******************************************************************************/
-#if(0u != CI_PACKET_CHECKSUM_CRC)
-    #define CI_CRC_CCITT_POLYNOMIAL       (0x8408u)       /* x^16 + x^12 + x^5 + 1 */
-    #define CI_CRC_CCITT_INITIAL_VALUE    (0xffffu)
-#endif /* (0u != CI_PACKET_CHECKSUM_CRC) */
-
-
 #define CI_COMMUNICATION_STATE_IDLE   (0u)
 #define CI_COMMUNICATION_STATE_ACTIVE (1u)
 
@@ -96,6 +89,30 @@ extern uint8 encryptionEnabled;
 
 #define CI_FLASH_ROWS_IN_ARRAY              (0x1FFu)
 
+
+/* Row prefetch from the external memory */
+#define CI_ROW_BUFFER_EMPTY                 (0u)
+#define CI_ROW_BUFFER_PENDING               (1u)
+#define CI_ROW_BUFFER_READY                 (2u)
+
+/* The programmed row is read back before the next row is copied; the row that
+* does not match is programmed again this many times.
+*/
+#define CI_PROGRAM_RETRIES                  (1u)
+
+/* Copies that end with the row that does not read back or with the failed
+* external memory read; the image is marked INVALID after the last one, so a
+* worn flash row does not reset the device forever.
+*/
+#define CI_COPY_ATTEMPTS                    (3u)
+
+/* Reasons of CI_AbortCopy() */
+#define CI_ABORT_IMAGE_DAMAGED              (0u)    /* Image is marked INVALID     */
+#define CI_ABORT_COPY_FAILED                (1u)    /* Copy is tried again         */
+
+/* Bitmap of the delta image rows */
+#define CI_ROW_MAP_SIZE                     ((EMI_DIGEST_MAX_ROWS + 7u) / 8u)
+
 #endif /* BLE_OTA_EM_CUSTOM_INTERFACE_H_ */
 
 /* [] END OF FILE */
@@ -0,0 +1,120 @@
+/*******************************************************************************
+* File Name: emi_backend.h
+*
+* Version: 1.50
+*
+* Description:
+*  Contains the function prototypes and constants of the external memory
+*  backends. The backend moves the data of the single queued operation to or
+*  from the memory part; it is selected at build time by EMI_BACKEND option.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#if !defined(EMI_BACKEND_H)
+#define EMI_BACKEND_H
+
+#include "cytypes.h"
+#include "options.h"
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+void     EMI_BackendStart(void);
+void     EMI_BackendStartWrite(uint32 dataAddr, uint8 buffer[], uint32 dataSize, uint32 eraseFirst);
+void     EMI_BackendStartRead(uint32 dataAddr, uint8 buffer[], uint8 *data, uint32 dataSize);
+cystatus EMI_BackendProcess(void);
+uint32   EMI_BackendIsBusy(void);
+uint32   EMI_BackendIsLastXfer(void);
+
+#if (EMI_BACKEND == EMI_BACKEND_SPI_NOR)
+    void EMI_BackendStartErase(uint32 dataAddr);
+#endif /* (EMI_BACKEND == EMI_BACKEND_SPI_NOR) */
+
+
+/***************************************
+*        Constants
+***************************************/
+#define EMI_NO_DATA_SIZE                    (0u)
+#define EMI_XFER_STATE_IDLE                 (0u)
+
+#if (EMI_BACKEND == EMI_BACKEND_I2C)
+
+/*******************************************************************************
+* I2C FRAM or EEPROM with the 2-byte memory address. The address bits above 16
+* are sent in the slave address, as the block select bits.
+*******************************************************************************/
+#define EMI_I2C_SLAVE_ADDR_BASE             (0x50u)
+#define EMI_I2C_BLOCK_SELECT_SHIFT          (0u)    /* Position of A16 in the slave address */
+#define EMI_I2C_SLAVE_ADDR(addr)            ((uint8) (EMI_I2C_SLAVE_ADDR_BASE | \
+                                            (((addr) >> 16u) << EMI_I2C_BLOCK_SELECT_SHIFT)))
+
+#define EMI_DATA_ADDR_MSB_INDX              (0u)
+#define EMI_DATA_ADDR_LSB_INDX              (1u)
+#define EMI_DATA_INDX                       (2u)    /* Memory address precedes the data     */
+
+#define EMI_EXTERNAL_MEMORY_PAGE_SIZE       (64u)
+#define EMI_ERASE_SIZE                      (1u)    /* Written in place, no erase needed    */
+#define EMI_ACK_POLL_RETRIES                (1000u) /* Page write cycle is polled by address NAK */
+
+#define EMI_BACKEND_IRQ_WAKEUP              (1u)    /* I2C master interrupt ends the transfer */
+
+#define EMI_XFER_STATE_WRITE                (1u)    /* Address and data write        */
+#define EMI_XFER_STATE_READ_ADDR            (2u)    /* Address write before the read */
+#define EMI_XFER_STATE_READ_DATA            (3u)    /* Data read                     */
+
+#elif (EMI_BACKEND == EMI_BACKEND_SPI_NOR)
+
+/*******************************************************************************
+* SPI NOR flash with the 3-byte address on the EMI_SPIM component, the chip
+* select is driven by the EMI_CS pin. Bits are only cleared by the page program,
+* the sector erase sets them back.
+*******************************************************************************/
+#define EMI_SPI_NOR_CMD_WRITE_ENABLE        (0x06u)
+#define EMI_SPI_NOR_CMD_READ_STATUS         (0x05u)
+#define EMI_SPI_NOR_CMD_READ                (0x03u)
+#define EMI_SPI_NOR_CMD_PAGE_PROGRAM        (0x02u)
+#define EMI_SPI_NOR_CMD_SECTOR_ERASE        (0x20u)
+#define EMI_SPI_NOR_CMD_RELEASE_POWER_DOWN  (0xABu)
+
+#define EMI_SPI_NOR_STATUS_WIP              (0x01u) /* Write in progress */
+
+/* Maximum sector erase and page program times of the datasheet (W25Q series);
+* the memory that does not clear WIP within them has failed.
+*/
+#define EMI_SPI_NOR_ERASE_MAX_MS            (400u)
+#define EMI_SPI_NOR_PROGRAM_MAX_MS          (3u)
+
+/* The cycle times are measured with the SysTick counting SYSCLK */
+#define EMI_SPI_NOR_SYSTICK_MASK            (0x00FFFFFFu)
+#define EMI_SPI_NOR_SYSCLK_PER_MS           (CYDEV_BCLK__SYSCLK__HZ / 1000u)
+
+/* The end of the erase or program cycle raises no interrupt, it is polled */
+#define EMI_BACKEND_IRQ_WAKEUP              (0u)
+
+#define EMI_CMD_INDX                        (0u)
+#define EMI_DATA_INDX                       (4u)    /* Command and address precede the data */
+
+#define EMI_EXTERNAL_MEMORY_PAGE_SIZE       (256u)
+#define EMI_ERASE_SIZE                      (4096u)
+
+#define EMI_XFER_STATE_ERASE                (1u)    /* Sector erase before the program */
+#define EMI_XFER_STATE_PROGRAM              (2u)    /* Page program                    */
+
+#else
+    #error "EMI_BACKEND: unsupported external memory backend"
+#endif /* (EMI_BACKEND == EMI_BACKEND_I2C) */
+
+#endif /* !defined(EMI_BACKEND_H) */
+
+
+/* [] END OF FILE */
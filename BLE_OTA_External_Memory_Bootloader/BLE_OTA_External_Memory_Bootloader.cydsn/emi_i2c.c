@@ -0,0 +1,306 @@
+/*******************************************************************************
+* File Name: emi_i2c.c
+*
+* Version: 1.50
+*
+* Description:
+*  Provides the external memory backend for the I2C FRAM and EEPROM parts on
+*  the EMI_I2CM component.
+*
+* Hardware Dependency:
+*  CY8CKIT-042 BLE
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#include "emi_backend.h"
+#include <project.h>
+
+#if (EMI_BACKEND == EMI_BACKEND_I2C)
+
+/* State of the operation in flight */
+static uint8 *emiXferBuffer;
+static uint8 *emiXferData;
+static uint32 emiXferAddr;
+static uint32 emiXferOffset;
+static uint32 emiXferSize;
+static uint32 emiXferReadSize;
+static uint32 emiXferChunkSize;
+static uint32 emiXferRetries;
+static uint32 emiXferState = EMI_XFER_STATE_IDLE;
+
+static void EMI_I2CStartChunk(void);
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendStart
+********************************************************************************
+*
+* Summary:
+*  Starts the I2C master.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*******************************************************************************/
+void EMI_BackendStart(void)
+{
+    EMI_I2CM_Start();
+
+    emiXferState = EMI_XFER_STATE_IDLE;
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendStartWrite
+********************************************************************************
+*
+* Summary:
+*  Starts the write of the data to the memory. The data is written in place,
+*  so no erase is needed.
+*
+* Parameters:
+*  uint32 dataAddr:   The memory address.
+*  uint8 buffer[]:    EMI_DATA_INDX bytes for the memory address followed by
+*                     the data.
+*  uint32 dataSize:   Size of the data.
+*  uint32 eraseFirst: Not used.
+*
+* Return:
+*  None
+*******************************************************************************/
+void EMI_BackendStartWrite(uint32 dataAddr, uint8 buffer[], uint32 dataSize, uint32 eraseFirst)
+{
+    eraseFirst = eraseFirst;
+
+    emiXferBuffer  = buffer;
+    emiXferAddr    = dataAddr;
+    emiXferOffset  = 0u;
+    emiXferSize    = dataSize;
+    emiXferRetries = 0u;
+    emiXferState   = EMI_XFER_STATE_WRITE;
+
+    EMI_I2CStartChunk();
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendStartRead
+********************************************************************************
+*
+* Summary:
+*  Starts the read of the data from the memory. The memory address is written
+*  first, then the data is read.
+*
+* Parameters:
+*  uint32 dataAddr: The memory address.
+*  uint8 buffer[]:  EMI_DATA_INDX bytes for the memory address.
+*  uint8 *data:     Buffer that receives the data.
+*  uint32 dataSize: Size of the data.
+*
+* Return:
+*  None
+*******************************************************************************/
+void EMI_BackendStartRead(uint32 dataAddr, uint8 buffer[], uint8 *data, uint32 dataSize)
+{
+    emiXferBuffer   = buffer;
+    emiXferData     = data;
+    emiXferAddr     = dataAddr;
+    emiXferOffset   = 0u;
+    emiXferSize     = EMI_NO_DATA_SIZE;
+    emiXferReadSize = dataSize;
+    emiXferRetries  = 0u;
+    emiXferState    = EMI_XFER_STATE_READ_ADDR;
+
+    EMI_I2CStartChunk();
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_I2CStartChunk
+********************************************************************************
+*
+* Summary:
+*  Starts the I2C transfer of the next chunk of the operation in flight. The
+*  chunk never crosses the external memory page boundary. The two address
+*  bytes are placed right before the chunk data, over the bytes that were
+*  already transferred with the previous chunk, so no data is moved.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*******************************************************************************/
+static void EMI_I2CStartChunk(void)
+{
+    uint32 pageLeft = EMI_EXTERNAL_MEMORY_PAGE_SIZE - (emiXferAddr % EMI_EXTERNAL_MEMORY_PAGE_SIZE);
+
+    emiXferChunkSize = emiXferSize - emiXferOffset;
+    if (emiXferChunkSize > pageLeft)
+    {
+        emiXferChunkSize = pageLeft;
+    }
+
+    emiXferBuffer[emiXferOffset + EMI_DATA_ADDR_MSB_INDX] = (uint8) (emiXferAddr >> 8u);
+    emiXferBuffer[emiXferOffset + EMI_DATA_ADDR_LSB_INDX] = (uint8) emiXferAddr;
+
+    (void) EMI_I2CM_I2CMasterClearStatus();
+    (void) EMI_I2CM_I2CMasterWriteBuf( EMI_I2C_SLAVE_ADDR(emiXferAddr),
+                                &emiXferBuffer[emiXferOffset],
+                                emiXferChunkSize + EMI_DATA_INDX,
+                                EMI_I2CM_I2C_MODE_COMPLETE_XFER);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendProcess
+********************************************************************************
+*
+* Summary:
+*  Advances the operation in flight. When the I2C master completes a chunk, the
+*  next chunk or the data read of the same operation is started. A chunk
+*  rejected with the address NAK is restarted, as page based memories do not
+*  acknowledge while the internal write cycle of the previous page is in
+*  progress.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Status
+*     Value               Description
+*    CYRET_STARTED           Operation is in progress
+*    CYRET_SUCCESS           Operation completed
+*    Other                   Operation failed
+*******************************************************************************/
+cystatus EMI_BackendProcess(void)
+{
+    cystatus status = CYRET_STARTED;
+    uint32 i2cStatus = EMI_I2CM_I2CMasterStatus();
+
+    switch (emiXferState)
+    {
+        case EMI_XFER_STATE_WRITE:
+        case EMI_XFER_STATE_READ_ADDR:
+            if (0u != (i2cStatus & EMI_I2CM_I2C_MSTAT_WR_CMPLT))
+            {
+                if (0u == (i2cStatus & EMI_I2CM_I2C_MSTAT_ERR_XFER))
+                {
+                    emiXferOffset += emiXferChunkSize;
+                    emiXferAddr   += emiXferChunkSize;
+                    emiXferRetries = 0u;
+
+                    if (emiXferOffset < emiXferSize)
+                    {
+                        EMI_I2CStartChunk();
+                    }
+                    else if (EMI_XFER_STATE_READ_ADDR == emiXferState)
+                    {
+                        /* Pointer is set, read the data */
+                        (void) EMI_I2CM_I2CMasterClearStatus();
+                        emiXferState = EMI_XFER_STATE_READ_DATA;
+                        (void) EMI_I2CM_I2CMasterReadBuf(
+                                    EMI_I2C_SLAVE_ADDR(emiXferAddr),
+                                    emiXferData,
+                                    emiXferReadSize,
+                                    EMI_I2CM_I2C_MODE_COMPLETE_XFER);
+                    }
+                    else
+                    {
+                        status = CYRET_SUCCESS;
+                    }
+                }
+                else if ((0u != (i2cStatus & EMI_I2CM_I2C_MSTAT_ERR_ADDR_NAK)) &&
+                         (emiXferRetries < EMI_ACK_POLL_RETRIES))
+                {
+                    emiXferRetries++;
+                    EMI_I2CStartChunk();
+                }
+                else
+                {
+                    status = CYRET_UNKNOWN;
+                }
+            }
+            break;
+
+        case EMI_XFER_STATE_READ_DATA:
+            if (0u != (i2cStatus & EMI_I2CM_I2C_MSTAT_RD_CMPLT))
+            {
+                status = (0u == (i2cStatus & EMI_I2CM_I2C_MSTAT_ERR_XFER)) ? CYRET_SUCCESS : CYRET_UNKNOWN;
+            }
+            break;
+
+        default:
+            status = CYRET_INVALID_STATE;
+            break;
+    }
+
+    if (CYRET_STARTED != status)
+    {
+        (void) EMI_I2CM_I2CMasterClearStatus();
+        emiXferState = EMI_XFER_STATE_IDLE;
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendIsBusy
+********************************************************************************
+*
+* Summary:
+*  Checks whether the I2C transfer is still in progress. The I2C master
+*  interrupt wakes the CPU on the transfer completion, so the caller may sleep
+*  while the transfer is busy.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Non-zero while the transfer is in progress.
+*******************************************************************************/
+uint32 EMI_BackendIsBusy(void)
+{
+    return ((EMI_XFER_STATE_IDLE != emiXferState) &&
+            (0u == (EMI_I2CM_I2CMasterStatus() & (EMI_I2CM_I2C_MSTAT_WR_CMPLT | EMI_I2CM_I2C_MSTAT_RD_CMPLT))));
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_BackendIsLastXfer
+********************************************************************************
+*
+* Summary:
+*  Checks whether the I2C transfer in progress is the last one of the
+*  operation: the data read, or the write of the last chunk. It completes the
+*  operation without EMI_BackendProcess() starting another transfer.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Non-zero while the last transfer is in progress.
+*******************************************************************************/
+uint32 EMI_BackendIsLastXfer(void)
+{
+    return ((0u != EMI_BackendIsBusy()) &&
+            ((EMI_XFER_STATE_READ_DATA == emiXferState) ||
+             ((EMI_XFER_STATE_WRITE == emiXferState) && ((emiXferOffset + emiXferChunkSize) >= emiXferSize))));
+}
+
+#endif /* (EMI_BACKEND == EMI_BACKEND_I2C) */
+
+
+/* [] END OF FILE */
@@ -35,6 +35,9 @@
 #define ENCRYPT_ENABLED         (NO)
 #define DEBUG_UART_ENABLED      (NO)
 #define CI_PACKET_CHECKSUM_CRC  (NO)
+/* YES - count the packets, bytes and CPU cycles of the update and print them
+ * over the debug UART at Exit Bootloader. Requires DEBUG_UART_ENABLED. */
+#define OTA_STATS_ENABLED       (NO)
 
 
 /*******************************************************************************
@@ -45,8 +48,37 @@
 *******************************************************************************/
 #define KEY_ROW_NUM             (1u)
 
+
+/*******************************************************************************
+* The next options select the external memory part. EMI_BACKEND_I2C is the
+* I2C FRAM or EEPROM on the EMI_I2CM component. EMI_BACKEND_SPI_NOR is the SPI
+* NOR flash on the EMI_SPIM component with the chip select on the EMI_CS pin;
+* both must be added to the schematic when it is selected. EMI_MEMORY_SIZE is
+* the size of the memory in bytes, the row digest table is kept at its end.
+*******************************************************************************/
+#define EMI_BACKEND_I2C         (0u)
+#define EMI_BACKEND_SPI_NOR     (1u)
+
+#define EMI_BACKEND             (EMI_BACKEND_I2C)
+#define EMI_MEMORY_SIZE         (0x20000u)
+
 #define ENCRYPTION_ENABLED      (ENCRYPT_ENABLED && CYDEV_BOOTLOADER_ENABLE)
 
+
+/*******************************************************************************
+* Verified boot. Once the application copied from the external memory passed
+* the full verification, a marker describing it is stored in the SFLASH row
+* VB_ROW_NUM (must differ from KEY_ROW_NUM). The following boots that find the
+* marker matching both metadata start the application without checksumming the
+* images. The full verification still runs after every update and on the
+* reset causes selected in VB_FULL_CHECK_RESETS: CY_SYS_RESET_WDT,
+* CY_SYS_RESET_PROTFAULT, CY_SYS_RESET_SW and VB_RESET_POR for the power-on and
+* external resets that leave no cause.
+*******************************************************************************/
+#define VERIFIED_BOOT_ENABLED   (YES)
+#define VB_ROW_NUM              (2u)
+#define VB_FULL_CHECK_RESETS    (CY_SYS_RESET_PROTFAULT)
+
 #endif /* BLE_OTA_EM_OPTIONS_H_ */
 
 /* [] END OF FILE */
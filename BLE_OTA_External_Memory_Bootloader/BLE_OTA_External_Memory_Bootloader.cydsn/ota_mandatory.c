@@ -27,6 +27,10 @@
 #include <project.h>
 #include "debug.h"
 
+#if (CYDEV_BOOTLOADER_ENABLE == 0)
+    #include "lzss.h"
+#endif /*(CYDEV_BOOTLOADER_ENABLE == 0)*/
+
 uint8  metadata[CY_FLASH_SIZEOF_ROW];
 uint16 appFirstRowNum;
 
@@ -50,9 +54,114 @@ uint16 appExtMemChecksum = 0u;
     static cystatus BootloaderEmulator_WritePacket(uint8 status, uint8 buffer[], uint16 size);
     static uint16   BootloaderEmulator_CalcPacketChecksum(const uint8 buffer[], uint16 size);
     static void     BootloaderEmulator_HostLink(uint8 timeOut);
+    static void     BootloaderEmulator_StartSession(uint16 firstRow);
+    static cystatus BootloaderEmulator_ResumeSession(void);
+    static uint16   BootloaderEmulator_ImageRow(uint16 flashRow);
+    static uint32   BootloaderEmulator_GetMetadata(uint32 offset);
+    static uint8    BootloaderEmulator_ProgramRow(uint16 flashRow, const uint8 data[]);
+
+    #if (0u != BootloaderEmulator_CMD_DELTA_AVAIL)
+        static uint32   BootloaderEmulator_RunningImageCrc(uint16 firstRow);
+    #endif /* (0u != BootloaderEmulator_CMD_DELTA_AVAIL) */
+
+    #if (0u != BootloaderEmulator_CMD_WINDOW_AVAIL)
+        static void     BootloaderEmulator_WindowReset(uint8 size);
+        static uint8    BootloaderEmulator_WindowFragment(const uint8 packet[], uint16 pktSize, uint8 *ackCode);
+        static uint8    BootloaderEmulator_WindowAccepted(uint8 indx);
+        static uint16   BootloaderEmulator_WindowStatus(uint8 buffer[]);
+    #endif /* (0u != BootloaderEmulator_CMD_WINDOW_AVAIL) */
+
+    #if (0u != BootloaderEmulator_CMD_COMPRESSED_AVAIL)
+        static uint8    BootloaderEmulator_CompressedData(const uint8 data[], uint16 size);
+    #endif /* (0u != BootloaderEmulator_CMD_COMPRESSED_AVAIL) */
+
+    #if (OTA_STATS_ENABLED == YES)
+        #if (DEBUG_UART_ENABLED != YES)
+            #error The statistics are reported over the debug UART
+        #endif /* (DEBUG_UART_ENABLED != YES) */
+
+        static void     BootloaderEmulator_StatsStart(void);
+        static uint32   BootloaderEmulator_StatsElapsed(uint32 mark);
+        static void     BootloaderEmulator_StatsReport(void);
+
+        static BootloaderEmulator_STATS btldrStats;
+
+        /* SysTick value at the reception of the current packet */
+        static uint32 btldrStatsMark = 0u;
+    #endif /* (OTA_STATS_ENABLED == YES) */
+
+    /* Whether the rows received after Enter Bootloader belong to a started update */
+    static uint32 btldrSession = BootloaderEmulator_SESSION_IDLE;
+
+    /* Image row of the bootloadable metadata row */
+    static uint16 btldrMdRow = BootloaderEmulator_MD_ROW_NONE;
+
+    /* Size in rows of the delta image, zero for the full image */
+    static uint16 btldrDeltaRows = 0u;
+
+    /* First flash row of the application if known before the first row arrives */
+    static uint16 btldrFirstRow = BootloaderEmulator_FIRST_ROW_NONE;
+
+    /* Image CRC-32 of the rows received in order and the row it expects next */
+    static uint32 btldrImageCrc = CRC_32_INITIAL_VALUE;
+    static uint16 btldrImageCrcRow = 0u;
+
+    #if (0u != BootloaderEmulator_CMD_WINDOW_AVAIL)
+        /* Fragments in the window, zero in the legacy single command mode */
+        static uint8 btldrWindowSize = 0u;
+
+        /* Sequence number of the first fragment in the window */
+        static uint8 btldrWindowBase = 0u;
+
+        /* Fragments of the window that were accepted */
+        static uint8 btldrWindowMap[BootloaderEmulator_WINDOW_MAP_SIZE];
+
+        /* Rows being assembled from the fragments */
+        static BootloaderEmulator_STREAM_ROW btldrStreamRow[BootloaderEmulator_STREAM_ROWS];
+    #endif /* (0u != BootloaderEmulator_CMD_WINDOW_AVAIL) */
+
+    #if (0u != BootloaderEmulator_CMD_COMPRESSED_AVAIL)
+        static LZSS_DECODER_T btldrLzss;
+
+        /* Row being decoded and the number of its decoded bytes */
+        static uint8  btldrLzssRowData[CY_FLASH_SIZEOF_ROW];
+        static uint16 btldrLzssRowFill = 0u;
+        static uint16 btldrLzssRow = 0u;
+
+        /* Rows of the compressed transfer not programmed yet */
+        static uint16 btldrLzssRowsLeft = 0u;
+    #endif /* (0u != BootloaderEmulator_CMD_COMPRESSED_AVAIL) */
 #endif /*(CYDEV_BOOTLOADER_ENABLE == 0)*/
 
-uint8 emiWriteBuffer[EMI_SIZE_OF_WRITE_BUFFER];
+/* Queue of outstanding external memory operations */
+static EMI_REQUEST_T emiQueue[EMI_QUEUE_SIZE];
+static uint32 emiQueueHead = 0u;
+static volatile uint32 emiQueueCount = 0u;
+
+/* Whether the operation at the queue head is in flight in the backend */
+static volatile uint32 emiXferState = EMI_XFER_STATE_IDLE;
+
+static uint16 EMI_RowDigest(const uint8 data[]);
+
+/* Failure of an operation that was submitted without a completion callback */
+static cystatus emiXferStatus = CYRET_SUCCESS;
+
+#if (CYDEV_BOOTLOADER_ENABLE == 0)
+    /* First application row of the erase sector that was prepared last */
+    static uint32 emiPreparedRow = EMI_APP_MAX_ROWS;
+#endif /* (CYDEV_BOOTLOADER_ENABLE == 0) */
+
+static EMI_REQUEST_T * EMI_AllocRequest(void);
+static void EMI_StartRequest(void);
+#if (EMI_BACKEND == EMI_BACKEND_SPI_NOR)
+    static cystatus EMI_SubmitErase(uint32 dataAddr);
+#endif /* (EMI_BACKEND == EMI_BACKEND_SPI_NOR) */
+static void EMI_CompleteRequest(cystatus status);
+static void EMI_WaitStep(void);
+
+#if (ENCRYPTION_ENABLED == YES)
+    static cystatus EMI_DecryptData(uint32 dataAddr, uint32 dataSize, uint8 *data);
+#endif /* (ENCRYPTION_ENABLED == YES) */
 
 
 /*******************************************************************************
@@ -70,7 +179,12 @@ uint8 emiWriteBuffer[EMI_SIZE_OF_WRITE_BUFFER];
 *******************************************************************************/
 void EMI_Start(void)
 {
-    EMI_I2CM_Start();
+    EMI_BackendStart();
+
+    emiQueueHead = 0u;
+    emiQueueCount = 0u;
+    emiXferState = EMI_XFER_STATE_IDLE;
+    emiXferStatus = CYRET_SUCCESS;
 }
 
 
@@ -95,527 +209,1968 @@ cystatus EMI_SetPointer(uint32 dataAddr)
 {
     uint32 status = CYRET_UNKNOWN;
     status =  EMI_WriteData(dataAddr, EMI_NO_DATA_SIZE, NULL);
+
+    if (CYRET_SUCCESS == status)
+    {
+        /* Pointer must be set before the following read is started */
+        status = EMI_WaitForIdle();
+    }
+
     return (status);
 }
 
+
 /*******************************************************************************
-* Function Name: EMI_WriteData
+* Function Name: EMI_AllocRequest
+********************************************************************************
+*
+* Summary:
+*  Returns the free queue slot for the new request. The slot is not queued
+*  until the emiQueueCount is incremented.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Pointer to the free slot or NULL if the queue is full.
+*******************************************************************************/
+static EMI_REQUEST_T * EMI_AllocRequest(void)
+{
+    EMI_REQUEST_T *req = NULL;
+
+    if (emiQueueCount < EMI_QUEUE_SIZE)
+    {
+        req = &emiQueue[(emiQueueHead + emiQueueCount) % EMI_QUEUE_SIZE];
+    }
+
+    return (req);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_SubmitWrite
 ********************************************************************************
 *
 * Summary:
-*  Write data to the external memory.
+*  Queues the write of data to the external memory and returns without waiting
+*  for its completion. The data is copied (and encrypted, if enabled) to the
+*  request buffer, so the caller may reuse its buffer immediately. The write is
+*  split into the chunks on the external memory page boundary.
 *
 * Parameters:
 *  uint32 dataAddr:
 *   The internal pointer value.
 *  uint32 dataSize:
-*   Size of input data
-*  uint8 *data:
+*   Size of input data. Must not exceed CY_FLASH_SIZEOF_ROW.
+*  const uint8 *data:
 *   Pointer to data that is written to external memory
+*  EMI_CALLBACK_T callback:
+*   Function called from EMI_Process() when the write completes. May be NULL.
 *
 * Return:
 *  Status
 *     Value               Description
-*    CYRET_SUCCESS           Successful
-*    Other non-zero          Failure
+*    CYRET_SUCCESS           Request is queued
+*    CYRET_BAD_PARAM         Data size exceeds the request buffer
+*    CYRET_MEMORY            Queue is full
+*    Other non-zero          Encryption failure
 *******************************************************************************/
-cystatus EMI_WriteData(uint32 dataAddr, uint32 dataSize, uint8 *data)
+cystatus EMI_SubmitWrite(uint32 dataAddr, uint32 dataSize, const uint8 *data, EMI_CALLBACK_T callback)
 {
-    uint32 i;
-    uint32 status = CYRET_UNKNOWN;
-    uint8 i2cAddr = (dataAddr > EMI_HIGHEST_ADDR_OF_LOW_BLOCK) ?
-                        EMI_I2C_SLAVE_ADDR_HIGH_64K :
-                        EMI_I2C_SLAVE_ADDR_LOW_64K;
+    EMI_REQUEST_T *req = EMI_AllocRequest();
+
+    if (dataSize > (EMI_SIZE_OF_WRITE_BUFFER - EMI_DATA_INDX))
+    {
+        return (CYRET_BAD_PARAM);
+    }
+
+    if (NULL == req)
+    {
+        return (CYRET_MEMORY);
+    }
+
+    /* Assemble the data while the previous operation may be still in flight */
+    if (0u != dataSize)
+    {
+        (void) memcpy(&req->buffer[EMI_DATA_INDX], data, dataSize);
+    }
 
-	emiWriteBuffer[EMI_DATA_ADDR_MSB_INDX] = (uint8) (dataAddr >> 8u);
-	emiWriteBuffer[EMI_DATA_ADDR_LSB_INDX] = (uint8) dataAddr;
-    
     #if (ENCRYPTION_ENABLED == YES)
-        if (dataAddr >= (META_DATA_ADDR + META_DATA_SIZE) && (dataSize>0))
+        if (EMI_IS_ENCRYPTED_ADDR(dataAddr) && (dataSize>0))
         {
-            uint8 key[KEY_LENGTH] = {0};
-            uint8 nonce[NONCE_LENGTH] = {0};
-            uint8 encrypted[ENC_BUFFER_SIZE] = {0};
-            uint8 out_mic[MIC_DATA_LENGTH];
             CYBLE_API_RESULT_T result;
-            
-            CR_ReadKey(key);
-            CR_ReadNonce(nonce);
-            result = CR_Encrypt(data, dataSize, key, nonce, encrypted, out_mic);
-            
-            if (result == CYBLE_ERROR_OK)
-            {
-                memcpy(data, encrypted, dataSize);
-            }
-            else
+
+            /* Encrypt in place in the request buffer */
+            result = CR_EncryptRow(dataAddr, &req->buffer[EMI_DATA_INDX], (uint16) dataSize);
+
+            if (result != CYBLE_ERROR_OK)
             {
                 if (result == CYBLE_ERROR_INVALID_PARAMETER)
                 {
-                    DBG_PRINT_TEXT("===============================================================================\r\n");                    
+                    DBG_PRINT_TEXT("===============================================================================\r\n");
                     DBG_PRINT_TEXT("=              ENCRYPTION ERROR: CYBLE_ERROR_INVALID_PARAMETER                 \r\n");
-                    DBG_PRINT_TEXT("===============================================================================\r\n");                    
+                    DBG_PRINT_TEXT("===============================================================================\r\n");
                 }
-                else 
+                else
                 {
                     DBG_PRINT_TEXT("===============================================================================\r\n");
                     DBG_PRINT_TEXT("=              ENCRYPTION ERROR:UNKNOWN:  ");
                     DBG_PRINT_HEX(result);
                     DBG_PRINT_TEXT("=\r\n");
-                    DBG_PRINT_TEXT("===============================================================================\r\n");                    
+                    DBG_PRINT_TEXT("===============================================================================\r\n");
                 }
                 return (result);
             }
-            
         }
     #endif /* (ENCRYPTION_ENABLED == YES) */
-    
-    for (i = 0; i < dataSize; i++)
-    {        
-        emiWriteBuffer[EMI_DATA_INDX + i] = data[i];   
+
+    req->operation = EMI_OPERATION_WRITE;
+    req->dataAddr  = dataAddr;
+    req->dataSize  = dataSize;
+    req->data      = NULL;
+    req->callback  = callback;
+    emiQueueCount++;
+
+    if ((EMI_XFER_STATE_IDLE == emiXferState) && (1u == emiQueueCount))
+    {
+        EMI_StartRequest();
     }
 
-	/* Write memory address bytes alone to initialize the pointer */
-	(void) EMI_I2CM_I2CMasterWriteBuf( i2cAddr,
-							    (uint8 *) emiWriteBuffer,
-	                            dataSize + EMI_DATA_INDX,
-	                            EMI_I2CM_I2C_MODE_COMPLETE_XFER);
+    return (CYRET_SUCCESS);
+}
+
 
-	while(0u == (EMI_I2CM_I2CMasterStatus() & EMI_I2CM_I2C_MSTAT_WR_CMPLT))
-	{
-	    /* Wait until master complete write */
-	}
+/*******************************************************************************
+* Function Name: EMI_SubmitRead
+********************************************************************************
+*
+* Summary:
+*  Queues the read of data from the external memory and returns without
+*  waiting for its completion. The data buffer must stay valid until the
+*  completion callback is called or EMI_WaitForIdle() returns.
+*
+* Parameters:
+*  uint32 dataAddr:
+*   The internal pointer value.
+*  uint32 dataSize:
+*   Size of output data
+*  uint8 *data:
+*   Pointer to buffer that receives data read from external memory
+*  EMI_CALLBACK_T callback:
+*   Function called from EMI_Process() when the read completes. May be NULL.
+*
+* Return:
+*  Status
+*     Value               Description
+*    CYRET_SUCCESS           Request is queued
+*    CYRET_MEMORY            Queue is full
+*******************************************************************************/
+cystatus EMI_SubmitRead(uint32 dataAddr, uint32 dataSize, uint8 *data, EMI_CALLBACK_T callback)
+{
+    EMI_REQUEST_T *req = EMI_AllocRequest();
 
-    if (0u == (EMI_I2CM_I2C_MSTAT_ERR_XFER & EMI_I2CM_I2CMasterStatus()))
+    if (NULL == req)
     {
-        status = CYRET_SUCCESS;
+        return (CYRET_MEMORY);
     }
 
-	/* Clear I2C master status */
-	(void) EMI_I2CM_I2CMasterClearStatus();
+    req->operation = EMI_OPERATION_READ;
+    req->dataAddr  = dataAddr;
+    req->dataSize  = dataSize;
+    req->data      = data;
+    req->callback  = callback;
+    emiQueueCount++;
 
-    return (status);
+    if ((EMI_XFER_STATE_IDLE == emiXferState) && (1u == emiQueueCount))
+    {
+        EMI_StartRequest();
+    }
+
+    return (CYRET_SUCCESS);
 }
 
 
+#if (EMI_BACKEND == EMI_BACKEND_SPI_NOR)
 /*******************************************************************************
-* Function Name: EMI_ReadData
+* Function Name: EMI_SubmitErase
 ********************************************************************************
 *
 * Summary:
-*  Read data from the external memory.
+*  Queues the erase of the external memory sector and returns without waiting
+*  for its completion.
 *
 * Parameters:
-*  uint32 dataAddr: The internal pointer value.
-*   
-*  uint32 dataSize: Size of output data
-*   
-*  uint8 *data:     Pointer to data that is read from external memory
-*   
+*  uint32 dataAddr:
+*   Address of the sector.
 *
 * Return:
 *  Status
 *     Value               Description
-*    CYRET_SUCCESS           Successful
-*    Other non-zero          Failure
-*    CYBLE_ERROR_INVALID_PARAMETER - problems with decryption
+*    CYRET_SUCCESS           Request is queued
+*    CYRET_MEMORY            Queue is full
 *******************************************************************************/
-cystatus EMI_ReadData(uint32 dataAddr, uint32 dataSize, uint8 *data)
+static cystatus EMI_SubmitErase(uint32 dataAddr)
+{
+    EMI_REQUEST_T *req = EMI_AllocRequest();
+
+    if (NULL == req)
+    {
+        return (CYRET_MEMORY);
+    }
+
+    req->operation = EMI_OPERATION_ERASE;
+    req->dataAddr  = dataAddr;
+    req->dataSize  = EMI_NO_DATA_SIZE;
+    req->data      = NULL;
+    req->callback  = NULL;
+    emiQueueCount++;
+
+    if ((EMI_XFER_STATE_IDLE == emiXferState) && (1u == emiQueueCount))
+    {
+        EMI_StartRequest();
+    }
+
+    return (CYRET_SUCCESS);
+}
+#endif /* (EMI_BACKEND == EMI_BACKEND_SPI_NOR) */
+
+
+/*******************************************************************************
+* Function Name: EMI_StartRequest
+********************************************************************************
+*
+* Summary:
+*  Passes the request at the queue head to the external memory backend. The
+*  metadata is erased before it is written on the memories that need erase.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*******************************************************************************/
+static void EMI_StartRequest(void)
+{
+    EMI_REQUEST_T *req = &emiQueue[emiQueueHead];
+
+    emiXferState = EMI_XFER_STATE_BUSY;
+
+    switch (req->operation)
+    {
+        case EMI_OPERATION_WRITE:
+            EMI_BackendStartWrite(req->dataAddr, req->buffer, req->dataSize,
+                                  (EMI_ERASE_SIZE > 1u) && (0u != req->dataSize) &&
+                                  EMI_IS_REWRITTEN_ADDR(req->dataAddr));
+            break;
+
+        case EMI_OPERATION_READ:
+            EMI_BackendStartRead(req->dataAddr, req->buffer, req->data, req->dataSize);
+            break;
+
+    #if (EMI_BACKEND == EMI_BACKEND_SPI_NOR)
+        case EMI_OPERATION_ERASE:
+            EMI_BackendStartErase(req->dataAddr);
+            break;
+    #endif /* (EMI_BACKEND == EMI_BACKEND_SPI_NOR) */
+
+        default:
+            break;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_CompleteRequest
+********************************************************************************
+*
+* Summary:
+*  Removes the request from the queue head, reports its status and starts the
+*  next queued request. The slot is released before the callback is called,
+*  so the callback is allowed to submit a new request.
+*
+* Parameters:
+*  cystatus status:
+*   Completion status of the request.
+*
+* Return:
+*  None
+*******************************************************************************/
+static void EMI_CompleteRequest(cystatus status)
+{
+    EMI_REQUEST_T *req = &emiQueue[emiQueueHead];
+    EMI_CALLBACK_T callback = req->callback;
+    uint32 dataAddr = req->dataAddr;
+    uint8 *data = req->data;
+
+    emiQueueHead = (emiQueueHead + 1u) % EMI_QUEUE_SIZE;
+    emiQueueCount--;
+    emiXferState = EMI_XFER_STATE_IDLE;
+
+    if (NULL != callback)
+    {
+        callback(status, dataAddr, data);
+    }
+    else if (CYRET_SUCCESS != status)
+    {
+        emiXferStatus = status;
+    }
+    else
+    {
+        /* Nothing to report */
+    }
+
+    if ((EMI_XFER_STATE_IDLE == emiXferState) && (0u != emiQueueCount))
+    {
+        EMI_StartRequest();
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_Process
+********************************************************************************
+*
+* Summary:
+*  Advances the operation in flight in the external memory backend and
+*  completes the request when the backend is done with it. Completion callbacks
+*  are called from this function. Must be called periodically while operations
+*  are queued.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*******************************************************************************/
+void EMI_Process(void)
 {
     cystatus status;
-    uint8 i2cAddr = (dataAddr > EMI_HIGHEST_ADDR_OF_LOW_BLOCK) ?
-                        EMI_I2C_SLAVE_ADDR_HIGH_64K :
-                        EMI_I2C_SLAVE_ADDR_LOW_64K;
-    status =  EMI_SetPointer(dataAddr);
+    #if (ENCRYPTION_ENABLED == YES)
+        EMI_REQUEST_T *req = &emiQueue[emiQueueHead];
+    #endif /* (ENCRYPTION_ENABLED == YES) */
 
-    if (CYRET_SUCCESS == status)
+    if (EMI_XFER_STATE_IDLE != emiXferState)
     {
-        /* Read the data from the FRAM into ReadBuf */
-        (void) EMI_I2CM_I2CMasterReadBuf(  i2cAddr,
-                                    (uint8 *) data,
-                                    dataSize,
-                                    EMI_I2CM_I2C_MODE_COMPLETE_XFER);
+        status = EMI_BackendProcess();
 
-        while(0u == (EMI_I2CM_I2CMasterStatus() & EMI_I2CM_I2C_MSTAT_RD_CMPLT))
+        if (CYRET_STARTED != status)
         {
-            /* Wait until master complete reading */
-        }
+            #if (ENCRYPTION_ENABLED == YES)
+                if ((CYRET_SUCCESS == status) && (EMI_OPERATION_READ == req->operation))
+                {
+                    status = EMI_DecryptData(req->dataAddr, req->dataSize, req->data);
+                }
+            #endif /* (ENCRYPTION_ENABLED == YES) */
 
-        if (0u != (EMI_I2CM_I2C_MSTAT_ERR_XFER & EMI_I2CM_I2CMasterStatus()))
-        {
-            status = CYRET_UNKNOWN;
+            EMI_CompleteRequest(status);
         }
+    }
+}
 
-        /* Clear I2C master status */
-        (void) EMI_I2CM_I2CMasterClearStatus();
-        
-        #if (ENCRYPTION_ENABLED == YES)
-        /*Encrypt data except to metadata*/
-        
 
-        if (dataAddr >= (META_DATA_ADDR + META_DATA_SIZE) && (dataSize>0))
+/*******************************************************************************
+* Function Name: EMI_WaitStep
+********************************************************************************
+*
+* Summary:
+*  Single step of waiting for the external memory. Advances the operation in
+*  flight, lets the BLE stack process its events in the bootloadable unless a
+*  received command is not read yet, and puts the CPU to Sleep until the next
+*  interrupt if the backend transfer is still in progress and its completion
+*  raises the interrupt.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*******************************************************************************/
+static void EMI_WaitStep(void)
+{
+    #if (0u != EMI_BACKEND_IRQ_WAKEUP)
+        uint8 interruptStatus;
+    #endif /* (0u != EMI_BACKEND_IRQ_WAKEUP) */
+
+    EMI_Process();
+
+    #if (CYDEV_BOOTLOADER_ENABLE == 0)
+        /* The Bootloader Service has the single receive buffer: the stack keeps
+        *  the next packets until the bootloader reads the one already received.
+        */
+        if (0u == cyBle_cmdReceivedFlag)
         {
-            uint8 key[KEY_LENGTH] = {0};
-            uint8 nonce[NONCE_LENGTH] = {0};
-            uint8 decrypted[ENC_BUFFER_SIZE] = {0};
-            uint8 out_mic[MIC_DATA_LENGTH]={0};
-            CYBLE_API_RESULT_T result;
-            
-            CR_ReadKey(key);
-            CR_ReadNonce(nonce);
-            result = CR_Decrypt(data, dataSize, key, nonce, decrypted, out_mic);
-            /* Invalid MIC_AUTH not checked  as it will consume additional memory and 
-               was not required.*/
-            if (result == CYBLE_ERROR_INVALID_PARAMETER)
-            {
-                DBG_PRINT_TEXT("DECRYPTION ERROR: CYBLE_ERROR_INVALID_PARAMETER            \r\n");
-                status = CYBLE_ERROR_INVALID_PARAMETER;
-            }
-            else
-            {
-                memcpy(data, decrypted, dataSize);
-            }                                            
+            CyBle_ProcessEvents();
         }
-    #endif /* (ENCRYPTION_ENABLED == YES) */
-    }
+    #endif /* (CYDEV_BOOTLOADER_ENABLE == 0) */
 
-    return (status);
+    #if (0u != EMI_BACKEND_IRQ_WAKEUP)
+        interruptStatus = CyEnterCriticalSection();
+        if ((EMI_XFER_STATE_IDLE != emiXferState) && (0u != EMI_BackendIsBusy()))
+        {
+            /* Pending interrupt wakes the CPU even though interrupts are disabled */
+            CySysPmSleep();
+        }
+        CyExitCriticalSection(interruptStatus);
+    #else
+        /* No interrupt ends the SPI NOR erase or program cycle: the CPU polls
+        *  the memory for up to EMI_SPI_NOR_ERASE_MAX_MS and does not sleep.
+        */
+    #endif /* (0u != EMI_BACKEND_IRQ_WAKEUP) */
 }
 
+
 /*******************************************************************************
-* Function Name: EMI_EraseAll
+* Function Name: EMI_WaitForIdle
 ********************************************************************************
 *
 * Summary:
-*  Erases content of the external memory.
+*  Waits until all queued operations are completed.
 *
 * Parameters:
-*  uint16 rowNum:
-*   The flash row number. The number of the flash rows is defined by the
-*   CY_FLASH_NUMBER_ROWS macro for the selected device. Refer to the device
-*   datasheet for the details.
-*
-*  uint8* rowData:
-*   Array of bytes to write. The size of the array must be equal to the flash
-*   row size. The flash row size for the selected device is defined by
-*   the CY_FLASH_SIZEOF_ROW macro. Refer to the device datasheet for the
-*   details.
+*  None
 *
 * Return:
-*  Status
-*     Value                     Description
-*    CY_SYS_FLASH_SUCCESS           Successful
-*    CY_SYS_FLASH_INVALID_ADDR      Specified flash row address is invalid
-*    CY_SYS_FLASH_PROTECTED         Specified flash row is protected
-*    Other non-zero                 Failure
-*
-* Side Effects:
-*   The IMO must be enabled before calling this function. The operation of the
-*   flash writing hardware is dependent on the IMO.
-*
+*  Status of the operations submitted without a completion callback
+*     Value               Description
+*    CYRET_SUCCESS           Successful
+*    Other non-zero          Failure
 *******************************************************************************/
-cystatus EMI_EraseAll(void)
+cystatus EMI_WaitForIdle(void)
 {
-    /* Ersase content of the external memory */
     cystatus status;
-    uint8  erase[CY_FLASH_SIZEOF_ROW] = {0u};
-    uint8  tmp[CY_FLASH_SIZEOF_ROW];
-    uint16 row;
 
-    for (row = 0; row < CY_FLASH_NUMBER_ROWS; row++)
+    while (0u != emiQueueCount)
     {
-        /* Read flash row data from external memory */
-        
-        (void) EMI_ReadData(EMI_APP_ABS_ADDR(row) , CY_FLASH_SIZEOF_ROW, tmp);                                
-        DBG_PRINT_TEXT("\t\t Before Erase: ");
-        DBG_PRINT_ARRAY(tmp, CY_FLASH_SIZEOF_ROW);
-        DBG_PRINT_TEXT("\r\n");               
+        EMI_WaitStep();
+    }
 
-        status = EMI_WriteData(EMI_APP_ABS_ADDR(row) , CY_FLASH_SIZEOF_ROW, erase);
+    status = emiXferStatus;
+    emiXferStatus = CYRET_SUCCESS;
 
-        (void) EMI_ReadData(EMI_APP_ABS_ADDR(row) , CY_FLASH_SIZEOF_ROW, tmp);                                
-        DBG_PRINT_TEXT("\t\t After Erase: ");
-        DBG_PRINT_ARRAY(tmp, CY_FLASH_SIZEOF_ROW);
-        DBG_PRINT_TEXT("\r\n");
-    }
-    
-    return (status);    
+    return (status);
 }
 
 
-#if (CYDEV_BOOTLOADER_ENABLE == 0)
 /*******************************************************************************
-* Function Name: BootloaderEmulator_CalcPacketChecksum
+* Function Name: EMI_ProcessUntilLastXfer
 ********************************************************************************
 *
 * Summary:
-*  This computes the 16 bit checksum for the provided number of bytes contained
-*  in the provided buffer
+*  Advances the operation at the queue head until the backend runs its last
+*  bus transfer, which completes the operation without the CPU. Called before
+*  the CPU is taken by a blocking operation, such as the flash row write, so
+*  the external memory transfer runs during it instead of after it. The I2C
+*  read, for example, writes the memory address before the data is read.
 *
 * Parameters:
-*  buffer:
-*     The buffer containing the data to compute the checksum for
-*  size:
-*     The number of bytes in the buffer to compute the checksum for
-*
-* Returns:
-*  16 bit checksum for the provided data
+*  None
 *
+* Return:
+*  None
 *******************************************************************************/
-static uint16 BootloaderEmulator_CalcPacketChecksum(const uint8 buffer[], uint16 size)
+void EMI_ProcessUntilLastXfer(void)
 {
-    #if(0u != BootloaderEmulator_PACKET_CHECKSUM_CRC)
+    while ((0u != emiQueueCount) && (0u == EMI_BackendIsLastXfer()))
+    {
+        EMI_Process();
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_GetQueueCount
+********************************************************************************
+*
+* Summary:
+*  Returns the number of the queued operations, including the one in flight.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Number of the outstanding operations.
+*******************************************************************************/
+uint32 EMI_GetQueueCount(void)
+{
+    return (emiQueueCount);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_WriteData
+********************************************************************************
+*
+* Summary:
+*  Write data to the external memory. The write is queued and the function
+*  returns without waiting for its completion; it blocks only while the queue
+*  is full. Use EMI_WaitForIdle() to wait for the write completion.
+*
+* Parameters:
+*  uint32 dataAddr:
+*   The internal pointer value.
+*  uint32 dataSize:
+*   Size of input data. Must not exceed CY_FLASH_SIZEOF_ROW.
+*  uint8 *data:
+*   Pointer to data that is written to external memory
+*
+* Return:
+*  Status
+*     Value               Description
+*    CYRET_SUCCESS           Successful
+*    CYRET_BAD_PARAM         Data size exceeds the write buffer
+*    Other non-zero          Failure
+*******************************************************************************/
+cystatus EMI_WriteData(uint32 dataAddr, uint32 dataSize, uint8 *data)
+{
+    cystatus status;
+
+    do
+    {
+        status = EMI_SubmitWrite(dataAddr, dataSize, data, NULL);
+
+        if (CYRET_MEMORY == status)
+        {
+            EMI_WaitStep();
+        }
+    }
+    while (CYRET_MEMORY == status);
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_ReadData
+********************************************************************************
+*
+* Summary:
+*  Read data from the external memory. Waits for the completion of all queued
+*  operations, including the read.
+*
+* Parameters:
+*  uint32 dataAddr: The internal pointer value.
+*
+*  uint32 dataSize: Size of output data
+*
+*  uint8 *data:     Pointer to data that is read from external memory
+*
+*
+* Return:
+*  Status
+*     Value               Description
+*    CYRET_SUCCESS           Successful
+*    Other non-zero          Failure
+*    CYBLE_ERROR_INVALID_PARAMETER - problems with decryption
+*******************************************************************************/
+cystatus EMI_ReadData(uint32 dataAddr, uint32 dataSize, uint8 *data)
+{
+    cystatus status;
+
+    do
+    {
+        status = EMI_SubmitRead(dataAddr, dataSize, data, NULL);
+
+        if (CYRET_MEMORY == status)
+        {
+            EMI_WaitStep();
+        }
+    }
+    while (CYRET_MEMORY == status);
+
+    return (EMI_WaitForIdle());
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_EraseData
+********************************************************************************
+*
+* Summary:
+*  Returns the area of the external memory to the erased state, all bytes are
+*  read back as 0xFF. The memories that need erase erase every sector the area
+*  touches; the others are written with 0xFF rows. The erase is queued like
+*  the write, use EMI_WaitForIdle() to wait for its completion.
+*
+* Parameters:
+*  uint32 dataAddr: Start of the area.
+*
+*  uint32 dataSize: Size of the area.
+*
+* Return:
+*  Status
+*     Value               Description
+*    CYRET_SUCCESS           Successful
+*    Other non-zero          Failure
+*******************************************************************************/
+cystatus EMI_EraseData(uint32 dataAddr, uint32 dataSize)
+{
+    cystatus status = CYRET_SUCCESS;
+    uint32 addr;
+
+#if (EMI_BACKEND == EMI_BACKEND_SPI_NOR)
+
+    for (addr = dataAddr - (dataAddr % EMI_ERASE_SIZE);
+         (addr < (dataAddr + dataSize)) && (CYRET_SUCCESS == status);
+         addr += EMI_ERASE_SIZE)
+    {
+        do
+        {
+            status = EMI_SubmitErase(addr);
+
+            if (CYRET_MEMORY == status)
+            {
+                EMI_WaitStep();
+            }
+        }
+        while (CYRET_MEMORY == status);
+    }
+
+#else
+
+    uint8  empty[CY_FLASH_SIZEOF_ROW];
+    uint32 size;
+
+    (void) memset(empty, 0xFF, CY_FLASH_SIZEOF_ROW);
+
+    for (addr = dataAddr; (addr < (dataAddr + dataSize)) && (CYRET_SUCCESS == status); addr += size)
+    {
+        size = dataAddr + dataSize - addr;
+        if (size > CY_FLASH_SIZEOF_ROW)
+        {
+            size = CY_FLASH_SIZEOF_ROW;
+        }
+
+        status = EMI_WriteData(addr, size, empty);
+    }
+
+#endif /* (EMI_BACKEND == EMI_BACKEND_SPI_NOR) */
+
+    return (status);
+}
+
+
+#if (ENCRYPTION_ENABLED == YES)
+/*******************************************************************************
+* Function Name: EMI_DecryptData
+********************************************************************************
+*
+* Summary:
+*  Decrypts data read from the external memory in place. Metadata and row
+*  digests are not encrypted.
+*
+* Parameters:
+*  uint32 dataAddr: External memory address the data was read from.
+*  uint32 dataSize: Size of data
+*  uint8 *data:     Pointer to data read from external memory
+*
+* Return:
+*  Status
+*     Value               Description
+*    CYRET_SUCCESS           Successful
+*    CYBLE_ERROR_INVALID_PARAMETER - problems with decryption
+*******************************************************************************/
+static cystatus EMI_DecryptData(uint32 dataAddr, uint32 dataSize, uint8 *data)
+{
+    cystatus status = CYRET_SUCCESS;
+
+    if (EMI_IS_ENCRYPTED_ADDR(dataAddr) && (dataSize>0))
+    {
+        /* Invalid MIC_AUTH not checked  as it will consume additional memory and
+           was not required.*/
+        if (CR_DecryptRow(dataAddr, data, (uint16) dataSize) == CYBLE_ERROR_INVALID_PARAMETER)
+        {
+            DBG_PRINT_TEXT("DECRYPTION ERROR: CYBLE_ERROR_INVALID_PARAMETER            \r\n");
+            status = CYBLE_ERROR_INVALID_PARAMETER;
+        }
+    }
+
+    return (status);
+}
+#endif /* (ENCRYPTION_ENABLED == YES) */
+
+/*******************************************************************************
+* Function Name: EMI_EraseAll
+********************************************************************************
+*
+* Summary:
+*  Erases the regions of the external memory layout: the metadata, the
+*  application rows and the row digest table. Each region is erased with
+*  EMI_EraseData(), so the SPI NOR sectors are erased and the FRAM is written
+*  with 0xFF rows, which none of the metadata status fields takes as valid.
+*  Waits for the completion of the erase.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Status
+*     Value               Description
+*    CYRET_SUCCESS           Successful
+*    Other non-zero          Failure
+*
+*******************************************************************************/
+cystatus EMI_EraseAll(void)
+{
+    cystatus status;
+
+    status = EMI_EraseData(EMI_MD_BASE_ADDR, EMI_APP_BASE_ADDR - EMI_MD_BASE_ADDR);
+
+    if (CYRET_SUCCESS == status)
+    {
+        status = EMI_EraseData(EMI_APP_BASE_ADDR, EMI_DIGEST_BASE_ADDR - EMI_APP_BASE_ADDR);
+    }
+
+    if (CYRET_SUCCESS == status)
+    {
+        status = EMI_EraseData(EMI_DIGEST_BASE_ADDR, EMI_DIGEST_TABLE_SIZE);
+    }
+
+    if (CYRET_SUCCESS == status)
+    {
+        status = EMI_WaitForIdle();
+    }
+    else
+    {
+        (void) EMI_WaitForIdle();
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_RowDigest
+********************************************************************************
+*
+* Summary:
+*  Calculates the digest of the application row: the sum of its bytes and the
+*  flag that the row contains bytes other than 0x00 and 0xFF.
+*
+* Parameters:
+*  uint8 data[]: The row data.
+*
+* Return:
+*  The row digest.
+*
+*******************************************************************************/
+static uint16 EMI_RowDigest(const uint8 data[])
+{
+    uint16 digest = 0u;
+    uint16 dataFlag = 0u;
+    uint32 i;
+
+    for (i = 0u; i < CY_FLASH_SIZEOF_ROW; i++)
+    {
+        if ((data[i] != 0u) && (data[i] != 0xFFu))
+        {
+            dataFlag = EMI_DIGEST_DATA_FLAG;
+        }
+        digest += data[i];
+    }
+
+    return (digest | dataFlag);
+}
+
+
+#if (CYDEV_BOOTLOADER_ENABLE == 0)
+/*******************************************************************************
+* Function Name: EMI_DigestAddRow
+********************************************************************************
+*
+* Summary:
+*  Writes the digest of the programmed application row to the digest table.
+*  The digest also marks the row as received, so the update can be resumed.
+*
+* Parameters:
+*  uint16 row:   The application row number in the external memory.
+*  uint8 data[]: The row data.
+*
+* Return:
+*  The sum of the row bytes.
+*
+*******************************************************************************/
+uint16 EMI_DigestAddRow(uint16 row, const uint8 data[])
+{
+    uint8  entry[EMI_DIGEST_SIZE_OF_ENTRY];
+    uint16 digest = EMI_RowDigest(data);
+
+    if (row < EMI_DIGEST_MAX_ROWS)
+    {
+        entry[0u] = LO8(digest);
+        entry[1u] = HI8(digest);
+        (void) EMI_WriteData(EMI_DIGEST_ENTRY_ADDR(row), EMI_DIGEST_SIZE_OF_ENTRY, entry);
+    }
+
+    return (digest & EMI_DIGEST_SUM_MASK);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_DigestClear
+********************************************************************************
+*
+* Summary:
+*  Marks all rows of the digest table as not received.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void EMI_DigestClear(void)
+{
+    /* Erased entry reads as EMI_DIGEST_EMPTY */
+    (void) EMI_EraseData(EMI_DIGEST_BASE_ADDR, EMI_DIGEST_TABLE_SIZE);
+
+    emiPreparedRow = EMI_APP_MAX_ROWS;
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_PrepareAppRow
+********************************************************************************
+*
+* Summary:
+*  Makes the application row ready to be written. On the memories that need
+*  erase, the sector of the row is erased when the first of its rows arrives.
+*  The digest table tells whether any row of the sector was received, so the
+*  rows stored before an interrupted update are kept.
+*
+* Parameters:
+*  uint16 row: The application row number in the external memory.
+*
+* Return:
+*  Status of the digest table read. The sector is not erased if the table
+*  could not be read.
+*
+*******************************************************************************/
+cystatus EMI_PrepareAppRow(uint16 row)
+{
+    uint32 firstRow = (uint32) row - ((uint32) row % EMI_ROWS_IN_ERASE);
+    cystatus status = CYRET_SUCCESS;
+    uint16 lastRow;
+
+    if ((EMI_ERASE_SIZE > 1u) && (firstRow != emiPreparedRow))
+    {
+        status = EMI_DigestRowMap(firstRow, EMI_ROWS_IN_ERASE, NULL, &lastRow);
+
+        if (CYRET_SUCCESS == status)
+        {
+            if (0u == lastRow)
+            {
+                (void) EMI_EraseData(EMI_APP_ABS_ADDR(firstRow), EMI_ERASE_SIZE);
+            }
+
+            emiPreparedRow = firstRow;
+        }
+    }
+
+    return (status);
+}
+
+
+#endif /* (CYDEV_BOOTLOADER_ENABLE == 0) */
+
+
+/*******************************************************************************
+* Function Name: EMI_DigestRowMap
+********************************************************************************
+*
+* Summary:
+*  Builds the bitmap of the received application rows from the digest table.
+*
+* Parameters:
+*  uint32 firstRow: The application row of the bit 0 of the map.
+*  uint32 rows:     The number of the rows in the map.
+*  uint8 map[]:     The bitmap output, (rows + 7) / 8 bytes. May be NULL.
+*  uint16 *lastRow: The number of the rows up to the last received one.
+*
+* Return:
+*  Status of the digest table read. The map and lastRow are not valid if it
+*  failed.
+*
+*******************************************************************************/
+cystatus EMI_DigestRowMap(uint32 firstRow, uint32 rows, uint8 map[], uint16 *lastRow)
+{
+    uint8  digestRow[CY_FLASH_SIZEOF_ROW];
+    uint16 digest;
+    uint32 entry;
+    uint32 row;
+    cystatus status = CYRET_SUCCESS;
+
+    *lastRow = 0u;
+
+    if (NULL != map)
+    {
+        (void) memset(map, 0, (rows + 7u) / 8u);
+    }
+
+    for (row = firstRow; (row < (firstRow + rows)) && (row < EMI_DIGEST_MAX_ROWS) && (CYRET_SUCCESS == status); row++)
+    {
+        entry = EMI_DIGEST_ENTRY_INDX(row);
+
+        if ((0u == entry) || (row == firstRow))
+        {
+            status = EMI_ReadData(EMI_DIGEST_ROW_ADDR(row), CY_FLASH_SIZEOF_ROW, digestRow);
+            if (CYRET_SUCCESS != status)
+            {
+                break;
+            }
+        }
+
+        digest = ((uint16)((uint16)digestRow[entry + 1u] << 8u)) | digestRow[entry];
+
+        if (EMI_DIGEST_EMPTY != digest)
+        {
+            if (NULL != map)
+            {
+                map[(row - firstRow) >> 3u] |= (uint8) (1u << ((row - firstRow) & 0x07u));
+            }
+            *lastRow = (uint16) (row + 1u);
+        }
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_DigestSum
+********************************************************************************
+*
+* Summary:
+*  Sums the application rows using the digest table instead of reading the
+*  rows themselves. The digest table is valid only if the metadata Digest
+*  Status field is EMI_MD_DIGEST_STATUS_VALID.
+*
+*  Rows absent from a delta image are unchanged, they are summed from the
+*  internal flash.
+*
+* Parameters:
+*  uint16 rows:      The number of the application rows to sum.
+*  uint16 baseRow:   The flash row of the application row 0 for a delta image,
+*                    EMI_DIGEST_NO_BASE for a full image.
+*  uint16 *sum:      The sum of the bytes of the rows.
+*  uint32 *dataFlag: Non-zero if the rows have bytes other than 0x00 and 0xFF.
+*
+* Return:
+*  Status
+*     Value               Description
+*    CYRET_SUCCESS           Successful
+*    CYRET_BAD_DATA          Some of the rows were not received
+*    Other non-zero          External memory read failed
+*
+*******************************************************************************/
+cystatus EMI_DigestSum(uint16 rows, uint16 baseRow, uint16 *sum, uint32 *dataFlag)
+{
+    uint8  digestRow[CY_FLASH_SIZEOF_ROW];
+    uint16 digest;
+    uint32 entry;
+    uint16 row;
+    cystatus status = CYRET_SUCCESS;
+
+    *sum = 0u;
+    *dataFlag = 0u;
+
+    for (row = 0u; (row < rows) && (CYRET_SUCCESS == status); row++)
+    {
+        entry = EMI_DIGEST_ENTRY_INDX(row);
+
+        if (0u == entry)
+        {
+            status = EMI_ReadData(EMI_DIGEST_ROW_ADDR(row), CY_FLASH_SIZEOF_ROW, digestRow);
+        }
+
+        digest = ((uint16)((uint16)digestRow[entry + 1u] << 8u)) | digestRow[entry];
+
+        if (EMI_DIGEST_EMPTY == digest)
+        {
+            if (EMI_DIGEST_NO_BASE != baseRow)
+            {
+                /* Unchanged row of the delta image */
+                digest = EMI_RowDigest((const uint8 *) EMI_FLASH_ROW_ADDR(baseRow + row));
+            }
+            else
+            {
+                status = CYRET_BAD_DATA;
+            }
+        }
+
+        *sum += digest & EMI_DIGEST_SUM_MASK;
+        if (0u != (digest & EMI_DIGEST_DATA_FLAG))
+        {
+            *dataFlag = 1u;
+        }
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_DigestCheckRow
+********************************************************************************
+*
+* Summary:
+*  Checks the application row read from the external memory against its
+*  digest, so the damaged row is found before it is programmed. The digest
+*  table is valid only if the metadata Digest Status field is
+*  EMI_MD_DIGEST_STATUS_VALID.
+*
+* Parameters:
+*  uint16 row:   The application row number in the external memory.
+*  uint8 data[]: The row data.
+*
+* Return:
+*  Status
+*     Value               Description
+*    CYRET_SUCCESS           The row matches its digest
+*    CYRET_BAD_DATA          The row does not match or was not received
+*    Other non-zero          External memory read failed
+*
+*******************************************************************************/
+cystatus EMI_DigestCheckRow(uint16 row, const uint8 data[])
+{
+    uint8  entry[EMI_DIGEST_SIZE_OF_ENTRY];
+    cystatus status = CYRET_BAD_DATA;
+
+    if (row < EMI_DIGEST_MAX_ROWS)
+    {
+        status = EMI_ReadData(EMI_DIGEST_ENTRY_ADDR(row), EMI_DIGEST_SIZE_OF_ENTRY, entry);
+
+        if ((CYRET_SUCCESS == status) &&
+            ((((uint16)((uint16)entry[1u] << 8u)) | entry[0u]) != EMI_RowDigest(data)))
+        {
+            status = CYRET_BAD_DATA;
+        }
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_ImageCrcAddRow
+********************************************************************************
+*
+* Summary:
+*  Continues the image CRC-32 over the next application row. The rows must be
+*  added in the row order.
+*
+* Parameters:
+*  uint32 crc:   The CRC of the previous rows or CRC_32_INITIAL_VALUE.
+*  uint16 row:   The application row number in the external memory.
+*  uint8 data[]: The row data.
+*
+* Return:
+*  The updated CRC, not inverted.
+*
+*******************************************************************************/
+uint32 EMI_ImageCrcAddRow(uint32 crc, uint16 row, const uint8 data[])
+{
+    uint8 rowNum[EMI_IMAGE_CRC_ROW_NUM_SIZE];
+
+    rowNum[0u] = LO8(row);
+    rowNum[1u] = HI8(row);
+
+    crc = CRC_Crc32Update(crc, rowNum, EMI_IMAGE_CRC_ROW_NUM_SIZE);
+
+    return (CRC_Crc32Update(crc, data, CY_FLASH_SIZEOF_ROW));
+}
+
+
+#if (CYDEV_BOOTLOADER_ENABLE == 0)
+/*******************************************************************************
+* Function Name: EMI_ImageCrcCalc
+********************************************************************************
+*
+* Summary:
+*  Computes the image CRC-32 by reading the application rows back from the
+*  external memory. Used only when the rows did not arrive in order, e.g. the
+*  update was resumed. The rows of a delta image are found in the digest table,
+*  which is valid only if the metadata Digest Status field is
+*  EMI_MD_DIGEST_STATUS_VALID.
+*
+* Parameters:
+*  uint16 rows:       The number of the application rows.
+*  uint32 deltaImage: Non-zero if only the rows with a digest are stored.
+*  uint32 *crc:       The image CRC-32.
+*
+* Return:
+*  Status
+*     Value               Description
+*    CYRET_SUCCESS           Successful
+*    CYRET_BAD_DATA          The rows of the delta image are unknown
+*    Other non-zero          External memory read failed
+*
+*******************************************************************************/
+cystatus EMI_ImageCrcCalc(uint16 rows, uint32 deltaImage, uint32 *crc)
+{
+    uint8  rowData[CY_FLASH_SIZEOF_ROW];
+    uint8  entry[EMI_DIGEST_SIZE_OF_ENTRY];
+    uint32 rowStored;
+    uint16 row;
+    cystatus status = CYRET_SUCCESS;
+
+    *crc = CRC_32_INITIAL_VALUE;
+
+    for (row = 0u; (row < rows) && (CYRET_SUCCESS == status); row++)
+    {
+        rowStored = 1u;
+
+        if (0u != deltaImage)
+        {
+            status = (row < EMI_DIGEST_MAX_ROWS) ?
+                EMI_ReadData(EMI_DIGEST_ENTRY_ADDR(row), EMI_DIGEST_SIZE_OF_ENTRY, entry) : CYRET_BAD_DATA;
+
+            /* Rows absent from the delta image are not in the CRC */
+            rowStored = (uint32) (EMI_DIGEST_EMPTY != (((uint16)((uint16)entry[1u] << 8u)) | entry[0u]));
+        }
+
+        if ((CYRET_SUCCESS == status) && (0u != rowStored))
+        {
+            status = EMI_ReadData(EMI_APP_ABS_ADDR(row), CY_FLASH_SIZEOF_ROW, rowData);
+            *crc = EMI_ImageCrcAddRow(*crc, row, rowData);
+        }
+    }
+
+    *crc = ~(*crc);
+
+    return (status);
+}
+#endif /* (CYDEV_BOOTLOADER_ENABLE == 0) */
+
+
+#if (CYDEV_BOOTLOADER_ENABLE == 0)
+/*******************************************************************************
+* Function Name: BootloaderEmulator_CalcPacketChecksum
+********************************************************************************
+*
+* Summary:
+*  This computes the 16 bit checksum for the provided number of bytes contained
+*  in the provided buffer
+*
+* Parameters:
+*  buffer:
+*     The buffer containing the data to compute the checksum for
+*  size:
+*     The number of bytes in the buffer to compute the checksum for
+*
+* Returns:
+*  16 bit checksum for the provided data
+*
+*******************************************************************************/
+static uint16 BootloaderEmulator_CalcPacketChecksum(const uint8 buffer[], uint16 size)
+{
+    #if(0u != BootloaderEmulator_PACKET_CHECKSUM_CRC)
+
+        uint16 CYDATA crc;
+
+        crc = ( uint16 )(~CRC_CcittCalc(buffer, size));
+        crc = ( uint16 )(crc << 8u) | (crc >> 8u);
+
+        return(crc);
+
+    #else
+
+        uint16 CYDATA sum = 0u;
+
+        while (size > 0u)
+        {
+            sum += buffer[size - 1u];
+            size--;
+        }
+
+        return(( uint16 )1u + ( uint16 )(~sum));
+
+    #endif /* (0u != BootloaderEmulator_PACKET_CHECKSUM_CRC) */
+}
+
+
+/*******************************************************************************
+* Function Name: BootloaderEmulator_Calc8BitSum
+********************************************************************************
+*
+* Summary:
+*  This computes the 8 bit sum for the provided number of bytes contained in
+*  FRAM.
+*
+* Parameters:
+* rowNum :
+*   Flash row number as located in the external memory.
+*
+* Returns:
+*   The 8 bit sum for the provided data.
+*
+*******************************************************************************/
+uint32 BootloaderEmulator_Calc8BitSum(uint32 rowNum)
+{
+    uint32 sum = 0u;
+    uint8 flashRowFromExtMem[CY_FLASH_SIZEOF_ROW];
+    uint32 size = CY_FLASH_SIZEOF_ROW;
+
+    (void) EMI_ReadData(EMI_APP_ABS_ADDR(rowNum), CY_FLASH_SIZEOF_ROW, flashRowFromExtMem);
+
+    DBG_PRINT_TEXT("\r\n");
+    DBG_PRINT_TEXT("BootloaderEmulator:\r\n");
+    DBG_PRINT_TEXT("\tBootloaderEmulator_Calc8BitSum():\r\n");
+
+    DBG_PRINT_TEXT("\t\trowNum  = ");
+    DBG_PRINT_DEC( (uint16) rowNum);
+    DBG_PRINT_TEXT("\r\n");
+
+    DBG_PRINT_TEXT("\t\tEMI_APP_ABS_ADDR(rowNum)  = ");
+    DBG_PRINT_HEX(EMI_APP_ABS_ADDR((uint16)rowNum));
+    DBG_PRINT_TEXT("\r\n");
+
+    DBG_PRINT_TEXT("\t\tEMI_ReadData():\r\n");
+    DBG_PRINT_ARRAY(flashRowFromExtMem, size);
+    DBG_PRINT_TEXT("\r\n");
+
+
+    while (size > 0u)
+    {
+        size--;
+        sum += flashRowFromExtMem[size];
+    }
+
+    return(sum);
+}
+
+
+/*******************************************************************************
+* Function Name: BootloaderEmulator_Start
+********************************************************************************
+* Summary:
+*  This function is called in order to execute the following algorithm:
+*
+*  - Identify the active bootloadable application (applicable only to
+*    the Multi-application bootloader)
+*
+*  - Validate the bootloader application (design-time configurable, Bootloader
+*    application validation option of the component customizer)
+*
+*  - Validate the active bootloadable application. If active bootloadable
+*    application is not valid, and the other bootloadable application (inactive)
+*    is valid, the last one is started.
+*
+*  - Run a communication subroutine (design-time configurable, Wait for command
+*    option of the component customizer)
+*
+*  - Schedule the bootloadable and reset the device
+*
+* Parameters:
+*  None
+*
+* Return:
+*  This method will never return. It will either load a new application and
+*  reset the device or jump directly to the existing application. The CPU is
+*  halted, if validation failed when "Bootloader application validation" option
+*  is enabled.
+*  PSoC 3/PSoC 5: The CPU is halted if Flash initialization fails.
+*
+* Side Effects:
+*  If Bootloader application validation option is enabled and this method
+*  determines that the bootloader application itself is corrupt, this method
+*  will not return, instead it will simply hang the application.
+*
+*******************************************************************************/
+void BootloaderEmulator_Start(void)
+{
+    EMI_Start();
+    BootloaderEmulator_HostLink(BootloaderEmulator_WAIT_FOR_COMMAND_FOREVER);
+}
+
+
+/*******************************************************************************
+* Function Name: BootloaderEmulator_ValidateBootloadable
+********************************************************************************
+* Summary:
+*  Performs the bootloadable application validation by calculating the
+*  application image checksum and comparing it with the checksum value stored
+*  in the Bootloadable Application Checksum field of the metadata section.
+*
+*  If the Fast bootloadable application validation option is enabled in the
+*  component customizer and bootloadable application successfully passes
+*  validation, the Bootloadable Application Verification Status field of the
+*  metadata section is updated. Refer to the Metadata Layout section for the
+*  details.
+*
+*  If the Fast bootloadable application validation option is enabled and
+*  Bootloadable Application Verification Status field of the metadata section
+*  claims that bootloadable application is valid, the function returns
+*  CYRET_SUCCESS without further checksum calculation.
+*
+* Parameters:
+*  appId:
+*  The number of the bootloadable application should be 0 for the normal
+*  bootloader and 0 or 1 for the Multi-Application bootloader.
+*
+* Returns:
+*  Returns CYRET_SUCCESS if the specified bootloadable application is valid.
+*
+*******************************************************************************/
+cystatus BootloaderEmulator_ValidateBootloadable(void)
+{
+    uint8 appChecksum;
+    uint8 calcedChecksum = 0u;
+    uint8   appFlashRow[CY_FLASH_SIZEOF_ROW];
+    uint32 row;
+    uint32 i;
+    uint32 valid = 0u;
+
+    cystatus status = CYRET_SUCCESS;
+
+    if (0u != appSizeInRows)
+    {
+        /* Get bootloadable application checksum from external memory */
+        (void) EMI_ReadData(EMI_APP_ABS_ADDR(appSizeInRows - 1u), CY_FLASH_SIZEOF_ROW, appFlashRow);
+
+
+        DBG_PRINT_TEXT("\t\t Metadata Row: ");
+        DBG_PRINT_ARRAY(appFlashRow, CY_FLASH_SIZEOF_ROW);
+        DBG_PRINT_TEXT("\r\n");
+
+        appChecksum = appFlashRow[BootloaderEmulator_MD_APP_CHECKSUM];
+
+
+        if (EMI_MD_DIGEST_STATUS_VALID == metadata[EMI_MD_DIGEST_STATUS_ADDR])
+        {
+            /* Use the row digests collected while programming */
+            uint16 digestSum;
+
+            if (CYRET_SUCCESS != EMI_DigestSum(appSizeInRows - 1u, EMI_DIGEST_BASE_ROW(metadata, appFirstRowNum),
+                                               &digestSum, &valid))
+            {
+                /* Not all rows were received */
+                valid = 0u;
+            }
+            calcedChecksum = LO8(digestSum);
+        }
+        else
+        {
+            for (row = 0u; row < (appSizeInRows - 1u); row++)
+            {
+                /* Read flash row data from external memory */
+                (void) EMI_ReadData(EMI_APP_ABS_ADDR(row) , CY_FLASH_SIZEOF_ROW, appFlashRow);
+
+                /* Calculate checksum of application row */
+                for(i = 0u; i < CY_FLASH_SIZEOF_ROW; i++)
+                {
+                    if((appFlashRow[i] != 0u) && (appFlashRow[i] != 0xFFu))
+                    {
+                        valid = 1u;
+                    }
+                    calcedChecksum += appFlashRow[i];
+                }
+            }
+        }
+
+        calcedChecksum = ( uint8 )1u + ( uint8 )(~calcedChecksum);
+
+        if((calcedChecksum != appChecksum) || (0u == valid))
+        {
+            status = CYRET_BAD_DATA;
+        }
+        
+        DBG_PRINT_TEXT("\r\n");
+        DBG_PRINT_TEXT("BootloaderEmulator:\r\n");
+        DBG_PRINT_TEXT("\tBootloaderEmulator_ValidateBootloadable() Status: ");
+        DBG_PRINT_DEC( (uint16) status);
+        DBG_PRINT_TEXT("\r\n");
+
+        DBG_PRINT_TEXT("\t\tStored Bootloadable Application Checksum  = ");
+        DBG_PRINT_DEC( (uint16) appChecksum);
+        DBG_PRINT_TEXT("\r\n");
+
+        DBG_PRINT_TEXT("\t\tCalculated Bootloadable Application Checksum  = ");
+        DBG_PRINT_DEC( (uint16) calcedChecksum);
+        DBG_PRINT_TEXT("\r\n");
+    }
+    else
+    {
+        status = CYRET_BAD_DATA;
+        DBG_PRINT_TEXT("\r\n");
+        DBG_PRINT_TEXT("Error: Stored data length = 0.");
+        DBG_PRINT_TEXT("\r\n");
+    }
+    
+
+    return(status);
+}
+
+
+/*******************************************************************************
+* Function Name: BootloaderEmulator_StartSession
+********************************************************************************
+*
+* Summary:
+*  Starts the new update on the first received row: invalidates the stored
+*  application, clears the row digests and generates the encryption key.
+*
+* Parameters:
+*  uint16 firstRow: The first flash row of the bootloadable application.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BootloaderEmulator_StartSession(uint16 firstRow)
+{
+    appFirstRowNum = firstRow;
+    appSizeInRows = 0u;
+    appExtMemChecksum = 0u;
+    btldrMdRow = BootloaderEmulator_MD_ROW_NONE;
+    btldrImageCrc = CRC_32_INITIAL_VALUE;
+    btldrImageCrcRow = 0u;
+
+    (void) memset(metadata, 0, CY_FLASH_SIZEOF_ROW);
+    metadata[EMI_MD_APP_FIRST_ROW_NUM_ADDR    ] = LO8(appFirstRowNum);
+    metadata[EMI_MD_APP_FIRST_ROW_NUM_ADDR + 1u] = HI8(appFirstRowNum);
+    metadata[EMI_MD_DIGEST_STATUS_ADDR] = EMI_MD_DIGEST_STATUS_VALID;
+    metadata[EMI_MD_RESUME_STATUS_ADDR] = EMI_MD_RESUME_STATUS_ACTIVE;
+
+    if (0u != btldrDeltaRows)
+    {
+        metadata[EMI_MD_IMAGE_TYPE_ADDR] = EMI_MD_IMAGE_TYPE_DELTA;
+        metadata[EMI_MD_APP_SIZE_IN_ROWS_ADDR     ] = LO8(btldrDeltaRows);
+        metadata[EMI_MD_APP_SIZE_IN_ROWS_ADDR + 1u] = HI8(btldrDeltaRows);
+    }
+
+    DBG_PRINT_TEXT("\r\n");
+    DBG_PRINT_TEXT("Metadata before: ");
+    DBG_PRINT_ARRAY(metadata, 32u);
+    DBG_PRINT_TEXT("\r\n");
+
+    /* Invalidate the stored application until the update completes */
+    (void) EMI_WriteData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW, metadata);
+
+    DBG_PRINT_TEXT("\r\n");
+    DBG_PRINT_TEXT("Metadata after: ");
+    DBG_PRINT_ARRAY(metadata, 32u);
+    DBG_PRINT_TEXT("\r\n");
+
+    EMI_DigestClear();
+
+    #if (ENCRYPTION_ENABLED == YES)
+        /*Generate key*/
+        CR_GenerateKey(emiKey);
+        DBG_PRINT_TEXT("Generated Key: ");
+        DBG_PRINT_ARRAY(emiKey, KEY_LENGTH);
+        DBG_PRINT_TEXT("\r\n");
+        CR_WriteKey(emiKey);
+        CR_ReadKey(emiKey);
+        DBG_PRINT_TEXT("Read Key     : ");
+        DBG_PRINT_ARRAY(emiKey, KEY_LENGTH);
+        DBG_PRINT_TEXT("\r\n");
+    #endif /*(ENCRYPTION_ENABLED == YES)*/
+
+    btldrSession = BootloaderEmulator_SESSION_ACTIVE;
+}
+
+
+/*******************************************************************************
+* Function Name: BootloaderEmulator_ResumeSession
+********************************************************************************
+*
+* Summary:
+*  Continues the interrupted update. The rows already stored in the external
+*  memory are kept along with the encryption key they were written with and
+*  the image type.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Status
+*     Value               Description
+*    CYRET_SUCCESS           The update can be resumed
+*    CYRET_BAD_DATA          No interrupted update is stored
+*    Other                   The external memory read failed
+*
+*******************************************************************************/
+static cystatus BootloaderEmulator_ResumeSession(void)
+{
+    cystatus status;
+
+    status = EMI_ReadData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW, metadata);
+
+    if ((CYRET_SUCCESS == status) &&
+        (EMI_MD_RESUME_STATUS_ACTIVE == metadata[EMI_MD_RESUME_STATUS_ADDR]) &&
+        (EMI_MD_DIGEST_STATUS_VALID == metadata[EMI_MD_DIGEST_STATUS_ADDR]))
+    {
+        status = EMI_DigestRowMap(0u, EMI_DIGEST_MAX_ROWS, NULL, &appSizeInRows);
+    }
+    else if (CYRET_SUCCESS == status)
+    {
+        status = CYRET_BAD_DATA;
+    }
+    else
+    {
+        /* Metadata read failed */
+    }
+
+    if (CYRET_SUCCESS == status)
+    {
+        appFirstRowNum = ((uint16)((uint16)metadata[EMI_MD_APP_FIRST_ROW_NUM_ADDR + 1u] << 8u)) |
+                                   metadata[EMI_MD_APP_FIRST_ROW_NUM_ADDR];
+        appExtMemChecksum = 0u;
+        btldrMdRow = BootloaderEmulator_MD_ROW_NONE;
+
+        /* The CRC of the rows stored before the interruption is not known */
+        btldrImageCrcRow = BootloaderEmulator_IMAGE_CRC_BROKEN;
+
+        if (EMI_MD_IMAGE_TYPE_DELTA == metadata[EMI_MD_IMAGE_TYPE_ADDR])
+        {
+            btldrDeltaRows = ((uint16)((uint16)metadata[EMI_MD_APP_SIZE_IN_ROWS_ADDR + 1u] << 8u)) |
+                                       metadata[EMI_MD_APP_SIZE_IN_ROWS_ADDR];
+        }
+        btldrSession = BootloaderEmulator_SESSION_ACTIVE;
+
+        DBG_PRINT_TEXT("\r\n");
+        DBG_PRINT_TEXT("Resuming update, rows stored: 0x");
+        DBG_PRINT_HEX(appSizeInRows);
+        DBG_PRINT_TEXT("\r\n");
+    }
+    else
+    {
+        (void) memset(metadata, 0, CY_FLASH_SIZEOF_ROW);
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: BootloaderEmulator_ImageRow
+********************************************************************************
+*
+* Summary:
+*  Returns the external memory row of the flash row sent by the host. The
+*  bootloadable metadata row is placed after the application rows, where the
+*  bootloader expects it.
+*
+* Parameters:
+*  uint16 flashRow: The flash row number.
+*
+* Return:
+*  The application row number in the external memory.
+*
+*******************************************************************************/
+static uint16 BootloaderEmulator_ImageRow(uint16 flashRow)
+{
+    uint16 row;
+
+    if (BootloaderEmulator_MD_FLASH_ROW == flashRow)
+    {
+        if (BootloaderEmulator_MD_ROW_NONE == btldrMdRow)
+        {
+            /* The delta image size is known in advance */
+            btldrMdRow = (0u != btldrDeltaRows) ? (btldrDeltaRows - 1u) : appSizeInRows;
+        }
+        row = btldrMdRow;
+    }
+    else
+    {
+        row = flashRow - appFirstRowNum;
+    }
+
+    return (row);
+}
+
+
+/*******************************************************************************
+* Function Name: BootloaderEmulator_GetMetadata
+********************************************************************************
+*
+* Summary:
+*  Reads the 4-byte field of the bootloadable metadata of the running
+*  application. The fields are not aligned, so the bytes are read one by one.
+*
+* Parameters:
+*  uint32 offset: The offset of the field in the metadata.
+*
+* Return:
+*  The field value.
+*
+*******************************************************************************/
+static uint32 BootloaderEmulator_GetMetadata(uint32 offset)
+{
+    const uint8 *field = (const uint8 *) (BootloaderEmulator_MD_ADDR + offset);
+
+    return (((uint32)field[3u] << 24u) | ((uint32)field[2u] << 16u) | ((uint32)field[1u] << 8u) | field[0u]);
+}
+
+
+#if (0u != BootloaderEmulator_CMD_DELTA_AVAIL)
+/*******************************************************************************
+* Function Name: BootloaderEmulator_RunningImageCrc
+********************************************************************************
+*
+* Summary:
+*  Computes the image CRC-32 of the running application over its rows in the
+*  internal flash, the same way as the one of the image received to the
+*  external memory. The metadata row is not included as the bootloader changes
+*  it in place.
+*
+* Parameters:
+*  uint16 firstRow: The first flash row of the running application.
+*
+* Return:
+*  The image CRC-32.
+*
+*******************************************************************************/
+static uint32 BootloaderEmulator_RunningImageCrc(uint16 firstRow)
+{
+    uint32 crc = CRC_32_INITIAL_VALUE;
+    uint32 rows;
+    uint16 row;
+
+    rows = (BootloaderEmulator_GetMetadata(BootloaderEmulator_MD_APP_LENGTH) + (CY_FLASH_SIZEOF_ROW - 1u)) /
+            CY_FLASH_SIZEOF_ROW;
+
+    if (rows > ((uint32) BootloaderEmulator_MD_FLASH_ROW - firstRow))
+    {
+        rows = (uint32) BootloaderEmulator_MD_FLASH_ROW - firstRow;
+    }
+
+    for (row = 0u; row < rows; row++)
+    {
+        crc = EMI_ImageCrcAddRow(crc, row, (const uint8 *) EMI_FLASH_ROW_ADDR(firstRow + row));
+    }
+
+    return (~crc);
+}
+#endif /* (0u != BootloaderEmulator_CMD_DELTA_AVAIL) */
+
+
+/*******************************************************************************
+* Function Name: BootloaderEmulator_ProgramRow
+********************************************************************************
+*
+* Summary:
+*  Writes the received flash row to the external memory. The first row of the
+*  update starts the session unless the host resumed the interrupted one.
+*
+* Parameters:
+*  uint16 flashRow: The flash row number.
+*  uint8 data[]:    The row data, CY_FLASH_SIZEOF_ROW bytes.
+*
+* Return:
+*  CYRET_SUCCESS, BootloaderEmulator_ERR_ROW if the row does not fit the image
+*  or BootloaderEmulator_ERR_UNK if the external memory could not be prepared
+*  for the row.
+*
+*******************************************************************************/
+static uint8 BootloaderEmulator_ProgramRow(uint16 flashRow, const uint8 data[])
+{
+    uint8  ackCode = BootloaderEmulator_ERR_ROW;
+    uint16 row;
+
+    #if (OTA_STATS_ENABLED == YES)
+        uint32 mark = CySysTickGetValue();
+    #endif /* (OTA_STATS_ENABLED == YES) */
+
+    if (BootloaderEmulator_SESSION_IDLE == btldrSession)
+    {
+        /* The host did not resume the interrupted update: start the new one */
+        BootloaderEmulator_StartSession((BootloaderEmulator_FIRST_ROW_NONE != btldrFirstRow) ?
+                                        btldrFirstRow : flashRow);
+    }
 
-        uint16 CYDATA crc = BootloaderEmulator_CRC_CCITT_INITIAL_VALUE;
-        uint16 CYDATA tmp;
-        uint8  CYDATA i;
-        uint16 CYDATA tmpIndex = size;
+    /* Row number in the external memory */
+    row = BootloaderEmulator_ImageRow(flashRow);
+
+    /* Application rows may not follow the metadata row */
+    if ((row < EMI_APP_MAX_ROWS) && (row <= btldrMdRow))
+    {
+        if ((row >= EMI_DIGEST_MAX_ROWS) &&
+            (EMI_MD_DIGEST_STATUS_VALID == metadata[EMI_MD_DIGEST_STATUS_ADDR]))
+        {
+            /* Application overlaps the digest table, the update can not be resumed */
+            metadata[EMI_MD_DIGEST_STATUS_ADDR] = EMI_MD_DIGEST_STATUS_INVALID;
+            metadata[EMI_MD_RESUME_STATUS_ADDR] = EMI_MD_RESUME_STATUS_NONE;
+            (void) EMI_WriteData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW, metadata);
+        }
 
-        if(0u == size)
+        /* Write row to the external memory */
+        if (CYRET_SUCCESS != EMI_PrepareAppRow(row))
         {
-            crc = ~crc;
+            /* The digest table read failed: the host sends the row again */
+            ackCode = BootloaderEmulator_ERR_UNK;
         }
         else
         {
-            do
-            {
-                tmp = buffer[tmpIndex - size];
-
-                for (i = 0u; i < 8u; i++)
-                {
-                    if (0u != ((crc & 0x0001u) ^ (tmp & 0x0001u)))
-                    {
-                        crc = (crc >> 1u) ^ BootloaderEmulator_CRC_CCITT_POLYNOMIAL;
-                    }
-                    else
-                    {
-                        crc >>= 1u;
-                    }
+            (void) EMI_WriteData(EMI_APP_ABS_ADDR(row), CY_FLASH_SIZEOF_ROW, (uint8 *) data);
 
-                    tmp >>= 1u;
-                }
+            /* Digest marks the row as received, so it follows the row */
+            appExtMemChecksum += EMI_DigestAddRow(row, data);
 
-                size--;
+            /* The image CRC follows the rows as long as they arrive in order */
+            if ((BootloaderEmulator_IMAGE_CRC_BROKEN != btldrImageCrcRow) && (row >= btldrImageCrcRow) &&
+                ((0u != btldrDeltaRows) || (row == btldrImageCrcRow)))
+            {
+                btldrImageCrc = EMI_ImageCrcAddRow(btldrImageCrc, row, data);
+                btldrImageCrcRow = (uint16) (row + 1u);
+            }
+            else
+            {
+                btldrImageCrcRow = BootloaderEmulator_IMAGE_CRC_BROKEN;
+            }
+            if (row >= appSizeInRows)
+            {
+                appSizeInRows = row + 1u;
             }
-            while(0u != size);
-
-            crc = ~crc;
-            tmp = crc;
-            crc = ( uint16 )(crc << 8u) | (tmp >> 8u);
-        }
 
-        return(crc);
 
-    #else
+            DBG_PRINT_TEXT("\r\n");
+            DBG_PRINT_TEXT("BootloaderEmulator:\r\n");
+            DBG_PRINT_TEXT("\tProgram Row Command:\r\n");
+            DBG_PRINT_TEXT("\t\tEMI Address: 0x");
+            DBG_PRINT_HEX(EMI_APP_ABS_ADDR(row));
+            DBG_PRINT_TEXT("\r\n");
 
-        uint16 CYDATA sum = 0u;
+            DBG_PRINT_TEXT("\t\tnumOfTxedRows = 0x");
+            DBG_PRINT_HEX(appSizeInRows);
+            DBG_PRINT_TEXT("\r\n");
 
-        while (size > 0u)
-        {
-            sum += buffer[size - 1u];
-            size--;
+            ackCode = CYRET_SUCCESS;
         }
+    }
 
-        return(( uint16 )1u + ( uint16 )(~sum));
+    #if (OTA_STATS_ENABLED == YES)
+        btldrStats.rows++;
+        btldrStats.rowCycles += BootloaderEmulator_StatsElapsed(mark);
+    #endif /* (OTA_STATS_ENABLED == YES) */
 
-    #endif /* (0u != BootloaderEmulator_PACKET_CHECKSUM_CRC) */
+    return (ackCode);
 }
 
 
+#if (0u != BootloaderEmulator_CMD_WINDOW_AVAIL)
 /*******************************************************************************
-* Function Name: BootloaderEmulator_Calc8BitSum
+* Function Name: BootloaderEmulator_WindowReset
 ********************************************************************************
 *
 * Summary:
-*  This computes the 8 bit sum for the provided number of bytes contained in
-*  FRAM.
+*  Starts the windowed transfer from the sequence number 0 or returns to the
+*  legacy single command mode. Partially assembled rows are dropped.
 *
 * Parameters:
-* rowNum :
-*   Flash row number as located in the external memory.
+*  uint8 size: Fragments in the window, zero for the legacy mode.
 *
-* Returns:
-*   The 8 bit sum for the provided data.
+* Return:
+*  None
 *
 *******************************************************************************/
-uint32 BootloaderEmulator_Calc8BitSum(uint32 rowNum)
+static void BootloaderEmulator_WindowReset(uint8 size)
 {
-    uint32 sum = 0u;
-    uint8 flashRowFromExtMem[CY_FLASH_SIZEOF_ROW];
-    uint32 size = CY_FLASH_SIZEOF_ROW;
-
-    (void) EMI_ReadData(EMI_APP_ABS_ADDR(rowNum), CY_FLASH_SIZEOF_ROW, flashRowFromExtMem);
-
-    DBG_PRINT_TEXT("\r\n");
-    DBG_PRINT_TEXT("BootloaderEmulator:\r\n");
-    DBG_PRINT_TEXT("\tBootloaderEmulator_Calc8BitSum():\r\n");
-
-    DBG_PRINT_TEXT("\t\trowNum  = ");
-    DBG_PRINT_DEC( (uint16) rowNum);
-    DBG_PRINT_TEXT("\r\n");
-
-    DBG_PRINT_TEXT("\t\tEMI_APP_ABS_ADDR(rowNum)  = ");
-    DBG_PRINT_HEX(EMI_APP_ABS_ADDR((uint16)rowNum));
-    DBG_PRINT_TEXT("\r\n");
-
-    DBG_PRINT_TEXT("\t\tEMI_ReadData():\r\n");
-    DBG_PRINT_ARRAY(flashRowFromExtMem, size);
-    DBG_PRINT_TEXT("\r\n");
+    uint32 i;
 
+    btldrWindowSize = size;
+    btldrWindowBase = 0u;
+    (void) memset(btldrWindowMap, 0, BootloaderEmulator_WINDOW_MAP_SIZE);
 
-    while (size > 0u)
+    for (i = 0u; i < BootloaderEmulator_STREAM_ROWS; i++)
     {
-        size--;
-        sum += flashRowFromExtMem[size];
+        btldrStreamRow[i].row = BootloaderEmulator_STREAM_ROW_NONE;
+        (void) memset(btldrStreamRow[i].map, 0, BootloaderEmulator_WINDOW_MAP_SIZE);
     }
-
-    return(sum);
 }
 
 
 /*******************************************************************************
-* Function Name: BootloaderEmulator_Start
+* Function Name: BootloaderEmulator_WindowAccepted
 ********************************************************************************
-* Summary:
-*  This function is called in order to execute the following algorithm:
-*
-*  - Identify the active bootloadable application (applicable only to
-*    the Multi-application bootloader)
-*
-*  - Validate the bootloader application (design-time configurable, Bootloader
-*    application validation option of the component customizer)
-*
-*  - Validate the active bootloadable application. If active bootloadable
-*    application is not valid, and the other bootloadable application (inactive)
-*    is valid, the last one is started.
-*
-*  - Run a communication subroutine (design-time configurable, Wait for command
-*    option of the component customizer)
 *
-*  - Schedule the bootloadable and reset the device
+* Summary:
+*  Checks whether the fragment of the window was accepted: its row is written
+*  or the row is still being assembled.
 *
 * Parameters:
-*  None
+*  uint8 indx: The fragment index in the window.
 *
 * Return:
-*  This method will never return. It will either load a new application and
-*  reset the device or jump directly to the existing application. The CPU is
-*  halted, if validation failed when "Bootloader application validation" option
-*  is enabled.
-*  PSoC 3/PSoC 5: The CPU is halted if Flash initialization fails.
-*
-* Side Effects:
-*  If Bootloader application validation option is enabled and this method
-*  determines that the bootloader application itself is corrupt, this method
-*  will not return, instead it will simply hang the application.
+*  Non-zero if the fragment must not be sent again.
 *
 *******************************************************************************/
-void BootloaderEmulator_Start(void)
+static uint8 BootloaderEmulator_WindowAccepted(uint8 indx)
 {
-    EMI_Start();
-    BootloaderEmulator_HostLink(BootloaderEmulator_WAIT_FOR_COMMAND_FOREVER);
+    uint8  bit = (uint8) (1u << (indx & 0x07u));
+    uint8  accepted = btldrWindowMap[indx >> 3u] & bit;
+    uint32 i;
+
+    for (i = 0u; (i < BootloaderEmulator_STREAM_ROWS) && (0u == accepted); i++)
+    {
+        if (BootloaderEmulator_STREAM_ROW_NONE != btldrStreamRow[i].row)
+        {
+            accepted = btldrStreamRow[i].map[indx >> 3u] & bit;
+        }
+    }
+
+    return (accepted);
 }
 
 
 /*******************************************************************************
-* Function Name: BootloaderEmulator_ValidateBootloadable
+* Function Name: BootloaderEmulator_WindowFragment
 ********************************************************************************
-* Summary:
-*  Performs the bootloadable application validation by calculating the
-*  application image checksum and comparing it with the checksum value stored
-*  in the Bootloadable Application Checksum field of the metadata section.
-*
-*  If the Fast bootloadable application validation option is enabled in the
-*  component customizer and bootloadable application successfully passes
-*  validation, the Bootloadable Application Verification Status field of the
-*  metadata section is updated. Refer to the Metadata Layout section for the
-*  details.
 *
-*  If the Fast bootloadable application validation option is enabled and
-*  Bootloadable Application Verification Status field of the metadata section
-*  claims that bootloadable application is valid, the function returns
-*  CYRET_SUCCESS without further checksum calculation.
+* Summary:
+*  Accepts the row fragment of the windowed transfer. The fragment is copied to
+*  the row being assembled; the row is written to the external memory once all
+*  its bytes are received and only then its fragments are marked as received.
+*  The fragments of a row that fails to be written are dropped, so they are
+*  reported as missing. The fragment is not accepted when all rows being
+*  assembled are busy; it is reported as missing and the host sends it again.
+*  Duplicates and fragments outside of the window are ignored.
 *
 * Parameters:
-*  appId:
-*  The number of the bootloadable application should be 0 for the normal
-*  bootloader and 0 or 1 for the Multi-Application bootloader.
+*  uint8 packet[]: The packet with the fragment.
+*  uint16 pktSize: Size of the packet data.
+*  uint8 *ackCode: Set to the error code if the fragment is not valid.
 *
-* Returns:
-*  Returns CYRET_SUCCESS if the specified bootloadable application is valid.
+* Return:
+*  Non-zero if the window status must be sent to the host: the fragment was
+*  the last in the window or it completed the window.
 *
 *******************************************************************************/
-cystatus BootloaderEmulator_ValidateBootloadable(void)
+static uint8 BootloaderEmulator_WindowFragment(const uint8 packet[], uint16 pktSize, uint8 *ackCode)
 {
-    uint8 appChecksum;
-    uint8 calcedChecksum = 0u;
-    uint8   appFlashRow[CY_FLASH_SIZEOF_ROW];
-    uint32 row;
-    uint32 i;
-    uint32 valid = 0u;
-
-    cystatus status = CYRET_SUCCESS;
-
-    if (0u != appSizeInRows)
+    const uint8 *param = &packet[BootloaderEmulator_DATA_ADDR];
+    uint8  indx = (uint8) (param[BootloaderEmulator_STREAM_SEQ_INDX] - btldrWindowBase);
+    uint16 size = pktSize - BootloaderEmulator_STREAM_HEADER_SIZE;
+    uint16 offset = param[BootloaderEmulator_STREAM_OFFSET_INDX];
+    uint16 flashRow;
+    uint16 i;
+    BootloaderEmulator_STREAM_ROW *slot = NULL;
+    uint8  windowDone;
+
+    flashRow = (uint16) (param[BootloaderEmulator_STREAM_ARRAY_INDX] * BootloaderEmulator_NUMBER_OF_ROWS_IN_ARRAY) +
+               (((uint16)((uint16)param[BootloaderEmulator_STREAM_ROW_INDX + 1u] << 8u)) |
+                 param[BootloaderEmulator_STREAM_ROW_INDX]);
+
+    *ackCode = CYRET_SUCCESS;
+
+    if ((offset + size) > CY_FLASH_SIZEOF_ROW)
     {
-        /* Get bootloadable application checksum from external memory */
-        (void) EMI_ReadData(EMI_APP_ABS_ADDR(appSizeInRows - 1u), CY_FLASH_SIZEOF_ROW, appFlashRow);
-
-
-        DBG_PRINT_TEXT("\t\t Metadata Row: ");
-        DBG_PRINT_ARRAY(appFlashRow, CY_FLASH_SIZEOF_ROW);
-        DBG_PRINT_TEXT("\r\n");
-
-        appChecksum = appFlashRow[BootloaderEmulator_MD_APP_CHECKSUM];
+        *ackCode = BootloaderEmulator_ERR_LENGTH;
+    }
+    else if ((indx < btldrWindowSize) && (0u == BootloaderEmulator_WindowAccepted(indx)))
+    {
+        for (i = 0u; (i < BootloaderEmulator_STREAM_ROWS) && (NULL == slot); i++)
+        {
+            if (flashRow == btldrStreamRow[i].row)
+            {
+                slot = &btldrStreamRow[i];
+            }
+        }
 
+        for (i = 0u; (i < BootloaderEmulator_STREAM_ROWS) && (NULL == slot); i++)
+        {
+            if (BootloaderEmulator_STREAM_ROW_NONE == btldrStreamRow[i].row)
+            {
+                slot = &btldrStreamRow[i];
+                slot->row = flashRow;
+                slot->received = 0u;
+                (void) memset(slot->map, 0, BootloaderEmulator_WINDOW_MAP_SIZE);
+            }
+        }
 
-        for (row = 0u; row < (appSizeInRows - 1u); row++)
+        if (NULL != slot)
         {
-            /* Read flash row data from external memory */
-            (void) EMI_ReadData(EMI_APP_ABS_ADDR(row) , CY_FLASH_SIZEOF_ROW, appFlashRow);
+            (void) memcpy(&slot->data[offset], &param[BootloaderEmulator_STREAM_HEADER_SIZE], (uint32) size);
+            slot->received += size;
+            slot->map[indx >> 3u] |= (uint8) (1u << (indx & 0x07u));
 
-            /* Calculate checksum of application row */
-            for(i = 0u; i < CY_FLASH_SIZEOF_ROW; i++)
+            if (CY_FLASH_SIZEOF_ROW <= slot->received)
             {
-                if((appFlashRow[i] != 0u) && (appFlashRow[i] != 0xFFu))
+                *ackCode = BootloaderEmulator_ProgramRow(slot->row, slot->data);
+
+                if (CYRET_SUCCESS == *ackCode)
                 {
-                    valid = 1u;
+                    for (i = 0u; i < BootloaderEmulator_WINDOW_MAP_SIZE; i++)
+                    {
+                        btldrWindowMap[i] |= slot->map[i];
+                    }
                 }
-                calcedChecksum += appFlashRow[i];
+                slot->row = BootloaderEmulator_STREAM_ROW_NONE;
             }
         }
+    }
+    else
+    {
+        /* Already accepted or left from the previous window */
+    }
 
-        calcedChecksum = ( uint8 )1u + ( uint8 )(~calcedChecksum);
-
-        if((calcedChecksum != appChecksum) || (0u == valid))
+    windowDone = (uint8) (indx == (btldrWindowSize - 1u));
+    for (i = 0u; (i < btldrWindowSize) && (0u == windowDone); i++)
+    {
+        if (0u == BootloaderEmulator_WindowAccepted((uint8) i))
         {
-            status = CYRET_BAD_DATA;
+            break;
         }
-        
-        DBG_PRINT_TEXT("\r\n");
-        DBG_PRINT_TEXT("BootloaderEmulator:\r\n");
-        DBG_PRINT_TEXT("\tBootloaderEmulator_ValidateBootloadable() Status: ");
-        DBG_PRINT_DEC( (uint16) status);
-        DBG_PRINT_TEXT("\r\n");
+    }
 
-        DBG_PRINT_TEXT("\t\tStored Bootloadable Application Checksum  = ");
-        DBG_PRINT_DEC( (uint16) appChecksum);
-        DBG_PRINT_TEXT("\r\n");
+    return ((uint8) ((0u != windowDone) || (i == btldrWindowSize)));
+}
 
-        DBG_PRINT_TEXT("\t\tCalculated Bootloadable Application Checksum  = ");
-        DBG_PRINT_DEC( (uint16) calcedChecksum);
-        DBG_PRINT_TEXT("\r\n");
+
+/*******************************************************************************
+* Function Name: BootloaderEmulator_WindowStatus
+********************************************************************************
+*
+* Summary:
+*  Builds the window status response: [1-byte window base] [missing map]. Bit n
+*  of the missing map is set if the fragment (base + n) must be sent again. A
+*  completed window is advanced first, so its status has the new base and the
+*  empty missing map. The rows still being assembled keep their data, only
+*  their fragments of the completed window are forgotten.
+*
+* Parameters:
+*  uint8 buffer[]: The response packet buffer.
+*
+* Return:
+*  Size of the response data.
+*
+*******************************************************************************/
+static uint16 BootloaderEmulator_WindowStatus(uint8 buffer[])
+{
+    uint8 *rsp = &buffer[BootloaderEmulator_DATA_ADDR];
+    uint8  mapSize = (uint8) ((btldrWindowSize + 7u) >> 3u);
+    uint8  missing = 0u;
+    uint8  i;
+
+    (void) memset(&rsp[1u], 0, (uint32) mapSize);
+
+    for (i = 0u; i < btldrWindowSize; i++)
+    {
+        if (0u == BootloaderEmulator_WindowAccepted(i))
+        {
+            rsp[1u + (i >> 3u)] |= (uint8) (1u << (i & 0x07u));
+            missing++;
+        }
     }
-    else
+
+    if (0u == missing)
     {
-        status = CYRET_BAD_DATA;
-        DBG_PRINT_TEXT("\r\n");
-        DBG_PRINT_TEXT("Error: Stored data length = 0.");
-        DBG_PRINT_TEXT("\r\n");
+        /* Whole window is received, the host continues with the next one */
+        btldrWindowBase += btldrWindowSize;
+        (void) memset(btldrWindowMap, 0, BootloaderEmulator_WINDOW_MAP_SIZE);
+
+        for (i = 0u; i < BootloaderEmulator_STREAM_ROWS; i++)
+        {
+            (void) memset(btldrStreamRow[i].map, 0, BootloaderEmulator_WINDOW_MAP_SIZE);
+        }
     }
-    
 
-    return(status);
+    rsp[0u] = btldrWindowBase;
+
+    return ((uint16) mapSize + 1u);
 }
+#endif /* (0u != BootloaderEmulator_CMD_WINDOW_AVAIL) */
 
 
 /*******************************************************************************
@@ -643,6 +2198,8 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
     uint8     CYDATA ackCode;
     uint16    CYDATA pktChecksum;
     cystatus  CYDATA readStat;
+    cystatus  CYDATA emiStat;
+    uint16    CYDATA rowMapLast;
     uint16    CYDATA pktSize    = 0u;
     uint16    CYDATA dataOffset = 0u;
     uint8     CYDATA timeOutCnt = 10u;
@@ -656,6 +2213,12 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
     uint8     packetBuffer[BootloaderEmulator_SIZEOF_COMMAND_BUFFER];
     uint8     dataBuffer  [BootloaderEmulator_SIZEOF_COMMAND_BUFFER];
 
+    #if (OTA_STATS_ENABLED == YES)
+        uint32 emiMark;
+
+        BootloaderEmulator_StatsStart();
+    #endif /* (OTA_STATS_ENABLED == YES) */
+
     /* Initialize communications channel. */
     CyBtldrCommStart();
 
@@ -679,12 +2242,26 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
 
         } while ( (0u != timeOutCnt) && (readStat != CYRET_SUCCESS) );
 
+        /* Continue the external memory write that was in flight during reception */
+        #if (OTA_STATS_ENABLED == YES)
+            emiMark = CySysTickGetValue();
+            EMI_Process();
+            btldrStats.emiCycles += BootloaderEmulator_StatsElapsed(emiMark);
+        #else
+            EMI_Process();
+        #endif /* (OTA_STATS_ENABLED == YES) */
 
         if( readStat != CYRET_SUCCESS )
         {
             continue;
         }
 
+        #if (OTA_STATS_ENABLED == YES)
+            btldrStatsMark = CySysTickGetValue();
+            btldrStats.packets++;
+            btldrStats.bytesIn += numberRead;
+        #endif /* (OTA_STATS_ENABLED == YES) */
+
         if((numberRead < BootloaderEmulator_MIN_PKT_SIZE) ||
            (packetBuffer[BootloaderEmulator_SOP_ADDR] != BootloaderEmulator_SOP))
         {
@@ -717,7 +2294,26 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
             }
         }
 
+        #if (OTA_STATS_ENABLED == YES)
+            if (CYRET_SUCCESS != ackCode)
+            {
+                btldrStats.badPackets++;
+            }
+        #endif /* (OTA_STATS_ENABLED == YES) */
+
         rspSize = 0u;
+
+        #if (0u != BootloaderEmulator_CMD_WINDOW_AVAIL)
+            if ((CYRET_SUCCESS != ackCode) && (0u != btldrWindowSize))
+            {
+                /* Sequence number of the damaged packet is unknown: the error is
+                *  answered with the window status, so the host sends the missing
+                *  fragments again without waiting for the timeout.
+                */
+                rspSize = BootloaderEmulator_WindowStatus(packetBuffer);
+            }
+        #endif /* (0u != BootloaderEmulator_CMD_WINDOW_AVAIL) */
+
         if(ackCode == CYRET_SUCCESS)
         {
             uint8 CYDATA btldrData = packetBuffer[BootloaderEmulator_DATA_ADDR];
@@ -823,88 +2419,26 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
                     /* The command may be sent along with the last block of data, to program the row. */
                     (void) memcpy(&dataBuffer[dataOffset],
                                 &packetBuffer[BootloaderEmulator_DATA_ADDR + 3u],
-                                (uint32) pktSize - 3u);
-
-                    dataOffset += (pktSize - 3u);
-
-                    /* Size of FLASH row (no ECC available) */
-                    pktSize = CY_FLASH_SIZEOF_ROW;
-
-
-                    /* Check if we have all data to program */
-                    if(dataOffset == pktSize)
-                    {
-                        uint16 row;
-                        uint32 size = CY_FLASH_SIZEOF_ROW;
-
-                        /* Save 1st bootloadable application flash row number to the metadata in external memory */
-                        if (appSizeInRows == 0u)
-                        {
-                            /* Get Flash row number inside of the array */
-                            dataOffset = ((uint16)((uint16)packetBuffer[BootloaderEmulator_DATA_ADDR + 2u] << 8u)) |
-                                                  packetBuffer[BootloaderEmulator_DATA_ADDR + 1u];
-
-                            /* btldrData  - holds flash array Id sent by host */
-                            /* dataOffset - holds flash row Id sent by host   */
-                            row = (uint16)(btldrData * BootloaderEmulator_NUMBER_OF_ROWS_IN_ARRAY) + dataOffset;
-
-                            /* Save number of the bootloadable application first flash row */
-                            appFirstRowNum = row;
-                        }
-
-                        /* Erase metadata row */
-                        if (appSizeInRows == 0u)
-                        {
-                            /* Ersase content of the external memory */
-                            uint8  erase[CY_FLASH_SIZEOF_ROW] = {0u};
-                            #if (DEBUG_UART_ENABLED == YES)
-                                uint8  tmp[CY_FLASH_SIZEOF_ROW];
-                            #endif /* #if (DEBUG_UART_ENABLED == YES) */
-
-                            #if (DEBUG_UART_ENABLED == YES)
-                                (void) EMI_ReadData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW, tmp);
-                            #endif /* #if (DEBUG_UART_ENABLED == YES) */
-                            DBG_PRINT_TEXT("\t\t Metadata Row Before Erase: ");
-                            DBG_PRINT_ARRAY(tmp, CY_FLASH_SIZEOF_ROW);
-                            DBG_PRINT_TEXT("\r\n");
-
-                            (void) EMI_WriteData(EMI_MD_BASE_ADDR , CY_FLASH_SIZEOF_ROW, erase);
-
-                            #if (DEBUG_UART_ENABLED == YES)
-                                (void) EMI_ReadData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW, tmp);
-                            #endif /* #if (DEBUG_UART_ENABLED == YES) */
-                            DBG_PRINT_TEXT("\t\t Metadata Row After Erase: ");
-                            DBG_PRINT_ARRAY(tmp, CY_FLASH_SIZEOF_ROW);
-                            DBG_PRINT_TEXT("\r\n");
-                        }
-
-
-                        /* External memory application checksum calculation */
-                        while (size > 0u)
-                        {
-                            size--;
-                            appExtMemChecksum += dataBuffer[size];
-                        }
-
-
-                        /* Write row to the external memory */
-                        (void) EMI_WriteData(EMI_APP_ABS_ADDR(appSizeInRows), CY_FLASH_SIZEOF_ROW, dataBuffer);
-                        appSizeInRows++;
-
-
-                        DBG_PRINT_TEXT("\r\n");
-                        DBG_PRINT_TEXT("BootloaderEmulator:\r\n");
-                        DBG_PRINT_TEXT("\tProgram Row Command:\r\n");
-                        DBG_PRINT_TEXT("\t\tEMI Address: 0x");
-                        DBG_PRINT_HEX(EMI_APP_ABS_ADDR(appSizeInRows - 1u));
-                        DBG_PRINT_TEXT("\r\n");
+                                (uint32) pktSize - 3u);
 
-                        DBG_PRINT_TEXT("\t\tnumOfTxedRows = 0x");
-                        DBG_PRINT_HEX(appSizeInRows - 1u);
-                        DBG_PRINT_TEXT("\r\n");
+                    dataOffset += (pktSize - 3u);
 
-                        ackCode = CYRET_SUCCESS;
+                    /* Size of FLASH row (no ECC available) */
+                    pktSize = CY_FLASH_SIZEOF_ROW;
 
+
+                    /* Check if we have all data to program */
+                    if(dataOffset == pktSize)
+                    {
+                        /* Get Flash row number inside of the array */
+                        dataOffset = ((uint16)((uint16)packetBuffer[BootloaderEmulator_DATA_ADDR + 2u] << 8u)) |
+                                              packetBuffer[BootloaderEmulator_DATA_ADDR + 1u];
+
+                        /* btldrData  - holds flash array Id sent by host */
+                        /* dataOffset - holds flash row Id sent by host   */
+                        ackCode = BootloaderEmulator_ProgramRow(
+                                    (uint16)(btldrData * BootloaderEmulator_NUMBER_OF_ROWS_IN_ARRAY) + dataOffset,
+                                    dataBuffer);
                     }
                     else
                     {
@@ -1000,31 +2534,319 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
                     {
                         metadata[i] = 0u;
                     }
+                    btldrSession = BootloaderEmulator_SESSION_IDLE;
+                    btldrDeltaRows = 0u;
+                    btldrFirstRow = BootloaderEmulator_FIRST_ROW_NONE;
+
+                    #if (0u != BootloaderEmulator_CMD_WINDOW_AVAIL)
+                        BootloaderEmulator_WindowReset(0u);
+                    #endif /* (0u != BootloaderEmulator_CMD_WINDOW_AVAIL) */
+
+                    #if (0u != BootloaderEmulator_CMD_COMPRESSED_AVAIL)
+                        btldrLzssRowsLeft = 0u;
+                    #endif /* (0u != BootloaderEmulator_CMD_COMPRESSED_AVAIL) */
 
 
                     DBG_PRINT_TEXT("BootloaderEmulator:\r\n");
                     DBG_PRINT_TEXT("\tEnter bootloader:\r\n");
                     DBG_PRINT_TEXT("\r\n");
 
-                    #if (ENCRYPTION_ENABLED == YES)
-                        /*Generate key*/
-                        CR_GenerateKey(emiKey);
-                        DBG_PRINT_TEXT("Generated Key: ");
-                        DBG_PRINT_ARRAY(emiKey, KEY_LENGTH);
-                        DBG_PRINT_TEXT("\r\n");
-                        CR_WriteKey(emiKey);
-                        CR_ReadKey(emiKey);
-                        DBG_PRINT_TEXT("Read Key     : ");
-                        DBG_PRINT_ARRAY(emiKey, KEY_LENGTH);
-                        DBG_PRINT_TEXT("\r\n");
-                        
-                    #endif /*(ENCRYPTION_ENABLED == YES)*/
-                    
                     ackCode = CYRET_SUCCESS;
                 }
                 break;
 
 
+            /***************************************************************************
+            *   Delta image
+            ***************************************************************************/
+            #if (0u != BootloaderEmulator_CMD_DELTA_AVAIL)
+
+            case BootloaderEmulator_COMMAND_DELTA:
+
+                if((BootloaderEmulator_COMMUNICATION_STATE_ACTIVE == communicationState) &&
+                   (pktSize == BootloaderEmulator_DELTA_PARAM_SIZE))
+                {
+                    uint16 firstRow;
+                    uint32 baseCrc;
+
+                    dataOffset = ((uint16)((uint16)packetBuffer[BootloaderEmulator_DATA_ADDR + 1u] << 8u)) |
+                                          packetBuffer[BootloaderEmulator_DATA_ADDR];
+                    baseCrc = ((uint32)packetBuffer[BootloaderEmulator_DATA_ADDR + 5u] << 24u) |
+                              ((uint32)packetBuffer[BootloaderEmulator_DATA_ADDR + 4u] << 16u) |
+                              ((uint32)packetBuffer[BootloaderEmulator_DATA_ADDR + 3u] <<  8u) |
+                                       packetBuffer[BootloaderEmulator_DATA_ADDR + 2u];
+
+                    /* Unchanged rows are taken from the running application, so it sets the first row */
+                    firstRow = (uint16) (BootloaderEmulator_GetMetadata(BootloaderEmulator_MD_LAST_BTLDR_ROW) + 1u);
+
+                    if (BootloaderEmulator_SESSION_IDLE != btldrSession)
+                    {
+                        /* The image type can not change once rows are received */
+                        ackCode = BootloaderEmulator_ERR_DATA;
+                    }
+                    else if ((0u == dataOffset) || (dataOffset > EMI_DIGEST_MAX_ROWS))
+                    {
+                        /* Rows of the delta image are tracked in the digest table */
+                        ackCode = BootloaderEmulator_ERR_LENGTH;
+                    }
+                    else if ((firstRow >= BootloaderEmulator_MD_FLASH_ROW) ||
+                             (BootloaderEmulator_RunningImageCrc(firstRow) != baseCrc))
+                    {
+                        /* Delta was made against other application */
+                        ackCode = BootloaderEmulator_ERR_CHECKSUM;
+                    }
+                    else
+                    {
+                        btldrDeltaRows = dataOffset;
+                        btldrFirstRow = firstRow;
+                        ackCode = CYRET_SUCCESS;
+                    }
+
+                    dataOffset = 0u;
+
+                    DBG_PRINT_TEXT("\r\n");
+                    DBG_PRINT_TEXT("BootloaderEmulator:\r\n");
+                    DBG_PRINT_TEXT("\tDelta Image:\r\n");
+                    DBG_PRINT_TEXT("\t\tImage Size in Rows: 0x");
+                    DBG_PRINT_HEX(btldrDeltaRows);
+                    DBG_PRINT_TEXT("\r\n");
+                    DBG_PRINT_TEXT("\t\tFirst Row: 0x");
+                    DBG_PRINT_HEX(firstRow);
+                    DBG_PRINT_TEXT("\r\n");
+                }
+                break;
+
+            #endif /* (0u != BootloaderEmulator_CMD_DELTA_AVAIL) */
+
+
+            /***************************************************************************
+            *   Get row map
+            ***************************************************************************/
+            #if (0u != BootloaderEmulator_CMD_GET_ROW_MAP_AVAIL)
+
+            case BootloaderEmulator_COMMAND_GET_ROW_MAP:
+
+                if((BootloaderEmulator_COMMUNICATION_STATE_ACTIVE == communicationState) && (pktSize == 2u))
+                {
+                    emiStat = CYRET_SUCCESS;
+                    if (BootloaderEmulator_SESSION_IDLE == btldrSession)
+                    {
+                        emiStat = BootloaderEmulator_ResumeSession();
+                        if (CYRET_BAD_DATA == emiStat)
+                        {
+                            /* No interrupted update: the map is empty */
+                            emiStat = CYRET_SUCCESS;
+                        }
+                    }
+
+                    /* Offset in the row map in bytes */
+                    dataOffset = ((uint16)((uint16)packetBuffer[BootloaderEmulator_DATA_ADDR + 1u] << 8u)) |
+                                          packetBuffer[BootloaderEmulator_DATA_ADDR];
+
+                    packetBuffer[BootloaderEmulator_DATA_ADDR     ] = LO8(appFirstRowNum);
+                    packetBuffer[BootloaderEmulator_DATA_ADDR + 1u] = HI8(appFirstRowNum);
+                    packetBuffer[BootloaderEmulator_DATA_ADDR + 2u] = LO8(appSizeInRows);
+                    packetBuffer[BootloaderEmulator_DATA_ADDR + 3u] = HI8(appSizeInRows);
+
+                    if (CYRET_SUCCESS != emiStat)
+                    {
+                        /* The host must not take the rows as missing when the map is not known */
+                        ackCode = BootloaderEmulator_ERR_UNK;
+                    }
+                    else if (BootloaderEmulator_SESSION_ACTIVE == btldrSession)
+                    {
+                        emiStat = EMI_DigestRowMap((uint32) dataOffset * 8u, BootloaderEmulator_ROW_MAP_CHUNK_SIZE * 8u,
+                                    &packetBuffer[BootloaderEmulator_DATA_ADDR + BootloaderEmulator_ROW_MAP_HEADER_SIZE],
+                                    &rowMapLast);
+                        ackCode = (CYRET_SUCCESS == emiStat) ? CYRET_SUCCESS : BootloaderEmulator_ERR_UNK;
+                    }
+                    else
+                    {
+                        (void) memset(&packetBuffer[BootloaderEmulator_DATA_ADDR + BootloaderEmulator_ROW_MAP_HEADER_SIZE],
+                                    0, BootloaderEmulator_ROW_MAP_CHUNK_SIZE);
+                        ackCode = CYRET_SUCCESS;
+                    }
+
+                    if (CYRET_SUCCESS == ackCode)
+                    {
+                        rspSize = BootloaderEmulator_ROW_MAP_HEADER_SIZE + BootloaderEmulator_ROW_MAP_CHUNK_SIZE;
+                    }
+                    dataOffset = 0u;
+
+                    DBG_PRINT_TEXT("\r\n");
+                    DBG_PRINT_TEXT("BootloaderEmulator:\r\n");
+                    DBG_PRINT_TEXT("\tGet Row Map:\r\n");
+                    DBG_PRINT_TEXT("\t\tRows in External Memory: 0x");
+                    DBG_PRINT_HEX(appSizeInRows);
+                    DBG_PRINT_TEXT("\r\n");
+                }
+                break;
+
+            #endif /* (0u != BootloaderEmulator_CMD_GET_ROW_MAP_AVAIL) */
+
+
+            /***************************************************************************
+            *   Compressed transfer
+            ***************************************************************************/
+            #if (0u != BootloaderEmulator_CMD_COMPRESSED_AVAIL)
+
+            case BootloaderEmulator_COMMAND_COMPRESSED:
+
+                if((BootloaderEmulator_COMMUNICATION_STATE_ACTIVE == communicationState) &&
+                   (pktSize == BootloaderEmulator_COMPRESSED_PARAM_SIZE))
+                {
+                    dataOffset = ((uint16)((uint16)packetBuffer[BootloaderEmulator_DATA_ADDR + 2u] << 8u)) |
+                                          packetBuffer[BootloaderEmulator_DATA_ADDR + 1u];
+
+                    LZSS_Init(&btldrLzss);
+                    btldrLzssRow = (uint16)(btldrData * BootloaderEmulator_NUMBER_OF_ROWS_IN_ARRAY) + dataOffset;
+                    btldrLzssRowFill = 0u;
+                    btldrLzssRowsLeft = ((uint16)((uint16)packetBuffer[BootloaderEmulator_DATA_ADDR + 4u] << 8u)) |
+                                                 packetBuffer[BootloaderEmulator_DATA_ADDR + 3u];
+
+                    ackCode = CYRET_SUCCESS;
+                    dataOffset = 0u;
+
+                    DBG_PRINT_TEXT("\r\n");
+                    DBG_PRINT_TEXT("BootloaderEmulator_COMMAND_COMPRESSED:\r\n");
+                    DBG_PRINT_TEXT("\t\tbtldrLzssRow  = ");
+                    DBG_PRINT_DEC(btldrLzssRow);
+                    DBG_PRINT_TEXT("\r\n");
+                }
+                break;
+
+            case BootloaderEmulator_COMMAND_COMPRESSED_DATA:
+
+                if((BootloaderEmulator_COMMUNICATION_STATE_ACTIVE == communicationState) && (0u != pktSize))
+                {
+                    ackCode = BootloaderEmulator_CompressedData(&packetBuffer[BootloaderEmulator_DATA_ADDR], pktSize);
+
+                    packetBuffer[BootloaderEmulator_DATA_ADDR     ] = LO8(btldrLzssRowsLeft);
+                    packetBuffer[BootloaderEmulator_DATA_ADDR + 1u] = HI8(btldrLzssRowsLeft);
+                    rspSize = (CYRET_SUCCESS == ackCode) ? 2u : 0u;
+                }
+                break;
+
+            #endif /* (0u != BootloaderEmulator_CMD_COMPRESSED_AVAIL) */
+
+
+            /***************************************************************************
+            *   Windowed transfer
+            ***************************************************************************/
+            #if (0u != BootloaderEmulator_CMD_WINDOW_AVAIL)
+
+            case BootloaderEmulator_COMMAND_WINDOW:
+
+                if((BootloaderEmulator_COMMUNICATION_STATE_ACTIVE == communicationState) &&
+                   (pktSize == BootloaderEmulator_WINDOW_PARAM_SIZE))
+                {
+                    if ((BootloaderEmulator_SESSION_IDLE == btldrSession) && (0u == btldrDeltaRows))
+                    {
+                        /* Rows may complete out of order, the first of them is not the first row */
+                        btldrFirstRow = (uint16) (packetBuffer[BootloaderEmulator_DATA_ADDR + 1u] *
+                                                  BootloaderEmulator_NUMBER_OF_ROWS_IN_ARRAY) +
+                                        (((uint16)((uint16)packetBuffer[BootloaderEmulator_DATA_ADDR + 3u] << 8u)) |
+                                          packetBuffer[BootloaderEmulator_DATA_ADDR + 2u]);
+                    }
+
+                    BootloaderEmulator_WindowReset((btldrData > BootloaderEmulator_WINDOW_MAX_SIZE) ?
+                                                    BootloaderEmulator_WINDOW_MAX_SIZE : btldrData);
+
+                    packetBuffer[BootloaderEmulator_DATA_ADDR     ] = btldrWindowSize;
+                    packetBuffer[BootloaderEmulator_DATA_ADDR + 1u] = btldrWindowBase;
+                    rspSize = 2u;
+                    ackCode = CYRET_SUCCESS;
+
+                    DBG_PRINT_TEXT("\r\n");
+                    DBG_PRINT_TEXT("BootloaderEmulator:\r\n");
+                    DBG_PRINT_TEXT("\tWindowed Transfer:\r\n");
+                    DBG_PRINT_TEXT("\t\tFragments in Window: 0x");
+                    DBG_PRINT_HEX(btldrWindowSize);
+                    DBG_PRINT_TEXT("\r\n");
+                }
+                break;
+
+            case BootloaderEmulator_COMMAND_STREAM:
+
+                if((BootloaderEmulator_COMMUNICATION_STATE_ACTIVE == communicationState) &&
+                   (0u != btldrWindowSize) && (pktSize > BootloaderEmulator_STREAM_HEADER_SIZE))
+                {
+                    if (0u == BootloaderEmulator_WindowFragment(packetBuffer, pktSize, &ackCode))
+                    {
+                        if (CYRET_SUCCESS == ackCode)
+                        {
+                            /* Fragments inside of the window are not acknowledged */
+                            continue;
+                        }
+                    }
+                    else if (CYRET_SUCCESS == ackCode)
+                    {
+                        rspSize = BootloaderEmulator_WindowStatus(packetBuffer);
+                    }
+                    else
+                    {
+                        /* Report the error */
+                    }
+                }
+                break;
+
+            case BootloaderEmulator_COMMAND_WINDOW_STATUS:
+
+                if((BootloaderEmulator_COMMUNICATION_STATE_ACTIVE == communicationState) &&
+                   (0u != btldrWindowSize) && (pktSize == 0u))
+                {
+                    rspSize = BootloaderEmulator_WindowStatus(packetBuffer);
+                    ackCode = CYRET_SUCCESS;
+                }
+                break;
+
+            #endif /* (0u != BootloaderEmulator_CMD_WINDOW_AVAIL) */
+
+
+            /***************************************************************************
+            *   Get packet size
+            ***************************************************************************/
+            #if (0u != BootloaderEmulator_CMD_GET_PKT_SIZE_AVAIL)
+
+            case BootloaderEmulator_COMMAND_GET_PKT_SIZE:
+
+                if((BootloaderEmulator_COMMUNICATION_STATE_ACTIVE == communicationState) && (pktSize == 0u))
+                {
+                    uint16 mtu = CYBLE_GATT_DEFAULT_MTU;
+                    uint16 maxPktSize;
+
+                    (void) CyBle_GattGetMtuSize(&mtu);
+
+                    /* Limited by the write, the Bootloader Service characteristic and the packet buffer */
+                    maxPktSize = mtu - BootloaderEmulator_ATT_WRITE_HEADER_SIZE;
+                    if (maxPktSize > CYBLE_GATT_MAX_ATTR_LEN)
+                    {
+                        maxPktSize = CYBLE_GATT_MAX_ATTR_LEN;
+                    }
+                    if (maxPktSize > BootloaderEmulator_SIZEOF_COMMAND_BUFFER)
+                    {
+                        maxPktSize = BootloaderEmulator_SIZEOF_COMMAND_BUFFER;
+                    }
+
+                    packetBuffer[BootloaderEmulator_DATA_ADDR     ] = LO8(maxPktSize);
+                    packetBuffer[BootloaderEmulator_DATA_ADDR + 1u] = HI8(maxPktSize);
+                    packetBuffer[BootloaderEmulator_DATA_ADDR + 2u] = LO8(mtu);
+                    packetBuffer[BootloaderEmulator_DATA_ADDR + 3u] = HI8(mtu);
+                    rspSize = 4u;
+                    ackCode = CYRET_SUCCESS;
+
+                    DBG_PRINT_TEXT("\r\n");
+                    DBG_PRINT_TEXT("BootloaderEmulator:\r\n");
+                    DBG_PRINT_TEXT("\tGet Packet Size:\r\n");
+                    DBG_PRINT_TEXT("\t\tPacket Size: 0x");
+                    DBG_PRINT_HEX(maxPktSize);
+                    DBG_PRINT_TEXT("\r\n");
+                }
+                break;
+
+            #endif /* (0u != BootloaderEmulator_CMD_GET_PKT_SIZE_AVAIL) */
+
+
             /***************************************************************************
             *   Verify row
             ***************************************************************************/
@@ -1035,8 +2857,15 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
                 if((BootloaderEmulator_COMMUNICATION_STATE_ACTIVE == communicationState) && (pktSize == 3u))
                 {
                     uint8 CYDATA checksum;
+                    uint16 row;
+
+                    /* Get Flash row number inside of the array */
+                    dataOffset = ((uint16)((uint16)packetBuffer[BootloaderEmulator_DATA_ADDR + 2u] << 8u)) |
+                                          packetBuffer[BootloaderEmulator_DATA_ADDR + 1u];
+                    row = (uint16)(btldrData * BootloaderEmulator_NUMBER_OF_ROWS_IN_ARRAY) + dataOffset;
 
-                    checksum = BootloaderEmulator_Calc8BitSum(appSizeInRows - 1u);
+                    checksum = BootloaderEmulator_Calc8BitSum(BootloaderEmulator_ImageRow(row));
+                    dataOffset = 0u;
 
                     packetBuffer[BootloaderEmulator_DATA_ADDR] = (uint8)1u + (uint8)(~checksum);
                     ackCode = CYRET_SUCCESS;
@@ -1060,6 +2889,21 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
             ***************************************************************************/
             case BootloaderEmulator_COMMAND_EXIT:
 
+                if (0u != btldrDeltaRows)
+                {
+                    /* Unchanged rows at the end of the delta image were not sent */
+                    appSizeInRows = btldrDeltaRows;
+                }
+
+                if (EMI_MD_DIGEST_STATUS_VALID == metadata[EMI_MD_DIGEST_STATUS_ADDR])
+                {
+                    /* Rows may have been received over several connections */
+                    uint32 dataFlag;
+
+                    (void) EMI_DigestSum(appSizeInRows, EMI_DIGEST_BASE_ROW(metadata, appFirstRowNum),
+                                         &appExtMemChecksum, &dataFlag);
+                }
+
                 if(CYRET_SUCCESS == BootloaderEmulator_ValidateBootloadable())
                 {
                     BootloaderEmulator_SET_RUN_TYPE(BootloaderEmulator_SCHEDULE_BTLDR);
@@ -1070,6 +2914,8 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
                     DBG_PRINT_TEXT("\t\tBootloadable Application is valid.\r\n");
                     metadata[EMI_MD_APP_STATUS_ADDR] = EMI_MD_APP_STATUS_VALID;
                     metadata[EMI_MD_ENCRYPTION_STATUS_ADDR] = ENCRYPTION_ENABLED;
+                    metadata[EMI_MD_RESUME_STATUS_ADDR] = EMI_MD_RESUME_STATUS_NONE;
+                    metadata[EMI_MD_COPY_ATTEMPTS_ADDR] = EMI_MD_COPY_ATTEMPTS_NONE;
                 }
                 else
                 {
@@ -1089,10 +2935,33 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
                 appExtMemChecksum = ( uint16 )1u + ( uint16 )(~appExtMemChecksum);
                 metadata[EMI_MD_APP_EM_CHECKSUM_ADDR     ]      = LO8(appExtMemChecksum);
                 metadata[EMI_MD_APP_EM_CHECKSUM_ADDR + 1u]      = HI8(appExtMemChecksum);
-                metadata[EMI_MD_EXTERNAL_MEMORY_PAGE_SIZE_ADDR] = EMI_EXTERNAL_MEMORY_PAGE_SIZE;
+                metadata[EMI_MD_EXTERNAL_MEMORY_PAGE_SIZE_ADDR     ] = LO8(EMI_EXTERNAL_MEMORY_PAGE_SIZE);
+                metadata[EMI_MD_EXTERNAL_MEMORY_PAGE_SIZE_ADDR + 1u] = HI8(EMI_EXTERNAL_MEMORY_PAGE_SIZE);
+
+                metadata[EMI_MD_IMAGE_CRC_STATUS_ADDR] = EMI_MD_IMAGE_CRC_STATUS_INVALID;
+                if ((BootloaderEmulator_IMAGE_CRC_BROKEN != btldrImageCrcRow) &&
+                    ((0u != btldrDeltaRows) || (btldrImageCrcRow == appSizeInRows)))
+                {
+                    /* Every row was added to the CRC as it arrived */
+                    btldrImageCrc = ~btldrImageCrc;
+                    metadata[EMI_MD_IMAGE_CRC_STATUS_ADDR] = EMI_MD_IMAGE_CRC_STATUS_VALID;
+                }
+                else if (((0u == btldrDeltaRows) ||
+                          (EMI_MD_DIGEST_STATUS_VALID == metadata[EMI_MD_DIGEST_STATUS_ADDR])) &&
+                         (CYRET_SUCCESS == EMI_ImageCrcCalc(appSizeInRows, (uint32) (0u != btldrDeltaRows),
+                                                            &btldrImageCrc)))
+                {
+                    /* Rows were read back once, as they did not arrive in order */
+                    metadata[EMI_MD_IMAGE_CRC_STATUS_ADDR] = EMI_MD_IMAGE_CRC_STATUS_VALID;
+                }
+                metadata[EMI_MD_IMAGE_CRC_ADDR     ] = LO8(LO16(btldrImageCrc));
+                metadata[EMI_MD_IMAGE_CRC_ADDR + 1u] = HI8(LO16(btldrImageCrc));
+                metadata[EMI_MD_IMAGE_CRC_ADDR + 2u] = LO8(HI16(btldrImageCrc));
+                metadata[EMI_MD_IMAGE_CRC_ADDR + 3u] = HI8(HI16(btldrImageCrc));
 
 
                 (void) EMI_WriteData(EMI_MD_BASE_ADDR, CY_FLASH_SIZEOF_ROW, metadata);
+                (void) EMI_WaitForIdle();
 
 
                 DBG_PRINT_TEXT("\t\tApplication Status: 0x");
@@ -1107,6 +2976,10 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
                 DBG_PRINT_HEX(appFirstRowNum);
                 DBG_PRINT_TEXT("\r\n");
 
+                DBG_PRINT_TEXT("\t\tImage CRC-32: 0x");
+                DBG_PRINT_HEX(btldrImageCrc);
+                DBG_PRINT_TEXT("\r\n");
+
                 DBG_PRINT_TEXT("\t\tExternal Memory Page Size: 0x");
                 DBG_PRINT_HEX(metadata[EMI_MD_EXTERNAL_MEMORY_PAGE_SIZE_ADDR]);
                 DBG_PRINT_TEXT(" KB");
@@ -1120,6 +2993,10 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
                 DBG_PRINT_TEXT("\r\n");
                 DBG_PRINT_TEXT("\r\n");
 
+                #if (OTA_STATS_ENABLED == YES)
+                    BootloaderEmulator_StatsReport();
+                #endif /* (OTA_STATS_ENABLED == YES) */
+
                 CySoftwareReset();
 
                 /* Will never get here */
@@ -1142,6 +3019,149 @@ static void BootloaderEmulator_HostLink(uint8 timeOut)
 }
 
 
+#if (0u != BootloaderEmulator_CMD_COMPRESSED_AVAIL)
+/*******************************************************************************
+* Function Name: BootloaderEmulator_CompressedData
+********************************************************************************
+*
+* Summary:
+*  Decodes the block of the compressed stream into the row buffer and programs
+*  the rows completed by it. The match that continues past the row is finished
+*  in the next row without waiting for more data.
+*
+* Parameters:
+*  const uint8 data[]: The compressed data.
+*  uint16 size:        The number of bytes in the compressed data.
+*
+* Return:
+*  CYRET_SUCCESS or the bootloader error code.
+*
+*******************************************************************************/
+static uint8 BootloaderEmulator_CompressedData(const uint8 data[], uint16 size)
+{
+    uint8  ackCode = CYRET_SUCCESS;
+    uint32 offset = 0u;
+    uint32 used;
+    uint32 decoded;
+
+    do
+    {
+        if (0u == btldrLzssRowsLeft)
+        {
+            /* The stream is longer than the announced rows */
+            ackCode = BootloaderEmulator_ERR_LENGTH;
+            break;
+        }
+
+        decoded = LZSS_Decode(&btldrLzss, &data[offset], (uint32) size - offset, &used,
+                              &btldrLzssRowData[btldrLzssRowFill], (uint32) CY_FLASH_SIZEOF_ROW - btldrLzssRowFill);
+        offset += used;
+        btldrLzssRowFill += (uint16) decoded;
+
+        if (CY_FLASH_SIZEOF_ROW == btldrLzssRowFill)
+        {
+            ackCode = BootloaderEmulator_ProgramRow(btldrLzssRow, btldrLzssRowData);
+            btldrLzssRow++;
+            btldrLzssRowsLeft--;
+            btldrLzssRowFill = 0u;
+        }
+    } while ((CYRET_SUCCESS == ackCode) && ((offset < size) || ((0u != decoded) && (0u != btldrLzssRowsLeft))));
+
+    if ((CYRET_SUCCESS == ackCode) && (0u == btldrLzssRowsLeft) && (0u == LZSS_IsIdle(&btldrLzss)))
+    {
+        /* The last match runs past the last row */
+        ackCode = BootloaderEmulator_ERR_DATA;
+    }
+
+    return (ackCode);
+}
+#endif /* (0u != BootloaderEmulator_CMD_COMPRESSED_AVAIL) */
+
+
+#if (OTA_STATS_ENABLED == YES)
+/*******************************************************************************
+* Function Name: BootloaderEmulator_StatsStart
+********************************************************************************
+*
+* Summary:
+*  Clears the transfer statistics and starts the SysTick as the free running
+*  SYSCLK cycle counter.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BootloaderEmulator_StatsStart(void)
+{
+    (void) memset(&btldrStats, 0, sizeof(btldrStats));
+
+    CySysTickSetClockSource(CY_SYS_SYST_CSR_CLK_SRC_SYSCLK);
+    CySysTickSetReload(BootloaderEmulator_STATS_SYSTICK_MASK);
+    CySysTickClear();
+    CySysTickEnable();
+
+    /* Only the counter is used, no SysTick handler is installed */
+    CySysTickDisableInterrupt();
+}
+
+
+/*******************************************************************************
+* Function Name: BootloaderEmulator_StatsElapsed
+********************************************************************************
+*
+* Summary:
+*  Returns the SYSCLK cycles since the SysTick value was sampled.
+*
+* Parameters:
+*  uint32 mark: The SysTick value sampled at the start of the measurement.
+*
+* Return:
+*  Number of cycles.
+*
+*******************************************************************************/
+static uint32 BootloaderEmulator_StatsElapsed(uint32 mark)
+{
+    /* SysTick counts down */
+    return ((mark - CySysTickGetValue()) & BootloaderEmulator_STATS_SYSTICK_MASK);
+}
+
+
+/*******************************************************************************
+* Function Name: BootloaderEmulator_StatsReport
+********************************************************************************
+*
+* Summary:
+*  Prints the transfer statistics. The row rate is the upper bound set by the
+*  CPU, the rate over the air is measured by the host.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BootloaderEmulator_StatsReport(void)
+{
+    uint32 rows = (0u != btldrStats.rows) ? btldrStats.rows : 1u;
+    uint32 cyclesPerRow = (btldrStats.cmdCycles + btldrStats.emiCycles) / rows;
+
+    DBG_PRINTF("OTA statistics:\r\n");
+    DBG_PRINTF("\tpackets: %lu, bad: %lu\r\n", btldrStats.packets, btldrStats.badPackets);
+    DBG_PRINTF("\tbytes over the air: %lu in, %lu out, %lu per row\r\n",
+        btldrStats.bytesIn, btldrStats.bytesOut, (btldrStats.bytesIn + btldrStats.bytesOut) / rows);
+    DBG_PRINTF("\trows: %lu, programming cycles per row: %lu\r\n", btldrStats.rows, btldrStats.rowCycles / rows);
+    DBG_PRINTF("\tcycles per row: %lu (commands %lu, external memory %lu)\r\n",
+        cyclesPerRow, btldrStats.cmdCycles / rows, btldrStats.emiCycles / rows);
+    DBG_PRINTF("\tCPU bound rows per second: %lu\r\n",
+        (0u != cyclesPerRow) ? (CYDEV_BCLK__SYSCLK__HZ / cyclesPerRow) : 0u);
+}
+#endif /* (OTA_STATS_ENABLED == YES) */
+
+
 /*******************************************************************************
 * Function Name: BootloaderEmulator_WritePacket
 ********************************************************************************
@@ -1179,6 +3199,11 @@ static cystatus BootloaderEmulator_WritePacket(uint8 status, uint8 buffer[], uin
     buffer[BootloaderEmulator_CHK_ADDR(1u + size)] = HI8(checksum);
     buffer[BootloaderEmulator_EOP_ADDR(size)]     = BootloaderEmulator_EOP;
 
+    #if (OTA_STATS_ENABLED == YES)
+        btldrStats.bytesOut += (uint32) size + BootloaderEmulator_MIN_PKT_SIZE;
+        btldrStats.cmdCycles += BootloaderEmulator_StatsElapsed(btldrStatsMark);
+    #endif /* (OTA_STATS_ENABLED == YES) */
+
     /* Start packet transmit. */
     return(CyBtldrCommWrite(buffer, size + BootloaderEmulator_MIN_PKT_SIZE, &size, 150u));
 }
@@ -0,0 +1,183 @@
+/*******************************************************************************
+* File Name: verified_boot.c
+*
+* Version: 1.50
+*
+* Description:
+*  Provides the verified boot marker. The bootloader stores the marker after
+*  the application in the internal flash and its copy in the external memory
+*  passed the checksum verification, and skips both checksums while the marker
+*  matches the metadata.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#include <project.h>
+#include <stddef.h>
+#include <string.h>
+#include "verified_boot.h"
+#include "ota_mandatory.h"
+#include "crc.h"
+#include "debug.h"
+
+#if (VERIFIED_BOOT_ENABLED == YES)
+
+static void   VB_BuildMarker(const uint8 extMemMetadata[], VB_MARKER_T *marker);
+static uint16 VB_MarkerCrc(const VB_MARKER_T *marker);
+
+
+/*******************************************************************************
+* Function Name: VB_IsImageVerified
+********************************************************************************
+*
+* Summary:
+*  Checks whether the application may be started without the full
+*  verification: the marker is valid, describes the image of the external
+*  memory metadata and the bootloadable metadata in flash, and the reset cause
+*  does not request the full verification.
+*
+* Parameters:
+*  extMemMetadata: The metadata row read from the external memory.
+*
+* Return:
+*  Non-zero if the application was already verified.
+*
+*******************************************************************************/
+uint32 VB_IsImageVerified(const uint8 extMemMetadata[])
+{
+    const VB_MARKER_T *stored = (const VB_MARKER_T *) VB_ROW_ADDR;
+    VB_MARKER_T expected;
+    uint32 resetCause;
+    uint32 verified = 0u;
+
+    /* Do not clear the reset cause, the application may check it as well */
+    resetCause = CySysGetResetReason(0u);
+    if (0u == resetCause)
+    {
+        resetCause = VB_RESET_POR;
+    }
+
+    if ((0u == (resetCause & (VB_FULL_CHECK_RESETS))) &&
+        (VB_MAGIC == stored->magic) && (VB_MarkerCrc(stored) == stored->crc))
+    {
+        VB_BuildMarker(extMemMetadata, &expected);
+
+        if ((expected.extMemChecksum == stored->extMemChecksum) &&
+            (expected.appRows == stored->appRows) &&
+            (expected.flashMdCrc == stored->flashMdCrc))
+        {
+            verified = 1u;
+        }
+    }
+
+    DBG_PRINT_TEXT("\r\n");
+    DBG_PRINT_TEXT("VerifiedBoot:\r\n");
+    DBG_PRINT_TEXT("\tVB_IsImageVerified(): 0x");
+    DBG_PRINT_HEX(verified);
+    DBG_PRINT_TEXT("\r\n");
+
+    return (verified);
+}
+
+
+/*******************************************************************************
+* Function Name: VB_RecordImage
+********************************************************************************
+*
+* Summary:
+*  Stores the marker of the application that passed the full verification.
+*  The row is not written if it already holds the same marker.
+*
+* Parameters:
+*  extMemMetadata: The metadata row read from the external memory.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void VB_RecordImage(const uint8 extMemMetadata[])
+{
+    const VB_MARKER_T *stored = (const VB_MARKER_T *) VB_ROW_ADDR;
+    uint32 row[CY_FLASH_SIZEOF_ROW / sizeof(uint32)];
+    VB_MARKER_T *marker = (VB_MARKER_T *) row;
+    uint32 storedValid;
+
+    storedValid = (uint32) ((VB_MAGIC == stored->magic) && (VB_MarkerCrc(stored) == stored->crc));
+
+    (void) memset(row, 0, sizeof(row));
+    VB_BuildMarker(extMemMetadata, marker);
+    marker->writeCount = (0u != storedValid) ? (stored->writeCount + 1u) : 1u;
+    marker->crc = VB_MarkerCrc(marker);
+
+    if ((0u == storedValid) ||
+        (marker->extMemChecksum != stored->extMemChecksum) ||
+        (marker->appRows != stored->appRows) ||
+        (marker->flashMdCrc != stored->flashMdCrc))
+    {
+        if (CY_SYS_FLASH_SUCCESS != SF_WriteUserSFlashRow(VB_ROW_NUM, row))
+        {
+            DBG_PRINT_TEXT("VerifiedBoot: marker write failed\r\n");
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: VB_BuildMarker
+********************************************************************************
+*
+* Summary:
+*  Fills the image fields of the marker from the metadata.
+*
+* Parameters:
+*  extMemMetadata: The metadata row read from the external memory.
+*  marker:         The marker to fill.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void VB_BuildMarker(const uint8 extMemMetadata[], VB_MARKER_T *marker)
+{
+    marker->magic = VB_MAGIC;
+    marker->extMemChecksum = ((uint16)((uint16)extMemMetadata[EMI_MD_APP_EM_CHECKSUM_ADDR + 1u] << 8u)) |
+                                            extMemMetadata[EMI_MD_APP_EM_CHECKSUM_ADDR];
+    marker->appRows = ((uint16)((uint16)extMemMetadata[EMI_MD_APP_SIZE_IN_ROWS_ADDR + 1u] << 8u)) |
+                                            extMemMetadata[EMI_MD_APP_SIZE_IN_ROWS_ADDR];
+
+    /* The bootloadable metadata holds the checksum and the length of the image in flash */
+    marker->flashMdCrc = CRC_CcittCalc((const uint8 *) VB_FLASH_MD_ADDR, VB_FLASH_MD_SIZEOF);
+}
+
+
+/*******************************************************************************
+* Function Name: VB_MarkerCrc
+********************************************************************************
+*
+* Summary:
+*  Computes the CRC of the marker fields that precede the CRC.
+*
+* Parameters:
+*  marker: The marker.
+*
+* Return:
+*  CRC-CCITT of the marker.
+*
+*******************************************************************************/
+static uint16 VB_MarkerCrc(const VB_MARKER_T *marker)
+{
+    return (CRC_CcittCalc((const uint8 *) marker, (uint32) offsetof(VB_MARKER_T, crc)));
+}
+
+#endif /* (VERIFIED_BOOT_ENABLED == YES) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,78 @@
+/*******************************************************************************
+* File Name: verified_boot.h
+*
+* Version: 1.50
+*
+* Description:
+*  Contains the function prototypes and constants of the verified boot marker.
+*  The marker records the application image that passed the full verification,
+*  so the following boots only compare it with the metadata.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#ifndef BLE_OTA_EM_VERIFIED_BOOT_H_
+#define BLE_OTA_EM_VERIFIED_BOOT_H_
+
+#include "options.h"
+#include "cytypes.h"
+#include "CyFlash.h"
+
+#if (VERIFIED_BOOT_ENABLED == YES)
+
+#if ((VB_ROW_NUM == 0u) || (VB_ROW_NUM == KEY_ROW_NUM))
+    #error VB_ROW_NUM must not be the BLE component row or the key row
+#endif /* ((VB_ROW_NUM == 0u) || (VB_ROW_NUM == KEY_ROW_NUM)) */
+
+
+/*******************************************************************************
+* Marker location. The user SFLASH rows are not touched by the image copy, the
+* marker row is rewritten only when the verified image changes.
+*******************************************************************************/
+#define VB_SFLASH_USER_BASE_ROW         (4u)    /* SFLASH row of the user row 0 */
+#define VB_ROW_ADDR                     (CYDEV_SFLASH_BASE + \
+                                            ((VB_ROW_NUM + VB_SFLASH_USER_BASE_ROW) * CY_FLASH_SIZEOF_ROW))
+
+#define VB_MAGIC                        (0x31425656u)   /* "VVB1" */
+
+/* Power-on and external resets do not set a bit in RES_CAUSE */
+#define VB_RESET_POR                    (0x80000000u)
+
+/* Bootloadable metadata at the end of the last flash row */
+#define VB_FLASH_MD_SIZEOF              (64u)
+#define VB_FLASH_MD_ADDR                (CYDEV_FLASH_BASE + CYDEV_FLASH_SIZE - VB_FLASH_MD_SIZEOF)
+
+
+/***************************************
+*        Data Types
+***************************************/
+typedef struct
+{
+    uint32 magic;
+    uint32 writeCount;                  /* Number of the marker row writes */
+    uint16 extMemChecksum;              /* Image checksum in the external memory metadata */
+    uint16 appRows;                     /* Image size in rows */
+    uint16 flashMdCrc;                  /* CRC-CCITT of the bootloadable metadata in flash */
+    uint16 crc;                         /* CRC-CCITT of the preceding fields */
+} VB_MARKER_T;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+uint32 VB_IsImageVerified(const uint8 extMemMetadata[]);
+void   VB_RecordImage(const uint8 extMemMetadata[]);
+
+#endif /* (VERIFIED_BOOT_ENABLED == YES) */
+
+#endif /* BLE_OTA_EM_VERIFIED_BOOT_H_ */
+
+/* [] END OF FILE */
@@ -0,0 +1,57 @@
+/*******************************************************************************
+* File Name: BLE_Stack.h
+*
+* Version: 1.50
+*
+* Description:
+*  Host build replacement of the BLE stack API used by the external memory OTA
+*  sources. The functions are provided by the simulator.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#if !defined(CY_BLE_CYBLE_STACK_H)
+#define CY_BLE_CYBLE_STACK_H
+
+#include "cytypes.h"
+
+
+/***************************************
+*        Data Types
+***************************************/
+typedef enum
+{
+    CYBLE_ERROR_OK                          = 0x0000u,
+    CYBLE_ERROR_INVALID_PARAMETER           = 0x0001u,
+    CYBLE_ERROR_INVALID_OPERATION           = 0x0002u,
+    CYBLE_ERROR_MEMORY_ALLOCATION_FAILED    = 0x0003u,
+    CYBLE_ERROR_INSUFFICIENT_RESOURCES      = 0x0004u,
+    CYBLE_ERROR_NO_DEVICE_ENTITY            = 0x0007u,
+    CYBLE_ERROR_INVALID_STATE               = 0x0011u,
+    CYBLE_ERROR_MIC_AUTH_FAILED             = 0x0014u
+} CYBLE_API_RESULT_T;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+void CyBle_ProcessEvents(void);
+void CyBle_AesCcmInit(void);
+CYBLE_API_RESULT_T CyBle_AesCcmEncrypt(uint8 *key, uint8 *nonce, uint8 *in_data, uint8 length,
+                                       uint8 *out_data, uint8 *out_mic);
+CYBLE_API_RESULT_T CyBle_AesCcmDecrypt(uint8 *key, uint8 *nonce, uint8 *in_data, uint8 length,
+                                       uint8 *out_data, uint8 *in_mic);
+CYBLE_API_RESULT_T CyBle_GenerateRandomNumber(uint8 *randomNumber);
+
+#endif /* !defined(CY_BLE_CYBLE_STACK_H) */
+
+
+/* [] END OF FILE */
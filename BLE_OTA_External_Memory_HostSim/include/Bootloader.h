@@ -0,0 +1,46 @@
+/*******************************************************************************
+* File Name: Bootloader.h
+*
+* Version: 1.50
+*
+* Description:
+*  Host build replacement of the public API of the Bootloader component used
+*  by the external memory bootloader. The component is emulated by the
+*  simulator, see sim_copy.c.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#if !defined(CY_BOOTLOADER_Bootloader_H)
+#define CY_BOOTLOADER_Bootloader_H
+
+#include "cytypes.h"
+
+
+/***************************************
+*        Constants
+***************************************/
+#define Bootloader_MD_BTLDB_ACTIVE_0    (0x00u)
+#define Bootloader_EXIT_TO_BTLDB        (0x80u)
+#define Bootloader_SCHEDULE_BTLDB       (0x80u)
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+void     Bootloader_Start(void);
+cystatus Bootloader_ValidateBootloadable(uint8 appId);
+void     Bootloader_Exit(uint32 appId);
+
+#endif /* !defined(CY_BOOTLOADER_Bootloader_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,71 @@
+/*******************************************************************************
+* File Name: Bootloader_PVT.h
+*
+* Version: 1.50
+*
+* Description:
+*  Host build replacement of the private header of the Bootloader component:
+*  the packet framing and the bootloadable metadata layout.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#if !defined(CY_BOOTLOADER_Bootloader_PVT_H)
+#define CY_BOOTLOADER_Bootloader_PVT_H
+
+#include "Bootloader.h"
+#include "CyFlash.h"
+
+
+/* Packet framing constants. */
+#define Bootloader_SOP                  (0x01u)    /* Start of Packet */
+#define Bootloader_EOP                  (0x17u)    /* End of Packet */
+
+#define Bootloader_SOP_ADDR             (0x00u)
+#define Bootloader_CMD_ADDR             (0x01u)
+#define Bootloader_SIZE_ADDR            (0x02u)
+#define Bootloader_DATA_ADDR            (0x04u)
+#define Bootloader_CHK_ADDR(x)          (0x04u + (x))
+#define Bootloader_EOP_ADDR(x)          (0x06u + (x))
+#define Bootloader_MIN_PKT_SIZE         (7u)
+
+#define Bootloader_SIZEOF_COMMAND_BUFFER    (300u)
+
+
+/* Bootloader command responses */
+#define Bootloader_ERR_LENGTH           (0x03u)
+#define Bootloader_ERR_DATA             (0x04u)
+#define Bootloader_ERR_CMD              (0x05u)
+#define Bootloader_ERR_CHECKSUM         (0x08u)
+#define Bootloader_ERR_ROW              (0x0Au)
+#define Bootloader_ERR_APP              (0x0Cu)
+
+
+/* Bootloader command definitions. */
+#define Bootloader_COMMAND_ENTER        (0x38u)
+#define Bootloader_COMMAND_PROGRAM      (0x39u)
+#define Bootloader_COMMAND_EXIT         (0x3Bu)
+
+
+/* Bootloadable metadata, the last 64 bytes of the last flash row */
+#define Bootloader_MD_SIZEOF            (64u)
+#define Bootloader_MD_FLASH_ROW         (CY_FLASH_NUMBER_ROWS - 1u)
+#define Bootloader_MD_APP_CHECKSUM      (CY_FLASH_SIZEOF_ROW - Bootloader_MD_SIZEOF)
+#define Bootloader_MD_APP_ADDR          (Bootloader_MD_APP_CHECKSUM + 1u)
+#define Bootloader_MD_LAST_BTLDR_ROW    (Bootloader_MD_APP_CHECKSUM + 5u)
+#define Bootloader_MD_APP_LENGTH        (Bootloader_MD_APP_CHECKSUM + 9u)
+
+#define Bootloader_NUMBER_OF_ROWS_IN_ARRAY  ((uint16) (CY_FLASH_SIZEOF_ARRAY / CY_FLASH_SIZEOF_ROW))
+
+#endif /* !defined(CY_BOOTLOADER_Bootloader_PVT_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,102 @@
+/*******************************************************************************
+* File Name: CyFlash.h
+*
+* Version: 1.50
+*
+* Description:
+*  Host build replacement of the PSoC 4 CyFlash.h for the CY8C4247LQI-BL483
+*  (128 KB flash in two 64 KB arrays). The system call registers are
+*  simulator variables, CY_FLASH_API_RETURN executes the call that was
+*  requested, see sim_memory.c.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#if !defined(CY_BOOT_CYFLASH_H)
+#define CY_BOOT_CYFLASH_H
+
+#include "cytypes.h"
+#include "CyLib.h"
+
+
+/***************************************
+*    Flash Geometry
+***************************************/
+#define CY_FLASH_BASE                       (CYDEV_FLASH_BASE)
+#define CY_FLASH_SIZE                       (CYDEV_FLASH_SIZE)
+#define CY_FLASH_SIZEOF_ROW                 (CYDEV_FLS_ROW_SIZE)
+#define CY_FLASH_NUMBER_ROWS                (CY_FLASH_SIZE / CY_FLASH_SIZEOF_ROW)
+#define CY_FLASH_SIZEOF_ARRAY               (0x00010000u)
+#define CY_FLASH_NUMBER_ARRAYS              (CY_FLASH_SIZE / CY_FLASH_SIZEOF_ARRAY)
+#define CY_FLASH_SRAM_ROM_DATA              (8u)
+
+#define CY_FLASH_GET_MACRO_FROM_ROW(row)    ((uint32) ((row) / (CY_FLASH_SIZEOF_ARRAY / CY_FLASH_SIZEOF_ROW)))
+
+
+/***************************************
+*    System Call Interface
+***************************************/
+#define CY_FLASH_KEY_ONE                    (0xB6u)
+#define CY_FLASH_KEY_TWO(x)                 ((uint32) (((uint16) 0xD3u) + ((uint16) (x))))
+
+#define CY_FLASH_PARAM_KEY_TWO_OFFSET       (8u)
+#define CY_FLASH_PARAM_ADDR_OFFSET          (16u)
+#define CY_FLASH_PARAM_MACRO_SEL_OFFSET     (24u)
+#define CY_FLASH_PAGE_LATCH_START_ADDR      (0u)
+
+#define CY_FLASH_API_OPCODE_LOAD            (0x04u)
+#define CY_FLASH_API_OPCODE_WRITE_ROW       (0x05u)
+#define CY_FLASH_API_OPCODE_PROGRAM_ROW     (0x06u)
+#define CY_FLASH_API_OPCODE_CLK_CONFIG      (0x15u)
+#define CY_FLASH_API_OPCODE_CLK_BACKUP      (0x16u)
+#define CY_FLASH_API_OPCODE_CLK_RESTORE     (0x17u)
+
+#define CY_FLASH_CPUSS_REQ_START            (0x80000000u)
+
+extern volatile uint32 SimSpc_sysArg;
+extern volatile uint32 SimSpc_sysReq;
+uint32 SimSpc_Execute(void);
+
+#define CY_FLASH_CPUSS_SYSARG_REG           (SimSpc_sysArg)
+#define CY_FLASH_CPUSS_SYSREQ_REG           (SimSpc_sysReq)
+#define CY_FLASH_API_RETURN                 (SimSpc_Execute())
+
+/* The firmware stack and data are mapped below 4 GB, see sim.h */
+#define SF_SRAM_ADDR(ptr)                   ((uint32) (uintptr_t) (ptr))
+
+
+/***************************************
+*    Return Codes
+***************************************/
+#define CY_SYS_FLASH_SUCCESS                (0x00u)
+#define CY_SYS_FLASH_INVALID_ADDR           (0x04u)
+#define CY_SYS_FLASH_PROTECTED              (0x05u)
+#define CY_SYS_FLASH_CLOCK_ERROR            (0x06u)
+
+
+/***************************************
+*    Data Types
+***************************************/
+typedef struct
+{
+    uint32 clockSettings[4u];
+} CY_SYS_FLASH_CLOCK_BACKUP_STRUCT;
+
+
+/***************************************
+*    Function Prototypes
+***************************************/
+uint32 CySysFlashWriteRow(uint32 rowNum, const uint8 rowData[]);
+
+#endif /* !defined(CY_BOOT_CYFLASH_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,61 @@
+/*******************************************************************************
+* File Name: CyLib.h
+*
+* Version: 1.50
+*
+* Description:
+*  Host build replacement of the PSoC 4 CyLib.h: the system functions of the
+*  cy_boot library the firmware calls. All of them are implemented by the
+*  simulator, see sim_core.c.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#if !defined(CY_BOOT_CYLIB_H)
+#define CY_BOOT_CYLIB_H
+
+#include "cytypes.h"
+
+
+/***************************************
+*        System Functions
+***************************************/
+#define CyGlobalIntEnable           do { SimCpu_InterruptsEnable(1u); } while (0)
+#define CyGlobalIntDisable          do { SimCpu_InterruptsEnable(0u); } while (0)
+
+#define CY_SYS_RESET_WDT            (0x01u)
+#define CY_SYS_RESET_PROTFAULT      (0x08u)
+#define CY_SYS_RESET_SW             (0x10u)
+
+#define CY_SYS_SYST_CSR_CLK_SRC_SYSCLK  (1u)
+
+void   SimCpu_InterruptsEnable(uint32 enable);
+
+uint8  CyEnterCriticalSection(void);
+void   CyExitCriticalSection(uint8 savedIntrStatus);
+void   CyDelay(uint32 milliseconds);
+void   CyDelayUs(uint16 microseconds);
+void   CySoftwareReset(void);
+void   CyHalt(uint8 reason);
+uint32 CySysGetResetReason(uint32 reason);
+void   CySysPmSleep(void);
+
+void   CySysTickEnable(void);
+void   CySysTickSetClockSource(uint32 clockSource);
+void   CySysTickSetReload(uint32 value);
+void   CySysTickClear(void);
+void   CySysTickDisableInterrupt(void);
+uint32 CySysTickGetValue(void);
+
+#endif /* !defined(CY_BOOT_CYLIB_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,126 @@
+/*******************************************************************************
+* File Name: cytypes.h
+*
+* Version: 1.50
+*
+* Description:
+*  Host build replacement of the PSoC Creator cytypes.h: the integer types,
+*  the return codes and the device constants the external memory OTA sources
+*  use. The device memory is mapped by the simulator at the addresses given
+*  here, see sim_memory.c.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#if !defined(CY_BOOT_CYTYPES_H)
+#define CY_BOOT_CYTYPES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/***************************************
+*        Data Types
+***************************************/
+typedef uint8_t             uint8;
+typedef uint16_t            uint16;
+typedef uint32_t            uint32;
+typedef int8_t              int8;
+typedef int16_t             int16;
+typedef int32_t             int32;
+typedef uint32              cystatus;
+typedef uint8               CYBIT;
+typedef volatile uint8      reg8;
+typedef volatile uint16     reg16;
+typedef volatile uint32     reg32;
+
+
+/***************************************
+*        Device Family
+***************************************/
+#define CY_PSOC3                    (0u)
+#define CY_PSOC4                    (1u)
+#define CY_PSOC5                    (0u)
+#define CY_IP_SPCIF_SYNCHRONOUS     (1u)
+
+#define CYDATA
+#define CYCODE
+#define CYXDATA
+
+
+/***************************************
+*        Return Codes
+***************************************/
+#define CYRET_SUCCESS               (0x00u)
+#define CYRET_BAD_PARAM             (0x01u)
+#define CYRET_INVALID_STATE         (0x02u)
+#define CYRET_MEMORY                (0x03u)
+#define CYRET_STARTED               (0x04u)
+#define CYRET_FINISHED              (0x05u)
+#define CYRET_CANCELED              (0x06u)
+#define CYRET_TIMEOUT               (0x07u)
+#define CYRET_INVALID_OBJECT        (0x08u)
+#define CYRET_BAD_DATA              (0x09u)
+#define CYRET_EMPTY                 (0x0Au)
+#define CYRET_LOCKED                (0x0Bu)
+#define CYRET_UNKNOWN               ((cystatus) 0xFFFFFFFFu)
+
+
+/***************************************
+*        Device Constants
+***************************************/
+#if !defined(CYDEV_BOOTLOADER_ENABLE)
+    #define CYDEV_BOOTLOADER_ENABLE (0)
+#endif /* !defined(CYDEV_BOOTLOADER_ENABLE) */
+
+#define CYDEV_CHIP_JTAG_ID          (0x0E36119Eu)   /* CY8C4247LQI-BL483 */
+#define CYDEV_CHIP_REV_EXPECT       (0x11u)
+#define CYDEV_BCLK__SYSCLK__HZ      (48000000u)
+
+/* Flash is mapped at the simulator address instead of 0 */
+#define CYDEV_FLASH_BASE            ((uintptr_t) 0x10000000u)
+#define CYDEV_FLASH_SIZE            (0x00020000u)
+#define CYDEV_FLS_SIZE              (CYDEV_FLASH_SIZE)
+#define CYDEV_FLS_ROW_SIZE          (128u)
+#define CYDEV_SFLASH_BASE           (0x0FFFF000u)
+#define CYDEV_SFLASH_SIZE           (0x00001000u)
+
+#define CYREG_SFLASH_SILICON_ID     (0x0FFFF144u)
+#define CYREG_SFLASH_DIE_LOT0       (0x0FFFF1E8u)
+#define CYREG_SFLASH_DIE_LOT1       (0x0FFFF1E9u)
+#define CYREG_SFLASH_DIE_LOT2       (0x0FFFF1EAu)
+#define CYREG_SFLASH_DIE_WAFER      (0x0FFFF1EBu)
+#define CYREG_SFLASH_DIE_X          (0x0FFFF1ECu)
+#define CYREG_SFLASH_DIE_Y          (0x0FFFF1EDu)
+#define CYREG_SFLASH_DIE_SORT       (0x0FFFF1EEu)
+#define CYREG_SFLASH_DIE_MINOR      (0x0FFFF1EFu)
+
+
+/***************************************
+*        Macros
+***************************************/
+#define LO8(x)                      ((uint8) ((x) & 0xFFu))
+#define HI8(x)                      ((uint8) ((uint16) (x) >> 8))
+#define LO16(x)                     ((uint16) ((x) & 0xFFFFu))
+#define HI16(x)                     ((uint16) ((uint32) (x) >> 16))
+
+#define CY_GET_REG8(addr)           (*((reg8 *) (uintptr_t) (addr)))
+#define CY_GET_REG32(addr)          (*((reg32 *) (uintptr_t) (addr)))
+#define CY_GET_XTND_REG8(addr)      CY_GET_REG8(addr)
+#define CY_GET_XTND_REG32(addr)     CY_GET_REG32(addr)
+
+#define CY_ISR(name)                void name(void)
+#define CY_ISR_PROTO(name)          void name(void)
+
+#endif /* !defined(CY_BOOT_CYTYPES_H) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,87 @@
+/*******************************************************************************
+* File Name: project.h
+*
+* Version: 1.50
+*
+* Description:
+*  Host build replacement of the generated project.h. Declares the part of the
+*  cy_boot library and of the components of the external memory OTA projects
+*  that their sources use: the I2C master of the external memory, the BLE
+*  Bootloader Service and the Bootloader. All of them are implemented by the
+*  simulator.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#if !defined(CY_PROJECT_H)
+#define CY_PROJECT_H
+
+#include "cytypes.h"
+#include "CyLib.h"
+#include "CyFlash.h"
+#include "BLE_Stack.h"
+
+#if (CYDEV_BOOTLOADER_ENABLE == 1)
+    #include "Bootloader.h"
+#endif /* (CYDEV_BOOTLOADER_ENABLE == 1) */
+
+
+/***************************************
+*        EMI_I2CM (SCB I2C master)
+***************************************/
+#define EMI_I2CM_I2C_MODE_COMPLETE_XFER     (0x00u)
+#define EMI_I2CM_I2C_MODE_REPEAT_START      (0x01u)
+#define EMI_I2CM_I2C_MODE_NO_STOP           (0x02u)
+
+#define EMI_I2CM_I2C_MSTAT_RD_CMPLT         (0x01u)
+#define EMI_I2CM_I2C_MSTAT_WR_CMPLT         (0x02u)
+#define EMI_I2CM_I2C_MSTAT_XFER_INP         (0x04u)
+#define EMI_I2CM_I2C_MSTAT_XFER_HALT        (0x08u)
+#define EMI_I2CM_I2C_MSTAT_ERR_SHORT_XFER   (0x10u)
+#define EMI_I2CM_I2C_MSTAT_ERR_ADDR_NAK     (0x20u)
+#define EMI_I2CM_I2C_MSTAT_ERR_ARB_LOST     (0x40u)
+#define EMI_I2CM_I2C_MSTAT_ERR_XFER         (0x80u)
+
+#define EMI_I2CM_I2C_MSTR_NO_ERROR          (0x00u)
+#define EMI_I2CM_I2C_MSTR_BUS_BUSY          (0x01u)
+#define EMI_I2CM_I2C_MSTR_NOT_READY         (0x02u)
+
+void   EMI_I2CM_Start(void);
+uint32 EMI_I2CM_I2CMasterWriteBuf(uint32 slaveAddress, uint8 *wrData, uint32 cnt, uint32 mode);
+uint32 EMI_I2CM_I2CMasterReadBuf(uint32 slaveAddress, uint8 *rdData, uint32 cnt, uint32 mode);
+uint32 EMI_I2CM_I2CMasterStatus(void);
+uint32 EMI_I2CM_I2CMasterClearStatus(void);
+
+
+/***************************************
+*        BLE component
+***************************************/
+#define CYBLE_GATT_DEFAULT_MTU      (23u)
+#define CYBLE_GATT_MTU              (512u)      /* Largest MTU set in the customizer */
+#define CYBLE_GATT_MAX_ATTR_LEN     (512u)
+
+CYBLE_API_RESULT_T CyBle_GattGetMtuSize(uint16 *mtu);
+
+#if (CYDEV_BOOTLOADER_ENABLE == 0)
+    /* Bootloader Service: the received command and its flag */
+    extern volatile uint8 cyBle_cmdReceivedFlag;
+
+    void     CyBLE_CyBtldrCommStart(void);
+    void     CyBLE_CyBtldrCommStop(void);
+    void     CyBLE_CyBtldrCommReset(void);
+    cystatus CyBLE_CyBtldrCommWrite(const uint8 pData[], uint16 size, uint16 *count, uint8 timeOut);
+    cystatus CyBLE_CyBtldrCommRead(uint8 pData[], uint16 size, uint16 *count, uint8 timeOut);
+#endif /* (CYDEV_BOOTLOADER_ENABLE == 0) */
+
+#endif /* !defined(CY_PROJECT_H) */
+
+
+/* [] END OF FILE */
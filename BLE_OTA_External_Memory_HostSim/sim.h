@@ -0,0 +1,172 @@
+/*******************************************************************************
+* File Name: sim.h
+*
+* Version: 1.50
+*
+* Description:
+*  Host-side simulator of the external memory OTA update. The bootloadable
+*  (BootloaderEmulator) and the bootloader (custom interface) sources are
+*  compiled unchanged for the host and run against the fake flash, the fake
+*  I2C FRAM and a simulated BLE link on a virtual clock.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#if !defined(BLE_OTA_EM_SIM_H_)
+#define BLE_OTA_EM_SIM_H_
+
+#include "cytypes.h"
+#include "CyFlash.h"
+#include "options.h"
+
+
+/***************************************
+*        Constants
+***************************************/
+#define SIM_NS_NEVER                (UINT64_MAX)
+#define SIM_NS_PER_US               (1000ull)
+#define SIM_NS_PER_MS               (1000000ull)
+#define SIM_NS_PER_S                (1000000000ull)
+
+/* Exit codes of the simulator */
+#define SIM_RESULT_PASS             (0)
+#define SIM_RESULT_THRESHOLD        (1)     /* Update completed, a threshold was missed */
+#define SIM_RESULT_FAILURE          (2)     /* Update did not complete or the image is wrong */
+
+/* How the firmware run ended */
+#define SIM_EXIT_NONE               (0u)
+#define SIM_EXIT_RESET              (1u)    /* CySoftwareReset() */
+#define SIM_EXIT_APP                (2u)    /* Bootloader_Exit() */
+#define SIM_EXIT_HALT               (3u)    /* CyHalt() */
+#define SIM_EXIT_RETURN             (4u)    /* Entry function returned */
+
+/* Memory of the device, mapped at the addresses the firmware uses */
+#define SIM_SFLASH_USER_BASE_ROW    (4u)    /* SFLASH row of the user row 0 */
+#define SIM_SFLASH_USER_ROWS        (4u)
+#define SIM_EM_SIZE                 (EMI_MEMORY_SIZE)
+
+/* Firmware stack, mapped below 4 GB so the stack addresses fit the uint32
+* system call arguments.
+*/
+#define SIM_STACK_BASE              (0x20000000u)
+#define SIM_STACK_SIZE              (0x00100000u)
+
+
+/***************************************
+*        Data Types
+***************************************/
+typedef struct
+{
+    /* Image */
+    uint32      rows;                   /* Application rows, the metadata row excluded */
+    uint32      firstRow;               /* First flash row of the application          */
+    uint32      changedPct;             /* Rows that differ from the running image     */
+    uint32      seed;
+
+    /* BLE link */
+    double      ciMs;                   /* Connection interval                         */
+    uint32      mtu;                    /* ATT MTU                                     */
+    uint32      llPayload;              /* LL PDU payload, 27 or up to 251 with DLE    */
+    uint32      pdusPerEvent;           /* Master PDUs in a connection event           */
+    uint32      llRxBufs;               /* LL PDUs the device buffers                  */
+    double      loss;                   /* LL PDU loss probability                     */
+    uint32      hostLatency;            /* Extra events the host takes to answer       */
+    uint32      window;                 /* Fragments in the window, 0 for legacy mode  */
+
+    /* Device */
+    uint32      i2cKhz;
+    uint32      memWriteUs;             /* EEPROM page write cycle, 0 for FRAM         */
+    uint32      flashRowUs;
+    double      cpuScale;               /* Device ns per host cycle of firmware code   */
+
+    const char *state;
+    double      timeoutS;               /* Virtual time limit of the run               */
+
+    /* Thresholds, 0 is not checked */
+    double      minRowsPerS;
+    double      maxCyclesPerRow;
+    double      maxAirPerRow;
+} SIM_CONFIG_T;
+
+typedef struct
+{
+    uint64_t    fwCycles;               /* Host TSC cycles spent in the firmware code  */
+    uint64_t    flashRows;              /* Rows written by CySysFlashWriteRow()        */
+    uint64_t    sflashRows;
+    uint64_t    i2cBytes;               /* Bytes on the I2C bus, slave address included */
+    uint64_t    i2cXfers;
+    uint64_t    i2cNaks;
+    uint64_t    connEvents;
+    uint64_t    pdus;                   /* LL PDUs sent, empty ones included           */
+    uint64_t    pdusLost;
+    uint64_t    pdusNaked;              /* Data PDUs refused by the full device buffer */
+    uint64_t    airBytes;               /* Bytes over the air, LL framing included     */
+    uint64_t    packetsIn;              /* Bootloader packets received by the device   */
+    uint64_t    packetsOut;
+} SIM_STATS_T;
+
+
+/***************************************
+*        External References
+***************************************/
+extern SIM_CONFIG_T simConfig;
+extern SIM_STATS_T  simStats;
+
+extern uint64_t     simNowNs;
+extern uint64_t     simLinkEventNs;     /* Next connection event, SIM_NS_NEVER if no link */
+extern void       (*simLinkEvent)(void);
+
+extern uint8       *simFlash;
+extern uint8       *simSflash;
+extern uint8        simEm[SIM_EM_SIZE];
+extern uint8        simImage[CY_FLASH_SIZE];    /* Flash content after the update */
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+/* sim_core.c */
+void     Sim_ParseArgs(int argc, char *argv[], const char *name);
+void     Sim_AdvanceTo(uint64_t ns);
+void     Sim_CpuEnter(void);
+void     Sim_CpuLeave(void);
+uint32   Sim_RunFirmware(void (*entry)(void));
+void     Sim_FirmwareExit(uint32 reason) __attribute__((noreturn));
+void     Sim_Fail(const char *fmt, ...) __attribute__((noreturn, format(printf, 1, 2)));
+uint32   Sim_Random(void);
+void     SimImage_Generate(void);
+uint32   SimImage_RowCount(void);
+void     SimState_Save(const char *path);
+void     SimState_Load(const char *path);
+int      Sim_Report(const char *name, uint32 rows);
+
+/* sim_memory.c */
+void     SimMemory_Init(void);
+uint64_t SimI2C_WakeNs(void);
+
+/* sim_ble.c */
+void     SimLink_Init(void);
+uint32   SimHost_Done(void);
+
+
+/***************************************
+*        Macros
+***************************************/
+/* Every fake called by the firmware is bracketed, so the firmware code time
+* is counted apart from the simulator time.
+*/
+#define SIM_ENTER()                 Sim_CpuEnter()
+#define SIM_LEAVE()                 Sim_CpuLeave()
+
+#endif /* !defined(BLE_OTA_EM_SIM_H_) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,1203 @@
+/*******************************************************************************
+* File Name: sim_ble.c
+*
+* Version: 1.50
+*
+* Description:
+*  BLE link of the simulated bootloadable: the connection events with the LL
+*  PDUs, their loss and retransmission and the flow control by the LL buffers
+*  of the device, the Bootloader Service of the BLE component and the OTA host
+*  that sends the image in the legacy (DATA and PROGRAM) or the windowed
+*  (WINDOW and STREAM) mode.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#include <string.h>
+
+#include <project.h>
+#include "sim.h"
+
+
+/***************************************
+*        Constants
+***************************************/
+/* L2CAP header and ATT Write Command or Handle Value Notification header */
+#define SIM_L2CAP_HEADER_SIZE       (4u)
+#define SIM_ATT_HEADER_SIZE         (3u)
+#define SIM_SDU_HEADER_SIZE         (SIM_L2CAP_HEADER_SIZE + SIM_ATT_HEADER_SIZE)
+#define SIM_L2CAP_CID_ATT           (0x0004u)
+#define SIM_ATT_WRITE_CMD           (0x52u)
+#define SIM_ATT_NOTIFICATION        (0x1Bu)
+#define SIM_BTS_HANDLE              (0x0012u)
+
+#define SIM_PACKET_MAX              (300u)
+#define SIM_SDU_MAX                 (SIM_SDU_HEADER_SIZE + SIM_PACKET_MAX)
+#define SIM_QUEUE_SIZE              (64u)
+
+/* LL PDU on the air: preamble, access address, header and CRC */
+#define SIM_LL_OVERHEAD             (10u)
+#define SIM_LL_NS_PER_BYTE          (8000u)     /* 1M PHY */
+#define SIM_LL_IFS_NS               (150000u)
+#define SIM_LL_PAYLOAD_MIN          (27u)
+#define SIM_LL_PAYLOAD_MAX          (251u)
+
+/* Bootloader packet */
+#define SIM_SOP                     (0x01u)
+#define SIM_EOP                     (0x17u)
+#define SIM_PACKET_OVERHEAD         (7u)
+#define SIM_PROGRAM_PARAM_SIZE      (3u)
+#define SIM_STREAM_HEADER_SIZE      (5u)
+#define SIM_WINDOW_MAX              (32u)
+#define SIM_ROWS_IN_ARRAY           (CY_FLASH_SIZEOF_ARRAY / CY_FLASH_SIZEOF_ROW)
+
+#define SIM_CMD_CHECKSUM            (0x31u)
+#define SIM_CMD_DATA                (0x37u)
+#define SIM_CMD_ENTER               (0x38u)
+#define SIM_CMD_PROGRAM             (0x39u)
+#define SIM_CMD_EXIT                (0x3Bu)
+#define SIM_CMD_WINDOW              (0x3Fu)
+#define SIM_CMD_STREAM              (0x40u)
+#define SIM_CMD_WINDOW_STATUS       (0x41u)
+#define SIM_CMD_GET_PKT_SIZE        (0x44u)
+
+/* Connection events with nothing on the link before the host asks for the
+* window status, and before the run is failed as stalled.
+*/
+#define SIM_HOST_STATUS_EVENTS      (8u)
+#define SIM_HOST_STALL_EVENTS       (400u)
+
+/* States of the host */
+#define SIM_HOST_ENTER              (0u)
+#define SIM_HOST_PKT_SIZE           (1u)
+#define SIM_HOST_LEGACY             (2u)
+#define SIM_HOST_WINDOW_OPEN        (3u)
+#define SIM_HOST_STREAM             (4u)
+#define SIM_HOST_CHECKSUM           (5u)
+#define SIM_HOST_EXIT               (6u)
+
+
+/***************************************
+*        Data Types
+***************************************/
+typedef struct
+{
+    uint8       data[SIM_SDU_MAX];
+    uint16      size;
+    uint16      pdus;                   /* LL PDUs the SDU took                  */
+    uint64_t    ready;                  /* Event the host handles the response   */
+} SIM_SDU_T;
+
+typedef struct
+{
+    SIM_SDU_T   sdu[SIM_QUEUE_SIZE];
+    uint32      head;
+    uint32      count;
+} SIM_QUEUE_T;
+
+
+/***************************************
+*        Global Variables
+***************************************/
+volatile uint8 cyBle_cmdReceivedFlag = 0u;
+
+static uint8       simBtsBuffer[SIM_PACKET_MAX];
+static uint16      simBtsSize;
+
+static SIM_QUEUE_T simHostTx;           /* Commands of the host                  */
+static SIM_QUEUE_T simDevRx;            /* Commands held by the device stack     */
+static SIM_QUEUE_T simDevTx;            /* Notifications of the device           */
+static SIM_QUEUE_T simHostRx;           /* Responses waiting for the host        */
+
+static uint32      simHostTxOffset;     /* Acknowledged bytes of the command     */
+static uint32      simDevRxOffset;      /* Received bytes of the command         */
+static uint32      simDevRxPdus;        /* LL PDUs held by the device stack      */
+static uint32      simDevTxOffset;
+
+static uint64_t    simLinkEventIdx = 0u;
+static uint64_t    simLinkCiNs;
+
+static uint32      simHostState;
+static uint32      simHostIdle;
+static uint8       simHostLastCmd;
+static uint32      simHostMaxPkt;
+static uint32      simHostRowIdx;       /* Image row: application rows, then metadata */
+static uint32      simHostRowOffset;
+static uint32      simHostFrag;         /* Fragment size of the windowed transfer */
+static uint32      simHostFragsPerRow;
+static uint32      simHostWinRowsMax;
+static uint32      simHostWinRows;
+static uint32      simHostWinSize;
+static uint32      simHostDevWinSize;
+static uint8       simHostWinBase;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+static SIM_SDU_T * SimQueue_Push(SIM_QUEUE_T *queue);
+static SIM_SDU_T * SimQueue_Head(SIM_QUEUE_T *queue);
+static void        SimQueue_Pop(SIM_QUEUE_T *queue);
+static uint64_t    SimLink_PduNs(uint32 payload);
+static uint32      SimLink_Lost(void);
+static uint32      SimLink_Slot(uint64_t *elapsed);
+static void        SimLink_Event(void);
+static uint16      SimHost_Checksum(const uint8 buffer[], uint32 size);
+static uint32      SimHost_FlashRow(uint32 rowIdx);
+static void        SimHost_Send(uint8 cmd, const uint8 data[], uint32 size);
+static void        SimHost_LegacyNext(void);
+static void        SimHost_WindowOpen(void);
+static void        SimHost_WindowStream(void);
+static void        SimHost_SendFragment(uint32 indx);
+static void        SimHost_WindowStatus(const uint8 data[], uint32 size);
+static void        SimHost_Response(const uint8 packet[], uint32 size);
+static void        SimHost_OnEvent(void);
+
+
+/*******************************************************************************
+* Function Name: SimQueue_Push
+********************************************************************************
+*
+* Summary:
+*  Adds the SDU to the tail of the queue.
+*
+* Parameters:
+*  SIM_QUEUE_T *queue: The queue.
+*
+* Return:
+*  The SDU to fill.
+*
+*******************************************************************************/
+static SIM_SDU_T * SimQueue_Push(SIM_QUEUE_T *queue)
+{
+    SIM_SDU_T *sdu;
+
+    if (SIM_QUEUE_SIZE <= queue->count)
+    {
+        Sim_Fail("SDU queue overflow");
+    }
+
+    sdu = &queue->sdu[(queue->head + queue->count) % SIM_QUEUE_SIZE];
+    queue->count++;
+
+    return (sdu);
+}
+
+
+/*******************************************************************************
+* Function Name: SimQueue_Head
+********************************************************************************
+*
+* Summary:
+*  Returns the SDU at the head of the queue.
+*
+* Parameters:
+*  SIM_QUEUE_T *queue: The queue.
+*
+* Return:
+*  The SDU or NULL if the queue is empty.
+*
+*******************************************************************************/
+static SIM_SDU_T * SimQueue_Head(SIM_QUEUE_T *queue)
+{
+    return ((0u != queue->count) ? &queue->sdu[queue->head] : NULL);
+}
+
+
+/*******************************************************************************
+* Function Name: SimQueue_Pop
+********************************************************************************
+*
+* Summary:
+*  Removes the SDU at the head of the queue.
+*
+* Parameters:
+*  SIM_QUEUE_T *queue: The queue.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimQueue_Pop(SIM_QUEUE_T *queue)
+{
+    queue->head = (queue->head + 1u) % SIM_QUEUE_SIZE;
+    queue->count--;
+}
+
+
+/*******************************************************************************
+* Function Name: SimLink_Init
+********************************************************************************
+*
+* Summary:
+*  Checks the link options, schedules the first connection event and queues
+*  the Enter Bootloader command of the host.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void SimLink_Init(void)
+{
+    if ((simConfig.mtu < CYBLE_GATT_DEFAULT_MTU) || (simConfig.mtu > CYBLE_GATT_MTU) ||
+        (simConfig.llPayload < SIM_LL_PAYLOAD_MIN) || (simConfig.llPayload > SIM_LL_PAYLOAD_MAX) ||
+        (0u == simConfig.pdusPerEvent) || (0u == simConfig.llRxBufs) ||
+        (simConfig.llRxBufs >= SIM_QUEUE_SIZE) || (simConfig.ciMs < 7.5) || (0u == simConfig.i2cKhz))
+    {
+        Sim_Fail("link options out of range: MTU 23..512, LL payload 27..251, CI >= 7.5 ms, "
+                 "LL buffers 1..%u", SIM_QUEUE_SIZE - 1u);
+    }
+
+    simLinkCiNs = (uint64_t) (simConfig.ciMs * (double) SIM_NS_PER_MS);
+    simLinkEvent = &SimLink_Event;
+    simLinkEventNs = simLinkCiNs;
+
+    simHostMaxPkt = simConfig.mtu - SIM_ATT_HEADER_SIZE;
+    if (simHostMaxPkt > SIM_PACKET_MAX)
+    {
+        simHostMaxPkt = SIM_PACKET_MAX;
+    }
+
+    SimHost_Send(SIM_CMD_ENTER, NULL, 0u);
+    simHostState = SIM_HOST_ENTER;
+}
+
+
+/*******************************************************************************
+* Function Name: SimLink_PduNs
+********************************************************************************
+*
+* Summary:
+*  Returns the air time of the LL PDU followed by the inter frame space.
+*
+* Parameters:
+*  uint32 payload: The PDU payload, 0 for the empty PDU.
+*
+* Return:
+*  The time, ns.
+*
+*******************************************************************************/
+static uint64_t SimLink_PduNs(uint32 payload)
+{
+    simStats.pdus++;
+    simStats.airBytes += SIM_LL_OVERHEAD + payload;
+
+    return (((uint64_t) (SIM_LL_OVERHEAD + payload) * SIM_LL_NS_PER_BYTE) + SIM_LL_IFS_NS);
+}
+
+
+/*******************************************************************************
+* Function Name: SimLink_Lost
+********************************************************************************
+*
+* Summary:
+*  Decides whether the PDU is lost.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Non-zero if the PDU is lost.
+*
+*******************************************************************************/
+static uint32 SimLink_Lost(void)
+{
+    uint32 lost = 0u;
+
+    if ((simConfig.loss > 0.0) && (((double) Sim_Random() / 4294967296.0) < simConfig.loss))
+    {
+        simStats.pdusLost++;
+        lost = 1u;
+    }
+
+    return (lost);
+}
+
+
+/*******************************************************************************
+* Function Name: SimLink_Slot
+********************************************************************************
+*
+* Summary:
+*  Runs one exchange of the connection event: the master (host) PDU and the
+*  slave (device) PDU. The device does not acknowledge the data PDU when its
+*  LL buffers are taken by the commands the firmware has not read yet, and
+*  ignores the retransmission of the PDU it already has. The lost PDU ends the
+*  connection event.
+*
+* Parameters:
+*  uint64_t *elapsed: Time from the start of the connection event, ns.
+*
+* Return:
+*  Non-zero if the event continues.
+*
+*******************************************************************************/
+static uint32 SimLink_Slot(uint64_t *elapsed)
+{
+    SIM_SDU_T *cmd = SimQueue_Head(&simHostTx);
+    SIM_SDU_T *rsp = SimQueue_Head(&simDevTx);
+    uint32 masterLen = 0u;
+    uint32 slaveLen = 0u;
+    uint32 acked = 0u;
+    SIM_SDU_T *sdu;
+
+    if (NULL != cmd)
+    {
+        masterLen = cmd->size - simHostTxOffset;
+        if (masterLen > simConfig.llPayload)
+        {
+            masterLen = simConfig.llPayload;
+        }
+    }
+
+    /* Master PDU */
+    *elapsed += SimLink_PduNs(masterLen);
+    if (0u != SimLink_Lost())
+    {
+        return (0u);
+    }
+
+    if (0u != masterLen)
+    {
+        if (simDevRxOffset > simHostTxOffset)
+        {
+            /* Retransmission of the PDU the device already has */
+            acked = 1u;
+        }
+        else if ((simDevRxPdus >= simConfig.llRxBufs) && (0u != simDevRx.count))
+        {
+            simStats.pdusNaked++;
+        }
+        else
+        {
+            simDevRxOffset += masterLen;
+            simDevRxPdus++;
+            acked = 1u;
+
+            if (simDevRxOffset == cmd->size)
+            {
+                sdu = SimQueue_Push(&simDevRx);
+                (void) memcpy(sdu->data, cmd->data, cmd->size);
+                sdu->size = cmd->size;
+                sdu->pdus = (uint16) ((cmd->size + simConfig.llPayload - 1u) / simConfig.llPayload);
+            }
+        }
+    }
+
+    /* Slave PDU */
+    if (NULL != rsp)
+    {
+        slaveLen = rsp->size - simDevTxOffset;
+        if (slaveLen > simConfig.llPayload)
+        {
+            slaveLen = simConfig.llPayload;
+        }
+    }
+
+    *elapsed += SimLink_PduNs(slaveLen);
+    if (0u != SimLink_Lost())
+    {
+        /* The master sends the acknowledged PDU again, the device ignores it */
+        return (0u);
+    }
+
+    if (0u != acked)
+    {
+        simHostTxOffset += masterLen;
+        if (simHostTxOffset == cmd->size)
+        {
+            SimQueue_Pop(&simHostTx);
+            simHostTxOffset = 0u;
+            simDevRxOffset = 0u;
+        }
+    }
+
+    if (0u != slaveLen)
+    {
+        simDevTxOffset += slaveLen;
+        if (simDevTxOffset == rsp->size)
+        {
+            sdu = SimQueue_Push(&simHostRx);
+            (void) memcpy(sdu->data, rsp->data, rsp->size);
+            sdu->size = rsp->size;
+            sdu->ready = simLinkEventIdx + 1u + simConfig.hostLatency;
+
+            SimQueue_Pop(&simDevTx);
+            simDevTxOffset = 0u;
+        }
+    }
+
+    return ((uint32) ((0u != simHostTx.count) || (0u != simDevTx.count)));
+}
+
+
+/*******************************************************************************
+* Function Name: SimLink_Event
+********************************************************************************
+*
+* Summary:
+*  Runs the connection event: the host handles the responses and sends the
+*  commands, then the PDUs are exchanged as long as there is data, the
+*  master allows more PDUs and the next exchange fits in the interval.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimLink_Event(void)
+{
+    uint64_t elapsed = 0u;
+    uint64_t slotMax = 2u * (((uint64_t) (SIM_LL_OVERHEAD + simConfig.llPayload) * SIM_LL_NS_PER_BYTE) +
+                             SIM_LL_IFS_NS);
+    uint32 slots = 0u;
+    uint32 more;
+
+    simStats.connEvents++;
+
+    SimHost_OnEvent();
+
+    do
+    {
+        more = SimLink_Slot(&elapsed);
+        slots++;
+    } while ((0u != more) && (slots < simConfig.pdusPerEvent) && ((elapsed + slotMax) <= simLinkCiNs));
+
+    simLinkEventIdx++;
+    simLinkEventNs += simLinkCiNs;
+}
+
+
+/*******************************************************************************
+* Function Name: CyBle_ProcessEvents
+********************************************************************************
+*
+* Summary:
+*  Fake of the BLE stack function: passes the next command received over the
+*  air to the Bootloader Service, unless the previous one was not read yet.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CyBle_ProcessEvents(void)
+{
+    SIM_SDU_T *sdu;
+
+    SIM_ENTER();
+
+    sdu = SimQueue_Head(&simDevRx);
+    if ((0u == cyBle_cmdReceivedFlag) && (NULL != sdu))
+    {
+        simBtsSize = (uint16) (sdu->size - SIM_SDU_HEADER_SIZE);
+        (void) memcpy(simBtsBuffer, &sdu->data[SIM_SDU_HEADER_SIZE], simBtsSize);
+        simDevRxPdus -= sdu->pdus;
+        SimQueue_Pop(&simDevRx);
+
+        simStats.packetsIn++;
+        cyBle_cmdReceivedFlag = 1u;
+    }
+
+    SIM_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name: CyBle_GattGetMtuSize
+********************************************************************************
+*
+* Summary:
+*  Fake of the BLE component function.
+*
+* Parameters:
+*  uint16 *mtu: Receives the negotiated MTU.
+*
+* Return:
+*  CYBLE_ERROR_OK.
+*
+*******************************************************************************/
+CYBLE_API_RESULT_T CyBle_GattGetMtuSize(uint16 *mtu)
+{
+    *mtu = (uint16) simConfig.mtu;
+
+    return (CYBLE_ERROR_OK);
+}
+
+
+/*******************************************************************************
+* Function Name: CyBLE_CyBtldrCommStart
+********************************************************************************
+*
+* Summary:
+*  Fake of the Bootloader Service function. The link is up from the start.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CyBLE_CyBtldrCommStart(void)
+{
+}
+
+
+/*******************************************************************************
+* Function Name: CyBLE_CyBtldrCommStop
+********************************************************************************
+*
+* Summary:
+*  Fake of the Bootloader Service function.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CyBLE_CyBtldrCommStop(void)
+{
+}
+
+
+/*******************************************************************************
+* Function Name: CyBLE_CyBtldrCommReset
+********************************************************************************
+*
+* Summary:
+*  Fake of the Bootloader Service function.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CyBLE_CyBtldrCommReset(void)
+{
+    cyBle_cmdReceivedFlag = 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: CyBLE_CyBtldrCommWrite
+********************************************************************************
+*
+* Summary:
+*  Fake of the Bootloader Service function: queues the response notification.
+*
+* Parameters:
+*  const uint8 pData[]: The response packet.
+*  uint16 size:         The packet size.
+*  uint16 *count:       Receives the bytes sent.
+*  uint8 timeOut:       Not used.
+*
+* Return:
+*  CYRET_SUCCESS.
+*
+*******************************************************************************/
+cystatus CyBLE_CyBtldrCommWrite(const uint8 pData[], uint16 size, uint16 *count, uint8 timeOut)
+{
+    SIM_SDU_T *sdu;
+    uint32 length = (uint32) size + SIM_ATT_HEADER_SIZE;
+
+    (void) timeOut;
+
+    SIM_ENTER();
+
+    if (size > (simConfig.mtu - SIM_ATT_HEADER_SIZE))
+    {
+        Sim_Fail("response of %u bytes does not fit the MTU", size);
+    }
+
+    sdu = SimQueue_Push(&simDevTx);
+    sdu->data[0u] = LO8(length);
+    sdu->data[1u] = HI8(length);
+    sdu->data[2u] = LO8(SIM_L2CAP_CID_ATT);
+    sdu->data[3u] = HI8(SIM_L2CAP_CID_ATT);
+    sdu->data[4u] = SIM_ATT_NOTIFICATION;
+    sdu->data[5u] = LO8(SIM_BTS_HANDLE);
+    sdu->data[6u] = HI8(SIM_BTS_HANDLE);
+    (void) memcpy(&sdu->data[SIM_SDU_HEADER_SIZE], pData, size);
+    sdu->size = (uint16) (size + SIM_SDU_HEADER_SIZE);
+
+    simStats.packetsOut++;
+    *count = size;
+
+    SIM_LEAVE();
+
+    return (CYRET_SUCCESS);
+}
+
+
+/*******************************************************************************
+* Function Name: CyBLE_CyBtldrCommRead
+********************************************************************************
+*
+* Summary:
+*  Fake of the Bootloader Service function: waits for the command in steps of
+*  a millisecond, processing the BLE events.
+*
+* Parameters:
+*  uint8 pData[]:  The buffer for the command packet.
+*  uint16 size:    The buffer size.
+*  uint16 *count:  Receives the packet size.
+*  uint8 timeOut:  The wait time, in 10s of ms.
+*
+* Return:
+*  CYRET_SUCCESS or CYRET_TIMEOUT.
+*
+*******************************************************************************/
+cystatus CyBLE_CyBtldrCommRead(uint8 pData[], uint16 size, uint16 *count, uint8 timeOut)
+{
+    cystatus status = CYRET_TIMEOUT;
+    uint32 wait;
+
+    SIM_ENTER();
+
+    for (wait = (uint32) timeOut * 10u; (0u != wait) && (CYRET_SUCCESS != status); wait--)
+    {
+        CyBle_ProcessEvents();
+
+        if (0u != cyBle_cmdReceivedFlag)
+        {
+            *count = (simBtsSize < size) ? simBtsSize : size;
+            (void) memcpy(pData, simBtsBuffer, *count);
+            cyBle_cmdReceivedFlag = 0u;
+            status = CYRET_SUCCESS;
+        }
+        else
+        {
+            CyDelay(1u);
+        }
+    }
+
+    SIM_LEAVE();
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: SimHost_Checksum
+********************************************************************************
+*
+* Summary:
+*  Computes the packet checksum, the 2's complement of the byte sum.
+*
+* Parameters:
+*  const uint8 buffer[]: The packet.
+*  uint32 size:          Bytes to sum.
+*
+* Return:
+*  The checksum.
+*
+*******************************************************************************/
+static uint16 SimHost_Checksum(const uint8 buffer[], uint32 size)
+{
+    uint16 sum = 0u;
+    uint32 i;
+
+    for (i = 0u; i < size; i++)
+    {
+        sum += buffer[i];
+    }
+
+    return ((uint16) 1u + (uint16) (~sum));
+}
+
+
+/*******************************************************************************
+* Function Name: SimHost_FlashRow
+********************************************************************************
+*
+* Summary:
+*  Returns the flash row of the image row. The application rows are sent in
+*  order, the bootloadable metadata row is the last one.
+*
+* Parameters:
+*  uint32 rowIdx: The image row.
+*
+* Return:
+*  The flash row.
+*
+*******************************************************************************/
+static uint32 SimHost_FlashRow(uint32 rowIdx)
+{
+    return ((rowIdx < simConfig.rows) ? (simConfig.firstRow + rowIdx) : (CY_FLASH_NUMBER_ROWS - 1u));
+}
+
+
+/*******************************************************************************
+* Function Name: SimHost_Send
+********************************************************************************
+*
+* Summary:
+*  Queues the bootloader command as the ATT Write Command.
+*
+* Parameters:
+*  uint8 cmd:          The command.
+*  const uint8 data[]: The command data.
+*  uint32 size:        The data size.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimHost_Send(uint8 cmd, const uint8 data[], uint32 size)
+{
+    SIM_SDU_T *sdu = SimQueue_Push(&simHostTx);
+    uint8 *packet = &sdu->data[SIM_SDU_HEADER_SIZE];
+    uint32 length = size + SIM_PACKET_OVERHEAD;
+    uint16 checksum;
+
+    if (length > simHostMaxPkt)
+    {
+        Sim_Fail("command 0x%02X of %u bytes does not fit the packet size %u", cmd, length, simHostMaxPkt);
+    }
+
+    packet[0u] = SIM_SOP;
+    packet[1u] = cmd;
+    packet[2u] = LO8(size);
+    packet[3u] = HI8(size);
+    if (0u != size)
+    {
+        (void) memcpy(&packet[4u], data, size);
+    }
+    checksum = SimHost_Checksum(packet, size + 4u);
+    packet[size + 4u] = LO8(checksum);
+    packet[size + 5u] = HI8(checksum);
+    packet[size + 6u] = SIM_EOP;
+
+    sdu->data[0u] = LO8(length + SIM_ATT_HEADER_SIZE);
+    sdu->data[1u] = HI8(length + SIM_ATT_HEADER_SIZE);
+    sdu->data[2u] = LO8(SIM_L2CAP_CID_ATT);
+    sdu->data[3u] = HI8(SIM_L2CAP_CID_ATT);
+    sdu->data[4u] = SIM_ATT_WRITE_CMD;
+    sdu->data[5u] = LO8(SIM_BTS_HANDLE);
+    sdu->data[6u] = HI8(SIM_BTS_HANDLE);
+    sdu->size = (uint16) (length + SIM_SDU_HEADER_SIZE);
+
+    simHostLastCmd = cmd;
+}
+
+
+/*******************************************************************************
+* Function Name: SimHost_LegacyNext
+********************************************************************************
+*
+* Summary:
+*  Sends the next command of the legacy mode: the row is split into the Send
+*  Data commands and the Program Row command that carries the rest of it.
+*  The Verify Checksum command follows the last row.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimHost_LegacyNext(void)
+{
+    uint8  param[SIM_PACKET_MAX];
+    uint32 flashRow = SimHost_FlashRow(simHostRowIdx);
+    const uint8 *row = &simImage[flashRow * CY_FLASH_SIZEOF_ROW];
+    uint32 left = CY_FLASH_SIZEOF_ROW - simHostRowOffset;
+    uint32 size;
+
+    if (simHostRowIdx >= SimImage_RowCount())
+    {
+        SimHost_Send(SIM_CMD_CHECKSUM, NULL, 0u);
+        simHostState = SIM_HOST_CHECKSUM;
+    }
+    else if (left > (simHostMaxPkt - SIM_PACKET_OVERHEAD - SIM_PROGRAM_PARAM_SIZE))
+    {
+        size = simHostMaxPkt - SIM_PACKET_OVERHEAD;
+        if (size > left)
+        {
+            size = left;
+        }
+        SimHost_Send(SIM_CMD_DATA, &row[simHostRowOffset], size);
+        simHostRowOffset += size;
+    }
+    else
+    {
+        param[0u] = (uint8) (flashRow / SIM_ROWS_IN_ARRAY);
+        param[1u] = LO8(flashRow % SIM_ROWS_IN_ARRAY);
+        param[2u] = HI8(flashRow % SIM_ROWS_IN_ARRAY);
+        (void) memcpy(&param[SIM_PROGRAM_PARAM_SIZE], &row[simHostRowOffset], left);
+        SimHost_Send(SIM_CMD_PROGRAM, param, SIM_PROGRAM_PARAM_SIZE + left);
+
+        simHostRowOffset = 0u;
+        simHostRowIdx++;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: SimHost_WindowOpen
+********************************************************************************
+*
+* Summary:
+*  Starts the next window of the rows. The window continues from the previous
+*  one unless its size changes: the tail of the application and the metadata
+*  row are opened with the Start Window command. The Verify Checksum command
+*  follows the last window.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimHost_WindowOpen(void)
+{
+    uint8  param[4u];
+    uint32 flashRow;
+
+    if (simHostRowIdx >= SimImage_RowCount())
+    {
+        SimHost_Send(SIM_CMD_CHECKSUM, NULL, 0u);
+        simHostState = SIM_HOST_CHECKSUM;
+    }
+    else
+    {
+        simHostWinRows = 1u;
+        if (simHostRowIdx < simConfig.rows)
+        {
+            simHostWinRows = simConfig.rows - simHostRowIdx;
+            if (simHostWinRows > simHostWinRowsMax)
+            {
+                simHostWinRows = simHostWinRowsMax;
+            }
+        }
+        simHostWinSize = simHostWinRows * simHostFragsPerRow;
+
+        if (simHostWinSize != simHostDevWinSize)
+        {
+            flashRow = SimHost_FlashRow(simHostRowIdx);
+            param[0u] = (uint8) simHostWinSize;
+            param[1u] = (uint8) (flashRow / SIM_ROWS_IN_ARRAY);
+            param[2u] = LO8(flashRow % SIM_ROWS_IN_ARRAY);
+            param[3u] = HI8(flashRow % SIM_ROWS_IN_ARRAY);
+            SimHost_Send(SIM_CMD_WINDOW, param, sizeof(param));
+            simHostState = SIM_HOST_WINDOW_OPEN;
+        }
+        else
+        {
+            SimHost_WindowStream();
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: SimHost_SendFragment
+********************************************************************************
+*
+* Summary:
+*  Sends the fragment of the window with the Stream command.
+*
+* Parameters:
+*  uint32 indx: The fragment index in the window.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimHost_SendFragment(uint32 indx)
+{
+    uint8  param[SIM_PACKET_MAX];
+    uint32 flashRow = SimHost_FlashRow(simHostRowIdx + (indx / simHostFragsPerRow));
+    uint32 offset = (indx % simHostFragsPerRow) * simHostFrag;
+    uint32 size = CY_FLASH_SIZEOF_ROW - offset;
+
+    if (size > simHostFrag)
+    {
+        size = simHostFrag;
+    }
+
+    param[0u] = (uint8) (simHostWinBase + indx);
+    param[1u] = (uint8) (flashRow / SIM_ROWS_IN_ARRAY);
+    param[2u] = LO8(flashRow % SIM_ROWS_IN_ARRAY);
+    param[3u] = HI8(flashRow % SIM_ROWS_IN_ARRAY);
+    param[4u] = (uint8) offset;
+    (void) memcpy(&param[SIM_STREAM_HEADER_SIZE], &simImage[(flashRow * CY_FLASH_SIZEOF_ROW) + offset], size);
+
+    SimHost_Send(SIM_CMD_STREAM, param, SIM_STREAM_HEADER_SIZE + size);
+}
+
+
+/*******************************************************************************
+* Function Name: SimHost_WindowStream
+********************************************************************************
+*
+* Summary:
+*  Sends all fragments of the window without waiting for the responses.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimHost_WindowStream(void)
+{
+    uint32 i;
+
+    for (i = 0u; i < simHostWinSize; i++)
+    {
+        SimHost_SendFragment(i);
+    }
+
+    simHostState = SIM_HOST_STREAM;
+    simHostIdle = 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: SimHost_WindowStatus
+********************************************************************************
+*
+* Summary:
+*  Handles the window status: the completed window advances the base and the
+*  next window is sent, otherwise the missing fragments are sent again. The
+*  status of the earlier window is ignored.
+*
+* Parameters:
+*  const uint8 data[]: The status: [window base] [missing map].
+*  uint32 size:        The status size.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimHost_WindowStatus(const uint8 data[], uint32 size)
+{
+    uint32 i;
+
+    if ((0u == size) || (size < (1u + ((simHostWinSize + 7u) / 8u))))
+    {
+        Sim_Fail("window status of %u bytes is too short", size);
+    }
+
+    if (data[0u] == (uint8) (simHostWinBase + simHostWinSize))
+    {
+        simHostRowIdx += simHostWinRows;
+        simHostWinBase = data[0u];
+        SimHost_WindowOpen();
+    }
+    else if (data[0u] == simHostWinBase)
+    {
+        for (i = 0u; i < simHostWinSize; i++)
+        {
+            if (0u != (data[1u + (i >> 3u)] & (uint8) (1u << (i & 0x07u))))
+            {
+                SimHost_SendFragment(i);
+            }
+        }
+        simHostIdle = 0u;
+    }
+    else
+    {
+        /* Status of the earlier window */
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: SimHost_Response
+********************************************************************************
+*
+* Summary:
+*  Checks the response packet and sends the next command.
+*
+* Parameters:
+*  const uint8 packet[]: The response packet.
+*  uint32 size:          The packet size.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimHost_Response(const uint8 packet[], uint32 size)
+{
+    uint32 length = (size >= SIM_PACKET_OVERHEAD) ? (((uint32) packet[3u] << 8u) | packet[2u]) : 0u;
+    const uint8 *data = &packet[4u];
+    uint32 frag;
+
+    if ((size < SIM_PACKET_OVERHEAD) || (size != (length + SIM_PACKET_OVERHEAD)) || (SIM_SOP != packet[0u]) ||
+        (SIM_EOP != packet[length + 6u]) ||
+        (SimHost_Checksum(packet, length + 4u) != (((uint16) packet[length + 5u] << 8u) | packet[length + 4u])))
+    {
+        Sim_Fail("malformed response to the command 0x%02X", simHostLastCmd);
+    }
+    if (CYRET_SUCCESS != packet[1u])
+    {
+        Sim_Fail("command 0x%02X failed with the status 0x%02X", simHostLastCmd, packet[1u]);
+    }
+
+    switch (simHostState)
+    {
+        case SIM_HOST_ENTER:
+            SimHost_Send(SIM_CMD_GET_PKT_SIZE, NULL, 0u);
+            simHostState = SIM_HOST_PKT_SIZE;
+            break;
+
+        case SIM_HOST_PKT_SIZE:
+            if (length < 2u)
+            {
+                Sim_Fail("packet size response is too short");
+            }
+            if ((((uint32) data[1u] << 8u) | data[0u]) < simHostMaxPkt)
+            {
+                simHostMaxPkt = ((uint32) data[1u] << 8u) | data[0u];
+            }
+
+            simHostFragsPerRow = 0u;
+            simHostWinRowsMax = 0u;
+            frag = simHostMaxPkt - SIM_PACKET_OVERHEAD - SIM_STREAM_HEADER_SIZE;
+            if ((0u != simConfig.window) && (simHostMaxPkt > (SIM_PACKET_OVERHEAD + SIM_STREAM_HEADER_SIZE)))
+            {
+                simHostFrag = (frag < CY_FLASH_SIZEOF_ROW) ? frag : CY_FLASH_SIZEOF_ROW;
+                simHostFragsPerRow = (CY_FLASH_SIZEOF_ROW + simHostFrag - 1u) / simHostFrag;
+                simHostWinRowsMax = ((simConfig.window < SIM_WINDOW_MAX) ? simConfig.window : SIM_WINDOW_MAX) /
+                                    simHostFragsPerRow;
+            }
+
+            if (0u != simHostWinRowsMax)
+            {
+                SimHost_WindowOpen();
+            }
+            else
+            {
+                simHostState = SIM_HOST_LEGACY;
+                SimHost_LegacyNext();
+            }
+            break;
+
+        case SIM_HOST_LEGACY:
+            SimHost_LegacyNext();
+            break;
+
+        case SIM_HOST_WINDOW_OPEN:
+            if ((length < 2u) || (data[0u] != simHostWinSize))
+            {
+                Sim_Fail("window of %u fragments was not accepted", simHostWinSize);
+            }
+            simHostDevWinSize = data[0u];
+            simHostWinBase = data[1u];
+            SimHost_WindowStream();
+            break;
+
+        case SIM_HOST_STREAM:
+            SimHost_WindowStatus(data, length);
+            break;
+
+        case SIM_HOST_CHECKSUM:
+            if ((length < 1u) || (1u != data[0u]))
+            {
+                Sim_Fail("the bootloadable rejected the image checksum");
+            }
+            SimHost_Send(SIM_CMD_EXIT, NULL, 0u);
+            simHostState = SIM_HOST_EXIT;
+            break;
+
+        default:
+            Sim_Fail("unexpected response after the command 0x%02X", simHostLastCmd);
+            break;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: SimHost_OnEvent
+********************************************************************************
+*
+* Summary:
+*  Runs the host at the start of the connection event: handles the responses
+*  that are due. The host asks for the window status when the link stays idle
+*  while it waits for it; the run fails if the link stays idle much longer.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimHost_OnEvent(void)
+{
+    SIM_SDU_T *sdu = SimQueue_Head(&simHostRx);
+
+    while ((NULL != sdu) && (sdu->ready <= simLinkEventIdx))
+    {
+        SimHost_Response(&sdu->data[SIM_SDU_HEADER_SIZE], (uint32) sdu->size - SIM_SDU_HEADER_SIZE);
+        SimQueue_Pop(&simHostRx);
+        sdu = SimQueue_Head(&simHostRx);
+    }
+
+    if ((0u == simHostTx.count) && (0u == simDevRx.count) && (0u == cyBle_cmdReceivedFlag) &&
+        (0u == simDevTx.count) && (0u == simHostRx.count) && (SIM_HOST_EXIT != simHostState))
+    {
+        simHostIdle++;
+
+        if ((SIM_HOST_STREAM == simHostState) && (0u == (simHostIdle % SIM_HOST_STATUS_EVENTS)))
+        {
+            SimHost_Send(SIM_CMD_WINDOW_STATUS, NULL, 0u);
+        }
+        if (simHostIdle >= SIM_HOST_STALL_EVENTS)
+        {
+            Sim_Fail("the bootloadable stopped answering the command 0x%02X", simHostLastCmd);
+        }
+    }
+    else
+    {
+        simHostIdle = 0u;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: SimHost_Done
+********************************************************************************
+*
+* Summary:
+*  Checks whether the host delivered the Exit Bootloader command.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Non-zero if the update is complete on the host side.
+*
+*******************************************************************************/
+uint32 SimHost_Done(void)
+{
+    return ((uint32) ((SIM_HOST_EXIT == simHostState) && (0u == simHostTx.count)));
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,309 @@
+/*******************************************************************************
+* File Name: sim_copy.c
+*
+* Version: 1.50
+*
+* Description:
+*  Host simulator of the copy stage of the update: loads the device state the
+*  link stage saved and runs the custom interface of the bootloader project,
+*  which copies the image from the I2C external memory to the flash through
+*  the Bootloader component, until the bootloader starts the new application.
+*  The Bootloader component is replaced by the part of it the custom interface
+*  drives: the Enter, Program Row and Exit commands and the application
+*  validation.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <project.h>
+#include "Bootloader_PVT.h"
+#include "custom_interface.h"
+#include "sim.h"
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+static uint16 SimBtldr_Checksum(const uint8 buffer[], uint32 size);
+static uint32 SimBtldr_Get32(const uint8 src[]);
+static void   SimCopy_Firmware(void);
+
+
+/*******************************************************************************
+* Function Name: SimBtldr_Checksum
+********************************************************************************
+*
+* Summary:
+*  Computes the packet checksum, the 2's complement of the byte sum.
+*
+* Parameters:
+*  const uint8 buffer[]: The packet.
+*  uint32 size:          Bytes to sum.
+*
+* Return:
+*  The checksum.
+*
+*******************************************************************************/
+static uint16 SimBtldr_Checksum(const uint8 buffer[], uint32 size)
+{
+    uint16 sum = 0u;
+    uint32 i;
+
+    for (i = 0u; i < size; i++)
+    {
+        sum += buffer[i];
+    }
+
+    return ((uint16) 1u + (uint16) (~sum));
+}
+
+
+/*******************************************************************************
+* Function Name: SimBtldr_Get32
+********************************************************************************
+*
+* Summary:
+*  Reads the little-endian 32-bit metadata field.
+*
+* Parameters:
+*  const uint8 src[]: The field.
+*
+* Return:
+*  The value.
+*
+*******************************************************************************/
+static uint32 SimBtldr_Get32(const uint8 src[])
+{
+    return (((uint32) src[3u] << 24u) | ((uint32) src[2u] << 16u) | ((uint32) src[1u] << 8u) | src[0u]);
+}
+
+
+/*******************************************************************************
+* Function Name: Bootloader_Start
+********************************************************************************
+*
+* Summary:
+*  Fake of the Bootloader component: reads the commands the custom interface
+*  generates, programs the rows and starts the application on Exit Bootloader.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Does not return.
+*
+*******************************************************************************/
+void Bootloader_Start(void)
+{
+    uint8  packet[Bootloader_SIZEOF_COMMAND_BUFFER];
+    uint16 count;
+    uint16 size;
+    uint16 row;
+    uint8  status;
+
+    CyBtldrCommStart();
+
+    for (;;)
+    {
+        count = 0u;
+        (void) CyBtldrCommRead(packet, sizeof(packet), &count, 0u);
+
+        SIM_ENTER();
+
+        size = (uint16) (((uint16) packet[Bootloader_SIZE_ADDR + 1u] << 8u) | packet[Bootloader_SIZE_ADDR]);
+        if ((count < Bootloader_MIN_PKT_SIZE) || (count != (size + Bootloader_MIN_PKT_SIZE)) ||
+            (Bootloader_SOP != packet[Bootloader_SOP_ADDR]) || (Bootloader_EOP != packet[Bootloader_EOP_ADDR(size)]) ||
+            (SimBtldr_Checksum(packet, Bootloader_DATA_ADDR + size) !=
+             (((uint16) packet[Bootloader_CHK_ADDR(size) + 1u] << 8u) | packet[Bootloader_CHK_ADDR(size)])))
+        {
+            Sim_Fail("custom interface generated a malformed packet");
+        }
+
+        status = CYRET_SUCCESS;
+        switch (packet[Bootloader_CMD_ADDR])
+        {
+            case Bootloader_COMMAND_ENTER:
+                break;
+
+            case Bootloader_COMMAND_PROGRAM:
+                row = (uint16) (((uint16) packet[Bootloader_DATA_ADDR + 2u] << 8u) | packet[Bootloader_DATA_ADDR + 1u]);
+                if ((size != (3u + CY_FLASH_SIZEOF_ROW)) || (row >= Bootloader_NUMBER_OF_ROWS_IN_ARRAY))
+                {
+                    Sim_Fail("custom interface generated a bad Program Row command");
+                }
+                SIM_LEAVE();
+                status = (uint8) CySysFlashWriteRow(((uint32) packet[Bootloader_DATA_ADDR] *
+                                                     Bootloader_NUMBER_OF_ROWS_IN_ARRAY) + row,
+                                                    &packet[Bootloader_DATA_ADDR + 3u]);
+                SIM_ENTER();
+                break;
+
+            case Bootloader_COMMAND_EXIT:
+                SIM_LEAVE();
+                if (CYRET_SUCCESS == Bootloader_ValidateBootloadable(Bootloader_MD_BTLDB_ACTIVE_0))
+                {
+                    Bootloader_Exit(Bootloader_EXIT_TO_BTLDB);
+                }
+                CyHalt(0x00u);
+                break;
+
+            default:
+                Sim_Fail("custom interface generated the unknown command 0x%02X", packet[Bootloader_CMD_ADDR]);
+                break;
+        }
+
+        /* Response: the custom interface does not read it */
+        packet[Bootloader_CMD_ADDR] = status;
+        packet[Bootloader_SIZE_ADDR] = 0u;
+        packet[Bootloader_SIZE_ADDR + 1u] = 0u;
+
+        SIM_LEAVE();
+
+        (void) CyBtldrCommWrite(packet, Bootloader_MIN_PKT_SIZE, &count, 0u);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Bootloader_ValidateBootloadable
+********************************************************************************
+*
+* Summary:
+*  Fake of the Bootloader component: checks the application in the flash
+*  against the checksum of the bootloadable metadata.
+*
+* Parameters:
+*  uint8 appId: Not used, the single application.
+*
+* Return:
+*  CYRET_SUCCESS or CYRET_BAD_DATA.
+*
+*******************************************************************************/
+cystatus Bootloader_ValidateBootloadable(uint8 appId)
+{
+    const uint8 *md = &simFlash[Bootloader_MD_FLASH_ROW * CY_FLASH_SIZEOF_ROW];
+    uint32 addr = SimBtldr_Get32(&md[Bootloader_MD_APP_ADDR]);
+    uint32 length = SimBtldr_Get32(&md[Bootloader_MD_APP_LENGTH]);
+    uint32 data = 0u;
+    uint8  sum = 0u;
+    uint32 i;
+
+    (void) appId;
+
+    SIM_ENTER();
+
+    if ((0u == length) || (addr >= CY_FLASH_SIZE) || (length > (CY_FLASH_SIZE - addr)))
+    {
+        SIM_LEAVE();
+        return (CYRET_BAD_DATA);
+    }
+
+    for (i = addr; i < (addr + length); i++)
+    {
+        sum += simFlash[i];
+        data |= (uint32) ((0x00u != simFlash[i]) && (0xFFu != simFlash[i]));
+    }
+
+    SIM_LEAVE();
+
+    return ((((uint8) (1u + (uint8) ~sum) == md[Bootloader_MD_APP_CHECKSUM]) && (0u != data)) ?
+            CYRET_SUCCESS : CYRET_BAD_DATA);
+}
+
+
+/*******************************************************************************
+* Function Name: Bootloader_Exit
+********************************************************************************
+*
+* Summary:
+*  Fake of the Bootloader component: starts the application, which ends the
+*  firmware run.
+*
+* Parameters:
+*  uint32 appId: Not used.
+*
+* Return:
+*  Does not return.
+*
+*******************************************************************************/
+void Bootloader_Exit(uint32 appId)
+{
+    (void) appId;
+
+    Sim_FirmwareExit(SIM_EXIT_APP);
+}
+
+
+/*******************************************************************************
+* Function Name: SimCopy_Firmware
+********************************************************************************
+*
+* Summary:
+*  Firmware entry: the part of the bootloader main() that runs the copy.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimCopy_Firmware(void)
+{
+    CyGlobalIntEnable;
+
+    CyBle_AesCcmInit();
+    Bootloader_Start();
+}
+
+
+/*******************************************************************************
+* Function Name: main
+********************************************************************************
+*
+* Summary:
+*  Runs the copy stage, checks the flash and reports the throughput.
+*
+* Parameters:
+*  int argc, char *argv[]: The simulator options, see Sim_ParseArgs().
+*
+* Return:
+*  SIM_RESULT_PASS, SIM_RESULT_THRESHOLD or SIM_RESULT_FAILURE.
+*
+*******************************************************************************/
+int main(int argc, char *argv[])
+{
+    uint32 exitReason;
+
+    Sim_ParseArgs(argc, argv, "ota_copy_sim");
+
+    SimMemory_Init();
+    SimState_Load(simConfig.state);
+
+    exitReason = Sim_RunFirmware(&SimCopy_Firmware);
+    if (SIM_EXIT_APP != exitReason)
+    {
+        Sim_Fail("bootloader ended the copy with the exit %u instead of starting the application", exitReason);
+    }
+
+    if (0 != memcmp(simFlash, simImage, CY_FLASH_SIZE))
+    {
+        Sim_Fail("flash differs from the image after the copy");
+    }
+
+    return (Sim_Report("copy", SimImage_RowCount()));
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,1358 @@
+/*******************************************************************************
+* File Name: sim_core.c
+*
+* Version: 1.50
+*
+* Description:
+*  Core of the host-side OTA simulator: the command line options, the virtual
+*  clock, the firmware coroutine and its CPU cycle accounting, the cy_boot
+*  functions the OTA sources call, the synthetic image, the state file passed
+*  from the bootloadable run to the bootloader run and the report.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif /* defined(__x86_64__) || defined(__i386__) */
+
+#include <project.h>
+#include "sim.h"
+
+
+/***************************************
+*        Constants
+***************************************/
+#define SIM_STATE_MAGIC             (0x5341544Fu)   /* "OTAS" */
+#define SIM_STATE_VERSION           (1u)
+#define SIM_AES_MIC_SIZE            (4u)
+#define SIM_RANDOM_KEY_SIZE         (8u)
+
+/* Bootloadable metadata fields, from the start of the last flash row */
+#define SIM_MD_APP_CHECKSUM         (CY_FLASH_SIZEOF_ROW - 64u)
+#define SIM_MD_APP_ADDR             (SIM_MD_APP_CHECKSUM + 1u)
+#define SIM_MD_LAST_BTLDR_ROW       (SIM_MD_APP_CHECKSUM + 5u)
+#define SIM_MD_APP_LENGTH           (SIM_MD_APP_CHECKSUM + 9u)
+
+
+/***************************************
+*        Data Types
+***************************************/
+typedef struct
+{
+    const char *name;
+    char        type;                   /* 'u' uint32, 'd' double, 's' string */
+    void       *value;
+    const char *help;
+} SIM_OPTION_T;
+
+typedef struct
+{
+    uint32      magic;
+    uint32      version;
+    uint32      rows;
+    uint32      firstRow;
+    uint32      changedPct;
+    uint32      seed;
+    uint32      emSize;
+    uint32      flashSize;
+} SIM_STATE_HEADER_T;
+
+
+/***************************************
+*        Global Variables
+***************************************/
+SIM_CONFIG_T simConfig =
+{
+    .rows            = 320u,
+    .firstRow        = 384u,
+    .changedPct      = 100u,
+    .seed            = 1u,
+
+    .ciMs            = 7.5,
+    .mtu             = 23u,
+    .llPayload       = 27u,
+    .pdusPerEvent    = 6u,
+    .llRxBufs        = 8u,
+    .loss            = 0.0,
+    .hostLatency     = 0u,
+    .window          = 0u,
+
+    .i2cKhz          = 400u,
+    .memWriteUs      = 0u,
+    .flashRowUs      = 20000u,
+    .cpuScale        = 0.0,
+
+    .state           = "build/ota_state.bin",
+    .timeoutS        = 3600.0,
+
+    .minRowsPerS     = 0.0,
+    .maxCyclesPerRow = 0.0,
+    .maxAirPerRow    = 0.0
+};
+
+SIM_STATS_T simStats;
+
+uint64_t simNowNs = 0u;
+uint64_t simLinkEventNs = SIM_NS_NEVER;
+void   (*simLinkEvent)(void) = NULL;
+
+uint8    simImage[CY_FLASH_SIZE];
+
+static const SIM_OPTION_T simOptions[] =
+{
+    { "--rows",               'u', &simConfig.rows,            "application rows, metadata row excluded" },
+    { "--first-row",          'u', &simConfig.firstRow,        "first flash row of the application" },
+    { "--changed",            'u', &simConfig.changedPct,      "percentage of the rows that differ from the running image" },
+    { "--seed",               'u', &simConfig.seed,            "seed of the image and of the packet loss" },
+    { "--ci-ms",              'd', &simConfig.ciMs,            "connection interval, ms" },
+    { "--mtu",                'u', &simConfig.mtu,             "ATT MTU" },
+    { "--ll-payload",         'u', &simConfig.llPayload,       "LL PDU payload, 27..251" },
+    { "--pdus-per-event",     'u', &simConfig.pdusPerEvent,    "master PDUs in a connection event" },
+    { "--ll-rx-bufs",         'u', &simConfig.llRxBufs,        "LL PDUs buffered by the device" },
+    { "--loss",               'd', &simConfig.loss,            "LL PDU loss probability, 0..1" },
+    { "--host-latency",       'u', &simConfig.hostLatency,     "extra connection events the host takes to answer" },
+    { "--window",             'u', &simConfig.window,          "fragments in the window, 0 for the legacy mode" },
+    { "--i2c-khz",            'u', &simConfig.i2cKhz,          "I2C clock, kHz" },
+    { "--mem-write-us",       'u', &simConfig.memWriteUs,      "EEPROM page write cycle, us, 0 for FRAM" },
+    { "--flash-row-us",       'u', &simConfig.flashRowUs,      "internal flash row write time, us" },
+    { "--cpu-scale",          'd', &simConfig.cpuScale,        "device ns per host cycle of firmware code" },
+    { "--state",              's', &simConfig.state,           "state file passed from the link run to the copy run" },
+    { "--timeout-s",          'd', &simConfig.timeoutS,        "virtual time limit of the run, s" },
+    { "--min-rows-per-s",     'd', &simConfig.minRowsPerS,     "fail if fewer rows per second" },
+    { "--max-cycles-per-row", 'd', &simConfig.maxCyclesPerRow, "fail if more host cycles of firmware code per row" },
+    { "--max-air-per-row",    'd', &simConfig.maxAirPerRow,    "fail if more bytes over the air per row" }
+};
+
+static ucontext_t simMainContext;
+static ucontext_t simFwContext;
+static void     (*simFwEntry)(void);
+static void      *simFwStack = NULL;
+static uint32     simExitReason = SIM_EXIT_NONE;
+
+/* The simulator itself runs at depth 1, the firmware code at depth 0 */
+static uint32     simCpuDepth = 1u;
+static uint64_t   simCpuMark = 0u;
+
+static uint32     simRandomState = 1u;
+static uint32     simSysTickReload = 0x00FFFFFFu;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+static void     Sim_Usage(const char *name);
+static uint64_t Sim_Cycles(void);
+static void     Sim_FirmwareMain(void);
+static void     SimImage_RandomRow(uint8 row[]);
+static void     SimImage_SetMetadata(uint8 image[]);
+static void     Sim_Put32(uint8 dst[], uint32 value);
+static void     SimState_Io(FILE *file, void *data, size_t size, int write, const char *path);
+
+
+/*******************************************************************************
+* Function Name: Sim_Usage
+********************************************************************************
+*
+* Summary:
+*  Prints the command line options with their default values.
+*
+* Parameters:
+*  const char *name: The program name.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void Sim_Usage(const char *name)
+{
+    uint32 i;
+
+    fprintf(stderr, "usage: %s [options]\n", name);
+
+    for (i = 0u; i < (sizeof(simOptions) / sizeof(simOptions[0u])); i++)
+    {
+        const SIM_OPTION_T *opt = &simOptions[i];
+
+        switch (opt->type)
+        {
+            case 'u':
+                fprintf(stderr, "  %-22s %-10u %s\n", opt->name, *(uint32 *) opt->value, opt->help);
+                break;
+            case 'd':
+                fprintf(stderr, "  %-22s %-10g %s\n", opt->name, *(double *) opt->value, opt->help);
+                break;
+            default:
+                fprintf(stderr, "  %-22s %-10s %s\n", opt->name, *(const char **) opt->value, opt->help);
+                break;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Sim_ParseArgs
+********************************************************************************
+*
+* Summary:
+*  Parses the command line options into simConfig. The options are accepted as
+*  "--name value" and "--name=value". An unknown option or a bad value ends the
+*  program.
+*
+* Parameters:
+*  int argc:      Argument count.
+*  char *argv[]:  Arguments.
+*  const char *name: The program name for the usage message.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Sim_ParseArgs(int argc, char *argv[], const char *name)
+{
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        const SIM_OPTION_T *opt = NULL;
+        const char *value = NULL;
+        char *end = NULL;
+        size_t length;
+        uint32 j;
+
+        if ((0 == strcmp(argv[i], "--help")) || (0 == strcmp(argv[i], "-h")))
+        {
+            Sim_Usage(name);
+            exit(SIM_RESULT_PASS);
+        }
+
+        length = strcspn(argv[i], "=");
+        for (j = 0u; (j < (sizeof(simOptions) / sizeof(simOptions[0u]))) && (NULL == opt); j++)
+        {
+            if ((strlen(simOptions[j].name) == length) && (0 == strncmp(argv[i], simOptions[j].name, length)))
+            {
+                opt = &simOptions[j];
+            }
+        }
+
+        if (NULL == opt)
+        {
+            fprintf(stderr, "%s: unknown option %s\n", name, argv[i]);
+            Sim_Usage(name);
+            exit(SIM_RESULT_FAILURE);
+        }
+
+        if ('=' == argv[i][length])
+        {
+            value = &argv[i][length + 1u];
+        }
+        else if ((i + 1) < argc)
+        {
+            value = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "%s: %s needs a value\n", name, opt->name);
+            exit(SIM_RESULT_FAILURE);
+        }
+
+        switch (opt->type)
+        {
+            case 'u':
+                *(uint32 *) opt->value = (uint32) strtoul(value, &end, 0);
+                break;
+            case 'd':
+                *(double *) opt->value = strtod(value, &end);
+                break;
+            default:
+                *(const char **) opt->value = value;
+                end = (char *) &value[strlen(value)];
+                break;
+        }
+
+        if ((end == value) || ('\0' != *end))
+        {
+            fprintf(stderr, "%s: bad value of %s: %s\n", name, opt->name, value);
+            exit(SIM_RESULT_FAILURE);
+        }
+    }
+
+    if ((simConfig.changedPct > 100u) || (simConfig.loss < 0.0) || (simConfig.loss >= 1.0))
+    {
+        fprintf(stderr, "%s: --changed must be 0..100 and --loss 0..1\n", name);
+        exit(SIM_RESULT_FAILURE);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Sim_Fail
+********************************************************************************
+*
+* Summary:
+*  Reports the functional failure of the run and ends the program with
+*  SIM_RESULT_FAILURE.
+*
+* Parameters:
+*  const char *fmt: printf() format of the message, followed by its arguments.
+*
+* Return:
+*  Does not return.
+*
+*******************************************************************************/
+void Sim_Fail(const char *fmt, ...)
+{
+    va_list args;
+
+    fflush(stdout);
+    fprintf(stderr, "FAIL at %.6f s: ", (double) simNowNs / (double) SIM_NS_PER_S);
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fprintf(stderr, "\n");
+
+    exit(SIM_RESULT_FAILURE);
+}
+
+
+/*******************************************************************************
+* Function Name: Sim_AdvanceTo
+********************************************************************************
+*
+* Summary:
+*  Moves the virtual clock forward to the given time and runs the connection
+*  events that fall on the way. The clock never goes back.
+*
+* Parameters:
+*  uint64_t ns: The virtual time, ns.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Sim_AdvanceTo(uint64_t ns)
+{
+    while (simLinkEventNs <= ns)
+    {
+        if (simLinkEventNs > simNowNs)
+        {
+            simNowNs = simLinkEventNs;
+        }
+        simLinkEvent();
+    }
+
+    if (ns > simNowNs)
+    {
+        simNowNs = ns;
+    }
+
+    if ((double) simNowNs > (simConfig.timeoutS * (double) SIM_NS_PER_S))
+    {
+        Sim_Fail("the run did not complete in %.0f s of virtual time", simConfig.timeoutS);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Sim_Cycles
+********************************************************************************
+*
+* Summary:
+*  Reads the host cycle counter. Hosts without the time stamp counter count
+*  the nanoseconds of the monotonic clock instead.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The cycle count.
+*
+*******************************************************************************/
+static uint64_t Sim_Cycles(void)
+{
+    #if defined(__x86_64__) || defined(__i386__)
+        return (__rdtsc());
+    #else
+        struct timespec ts;
+
+        (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (((uint64_t) ts.tv_sec * SIM_NS_PER_S) + (uint64_t) ts.tv_nsec);
+    #endif /* defined(__x86_64__) || defined(__i386__) */
+}
+
+
+/*******************************************************************************
+* Function Name: Sim_CpuEnter
+********************************************************************************
+*
+* Summary:
+*  Called on the entry to every fake the firmware calls. The cycles spent in
+*  the firmware code since the last fake returned are added to the statistics
+*  and, with --cpu-scale, to the virtual clock.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Sim_CpuEnter(void)
+{
+    if (0u == simCpuDepth++)
+    {
+        uint64_t cycles = Sim_Cycles() - simCpuMark;
+
+        simStats.fwCycles += cycles;
+        if (simConfig.cpuScale > 0.0)
+        {
+            Sim_AdvanceTo(simNowNs + (uint64_t) ((double) cycles * simConfig.cpuScale));
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Sim_CpuLeave
+********************************************************************************
+*
+* Summary:
+*  Called on the return from every fake the firmware calls. Restarts the count
+*  of the firmware code cycles.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Sim_CpuLeave(void)
+{
+    if (0u == --simCpuDepth)
+    {
+        simCpuMark = Sim_Cycles();
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Sim_FirmwareMain
+********************************************************************************
+*
+* Summary:
+*  The coroutine body: runs the firmware entry function.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void Sim_FirmwareMain(void)
+{
+    simFwEntry();
+
+    SIM_ENTER();
+    Sim_FirmwareExit(SIM_EXIT_RETURN);
+}
+
+
+/*******************************************************************************
+* Function Name: Sim_RunFirmware
+********************************************************************************
+*
+* Summary:
+*  Runs the firmware entry function on its own stack until it resets the
+*  device, exits to the application, halts or returns. The stack is mapped
+*  below 4 GB, so the stack addresses the firmware passes in the uint32 system
+*  call arguments are valid host addresses.
+*
+* Parameters:
+*  void (*entry)(void): The firmware entry function.
+*
+* Return:
+*  How the run ended, SIM_EXIT_*.
+*
+*******************************************************************************/
+uint32 Sim_RunFirmware(void (*entry)(void))
+{
+    if (NULL == simFwStack)
+    {
+        simFwStack = mmap((void *) (uintptr_t) SIM_STACK_BASE, SIM_STACK_SIZE, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        if (simFwStack != (void *) (uintptr_t) SIM_STACK_BASE)
+        {
+            Sim_Fail("can not map the firmware stack at 0x%08X", SIM_STACK_BASE);
+        }
+    }
+
+    (void) getcontext(&simFwContext);
+    simFwContext.uc_stack.ss_sp = simFwStack;
+    simFwContext.uc_stack.ss_size = SIM_STACK_SIZE;
+    simFwContext.uc_link = &simMainContext;
+    makecontext(&simFwContext, Sim_FirmwareMain, 0);
+
+    simFwEntry = entry;
+    simExitReason = SIM_EXIT_NONE;
+    simCpuDepth = 0u;
+    simCpuMark = Sim_Cycles();
+
+    (void) swapcontext(&simMainContext, &simFwContext);
+
+    simCpuDepth = 1u;
+
+    return (simExitReason);
+}
+
+
+/*******************************************************************************
+* Function Name: Sim_FirmwareExit
+********************************************************************************
+*
+* Summary:
+*  Ends the firmware run and returns to Sim_RunFirmware(). Must be called from
+*  a fake, after SIM_ENTER().
+*
+* Parameters:
+*  uint32 reason: How the run ended, SIM_EXIT_*.
+*
+* Return:
+*  Does not return.
+*
+*******************************************************************************/
+void Sim_FirmwareExit(uint32 reason)
+{
+    simExitReason = reason;
+    (void) setcontext(&simMainContext);
+    abort();
+}
+
+
+/*******************************************************************************
+* Function Name: Sim_Random
+********************************************************************************
+*
+* Summary:
+*  The xorshift32 generator of the image data and of the packet loss, so the
+*  runs are repeatable for the given --seed.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The next pseudo random number.
+*
+*******************************************************************************/
+uint32 Sim_Random(void)
+{
+    simRandomState ^= simRandomState << 13u;
+    simRandomState ^= simRandomState >> 17u;
+    simRandomState ^= simRandomState << 5u;
+
+    return (simRandomState);
+}
+
+
+/*******************************************************************************
+* Function Name: SimCpu_InterruptsEnable
+********************************************************************************
+*
+* Summary:
+*  CyGlobalIntEnable and CyGlobalIntDisable. The simulator has no interrupts.
+*
+* Parameters:
+*  uint32 enable: Non-zero to enable the interrupts.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void SimCpu_InterruptsEnable(uint32 enable)
+{
+    (void) enable;
+}
+
+
+/*******************************************************************************
+* Function Name: CyEnterCriticalSection
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function. The simulator has no interrupts.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The saved interrupt state, always 0.
+*
+*******************************************************************************/
+uint8 CyEnterCriticalSection(void)
+{
+    return (0u);
+}
+
+
+/*******************************************************************************
+* Function Name: CyExitCriticalSection
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function. The simulator has no interrupts.
+*
+* Parameters:
+*  uint8 savedIntrStatus: The state returned by CyEnterCriticalSection().
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CyExitCriticalSection(uint8 savedIntrStatus)
+{
+    (void) savedIntrStatus;
+}
+
+
+/*******************************************************************************
+* Function Name: CyDelay
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function: advances the virtual clock.
+*
+* Parameters:
+*  uint32 milliseconds: The delay.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CyDelay(uint32 milliseconds)
+{
+    SIM_ENTER();
+    Sim_AdvanceTo(simNowNs + ((uint64_t) milliseconds * SIM_NS_PER_MS));
+    SIM_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name: CyDelayUs
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function: advances the virtual clock.
+*
+* Parameters:
+*  uint16 microseconds: The delay.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CyDelayUs(uint16 microseconds)
+{
+    SIM_ENTER();
+    Sim_AdvanceTo(simNowNs + ((uint64_t) microseconds * SIM_NS_PER_US));
+    SIM_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name: CySysPmSleep
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function: advances the virtual clock to the next wake
+*  up source, the end of the I2C transfer or the connection event. The sleep
+*  with no wake up source would never end on the device.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CySysPmSleep(void)
+{
+    uint64_t wake;
+
+    SIM_ENTER();
+
+    wake = SimI2C_WakeNs();
+    if (simLinkEventNs < wake)
+    {
+        wake = simLinkEventNs;
+    }
+    if (SIM_NS_NEVER == wake)
+    {
+        Sim_Fail("CySysPmSleep() with no wake up source");
+    }
+    Sim_AdvanceTo(wake);
+
+    SIM_LEAVE();
+}
+
+
+/*******************************************************************************
+* Function Name: CySoftwareReset
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function: ends the firmware run.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Does not return.
+*
+*******************************************************************************/
+void CySoftwareReset(void)
+{
+    SIM_ENTER();
+    Sim_FirmwareExit(SIM_EXIT_RESET);
+}
+
+
+/*******************************************************************************
+* Function Name: CyHalt
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function: ends the firmware run.
+*
+* Parameters:
+*  uint8 reason: Not used.
+*
+* Return:
+*  Does not return.
+*
+*******************************************************************************/
+void CyHalt(uint8 reason)
+{
+    (void) reason;
+
+    SIM_ENTER();
+    Sim_FirmwareExit(SIM_EXIT_HALT);
+}
+
+
+/*******************************************************************************
+* Function Name: CySysGetResetReason
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function. Both runs of the simulator follow the
+*  software reset.
+*
+* Parameters:
+*  uint32 reason: The reset reasons to clear, not used.
+*
+* Return:
+*  CY_SYS_RESET_SW.
+*
+*******************************************************************************/
+uint32 CySysGetResetReason(uint32 reason)
+{
+    (void) reason;
+
+    return (CY_SYS_RESET_SW);
+}
+
+
+/*******************************************************************************
+* Function Name: CySysTickEnable
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function. The SysTick counts the virtual time at the
+*  system clock frequency.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CySysTickEnable(void)
+{
+}
+
+
+/*******************************************************************************
+* Function Name: CySysTickSetClockSource
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function.
+*
+* Parameters:
+*  uint32 clockSource: Not used, the system clock is assumed.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CySysTickSetClockSource(uint32 clockSource)
+{
+    (void) clockSource;
+}
+
+
+/*******************************************************************************
+* Function Name: CySysTickSetReload
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function.
+*
+* Parameters:
+*  uint32 value: The reload value, 24 bits.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CySysTickSetReload(uint32 value)
+{
+    simSysTickReload = value & 0x00FFFFFFu;
+}
+
+
+/*******************************************************************************
+* Function Name: CySysTickClear
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CySysTickClear(void)
+{
+}
+
+
+/*******************************************************************************
+* Function Name: CySysTickDisableInterrupt
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CySysTickDisableInterrupt(void)
+{
+}
+
+
+/*******************************************************************************
+* Function Name: CySysTickGetValue
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function: the down counter derived from the virtual
+*  clock.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The counter value.
+*
+*******************************************************************************/
+uint32 CySysTickGetValue(void)
+{
+    uint64_t ticks = (simNowNs * (CYDEV_BCLK__SYSCLK__HZ / 1000000u)) / SIM_NS_PER_US;
+
+    return (simSysTickReload - (uint32) (ticks % ((uint64_t) simSysTickReload + 1u)));
+}
+
+
+/*******************************************************************************
+* Function Name: CyBle_AesCcmInit
+********************************************************************************
+*
+* Summary:
+*  Fake of the BLE stack function. The simulator does not encrypt: the image
+*  is stored in the clear with the encryption disabled in options.h.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void CyBle_AesCcmInit(void)
+{
+}
+
+
+/*******************************************************************************
+* Function Name: CyBle_AesCcmEncrypt
+********************************************************************************
+*
+* Summary:
+*  Fake of the BLE stack function: copies the data, the MIC is zero.
+*
+* Parameters:
+*  uint8 *key:      Not used.
+*  uint8 *nonce:    Not used.
+*  uint8 *in_data:  The data.
+*  uint8 length:    The data length.
+*  uint8 *out_data: The "encrypted" data.
+*  uint8 *out_mic:  The MIC.
+*
+* Return:
+*  CYBLE_ERROR_OK.
+*
+*******************************************************************************/
+CYBLE_API_RESULT_T CyBle_AesCcmEncrypt(uint8 *key, uint8 *nonce, uint8 *in_data, uint8 length,
+                                       uint8 *out_data, uint8 *out_mic)
+{
+    (void) key;
+    (void) nonce;
+
+    (void) memmove(out_data, in_data, length);
+    (void) memset(out_mic, 0, SIM_AES_MIC_SIZE);
+
+    return (CYBLE_ERROR_OK);
+}
+
+
+/*******************************************************************************
+* Function Name: CyBle_AesCcmDecrypt
+********************************************************************************
+*
+* Summary:
+*  Fake of the BLE stack function: copies the data.
+*
+* Parameters:
+*  uint8 *key:      Not used.
+*  uint8 *nonce:    Not used.
+*  uint8 *in_data:  The "encrypted" data.
+*  uint8 length:    The data length.
+*  uint8 *out_data: The data.
+*  uint8 *in_mic:   Not checked.
+*
+* Return:
+*  CYBLE_ERROR_OK.
+*
+*******************************************************************************/
+CYBLE_API_RESULT_T CyBle_AesCcmDecrypt(uint8 *key, uint8 *nonce, uint8 *in_data, uint8 length,
+                                       uint8 *out_data, uint8 *in_mic)
+{
+    (void) key;
+    (void) nonce;
+    (void) in_mic;
+
+    (void) memmove(out_data, in_data, length);
+
+    return (CYBLE_ERROR_OK);
+}
+
+
+/*******************************************************************************
+* Function Name: CyBle_GenerateRandomNumber
+********************************************************************************
+*
+* Summary:
+*  Fake of the BLE stack function.
+*
+* Parameters:
+*  uint8 *randomNumber: Receives the 8-byte random number.
+*
+* Return:
+*  CYBLE_ERROR_OK.
+*
+*******************************************************************************/
+CYBLE_API_RESULT_T CyBle_GenerateRandomNumber(uint8 *randomNumber)
+{
+    uint32 i;
+
+    for (i = 0u; i < SIM_RANDOM_KEY_SIZE; i++)
+    {
+        randomNumber[i] = LO8(Sim_Random());
+    }
+
+    return (CYBLE_ERROR_OK);
+}
+
+
+/*******************************************************************************
+* Function Name: Sim_Put32
+********************************************************************************
+*
+* Summary:
+*  Stores the 32-bit little endian field.
+*
+* Parameters:
+*  uint8 dst[]:  The field.
+*  uint32 value: The value.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void Sim_Put32(uint8 dst[], uint32 value)
+{
+    dst[0u] = LO8(value);
+    dst[1u] = LO8(value >> 8u);
+    dst[2u] = LO8(value >> 16u);
+    dst[3u] = LO8(value >> 24u);
+}
+
+
+/*******************************************************************************
+* Function Name: SimImage_RandomRow
+********************************************************************************
+*
+* Summary:
+*  Fills the flash row with the pseudo random data.
+*
+* Parameters:
+*  uint8 row[]: The row, CY_FLASH_SIZEOF_ROW bytes.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimImage_RandomRow(uint8 row[])
+{
+    uint32 i;
+
+    for (i = 0u; i < CY_FLASH_SIZEOF_ROW; i++)
+    {
+        row[i] = LO8(Sim_Random() >> 11u);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: SimImage_SetMetadata
+********************************************************************************
+*
+* Summary:
+*  Builds the bootloadable metadata in the last flash row of the image: the
+*  checksum of the application rows, the application address, the last
+*  bootloader row and the application length, as the Bootloader component
+*  expects them.
+*
+* Parameters:
+*  uint8 image[]: The flash image, CY_FLASH_SIZE bytes.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimImage_SetMetadata(uint8 image[])
+{
+    uint8 *md = &image[(CY_FLASH_NUMBER_ROWS - 1u) * CY_FLASH_SIZEOF_ROW];
+    uint8  sum = 0u;
+    uint32 i;
+
+    for (i = simConfig.firstRow * CY_FLASH_SIZEOF_ROW;
+         i < ((simConfig.firstRow + simConfig.rows) * CY_FLASH_SIZEOF_ROW); i++)
+    {
+        sum += image[i];
+    }
+
+    (void) memset(md, 0, CY_FLASH_SIZEOF_ROW);
+    md[SIM_MD_APP_CHECKSUM]  = (uint8) 1u + (uint8) (~sum);
+    Sim_Put32(&md[SIM_MD_APP_ADDR], simConfig.firstRow * CY_FLASH_SIZEOF_ROW);
+    Sim_Put32(&md[SIM_MD_LAST_BTLDR_ROW], simConfig.firstRow - 1u);
+    Sim_Put32(&md[SIM_MD_APP_LENGTH], simConfig.rows * CY_FLASH_SIZEOF_ROW);
+}
+
+
+/*******************************************************************************
+* Function Name: SimImage_Generate
+********************************************************************************
+*
+* Summary:
+*  Builds the running image in the flash and the new image in simImage. The
+*  bootloader and the running application are random, --changed percent of the
+*  application rows of the new image differ from the running ones. The flash
+*  beyond the application is blank.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void SimImage_Generate(void)
+{
+    uint32 row;
+
+    if ((0u == simConfig.firstRow) || (0u == simConfig.rows) ||
+        ((simConfig.firstRow + simConfig.rows) >= (CY_FLASH_NUMBER_ROWS - 1u)))
+    {
+        Sim_Fail("the image of %u rows at the row %u does not fit", simConfig.rows, simConfig.firstRow);
+    }
+
+    simRandomState = (0u != simConfig.seed) ? simConfig.seed : 1u;
+
+    (void) memset(simFlash, 0, CY_FLASH_SIZE);
+    for (row = 0u; row < (simConfig.firstRow + simConfig.rows); row++)
+    {
+        SimImage_RandomRow(&simFlash[row * CY_FLASH_SIZEOF_ROW]);
+    }
+    SimImage_SetMetadata(simFlash);
+
+    (void) memcpy(simImage, simFlash, CY_FLASH_SIZE);
+    for (row = simConfig.firstRow; row < (simConfig.firstRow + simConfig.rows); row++)
+    {
+        if ((Sim_Random() % 100u) < simConfig.changedPct)
+        {
+            SimImage_RandomRow(&simImage[row * CY_FLASH_SIZEOF_ROW]);
+        }
+    }
+    SimImage_SetMetadata(simImage);
+}
+
+
+/*******************************************************************************
+* Function Name: SimImage_RowCount
+********************************************************************************
+*
+* Summary:
+*  Returns the rows of the image sent over the air, the metadata row included.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The row count.
+*
+*******************************************************************************/
+uint32 SimImage_RowCount(void)
+{
+    return (simConfig.rows + 1u);
+}
+
+
+/*******************************************************************************
+* Function Name: SimState_Io
+********************************************************************************
+*
+* Summary:
+*  Reads or writes the block of the state file.
+*
+* Parameters:
+*  FILE *file:       The state file.
+*  void *data:       The block.
+*  size_t size:      The block size.
+*  int write:        Non-zero to write the block.
+*  const char *path: The file name for the error message.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimState_Io(FILE *file, void *data, size_t size, int write, const char *path)
+{
+    size_t done = (0 != write) ? fwrite(data, 1u, size, file) : fread(data, 1u, size, file);
+
+    if (done != size)
+    {
+        Sim_Fail("can not %s the state file %s", (0 != write) ? "write" : "read", path);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: SimState_Save
+********************************************************************************
+*
+* Summary:
+*  Saves the device state at the end of the bootloadable run: the external
+*  memory, the flash, the SFLASH and the expected image.
+*
+* Parameters:
+*  const char *path: The state file.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void SimState_Save(const char *path)
+{
+    SIM_STATE_HEADER_T header;
+    FILE *file = fopen(path, "wb");
+
+    if (NULL == file)
+    {
+        Sim_Fail("can not create the state file %s", path);
+    }
+
+    header.magic      = SIM_STATE_MAGIC;
+    header.version    = SIM_STATE_VERSION;
+    header.rows       = simConfig.rows;
+    header.firstRow   = simConfig.firstRow;
+    header.changedPct = simConfig.changedPct;
+    header.seed       = simConfig.seed;
+    header.emSize     = SIM_EM_SIZE;
+    header.flashSize  = CY_FLASH_SIZE;
+
+    SimState_Io(file, &header, sizeof(header), 1, path);
+    SimState_Io(file, simEm, SIM_EM_SIZE, 1, path);
+    SimState_Io(file, simFlash, CY_FLASH_SIZE, 1, path);
+    SimState_Io(file, simSflash, CYDEV_SFLASH_SIZE, 1, path);
+    SimState_Io(file, simImage, CY_FLASH_SIZE, 1, path);
+
+    if (0 != fclose(file))
+    {
+        Sim_Fail("can not write the state file %s", path);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: SimState_Load
+********************************************************************************
+*
+* Summary:
+*  Restores the device state saved by the bootloadable run. The image options
+*  are taken from the file.
+*
+* Parameters:
+*  const char *path: The state file.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void SimState_Load(const char *path)
+{
+    SIM_STATE_HEADER_T header;
+    FILE *file = fopen(path, "rb");
+
+    if (NULL == file)
+    {
+        Sim_Fail("can not open the state file %s, run ota_link_sim first", path);
+    }
+
+    SimState_Io(file, &header, sizeof(header), 0, path);
+    if ((SIM_STATE_MAGIC != header.magic) || (SIM_STATE_VERSION != header.version) ||
+        (SIM_EM_SIZE != header.emSize) || (CY_FLASH_SIZE != header.flashSize))
+    {
+        Sim_Fail("%s is not the state file of this simulator build", path);
+    }
+
+    simConfig.rows       = header.rows;
+    simConfig.firstRow   = header.firstRow;
+    simConfig.changedPct = header.changedPct;
+    simConfig.seed       = header.seed;
+
+    SimState_Io(file, simEm, SIM_EM_SIZE, 0, path);
+    SimState_Io(file, simFlash, CY_FLASH_SIZE, 0, path);
+    SimState_Io(file, simSflash, CYDEV_SFLASH_SIZE, 0, path);
+    SimState_Io(file, simImage, CY_FLASH_SIZE, 0, path);
+
+    (void) fclose(file);
+}
+
+
+/*******************************************************************************
+* Function Name: Sim_Report
+********************************************************************************
+*
+* Summary:
+*  Prints the figures of the run and checks them against the thresholds given
+*  on the command line. The time is the virtual time, so the rows per second
+*  and the bytes over the air do not depend on the host; the host cycles do.
+*
+* Parameters:
+*  const char *name: The run name.
+*  uint32 rows:      The rows the run transferred or programmed.
+*
+* Return:
+*  SIM_RESULT_PASS or SIM_RESULT_THRESHOLD.
+*
+*******************************************************************************/
+int Sim_Report(const char *name, uint32 rows)
+{
+    double seconds = (double) simNowNs / (double) SIM_NS_PER_S;
+    double perRow = (0u != rows) ? (1.0 / (double) rows) : 0.0;
+    double rowsPerS = (seconds > 0.0) ? ((double) rows / seconds) : 0.0;
+    double cyclesPerRow = (double) simStats.fwCycles * perRow;
+    double airPerRow = (double) simStats.airBytes * perRow;
+    int result = SIM_RESULT_PASS;
+
+    printf("%s:\n", name);
+    printf("  rows                 %u\n", rows);
+    printf("  time                 %.3f s\n", seconds);
+    printf("  rows/s               %.1f\n", rowsPerS);
+    printf("  host cycles/row      %.0f\n", cyclesPerRow);
+    if (0u != simStats.pdus)
+    {
+        printf("  air bytes            %llu (%.1f per row)\n", (unsigned long long) simStats.airBytes, airPerRow);
+        printf("  connection events    %llu\n", (unsigned long long) simStats.connEvents);
+        printf("  LL PDUs              %llu (lost %llu, not acknowledged %llu)\n",
+               (unsigned long long) simStats.pdus, (unsigned long long) simStats.pdusLost,
+               (unsigned long long) simStats.pdusNaked);
+        printf("  packets in/out       %llu/%llu\n",
+               (unsigned long long) simStats.packetsIn, (unsigned long long) simStats.packetsOut);
+    }
+    printf("  flash rows written   %llu\n", (unsigned long long) simStats.flashRows);
+    printf("  SFLASH rows written  %llu\n", (unsigned long long) simStats.sflashRows);
+    printf("  I2C bytes            %llu (%llu transfers, %llu NAKs)\n", (unsigned long long) simStats.i2cBytes,
+           (unsigned long long) simStats.i2cXfers, (unsigned long long) simStats.i2cNaks);
+
+    if ((simConfig.minRowsPerS > 0.0) && (rowsPerS < simConfig.minRowsPerS))
+    {
+        printf("THRESHOLD: %.1f rows/s is below %.1f\n", rowsPerS, simConfig.minRowsPerS);
+        result = SIM_RESULT_THRESHOLD;
+    }
+    if ((simConfig.maxCyclesPerRow > 0.0) && (cyclesPerRow > simConfig.maxCyclesPerRow))
+    {
+        printf("THRESHOLD: %.0f host cycles/row is above %.0f\n", cyclesPerRow, simConfig.maxCyclesPerRow);
+        result = SIM_RESULT_THRESHOLD;
+    }
+    if ((simConfig.maxAirPerRow > 0.0) && (airPerRow > simConfig.maxAirPerRow))
+    {
+        printf("THRESHOLD: %.1f air bytes/row is above %.1f\n", airPerRow, simConfig.maxAirPerRow);
+        result = SIM_RESULT_THRESHOLD;
+    }
+
+    return (result);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,228 @@
+/*******************************************************************************
+* File Name: sim_crc.c
+*
+* Version: 1.50
+*
+* Description:
+*  Host benchmark of the CRC-CCITT of the packet checksum: times the bit-wise
+*  routine the projects used before crc.c, the nibble table build and the byte
+*  table build of CRC_CcittUpdate() over a fixed buffer, checks that the three
+*  agree and prints the bytes per host cycle of each.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif /* defined(__x86_64__) || defined(__i386__) */
+
+#include "crc.h"
+
+
+/***************************************
+*        Constants
+***************************************/
+#define SIM_CRC_BUFFER_SIZE         (4096u)     /* Fixed buffer, 32 flash rows */
+#define SIM_CRC_PASSES              (200u)      /* The fastest pass is reported */
+
+#define SIM_CRC_VARIANTS            (3u)
+
+
+/***************************************
+*        Data Types
+***************************************/
+typedef uint16 (* SIM_CRC_UPDATE_T)(uint16 crc, const uint8 buffer[], uint32 size);
+
+typedef struct
+{
+    const char         *name;
+    SIM_CRC_UPDATE_T    update;
+} SIM_CRC_VARIANT_T;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+/* crc.c built with CRC_CCITT_NIBBLE_TABLE set, see the Makefile */
+uint16 CrcNibble_CcittUpdate(uint16 crc, const uint8 buffer[], uint32 size);
+
+static uint16   SimCrc_BitUpdate(uint16 crc, const uint8 buffer[], uint32 size);
+static uint64_t SimCrc_Cycles(void);
+
+
+/***************************************
+*        Global Variables
+***************************************/
+static const SIM_CRC_VARIANT_T simCrcVariant[SIM_CRC_VARIANTS] =
+{
+    { "bit loop",     &SimCrc_BitUpdate      },
+    { "nibble table", &CrcNibble_CcittUpdate },
+    { "byte table",   &CRC_CcittUpdate       }
+};
+
+static uint8 simCrcBuffer[SIM_CRC_BUFFER_SIZE];
+
+
+/*******************************************************************************
+* Function Name: SimCrc_BitUpdate
+********************************************************************************
+*
+* Summary:
+*  The bit-wise CRC-CCITT of the packet checksum before the table-driven
+*  CRC_CcittUpdate(): eight shift and xor steps per byte.
+*
+* Parameters:
+*  uint16 crc:          The CRC of the previous data or CRC_CCITT_INITIAL_VALUE.
+*  const uint8 buffer[]: The data.
+*  uint32 size:         The number of bytes in the buffer.
+*
+* Return:
+*  Updated 16 bit CRC, not inverted.
+*
+*******************************************************************************/
+static uint16 SimCrc_BitUpdate(uint16 crc, const uint8 buffer[], uint32 size)
+{
+    uint16 tmp;
+    uint8  i;
+    uint32 tmpIndex = size;
+
+    while (0u != size)
+    {
+        tmp = buffer[tmpIndex - size];
+
+        for (i = 0u; i < 8u; i++)
+        {
+            if (0u != ((crc & 0x0001u) ^ (tmp & 0x0001u)))
+            {
+                crc = (crc >> 1u) ^ CRC_CCITT_POLYNOMIAL;
+            }
+            else
+            {
+                crc >>= 1u;
+            }
+
+            tmp >>= 1u;
+        }
+
+        size--;
+    }
+
+    return (crc);
+}
+
+
+/*******************************************************************************
+* Function Name: SimCrc_Cycles
+********************************************************************************
+*
+* Summary:
+*  Reads the host cycle counter. Hosts without the time stamp counter count
+*  the nanoseconds of the monotonic clock instead.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The cycle count.
+*
+*******************************************************************************/
+static uint64_t SimCrc_Cycles(void)
+{
+    #if defined(__x86_64__) || defined(__i386__)
+        return (__rdtsc());
+    #else
+        struct timespec ts;
+
+        (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (((uint64_t) ts.tv_sec * 1000000000ull) + (uint64_t) ts.tv_nsec);
+    #endif /* defined(__x86_64__) || defined(__i386__) */
+}
+
+
+/*******************************************************************************
+* Function Name: main
+********************************************************************************
+*
+* Summary:
+*  Runs the benchmark. The buffer is filled with a fixed pseudo-random
+*  sequence, so every run computes the same CRC.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  0 if the variants agree and the byte table is the fastest, 1 if the byte
+*  table is slower than another variant, 2 if the CRCs differ.
+*
+*******************************************************************************/
+int main(void)
+{
+    double   bytesPerCycle[SIM_CRC_VARIANTS];
+    uint16   crc[SIM_CRC_VARIANTS];
+    uint64_t best;
+    uint64_t start;
+    uint64_t cycles;
+    uint32   seed = 0x2545F491u;
+    uint32   pass;
+    uint32   i;
+    int      result = 0;
+
+    for (i = 0u; i < SIM_CRC_BUFFER_SIZE; i++)
+    {
+        seed = (seed * 1103515245u) + 12345u;
+        simCrcBuffer[i] = (uint8) (seed >> 16u);
+    }
+
+    printf("CRC-CCITT over %u bytes, best of %u passes:\n", SIM_CRC_BUFFER_SIZE, SIM_CRC_PASSES);
+
+    for (i = 0u; i < SIM_CRC_VARIANTS; i++)
+    {
+        best = UINT64_MAX;
+        for (pass = 0u; pass < SIM_CRC_PASSES; pass++)
+        {
+            start = SimCrc_Cycles();
+            crc[i] = simCrcVariant[i].update(CRC_CCITT_INITIAL_VALUE, simCrcBuffer, SIM_CRC_BUFFER_SIZE);
+            cycles = SimCrc_Cycles() - start;
+            if (cycles < best)
+            {
+                best = cycles;
+            }
+        }
+
+        bytesPerCycle[i] = (double) SIM_CRC_BUFFER_SIZE / (double) best;
+        printf("  %-14s CRC 0x%04X  %8llu cycles  %.3f bytes/cycle\n", simCrcVariant[i].name, crc[i],
+               (unsigned long long) best, bytesPerCycle[i]);
+    }
+
+    for (i = 1u; i < SIM_CRC_VARIANTS; i++)
+    {
+        if (crc[i] != crc[0u])
+        {
+            printf("FAILURE: %s CRC differs from the %s\n", simCrcVariant[i].name, simCrcVariant[0u].name);
+            return (2);
+        }
+        if (bytesPerCycle[SIM_CRC_VARIANTS - 1u] < bytesPerCycle[i - 1u])
+        {
+            printf("THRESHOLD: %s is slower than the %s\n", simCrcVariant[SIM_CRC_VARIANTS - 1u].name,
+                   simCrcVariant[i - 1u].name);
+            result = 1;
+        }
+    }
+
+    return (result);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,247 @@
+/*******************************************************************************
+* File Name: sim_emi.c
+*
+* Version: 1.50
+*
+* Description:
+*  Host test of the asynchronous external memory queue of the bootloadable
+*  project against the simulated I2C FRAM or EEPROM: writes the rows with
+*  EMI_SubmitWrite() keeping the queue full, reads them back with
+*  EMI_SubmitRead(), checks the data, the callbacks and the full queue, and
+*  reports the rows per second of the write and read pass.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <project.h>
+#include "ota_mandatory.h"
+#include "sim.h"
+
+
+/***************************************
+*        Global Variables
+***************************************/
+volatile uint32 cyBtldrRunType;
+
+/* Completions in the order of the callbacks */
+static uint32 simEmiDone;
+static uint32 simEmiDoneAddr[CY_FLASH_NUMBER_ROWS];
+static cystatus simEmiDoneStatus;
+
+/* Rows read back, one buffer per queue entry */
+static uint8  simEmiReadBuffer[EMI_QUEUE_SIZE][CY_FLASH_SIZEOF_ROW];
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+static void SimEmi_Callback(cystatus status, uint32 dataAddr, uint8 *data);
+static void SimEmi_ReadCallback(cystatus status, uint32 dataAddr, uint8 *data);
+static void SimEmi_Firmware(void);
+
+
+/*******************************************************************************
+* Function Name: SimEmi_Callback
+********************************************************************************
+*
+* Summary:
+*  Completion callback of the writes: records the order and the status.
+*
+* Parameters:
+*  cystatus status: Status of the operation.
+*  uint32 dataAddr: The external memory address of the operation.
+*  uint8 *data:     The read destination, not used.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimEmi_Callback(cystatus status, uint32 dataAddr, uint8 *data)
+{
+    (void) data;
+
+    if (simEmiDone >= CY_FLASH_NUMBER_ROWS)
+    {
+        Sim_Fail("more completions than operations");
+    }
+    simEmiDoneAddr[simEmiDone] = dataAddr;
+    simEmiDone++;
+
+    if (CYRET_SUCCESS != status)
+    {
+        simEmiDoneStatus = status;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: SimEmi_ReadCallback
+********************************************************************************
+*
+* Summary:
+*  Completion callback of the reads: checks the row against the image before
+*  its buffer is reused.
+*
+* Parameters:
+*  cystatus status: Status of the read.
+*  uint32 dataAddr: The external memory address of the row.
+*  uint8 *data:     The row read.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimEmi_ReadCallback(cystatus status, uint32 dataAddr, uint8 *data)
+{
+    SimEmi_Callback(status, dataAddr, data);
+
+    if ((CYRET_SUCCESS == status) &&
+        (0 != memcmp(data, &simImage[(dataAddr - EMI_APP_BASE_ADDR) + (simConfig.firstRow * CY_FLASH_SIZEOF_ROW)],
+                     CY_FLASH_SIZEOF_ROW)))
+    {
+        Sim_Fail("row at 0x%X read back differs from the image", dataAddr);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: SimEmi_Firmware
+********************************************************************************
+*
+* Summary:
+*  Firmware entry: writes and reads back the image through the queue.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimEmi_Firmware(void)
+{
+    const uint8 *image = &simImage[simConfig.firstRow * CY_FLASH_SIZEOF_ROW];
+    uint32 row;
+    uint32 i;
+
+    CyGlobalIntEnable;
+
+    EMI_Start();
+
+    /* Writes: the queue is kept full, the rejected row is submitted again */
+    for (row = 0u; row < simConfig.rows; )
+    {
+        if (CYRET_SUCCESS == EMI_SubmitWrite(EMI_APP_ABS_ADDR(row), CY_FLASH_SIZEOF_ROW,
+                                             &image[row * CY_FLASH_SIZEOF_ROW], &SimEmi_Callback))
+        {
+            row++;
+        }
+        else if (EMI_QUEUE_SIZE != EMI_GetQueueCount())
+        {
+            Sim_Fail("write of the row %u was rejected with %u operations queued", row, EMI_GetQueueCount());
+        }
+        else
+        {
+            EMI_Process();
+        }
+    }
+    if (CYRET_SUCCESS != EMI_WaitForIdle())
+    {
+        Sim_Fail("wait for the writes failed");
+    }
+
+    for (i = 0u; i < simConfig.rows; i++)
+    {
+        if (EMI_APP_ABS_ADDR(i) != simEmiDoneAddr[i])
+        {
+            Sim_Fail("write %u completed out of order", i);
+        }
+    }
+
+    /* Reads: buffer of the queue entry is reused once its callback ran */
+    simEmiDone = 0u;
+    for (row = 0u; row < simConfig.rows; )
+    {
+        if ((row - simEmiDone) >= EMI_QUEUE_SIZE)
+        {
+            EMI_Process();
+        }
+        else if (CYRET_SUCCESS == EMI_SubmitRead(EMI_APP_ABS_ADDR(row), CY_FLASH_SIZEOF_ROW,
+                                                 simEmiReadBuffer[row % EMI_QUEUE_SIZE], &SimEmi_ReadCallback))
+        {
+            row++;
+        }
+        else
+        {
+            Sim_Fail("read of the row %u was rejected with %u operations queued", row, EMI_GetQueueCount());
+        }
+    }
+    if (CYRET_SUCCESS != EMI_WaitForIdle())
+    {
+        Sim_Fail("wait for the reads failed");
+    }
+
+    if ((simConfig.rows != simEmiDone) || (CYRET_SUCCESS != simEmiDoneStatus))
+    {
+        Sim_Fail("%u of %u reads completed, status 0x%X", simEmiDone, simConfig.rows, simEmiDoneStatus);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: main
+********************************************************************************
+*
+* Summary:
+*  Runs the queue test, checks the external memory and reports the rows per
+*  second of the write and read pass.
+*
+* Parameters:
+*  int argc, char *argv[]: The simulator options, see Sim_ParseArgs().
+*
+* Return:
+*  SIM_RESULT_PASS, SIM_RESULT_THRESHOLD or SIM_RESULT_FAILURE.
+*
+*******************************************************************************/
+int main(int argc, char *argv[])
+{
+    uint32 exitReason;
+
+    Sim_ParseArgs(argc, argv, "emi_sim");
+
+    if (simConfig.rows > EMI_APP_MAX_ROWS)
+    {
+        Sim_Fail("%u rows do not fit the external memory", simConfig.rows);
+    }
+
+    SimMemory_Init();
+    SimImage_Generate();
+
+    exitReason = Sim_RunFirmware(&SimEmi_Firmware);
+    if (SIM_EXIT_RETURN != exitReason)
+    {
+        Sim_Fail("queue test ended with the exit %u", exitReason);
+    }
+
+    if (0 != memcmp(&simEm[EMI_APP_BASE_ADDR], &simImage[simConfig.firstRow * CY_FLASH_SIZEOF_ROW],
+                    simConfig.rows * CY_FLASH_SIZEOF_ROW))
+    {
+        Sim_Fail("external memory differs from the rows written");
+    }
+
+    return (Sim_Report("emi", simConfig.rows));
+}
+
+
+/* [] END OF FILE */
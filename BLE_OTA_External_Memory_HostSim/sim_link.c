@@ -0,0 +1,123 @@
+/*******************************************************************************
+* File Name: sim_link.c
+*
+* Version: 1.50
+*
+* Description:
+*  Host simulator of the over-the-air stage of the update: runs the Bootloader
+*  Emulator of the bootloadable project against the simulated BLE link and
+*  I2C external memory until the host sends Exit Bootloader and the firmware
+*  resets, checks the image in the external memory and saves the device state
+*  for the copy stage.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include <project.h>
+#include "ota_mandatory.h"
+#include "sim.h"
+
+
+/***************************************
+*        Global Variables
+***************************************/
+volatile uint32 cyBtldrRunType;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+static void SimLink_Firmware(void);
+
+
+/*******************************************************************************
+* Function Name: SimLink_Firmware
+********************************************************************************
+*
+* Summary:
+*  Firmware entry: the part of the bootloadable main() that runs the update.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimLink_Firmware(void)
+{
+    CyGlobalIntEnable;
+
+    BootloaderEmulator_Start();
+}
+
+
+/*******************************************************************************
+* Function Name: main
+********************************************************************************
+*
+* Summary:
+*  Runs the over-the-air stage, checks the external memory image and reports
+*  the throughput.
+*
+* Parameters:
+*  int argc, char *argv[]: The simulator options, see Sim_ParseArgs().
+*
+* Return:
+*  SIM_RESULT_PASS, SIM_RESULT_THRESHOLD or SIM_RESULT_FAILURE.
+*
+*******************************************************************************/
+int main(int argc, char *argv[])
+{
+    const uint8 *md = &simImage[(CY_FLASH_NUMBER_ROWS - 1u) * CY_FLASH_SIZEOF_ROW];
+    uint32 exitReason;
+    uint32 row;
+
+    Sim_ParseArgs(argc, argv, "ota_link_sim");
+
+    SimMemory_Init();
+    SimImage_Generate();
+    SimLink_Init();
+
+    exitReason = Sim_RunFirmware(&SimLink_Firmware);
+    if ((SIM_EXIT_RESET != exitReason) || (0u == SimHost_Done()))
+    {
+        Sim_Fail("bootloadable ended the update with the exit %u before the host was done", exitReason);
+    }
+
+    /* Application rows, the metadata row follows them */
+    for (row = 0u; row < simConfig.rows; row++)
+    {
+        if (0 != memcmp(&simEm[EMI_APP_ABS_ADDR(row)],
+                        &simImage[(simConfig.firstRow + row) * CY_FLASH_SIZEOF_ROW], CY_FLASH_SIZEOF_ROW))
+        {
+            Sim_Fail("external memory row %u differs from the image", row);
+        }
+    }
+    if (0 != memcmp(&simEm[EMI_APP_ABS_ADDR(simConfig.rows)], md, CY_FLASH_SIZEOF_ROW))
+    {
+        Sim_Fail("external memory metadata row differs from the image");
+    }
+    if (EMI_MD_APP_STATUS_VALID != simEm[EMI_MD_BASE_ADDR + EMI_MD_APP_STATUS_ADDR])
+    {
+        Sim_Fail("external memory image is not marked valid");
+    }
+
+    SimState_Save(simConfig.state);
+
+    return (Sim_Report("link", SimImage_RowCount()));
+}
+
+
+/* [] END OF FILE */
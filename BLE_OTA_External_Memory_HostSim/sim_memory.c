@@ -0,0 +1,505 @@
+/*******************************************************************************
+* File Name: sim_memory.c
+*
+* Version: 1.50
+*
+* Description:
+*  Memories of the simulated device: the internal flash and SFLASH with the
+*  system calls that write them, and the external memory on the I2C master.
+*  The external memory is the FRAM by default; with --mem-write-us it is the
+*  EEPROM that does not acknowledge its address during the page write cycle.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <sys/mman.h>
+
+#include <project.h>
+#include "sim.h"
+
+
+/***************************************
+*        Constants
+***************************************/
+/* SFLASH and flash are mapped together */
+#define SIM_MEMORY_BASE             (CYDEV_SFLASH_BASE)
+#define SIM_MEMORY_SIZE             ((CYDEV_FLASH_BASE - CYDEV_SFLASH_BASE) + CYDEV_FLASH_SIZE)
+
+#define SIM_SPC_OPCODE_MASK         (0xFFu)
+#define SIM_SPC_WRITE_SFLASH_ROW    (0x18u)
+
+#define SIM_I2C_ADDR_SIZE           (2u)        /* Address bytes of the memory    */
+#define SIM_I2C_NAK_BITS            (10u)       /* Start and the slave address    */
+#define SIM_I2C_POLL_NS             (SIM_NS_PER_US)
+
+
+/***************************************
+*        Global Variables
+***************************************/
+uint8 *simFlash = NULL;
+uint8 *simSflash = NULL;
+uint8  simEm[SIM_EM_SIZE];
+
+volatile uint32 SimSpc_sysArg;
+volatile uint32 SimSpc_sysReq;
+
+static uint8    simSpcLatch[CY_FLASH_SIZEOF_ROW];
+
+static uint32   simI2cStatus = 0u;
+static uint32   simI2cDoneStatus = 0u;
+static uint64_t simI2cDoneNs = SIM_NS_NEVER;
+static uint64_t simI2cBusyNs = 0u;      /* EEPROM page write cycle ends */
+static uint32   simI2cPointer = 0u;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+static uint64_t SimI2C_BitsNs(uint32 bits);
+static void     SimI2C_Update(void);
+static uint32   SimI2C_Start(uint32 slaveAddress, uint8 *data, uint32 cnt, uint32 read);
+
+
+/*******************************************************************************
+* Function Name: SimMemory_Init
+********************************************************************************
+*
+* Summary:
+*  Maps the SFLASH and the flash at the addresses the firmware reads them
+*  from. The memories, the external one included, are blank (all zeros).
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void SimMemory_Init(void)
+{
+    void *base = mmap((void *) (uintptr_t) SIM_MEMORY_BASE, SIM_MEMORY_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+    if (base != (void *) (uintptr_t) SIM_MEMORY_BASE)
+    {
+        Sim_Fail("can not map the flash at 0x%08X, the simulator must be linked with -no-pie", SIM_MEMORY_BASE);
+    }
+
+    simSflash = (uint8 *) base;
+    simFlash  = (uint8 *) (uintptr_t) CYDEV_FLASH_BASE;
+
+    (void) memset(simEm, 0, SIM_EM_SIZE);
+}
+
+
+/*******************************************************************************
+* Function Name: SimSpc_Execute
+********************************************************************************
+*
+* Summary:
+*  Executes the system call requested in the SYSREQ register with the
+*  parameters pointed to by the SYSARG register. Implements the calls
+*  SF_WriteUserSFlashRow() makes: loading the page latch, writing the user
+*  SFLASH row and the flash clock configuration.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The system call status.
+*
+*******************************************************************************/
+uint32 SimSpc_Execute(void)
+{
+    volatile uint32 *param = (volatile uint32 *) (uintptr_t) SimSpc_sysArg;
+    uint32 status = CY_SYS_FLASH_SUCCESS;
+    uint32 size;
+    uint32 row;
+
+    SIM_ENTER();
+
+    switch (SimSpc_sysReq & SIM_SPC_OPCODE_MASK)
+    {
+        case CY_FLASH_API_OPCODE_LOAD:
+            size = param[1u] + 1u;
+            if (size > CY_FLASH_SIZEOF_ROW)
+            {
+                size = CY_FLASH_SIZEOF_ROW;
+            }
+            (void) memcpy(simSpcLatch, (const void *) &param[2u], size);
+            break;
+
+        case SIM_SPC_WRITE_SFLASH_ROW:
+            row = param[1u];
+            if (row < SIM_SFLASH_USER_ROWS)
+            {
+                (void) memcpy(&simSflash[(SIM_SFLASH_USER_BASE_ROW + row) * CY_FLASH_SIZEOF_ROW],
+                              simSpcLatch, CY_FLASH_SIZEOF_ROW);
+                simStats.sflashRows++;
+                Sim_AdvanceTo(simNowNs + ((uint64_t) simConfig.flashRowUs * SIM_NS_PER_US));
+            }
+            else
+            {
+                status = CY_SYS_FLASH_INVALID_ADDR;
+            }
+            break;
+
+        case CY_FLASH_API_OPCODE_CLK_CONFIG:
+        case CY_FLASH_API_OPCODE_CLK_BACKUP:
+        case CY_FLASH_API_OPCODE_CLK_RESTORE:
+            break;
+
+        default:
+            Sim_Fail("system call 0x%02X is not simulated", SimSpc_sysReq & SIM_SPC_OPCODE_MASK);
+            break;
+    }
+
+    SIM_LEAVE();
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: CySysFlashWriteRow
+********************************************************************************
+*
+* Summary:
+*  Fake of the cy_boot function: writes the flash row and advances the virtual
+*  clock by the row write time.
+*
+* Parameters:
+*  uint32 rowNum:       The flash row number.
+*  const uint8 rowData: The row data, CY_FLASH_SIZEOF_ROW bytes.
+*
+* Return:
+*  CY_SYS_FLASH_SUCCESS or CY_SYS_FLASH_INVALID_ADDR.
+*
+*******************************************************************************/
+uint32 CySysFlashWriteRow(uint32 rowNum, const uint8 rowData[])
+{
+    uint32 status = CY_SYS_FLASH_INVALID_ADDR;
+
+    SIM_ENTER();
+
+    if ((rowNum < CY_FLASH_NUMBER_ROWS) && (NULL != rowData))
+    {
+        (void) memcpy(&simFlash[rowNum * CY_FLASH_SIZEOF_ROW], rowData, CY_FLASH_SIZEOF_ROW);
+        simStats.flashRows++;
+        Sim_AdvanceTo(simNowNs + ((uint64_t) simConfig.flashRowUs * SIM_NS_PER_US));
+        status = CY_SYS_FLASH_SUCCESS;
+    }
+
+    SIM_LEAVE();
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: SimI2C_BitsNs
+********************************************************************************
+*
+* Summary:
+*  Returns the time the given number of bits takes on the I2C bus.
+*
+* Parameters:
+*  uint32 bits: Bit count.
+*
+* Return:
+*  The time, ns.
+*
+*******************************************************************************/
+static uint64_t SimI2C_BitsNs(uint32 bits)
+{
+    return (((uint64_t) bits * SIM_NS_PER_MS) / simConfig.i2cKhz);
+}
+
+
+/*******************************************************************************
+* Function Name: SimI2C_Update
+********************************************************************************
+*
+* Summary:
+*  Completes the transfer in progress if its time has come.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void SimI2C_Update(void)
+{
+    if ((0u != (simI2cStatus & EMI_I2CM_I2C_MSTAT_XFER_INP)) && (simNowNs >= simI2cDoneNs))
+    {
+        simI2cStatus = simI2cDoneStatus;
+        simI2cDoneNs = SIM_NS_NEVER;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: SimI2C_Start
+********************************************************************************
+*
+* Summary:
+*  Starts the I2C transfer to the external memory. The data moves at once, the
+*  transfer completes after its time on the bus. The first two bytes of the
+*  write are the memory address, bit 0 of the slave address is its bit 16.
+*  The EEPROM busy with the page write does not acknowledge the slave address.
+*
+* Parameters:
+*  uint32 slaveAddress: 7-bit slave address.
+*  uint8 *data:         The data to write or the buffer to read to.
+*  uint32 cnt:          Bytes to transfer.
+*  uint32 read:         Non-zero for the read.
+*
+* Return:
+*  EMI_I2CM_I2C_MSTR_NO_ERROR or EMI_I2CM_I2C_MSTR_BUS_BUSY.
+*
+*******************************************************************************/
+static uint32 SimI2C_Start(uint32 slaveAddress, uint8 *data, uint32 cnt, uint32 read)
+{
+    uint32 doneStatus = (0u != read) ? EMI_I2CM_I2C_MSTAT_RD_CMPLT : EMI_I2CM_I2C_MSTAT_WR_CMPLT;
+    uint32 i;
+
+    SimI2C_Update();
+    if (0u != (simI2cStatus & EMI_I2CM_I2C_MSTAT_XFER_INP))
+    {
+        return (EMI_I2CM_I2C_MSTR_BUS_BUSY);
+    }
+
+    simStats.i2cXfers++;
+
+    if (simNowNs < simI2cBusyNs)
+    {
+        simStats.i2cNaks++;
+        simStats.i2cBytes++;
+        simI2cDoneStatus = doneStatus | EMI_I2CM_I2C_MSTAT_ERR_ADDR_NAK | EMI_I2CM_I2C_MSTAT_ERR_XFER;
+        simI2cDoneNs = simNowNs + SimI2C_BitsNs(SIM_I2C_NAK_BITS);
+    }
+    else
+    {
+        if (0u != read)
+        {
+            for (i = 0u; i < cnt; i++)
+            {
+                data[i] = simEm[(simI2cPointer + i) % SIM_EM_SIZE];
+            }
+            simI2cPointer += cnt;
+        }
+        else if (cnt >= SIM_I2C_ADDR_SIZE)
+        {
+            simI2cPointer = ((slaveAddress & 0x01u) << 16u) | ((uint32) data[0u] << 8u) | data[1u];
+            for (i = SIM_I2C_ADDR_SIZE; i < cnt; i++)
+            {
+                simEm[simI2cPointer % SIM_EM_SIZE] = data[i];
+                simI2cPointer++;
+            }
+        }
+        else
+        {
+            Sim_Fail("I2C write of %u bytes has no memory address", cnt);
+        }
+
+        /* Every byte is followed by ACK, plus the start and the stop */
+        simStats.i2cBytes += 1u + cnt;
+        simI2cDoneStatus = doneStatus;
+        simI2cDoneNs = simNowNs + SimI2C_BitsNs(((1u + cnt) * 9u) + 2u);
+
+        if ((0u == read) && (cnt > SIM_I2C_ADDR_SIZE) && (0u != simConfig.memWriteUs))
+        {
+            simI2cBusyNs = simI2cDoneNs + ((uint64_t) simConfig.memWriteUs * SIM_NS_PER_US);
+        }
+    }
+
+    simI2cStatus = EMI_I2CM_I2C_MSTAT_XFER_INP;
+
+    return (EMI_I2CM_I2C_MSTR_NO_ERROR);
+}
+
+
+/*******************************************************************************
+* Function Name: SimI2C_WakeNs
+********************************************************************************
+*
+* Summary:
+*  Returns the time the I2C transfer in progress completes, the wake up source
+*  of CySysPmSleep().
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The time, ns, or SIM_NS_NEVER if no transfer is in progress.
+*
+*******************************************************************************/
+uint64_t SimI2C_WakeNs(void)
+{
+    return ((0u != (simI2cStatus & EMI_I2CM_I2C_MSTAT_XFER_INP)) ? simI2cDoneNs : SIM_NS_NEVER);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_I2CM_Start
+********************************************************************************
+*
+* Summary:
+*  Fake of the SCB component function.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void EMI_I2CM_Start(void)
+{
+    simI2cStatus = 0u;
+    simI2cDoneNs = SIM_NS_NEVER;
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_I2CM_I2CMasterWriteBuf
+********************************************************************************
+*
+* Summary:
+*  Fake of the SCB component function.
+*
+* Parameters:
+*  uint32 slaveAddress: 7-bit slave address.
+*  uint8 *wrData:       The data to write.
+*  uint32 cnt:          Bytes to write.
+*  uint32 mode:         Transfer mode, only the complete transfer is simulated.
+*
+* Return:
+*  Error status.
+*
+*******************************************************************************/
+uint32 EMI_I2CM_I2CMasterWriteBuf(uint32 slaveAddress, uint8 *wrData, uint32 cnt, uint32 mode)
+{
+    uint32 status;
+
+    (void) mode;
+
+    SIM_ENTER();
+    status = SimI2C_Start(slaveAddress, wrData, cnt, 0u);
+    SIM_LEAVE();
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_I2CM_I2CMasterReadBuf
+********************************************************************************
+*
+* Summary:
+*  Fake of the SCB component function. Reads from the address set by the
+*  previous write.
+*
+* Parameters:
+*  uint32 slaveAddress: 7-bit slave address.
+*  uint8 *rdData:       The buffer for the data.
+*  uint32 cnt:          Bytes to read.
+*  uint32 mode:         Transfer mode, only the complete transfer is simulated.
+*
+* Return:
+*  Error status.
+*
+*******************************************************************************/
+uint32 EMI_I2CM_I2CMasterReadBuf(uint32 slaveAddress, uint8 *rdData, uint32 cnt, uint32 mode)
+{
+    uint32 status;
+
+    (void) mode;
+
+    SIM_ENTER();
+    status = SimI2C_Start(slaveAddress, rdData, cnt, 1u);
+    SIM_LEAVE();
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_I2CM_I2CMasterStatus
+********************************************************************************
+*
+* Summary:
+*  Fake of the SCB component function. Every poll of the transfer in progress
+*  takes a microsecond of the virtual time.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The master status, EMI_I2CM_I2C_MSTAT_*.
+*
+*******************************************************************************/
+uint32 EMI_I2CM_I2CMasterStatus(void)
+{
+    uint32 status;
+
+    SIM_ENTER();
+
+    SimI2C_Update();
+    if (0u != (simI2cStatus & EMI_I2CM_I2C_MSTAT_XFER_INP))
+    {
+        Sim_AdvanceTo(simNowNs + SIM_I2C_POLL_NS);
+        SimI2C_Update();
+    }
+    status = simI2cStatus;
+
+    SIM_LEAVE();
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: EMI_I2CM_I2CMasterClearStatus
+********************************************************************************
+*
+* Summary:
+*  Fake of the SCB component function. The transfer in progress flag is kept.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The master status before it was cleared.
+*
+*******************************************************************************/
+uint32 EMI_I2CM_I2CMasterClearStatus(void)
+{
+    uint32 status;
+
+    SIM_ENTER();
+
+    SimI2C_Update();
+    status = simI2cStatus;
+    simI2cStatus &= EMI_I2CM_I2C_MSTAT_XFER_INP;
+
+    SIM_LEAVE();
+
+    return (status);
+}
+
+
+/* [] END OF FILE */
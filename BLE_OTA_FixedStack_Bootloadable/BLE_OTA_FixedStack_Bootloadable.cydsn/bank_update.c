@@ -0,0 +1,845 @@
+/*******************************************************************************
+* File Name: bank_update.c
+*
+* Version: 1.40
+*
+* Description:
+*  Provides an API that receives the new image into the inactive flash bank
+*  while the application is running, verifies it and switches the bootloadable
+*  metadata row to it.
+*
+* Hardware Dependency:
+*  CY8CKIT-042 BLE
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#include <string.h>
+#include "bank_update.h"
+
+#if (AB_UPDATE_ENABLED == YES)
+
+static uint32   BANK_Get32(const uint8 buffer[]);
+static uint32   BANK_OfRow(uint32 row);
+static cystatus BANK_ValidateImage(const uint8 mdRow[]);
+static uint8    BANK_ProgramRow(uint32 row, const uint8 data[]);
+static uint8    BANK_CommitImage(void);
+static uint8    BANK_CompressedData(const uint8 data[], uint16 size);
+static void     BANK_Restart(void);
+static uint16   BANK_CalcPacketChecksum(const uint8 buffer[], uint16 size);
+static cystatus BANK_WritePacket(uint8 status, uint8 buffer[], uint16 size);
+
+/* First row of the banks, the last entry is the standby metadata row */
+static uint32 bankFirstRow[BANK_COUNT + 1u];
+
+/* Bank of the running image */
+static uint32 bankActive = BANK_A;
+
+/* Whether the host has entered the update session */
+static uint32 bankSession = 0u;
+
+/* Whether the standby metadata was cleared before the inactive bank was written */
+static uint32 bankStandbyCleared = 0u;
+
+/* Set when the image of the other bank was made active */
+static uint32 bankRestartPending = 0u;
+
+/* Metadata row of the received image, written to flash once it is verified */
+static uint8  bankMdRow[CY_FLASH_SIZEOF_ROW];
+static uint32 bankMdReceived = 0u;
+
+/* Row data queued by the Send Data commands */
+static uint8  bankRowData[CY_FLASH_SIZEOF_ROW];
+static uint16 bankRowOffset = 0u;
+
+static uint8  bankPacket[BANK_SIZEOF_PACKET];
+
+/* Compressed transfer: decoder, next row to program and rows not programmed yet */
+static LZSS_DECODER_T bankLzss;
+static uint32 bankLzssRow = 0u;
+static uint32 bankLzssRowsLeft = 0u;
+
+
+/*******************************************************************************
+* Function Name: BANK_Start
+********************************************************************************
+*
+* Summary:
+*  Locates the flash banks from the metadata of the running image and starts
+*  the Bootloader Service communication.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void BANK_Start(void)
+{
+    const uint8 *activeMd = (const uint8 *) BANK_ROW_ADDR(BANK_ACTIVE_MD_ROW);
+    uint32 firstAppRow;
+
+    /* Bank A follows the bootloader, bank B starts at appl2_start of the linker script */
+    firstAppRow = BANK_Get32(&activeMd[BANK_MD_LAST_BTLDR_ROW]) + 1u;
+
+    bankFirstRow[BANK_A] = firstAppRow;
+    bankFirstRow[BANK_B] = firstAppRow + (((BANK_STANDBY_MD_ROW - firstAppRow) + 1u) / 2u);
+    bankFirstRow[BANK_COUNT] = BANK_STANDBY_MD_ROW;
+
+    bankActive = BANK_OfRow((BANK_Get32(&activeMd[BANK_MD_APP_ADDR]) - CYDEV_FLASH_BASE) / CY_FLASH_SIZEOF_ROW);
+
+    DBG_PRINTF("Running from bank %c, bank B at row %lu \r\n",
+        (BANK_B == bankActive) ? 'B' : 'A', bankFirstRow[BANK_B]);
+
+    CyBLE_CyBtldrCommStart();
+}
+
+
+/*******************************************************************************
+* Function Name: BANK_Process
+********************************************************************************
+*
+* Summary:
+*  Handles the command received over the Bootloader Service, if any. Has to be
+*  called from the main loop, it does not wait for the host.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void BANK_Process(void)
+{
+    uint16 numberRead;
+    uint16 pktSize;
+    uint16 pktChecksum;
+    uint16 rspSize = 0u;
+    uint8  ackCode;
+    uint8  btldrData;
+
+    if (0u != bankRestartPending)
+    {
+        /* The response to Set Active Application has been sent */
+        BANK_Restart();
+    }
+
+    if (CYRET_SUCCESS != CyBLE_CyBtldrCommRead(bankPacket, BANK_SIZEOF_PACKET, &numberRead, BANK_COMM_TIMEOUT))
+    {
+        return;
+    }
+
+    if ((numberRead < BANK_MIN_PKT_SIZE) || (BANK_SOP != bankPacket[BANK_SOP_ADDR]))
+    {
+        ackCode = BANK_ERR_DATA;
+    }
+    else
+    {
+        pktSize = ((uint16)((uint16)bankPacket[BANK_SIZE_ADDR + 1u] << 8u)) | bankPacket[BANK_SIZE_ADDR];
+
+        if ((pktSize + BANK_MIN_PKT_SIZE) > numberRead)
+        {
+            ackCode = BANK_ERR_LENGTH;
+        }
+        else
+        {
+            pktChecksum = ((uint16)((uint16)bankPacket[BANK_CHK_ADDR(pktSize) + 1u] << 8u)) |
+                                   bankPacket[BANK_CHK_ADDR(pktSize)];
+
+            if (BANK_EOP != bankPacket[BANK_EOP_ADDR(pktSize)])
+            {
+                ackCode = BANK_ERR_DATA;
+            }
+            else if (pktChecksum != BANK_CalcPacketChecksum(bankPacket, pktSize + BANK_DATA_ADDR))
+            {
+                ackCode = BANK_ERR_CHECKSUM;
+            }
+            else
+            {
+                ackCode = CYRET_SUCCESS;
+            }
+        }
+    }
+
+    if (CYRET_SUCCESS == ackCode)
+    {
+        btldrData = bankPacket[BANK_DATA_ADDR];
+
+        ackCode = BANK_ERR_DATA;
+        switch (bankPacket[BANK_CMD_ADDR])
+        {
+        case BANK_COMMAND_ENTER:
+            if (0u == pktSize)
+            {
+                BANK_ENTER_T version = {CYDEV_CHIP_JTAG_ID, CYDEV_CHIP_REV_EXPECT, BANK_VERSION};
+
+                bankSession = 1u;
+                bankMdReceived = 0u;
+                bankRowOffset = 0u;
+                bankLzssRowsLeft = 0u;
+
+                rspSize = sizeof(BANK_ENTER_T);
+                (void) memcpy(&bankPacket[BANK_DATA_ADDR], &version, (uint32) rspSize);
+                ackCode = CYRET_SUCCESS;
+                DBG_PRINTF("Bank update: enter, inactive bank %c \r\n", (BANK_A == bankActive) ? 'B' : 'A');
+            }
+            break;
+
+        case BANK_COMMAND_REPORT_SIZE:
+            if ((0u != bankSession) && (1u == pktSize))
+            {
+                /* Rows of the inactive bank and both metadata rows */
+                uint32 firstRow = bankFirstRow[(BANK_A == bankActive) ? BANK_B : BANK_A];
+
+                bankPacket[BANK_DATA_ADDR]      = LO8(firstRow);
+                bankPacket[BANK_DATA_ADDR + 1u] = HI8(firstRow);
+                bankPacket[BANK_DATA_ADDR + 2u] = LO8(BANK_ACTIVE_MD_ROW);
+                bankPacket[BANK_DATA_ADDR + 3u] = HI8(BANK_ACTIVE_MD_ROW);
+                rspSize = 4u;
+                ackCode = CYRET_SUCCESS;
+            }
+            break;
+
+        case BANK_COMMAND_DATA:
+            if (0u != bankSession)
+            {
+                if ((bankRowOffset + pktSize) <= CY_FLASH_SIZEOF_ROW)
+                {
+                    (void) memcpy(&bankRowData[bankRowOffset], &bankPacket[BANK_DATA_ADDR], (uint32) pktSize);
+                    bankRowOffset += pktSize;
+                    ackCode = CYRET_SUCCESS;
+                }
+                else
+                {
+                    ackCode = BANK_ERR_LENGTH;
+                }
+            }
+            break;
+
+        case BANK_COMMAND_PROGRAM:
+            if ((0u != bankSession) && (pktSize >= 3u))
+            {
+                /* The command may be sent along with the last block of data */
+                if ((bankRowOffset + (pktSize - 3u)) != CY_FLASH_SIZEOF_ROW)
+                {
+                    ackCode = BANK_ERR_LENGTH;
+                }
+                else if (0u != btldrData)
+                {
+                    ackCode = BANK_ERR_ARRAY;
+                }
+                else
+                {
+                    (void) memcpy(&bankRowData[bankRowOffset], &bankPacket[BANK_DATA_ADDR + 3u],
+                                  (uint32) pktSize - 3u);
+                    ackCode = BANK_ProgramRow(((uint32)((uint32)bankPacket[BANK_DATA_ADDR + 2u] << 8u)) |
+                                              bankPacket[BANK_DATA_ADDR + 1u], bankRowData);
+                }
+                bankRowOffset = 0u;
+            }
+            break;
+
+        case BANK_COMMAND_COMPRESSED:
+            if ((0u != bankSession) && (BANK_COMPRESSED_PARAM_SIZE == pktSize))
+            {
+                if (0u != btldrData)
+                {
+                    ackCode = BANK_ERR_ARRAY;
+                }
+                else
+                {
+                    /* Rows are decoded into the Send Data buffer */
+                    LZSS_Init(&bankLzss);
+                    bankRowOffset = 0u;
+                    bankLzssRow = ((uint32)((uint32)bankPacket[BANK_DATA_ADDR + 2u] << 8u)) |
+                                  bankPacket[BANK_DATA_ADDR + 1u];
+                    bankLzssRowsLeft = ((uint32)((uint32)bankPacket[BANK_DATA_ADDR + 4u] << 8u)) |
+                                       bankPacket[BANK_DATA_ADDR + 3u];
+                    ackCode = CYRET_SUCCESS;
+                }
+            }
+            break;
+
+        case BANK_COMMAND_COMPRESSED_DATA:
+            if ((0u != bankSession) && (0u != pktSize))
+            {
+                ackCode = BANK_CompressedData(&bankPacket[BANK_DATA_ADDR], pktSize);
+
+                bankPacket[BANK_DATA_ADDR]      = LO8(bankLzssRowsLeft);
+                bankPacket[BANK_DATA_ADDR + 1u] = HI8(bankLzssRowsLeft);
+                rspSize = (CYRET_SUCCESS == ackCode) ? 2u : 0u;
+            }
+            break;
+
+        case BANK_COMMAND_GET_PKT_SIZE:
+            if ((0u != bankSession) && (0u == pktSize))
+            {
+                uint16 mtu = CYBLE_GATT_DEFAULT_MTU;
+                uint16 maxPktSize;
+
+                (void) CyBle_GattGetMtuSize(&mtu);
+
+                /* Limited by the write and by the Bootloader Service characteristic */
+                maxPktSize = mtu - BANK_ATT_WRITE_HEADER_SIZE;
+                if (maxPktSize > BANK_SIZEOF_PACKET)
+                {
+                    maxPktSize = BANK_SIZEOF_PACKET;
+                }
+
+                bankPacket[BANK_DATA_ADDR]      = LO8(maxPktSize);
+                bankPacket[BANK_DATA_ADDR + 1u] = HI8(maxPktSize);
+                bankPacket[BANK_DATA_ADDR + 2u] = LO8(mtu);
+                bankPacket[BANK_DATA_ADDR + 3u] = HI8(mtu);
+                rspSize = 4u;
+                ackCode = CYRET_SUCCESS;
+            }
+            break;
+
+        case BANK_COMMAND_VERIFY:
+            if ((0u != bankSession) && (3u == pktSize))
+            {
+                uint32 row = ((uint32)((uint32)bankPacket[BANK_DATA_ADDR + 2u] << 8u)) | bankPacket[BANK_DATA_ADDR + 1u];
+                uint32 mdRow = (uint32) ((BANK_ACTIVE_MD_ROW == row) || (BANK_STANDBY_MD_ROW == row));
+                const uint8 *rowByte = (0u != mdRow) ? bankMdRow : (const uint8 *) BANK_ROW_ADDR(row);
+                uint8 checksum = 0u;
+                uint32 i;
+
+                if ((0u != mdRow) && (0u == bankMdReceived))
+                {
+                    /* The metadata row is kept in RAM, it was not received in this session */
+                    ackCode = BANK_ERR_DATA;
+                }
+                else if (row < CY_FLASH_NUMBER_ROWS)
+                {
+                    for (i = 0u; i < CY_FLASH_SIZEOF_ROW; i++)
+                    {
+                        checksum += rowByte[i];
+                    }
+                    bankPacket[BANK_DATA_ADDR] = (uint8)1u + (uint8)(~checksum);
+                    rspSize = 1u;
+                    ackCode = CYRET_SUCCESS;
+                }
+                else
+                {
+                    ackCode = BANK_ERR_ROW;
+                }
+            }
+            break;
+
+        case BANK_COMMAND_CHECKSUM:
+            if ((0u != bankSession) && (0u == pktSize))
+            {
+                /* Background verification of the image in the inactive bank */
+                bankPacket[BANK_DATA_ADDR] = (uint8)((0u != bankMdReceived) &&
+                                                     (CYRET_SUCCESS == BANK_ValidateImage(bankMdRow)));
+                rspSize = 1u;
+                ackCode = CYRET_SUCCESS;
+            }
+            break;
+
+        case BANK_COMMAND_APP_STATUS:
+            if ((0u != bankSession) && (1u == pktSize) && (btldrData < BANK_COUNT))
+            {
+                const uint8 *standbyMd = (const uint8 *) BANK_ROW_ADDR(BANK_STANDBY_MD_ROW);
+
+                bankPacket[BANK_DATA_ADDR] = (uint8)((btldrData == bankActive) ||
+                                                     (CYRET_SUCCESS == BANK_ValidateImage(standbyMd)));
+                bankPacket[BANK_DATA_ADDR + 1u] = (uint8)(btldrData == bankActive);
+                rspSize = 2u;
+                ackCode = CYRET_SUCCESS;
+            }
+            break;
+
+        case BANK_COMMAND_APP_ACTIVE:
+            if ((0u != bankSession) && (1u == pktSize) && (btldrData < BANK_COUNT))
+            {
+                if (btldrData == bankActive)
+                {
+                    ackCode = CYRET_SUCCESS;
+                }
+                else if (CYRET_SUCCESS == BANK_Switch())
+                {
+                    /* Rollback to the image kept in the other bank */
+                    bankRestartPending = 1u;
+                    ackCode = CYRET_SUCCESS;
+                }
+                else
+                {
+                    ackCode = BANK_ERR_APP;
+                }
+            }
+            break;
+
+        case BANK_COMMAND_EXIT:
+            if (0u != bankSession)
+            {
+                ackCode = BANK_CommitImage();
+                if (CYRET_SUCCESS == ackCode)
+                {
+                    /* Exit Bootloader is not acknowledged */
+                    BANK_Restart();
+                }
+                bankSession = 0u;
+            }
+            break;
+
+        default:
+            ackCode = BANK_ERR_CMD;
+            break;
+        }
+    }
+
+    (void) BANK_WritePacket(ackCode, bankPacket, rspSize);
+}
+
+
+/*******************************************************************************
+* Function Name: BANK_GetActive
+********************************************************************************
+*
+* Summary:
+*  Returns the bank of the running image.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  BANK_A or BANK_B.
+*
+*******************************************************************************/
+uint32 BANK_GetActive(void)
+{
+    return (bankActive);
+}
+
+
+/*******************************************************************************
+* Function Name: BANK_Switch
+********************************************************************************
+*
+* Summary:
+*  Makes the image described by the standby metadata row active. The metadata
+*  row of the running image is replaced by a single row write, so a reset at
+*  any time starts either the old or the new image. The old metadata is then
+*  kept in the standby row to allow the rollback.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  CYRET_SUCCESS    - The image of the other bank starts after the reset.
+*  CYRET_BAD_DATA   - The image of the other bank is not valid.
+*  CYRET_UNKNOWN    - The flash write failed.
+*
+*******************************************************************************/
+cystatus BANK_Switch(void)
+{
+    cystatus status = CYRET_BAD_DATA;
+    uint8 newMd[CY_FLASH_SIZEOF_ROW];
+    uint8 oldMd[CY_FLASH_SIZEOF_ROW];
+
+    /* The rows of the session, the queued Send Data and the received metadata, are kept */
+    (void) memcpy(newMd, (const uint8 *) BANK_ROW_ADDR(BANK_STANDBY_MD_ROW), CY_FLASH_SIZEOF_ROW);
+    (void) memcpy(oldMd, (const uint8 *) BANK_ROW_ADDR(BANK_ACTIVE_MD_ROW), CY_FLASH_SIZEOF_ROW);
+
+    if (CYRET_SUCCESS == BANK_ValidateImage(newMd))
+    {
+        newMd[BANK_MD_ACTIVE] = 1u;
+        newMd[BANK_MD_VERIFIED] = 1u;
+        oldMd[BANK_MD_ACTIVE] = 0u;
+
+        status = CYRET_UNKNOWN;
+        if (CY_SYS_FLASH_SUCCESS == CySysFlashWriteRow(BANK_ACTIVE_MD_ROW, newMd))
+        {
+            /* A failure here only loses the rollback image */
+            (void) CySysFlashWriteRow(BANK_STANDBY_MD_ROW, oldMd);
+            status = CYRET_SUCCESS;
+
+            /* The received metadata described the bank that now runs */
+            bankMdReceived = 0u;
+        }
+        DBG_PRINTF("Bank switch, status: %lx \r\n", status);
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: BANK_Get32
+********************************************************************************
+*
+* Summary:
+*  Reads the little endian 32 bit metadata field.
+*
+* Parameters:
+*  buffer: The first byte of the field.
+*
+* Return:
+*  The field value.
+*
+*******************************************************************************/
+static uint32 BANK_Get32(const uint8 buffer[])
+{
+    return (((uint32) buffer[0u])          | ((uint32) buffer[1u] << 8u) |
+            ((uint32) buffer[2u] << 16u)   | ((uint32) buffer[3u] << 24u));
+}
+
+
+/*******************************************************************************
+* Function Name: BANK_OfRow
+********************************************************************************
+*
+* Summary:
+*  Returns the bank the flash row belongs to.
+*
+* Parameters:
+*  row: Flash row number.
+*
+* Return:
+*  BANK_A, BANK_B or BANK_NONE for the bootloader and metadata rows.
+*
+*******************************************************************************/
+static uint32 BANK_OfRow(uint32 row)
+{
+    uint32 bank = BANK_NONE;
+
+    if ((row >= bankFirstRow[BANK_A]) && (row < bankFirstRow[BANK_B]))
+    {
+        bank = BANK_A;
+    }
+    else if ((row >= bankFirstRow[BANK_B]) && (row < bankFirstRow[BANK_COUNT]))
+    {
+        bank = BANK_B;
+    }
+    else
+    {
+        /* Not an application row */
+    }
+
+    return (bank);
+}
+
+
+/*******************************************************************************
+* Function Name: BANK_ValidateImage
+********************************************************************************
+*
+* Summary:
+*  Validates the image of the inactive bank the same way as the bootloader
+*  validates the bank images before LaunchActiveBank() starts them: the two's
+*  complement of the 8 bit sum of the image from the metadata application
+*  address has to match the metadata checksum.
+*
+* Parameters:
+*  mdRow: Metadata row of the image.
+*
+* Return:
+*  CYRET_SUCCESS if the image is valid, CYRET_BAD_DATA otherwise.
+*
+*******************************************************************************/
+static cystatus BANK_ValidateImage(const uint8 mdRow[])
+{
+    uint32 appAddr = BANK_Get32(&mdRow[BANK_MD_APP_ADDR]);
+    uint32 appLength = BANK_Get32(&mdRow[BANK_MD_APP_LENGTH]);
+    uint32 bank = BANK_NONE;
+    uint32 firstRow = 0u;
+    uint8 calcedChecksum = 0u;
+    const uint8 *appByte;
+    cystatus status = CYRET_BAD_DATA;
+
+    if ((appAddr >= CYDEV_FLASH_BASE) && (0u == ((appAddr - CYDEV_FLASH_BASE) % CY_FLASH_SIZEOF_ROW)))
+    {
+        firstRow = (appAddr - CYDEV_FLASH_BASE) / CY_FLASH_SIZEOF_ROW;
+        bank = BANK_OfRow(firstRow);
+    }
+
+    /* The image has to start at the inactive bank and fit into it */
+    if ((BANK_NONE != bank) && (bank != bankActive) && (firstRow == bankFirstRow[bank]) &&
+        (0u != appLength) && (appLength <= ((bankFirstRow[bank + 1u] - firstRow) * CY_FLASH_SIZEOF_ROW)))
+    {
+        for (appByte = (const uint8 *) appAddr; appLength > 0u; appLength--)
+        {
+            calcedChecksum += *appByte;
+            appByte++;
+        }
+
+        calcedChecksum = (uint8)1u + (uint8)(~calcedChecksum);
+        if (calcedChecksum == mdRow[BANK_MD_CHECKSUM])
+        {
+            status = CYRET_SUCCESS;
+        }
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: BANK_ProgramRow
+********************************************************************************
+*
+* Summary:
+*  Programs the row of the inactive bank. The metadata row of the image is
+*  kept in RAM until the image is verified.
+*
+* Parameters:
+*  row:  Flash row number.
+*  data: Row data.
+*
+* Return:
+*  CYRET_SUCCESS or the bootloader error code.
+*
+*******************************************************************************/
+static uint8 BANK_ProgramRow(uint32 row, const uint8 data[])
+{
+    uint8 ackCode = CYRET_SUCCESS;
+    uint32 bank;
+
+    if ((BANK_ACTIVE_MD_ROW == row) || (BANK_STANDBY_MD_ROW == row))
+    {
+        /* Image built either for bank A (CY_APPL_NUM = 1) or bank B (CY_APPL_NUM = 2) */
+        (void) memcpy(bankMdRow, data, CY_FLASH_SIZEOF_ROW);
+        bankMdReceived = 1u;
+    }
+    else
+    {
+        bank = BANK_OfRow(row);
+        if (BANK_NONE == bank)
+        {
+            ackCode = (row < CY_FLASH_NUMBER_ROWS) ? BANK_ERR_PROTECT : BANK_ERR_ROW;
+        }
+        else if (bank == bankActive)
+        {
+            ackCode = BANK_ERR_ACTIVE;
+        }
+        else
+        {
+            if (0u == bankStandbyCleared)
+            {
+                /* The old image of the inactive bank can no longer be started */
+                uint8 emptyRow[CY_FLASH_SIZEOF_ROW];
+
+                (void) memset(emptyRow, 0, CY_FLASH_SIZEOF_ROW);
+                if (CY_SYS_FLASH_SUCCESS == CySysFlashWriteRow(BANK_STANDBY_MD_ROW, emptyRow))
+                {
+                    bankStandbyCleared = 1u;
+                }
+            }
+
+            if ((0u == bankStandbyCleared) || (CY_SYS_FLASH_SUCCESS != CySysFlashWriteRow(row, data)))
+            {
+                ackCode = BANK_ERR_ROW;
+            }
+        }
+    }
+
+    return (ackCode);
+}
+
+
+/*******************************************************************************
+* Function Name: BANK_CommitImage
+********************************************************************************
+*
+* Summary:
+*  Stores the metadata of the verified image in the standby row and makes the
+*  image active.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  CYRET_SUCCESS or the bootloader error code.
+*
+*******************************************************************************/
+static uint8 BANK_CommitImage(void)
+{
+    uint8 ackCode = BANK_ERR_APP;
+
+    if ((0u != bankMdReceived) && (CYRET_SUCCESS == BANK_ValidateImage(bankMdRow)))
+    {
+        bankMdRow[BANK_MD_ACTIVE] = 0u;
+        bankMdRow[BANK_MD_VERIFIED] = 1u;
+
+        ackCode = BANK_ERR_UNK;
+        if ((CY_SYS_FLASH_SUCCESS == CySysFlashWriteRow(BANK_STANDBY_MD_ROW, bankMdRow)) &&
+            (CYRET_SUCCESS == BANK_Switch()))
+        {
+            bankStandbyCleared = 0u;
+            ackCode = CYRET_SUCCESS;
+        }
+    }
+
+    return (ackCode);
+}
+
+
+/*******************************************************************************
+* Function Name: BANK_CompressedData
+********************************************************************************
+*
+* Summary:
+*  Decodes the block of the compressed stream into the row buffer and programs
+*  the rows completed by it. The match that continues past the row is finished
+*  in the next row without waiting for more data.
+*
+* Parameters:
+*  data: The compressed data.
+*  size: The number of bytes in the compressed data.
+*
+* Return:
+*  CYRET_SUCCESS or the bootloader error code.
+*
+*******************************************************************************/
+static uint8 BANK_CompressedData(const uint8 data[], uint16 size)
+{
+    uint8  ackCode = CYRET_SUCCESS;
+    uint32 offset = 0u;
+    uint32 used;
+    uint32 decoded;
+
+    do
+    {
+        if (0u == bankLzssRowsLeft)
+        {
+            /* The stream is longer than the announced rows */
+            ackCode = BANK_ERR_LENGTH;
+            break;
+        }
+
+        decoded = LZSS_Decode(&bankLzss, &data[offset], (uint32) size - offset, &used,
+                              &bankRowData[bankRowOffset], (uint32) CY_FLASH_SIZEOF_ROW - bankRowOffset);
+        offset += used;
+        bankRowOffset += (uint16) decoded;
+
+        if (CY_FLASH_SIZEOF_ROW == bankRowOffset)
+        {
+            ackCode = BANK_ProgramRow(bankLzssRow, bankRowData);
+            bankLzssRow++;
+            bankLzssRowsLeft--;
+            bankRowOffset = 0u;
+        }
+    } while ((CYRET_SUCCESS == ackCode) && ((offset < size) || ((0u != decoded) && (0u != bankLzssRowsLeft))));
+
+    if ((CYRET_SUCCESS == ackCode) && (0u == bankLzssRowsLeft) && (0u == LZSS_IsIdle(&bankLzss)))
+    {
+        /* The last match runs past the last row */
+        ackCode = BANK_ERR_DATA;
+    }
+
+    return (ackCode);
+}
+
+
+/*******************************************************************************
+* Function Name: BANK_Restart
+********************************************************************************
+*
+* Summary:
+*  Stops BLE and resets the device to start the image of the active metadata.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  This function does not return.
+*
+*******************************************************************************/
+static void BANK_Restart(void)
+{
+    DBG_PRINTF("Restarting to bank %c... \r\n", (BANK_A == bankActive) ? 'B' : 'A');
+    CyDelay(500u);
+
+    CyBle_Shutdown(); /* stop all ongoing activities */
+    CyBle_ProcessEvents(); /* process all pending events */
+    CyBle_SetState(CYBLE_STATE_STOPPED);
+    CySysWdtUnlock();
+    CySysWdtDisable(WDT_COUNTER_MASK);
+    CySoftwareReset();
+}
+
+
+/*******************************************************************************
+* Function Name: BANK_CalcPacketChecksum
+********************************************************************************
+*
+* Summary:
+*  This computes the 16 bit checksum for the provided number of bytes contained
+*  in the provided buffer
+*
+* Parameters:
+*  buffer:
+*     The buffer containing the data to compute the checksum for
+*  size:
+*     The number of bytes in the buffer to compute the checksum for
+*
+* Returns:
+*  16 bit checksum for the provided data
+*
+*******************************************************************************/
+static uint16 BANK_CalcPacketChecksum(const uint8 buffer[], uint16 size)
+{
+    uint16 sum = 0u;
+
+    while (size > 0u)
+    {
+        sum += buffer[size - 1u];
+        size--;
+    }
+
+    return ((uint16)1u + (uint16)(~sum));
+}
+
+
+/*******************************************************************************
+* Function Name: BANK_WritePacket
+********************************************************************************
+*
+* Summary:
+*  Creates a bootloader response packet and transmits it back to the bootloader
+*  host application over the Bootloader Service.
+*
+* Parameters:
+*  status:
+*      The status code to pass back as the second byte of the packet
+*  buffer:
+*      The buffer containing the data portion of the packet
+*  size:
+*      The number of bytes contained within the buffer to pass back
+*
+* Return:
+*   CYRET_SUCCESS if successful. Any other non-zero value if failure occurred.
+*
+*******************************************************************************/
+static cystatus BANK_WritePacket(uint8 status, uint8 buffer[], uint16 size)
+{
+    uint16 checksum;
+
+    buffer[BANK_SOP_ADDR]       = BANK_SOP;
+    buffer[BANK_CMD_ADDR]       = status;
+    buffer[BANK_SIZE_ADDR]      = LO8(size);
+    buffer[BANK_SIZE_ADDR + 1u] = HI8(size);
+
+    checksum = BANK_CalcPacketChecksum(buffer, size + BANK_DATA_ADDR);
+
+    buffer[BANK_CHK_ADDR(size)]      = LO8(checksum);
+    buffer[BANK_CHK_ADDR(1u + size)] = HI8(checksum);
+    buffer[BANK_EOP_ADDR(size)]      = BANK_EOP;
+
+    return (CyBLE_CyBtldrCommWrite(buffer, size + BANK_MIN_PKT_SIZE, &size, BANK_COMM_WRITE_TIMEOUT));
+}
+
+#endif /* (AB_UPDATE_ENABLED == YES) */
+
+/* [] END OF FILE */
@@ -0,0 +1,128 @@
+/*******************************************************************************
+* File Name: bank_update.h
+*
+* Version 1.40
+*
+* Description:
+*  Contains the function prototypes and constants of the dual bank update. The
+*  new image is received over the Bootloader Service into the inactive bank
+*  while the application keeps running, and is started by rewriting the
+*  bootloadable metadata row.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#ifndef BLE_OTA_EP_BANK_UPDATE_H_
+#define BLE_OTA_EP_BANK_UPDATE_H_
+
+#include "common.h"
+#include "lzss.h"
+
+#if (AB_UPDATE_ENABLED == YES)
+
+/*******************************************************************************
+* Flash layout. Bank A starts at the first row after the bootloader, bank B in
+* the middle of the remaining flash, as placed by the linker script for
+* CY_APPL_NUM equal to 1 and 2. The metadata row of the running image is the
+* last flash row, the image of the other bank is described by the row below.
+*******************************************************************************/
+#define BANK_A                      (0u)
+#define BANK_B                      (1u)
+#define BANK_COUNT                  (2u)
+#define BANK_NONE                   (0xFFu)
+
+#define BANK_ACTIVE_MD_ROW          (CY_FLASH_NUMBER_ROWS - 1u)
+#define BANK_STANDBY_MD_ROW         (CY_FLASH_NUMBER_ROWS - 2u)
+#define BANK_ROW_ADDR(row)          (CYDEV_FLASH_BASE + ((uint32)(row) * CY_FLASH_SIZEOF_ROW))
+
+/* Bootloadable metadata, located at the end of the metadata row */
+#define BANK_MD_SIZEOF              (64u)
+#define BANK_MD_BASE                (CY_FLASH_SIZEOF_ROW - BANK_MD_SIZEOF)
+#define BANK_MD_CHECKSUM            (BANK_MD_BASE + 0u)
+#define BANK_MD_APP_ADDR            (BANK_MD_BASE + 1u)
+#define BANK_MD_LAST_BTLDR_ROW      (BANK_MD_BASE + 5u)
+#define BANK_MD_APP_LENGTH          (BANK_MD_BASE + 9u)
+#define BANK_MD_ACTIVE              (BANK_MD_BASE + 16u)
+#define BANK_MD_VERIFIED            (BANK_MD_BASE + 17u)
+
+/*******************************************************************************
+* Bootloader host protocol. Only the commands needed to program an image are
+* supported, the packet checksum is the Basic summation of the Bootloader
+* component.
+*******************************************************************************/
+#define BANK_SIZEOF_PACKET          (144u)      /* Bootloader Service characteristic size */
+
+#define BANK_SOP                    (0x01u)     /* Start of Packet */
+#define BANK_EOP                    (0x17u)     /* End of Packet */
+
+#define BANK_SOP_ADDR               (0x00u)     /* Start of packet offset from beginning     */
+#define BANK_CMD_ADDR               (0x01u)     /* Command offset from beginning             */
+#define BANK_SIZE_ADDR              (0x02u)     /* Packet size offset from beginning         */
+#define BANK_DATA_ADDR              (0x04u)     /* Packet data offset from beginning         */
+#define BANK_CHK_ADDR(x)            (0x04u + (x))   /* Packet checksum offset from end       */
+#define BANK_EOP_ADDR(x)            (0x06u + (x))   /* End of packet offset from end         */
+#define BANK_MIN_PKT_SIZE           (7u)        /* The minimum number of bytes in a packet   */
+
+#define BANK_COMMAND_CHECKSUM       (0x31u)     /* Verify the checksum of the received image        */
+#define BANK_COMMAND_REPORT_SIZE    (0x32u)     /* Report the programmable portions of flash        */
+#define BANK_COMMAND_APP_STATUS     (0x33u)     /* Gets status info about the provided bank         */
+#define BANK_COMMAND_APP_ACTIVE     (0x36u)     /* Starts the image of the provided bank            */
+#define BANK_COMMAND_DATA           (0x37u)     /* Queue up a block of data for programming         */
+#define BANK_COMMAND_ENTER          (0x38u)     /* Start the update session                         */
+#define BANK_COMMAND_PROGRAM        (0x39u)     /* Program the specified row                        */
+#define BANK_COMMAND_VERIFY         (0x3Au)     /* Compute flash row checksum for verification      */
+#define BANK_COMMAND_EXIT           (0x3Bu)     /* Starts the received image & resets the chip      */
+#define BANK_COMMAND_COMPRESSED     (0x42u)     /* Starts the transfer of the compressed rows       */
+#define BANK_COMMAND_COMPRESSED_DATA (0x43u)    /* Block of compressed rows, decoded and programmed */
+#define BANK_COMMAND_GET_PKT_SIZE   (0x44u)     /* Reports the largest packet of a single ATT write */
+
+#define BANK_ERR_LENGTH             (0x03u)     /* The amount of data available is outside the expected range  */
+#define BANK_ERR_DATA               (0x04u)     /* The data is not of the proper form                          */
+#define BANK_ERR_CMD                (0x05u)     /* The command is not recognized                               */
+#define BANK_ERR_CHECKSUM           (0x08u)     /* The checksum does not match the expected value              */
+#define BANK_ERR_ARRAY              (0x09u)     /* The flash array is not valid                                */
+#define BANK_ERR_ROW                (0x0Au)     /* The flash row is not valid                                  */
+#define BANK_ERR_PROTECT            (0x0Bu)     /* The flash row is protected and can not be programmed        */
+#define BANK_ERR_APP                (0x0Cu)     /* The application is not valid and cannot be set as active    */
+#define BANK_ERR_ACTIVE             (0x0Du)     /* The row belongs to the running application                  */
+#define BANK_ERR_UNK                (0x0Fu)     /* An unknown error occurred                                   */
+
+#define BANK_VERSION                {(uint8)30u, (uint8)1u, (uint8)0x01u}
+
+/* Compressed transfer: [1-byte array] [2-byte first row] [2-byte number of rows],
+* then the rows as one LZSS stream in Compressed Data packets of any size. The
+* response to Compressed Data is [2-byte rows left].
+*/
+#define BANK_COMPRESSED_PARAM_SIZE  (5u)
+
+/* Get Packet Size response: [2-byte largest packet carried by one write] [2-byte
+* ATT MTU]. The MTU is negotiated by the client up to the GATT MTU of the stack
+* in the bootloader; the whole Program Row fits one write from 150 bytes on.
+*/
+#define BANK_ATT_WRITE_HEADER_SIZE  (3u)        /* Opcode and attribute handle */
+
+#define BANK_COMM_TIMEOUT           (1u)        /* Poll the Bootloader Service without waiting */
+#define BANK_COMM_WRITE_TIMEOUT     (150u)
+
+typedef struct
+{
+    uint32 siliconId;
+    uint8  revision;
+    uint8  bootLoaderVersion[3u];
+} BANK_ENTER_T;
+
+
+void     BANK_Start(void);
+void     BANK_Process(void);
+uint32   BANK_GetActive(void);
+cystatus BANK_Switch(void);
+
+#endif /* (AB_UPDATE_ENABLED == YES) */
+
+#endif /* BLE_OTA_EP_BANK_UPDATE_H_ */
+
+/* [] END OF FILE */
@@ -59,7 +59,12 @@ int main()
 
     /* Start CYBLE component and register generic event handler */
     CyBle_Start(AppCallBack);
+#if (AB_UPDATE_ENABLED == YES)
+    /* Bootloader service receives the image of the inactive bank */
+    BANK_Start();
+#else
     CyBle_GattsDisableAttribute(cyBle_btss.btServiceHandle); /* fix CDT 243443, disable bootloader service */
+#endif /* (AB_UPDATE_ENABLED == YES) */
 
     WDT_Start();
 
@@ -115,6 +120,10 @@ int main()
         }
         CyBle_ProcessEvents();
         
+    #if (AB_UPDATE_ENABLED == YES)
+        BANK_Process();
+    #endif /* (AB_UPDATE_ENABLED == YES) */
+
         BootloaderSwitch();
     }   
 }
@@ -228,6 +237,12 @@ void AppCallBack(uint32 event, void* eventParam)
             break;
         case CYBLE_EVT_GAP_DEVICE_CONNECTED:
             DBG_PRINTF("CYBLE_EVT_GAP_DEVICE_CONNECTED \r\n");
+            #if (CYBLE_DLE_FEATURE_ENABLED)
+                /* Let a full bootloader packet go in a single link layer PDU */
+                apiResult = CyBle_GapSetDataLength(cyBle_connHandle.bdHandle,
+                                CYBLE_LL_MAX_SUPPORTED_TX_PAYLOAD_SIZE, CYBLE_LL_MAX_TX_TIME);
+                DBG_PRINTF("CyBle_GapSetDataLength API: 0x%2.2x \r\n", apiResult);
+            #endif /* (CYBLE_DLE_FEATURE_ENABLED) */
             Disconnect_LED_Write(LED_OFF);
             Advertising_LED_Write(LED_OFF);
             break;
@@ -35,6 +35,7 @@
 #include "hids.h"
 #include "bas.h"
 #include "scps.h"
+#include "bank_update.h"
 
 void AppCallBack(uint32 event, void* eventParam);
 
@@ -35,6 +35,10 @@
 /* YES - use printf, NO - use UART_PutString
  * e.g. DBG_PRINTF("message %d\r\n", i) will transform to UART_PutString("message %d\r\n") */
 #define DEBUG_UART_USE_PRINTF_FORMAT  (YES)
+/* YES - receive the new image into the inactive flash bank while the application
+ * is running, NO - the image is loaded by the bootloader (SW2 button). The
+ * image for bank B is built with CY_APPL_NUM set to 2 in the linker script. */
+#define AB_UPDATE_ENABLED       (YES)
 
 #endif /* BLE_OTA_EP_OPTIONS_H_ */
 
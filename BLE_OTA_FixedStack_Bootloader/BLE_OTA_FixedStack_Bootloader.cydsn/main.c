@@ -73,6 +73,11 @@ int main()
     DBG_PRINT_TEXT("\r\n");
     DBG_PRINT_TEXT("\r\n");
 
+#if (AB_UPDATE_ENABLED == YES)
+    RecoverActiveBank();
+    LaunchActiveBank();
+#endif /* (AB_UPDATE_ENABLED == YES) */
+
     CyGlobalIntEnable;
 
     Bootloading_LED_Write(LED_OFF);
@@ -33,6 +33,10 @@
 /* YES - use printf, NO - use UART_PutString
  * e.g. DBG_PRINTF("message %d\r\n", i) will transform to UART_PutString("message %d\r\n") */
 #define DEBUG_UART_USE_PRINTF_FORMAT  (YES)
+/* YES - start the image of the other bank at reset when the active image is not
+ * valid, and start the images of bank B by their metadata application address.
+ * Has to match AB_UPDATE_ENABLED of the bootloadable project. */
+#define AB_UPDATE_ENABLED       (YES)
 
 #endif /* BLE_OTA_EP_OPTIONS_H_ */
 
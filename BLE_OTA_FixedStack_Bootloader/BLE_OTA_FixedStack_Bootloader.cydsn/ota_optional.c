@@ -19,7 +19,13 @@
 * WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
 * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
 *******************************************************************************/
+#include <string.h>
 #include "ota_optional.h"
+#include "debug.h"
+
+#if (AB_UPDATE_ENABLED == YES)
+    static cystatus ValidateBankImage(const uint8 mdRow[]);
+#endif /* (AB_UPDATE_ENABLED == YES) */
 
 
 /*******************************************************************************
@@ -127,4 +133,127 @@ void HandleLeds(void)
     }
 }
 
+#if (AB_UPDATE_ENABLED == YES)
+
+/*******************************************************************************
+* Function Name: RecoverActiveBank
+********************************************************************************
+*
+* Summary:
+*   Makes the image of the standby bank active when the active image is not
+*   valid, e.g. if its bank was overwritten by the update that did not
+*   complete. Has to be called before Bootloader_Start().
+*
+* Parameters:
+*   None
+*
+* Return:
+*   None
+*
+*******************************************************************************/
+void RecoverActiveBank(void)
+{
+    uint8 activeRow[CY_FLASH_SIZEOF_ROW];
+    uint8 standbyRow[CY_FLASH_SIZEOF_ROW];
+
+    (void) memcpy(activeRow, (const uint8 *) AB_ROW_ADDR(AB_ACTIVE_MD_ROW), CY_FLASH_SIZEOF_ROW);
+    (void) memcpy(standbyRow, (const uint8 *) AB_ROW_ADDR(AB_STANDBY_MD_ROW), CY_FLASH_SIZEOF_ROW);
+
+    if ((CYRET_SUCCESS != ValidateBankImage(activeRow)) && (CYRET_SUCCESS == ValidateBankImage(standbyRow)))
+    {
+        DBG_PRINT_TEXT("> Active image is not valid, starting the image of the standby bank\r\n");
+
+        standbyRow[AB_MD_ACTIVE] = 1u;
+        activeRow[AB_MD_ACTIVE] = 0u;
+        if (CY_SYS_FLASH_SUCCESS == CySysFlashWriteRow(AB_ACTIVE_MD_ROW, standbyRow))
+        {
+            (void) CySysFlashWriteRow(AB_STANDBY_MD_ROW, activeRow);
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: LaunchActiveBank
+********************************************************************************
+*
+* Summary:
+*   Starts the active image if it does not follow the bootloader, i.e. it is
+*   the image of bank B. The Bootloader component in the single application
+*   mode validates the image from the row after the bootloader, so it never
+*   starts such an image. The image is validated from its metadata application
+*   address here and started by Bootloader_LaunchApplication(), which jumps to
+*   the same address. Does nothing if the bootloadable requested the
+*   bootloader. Has to be called before Bootloader_Start().
+*
+* Parameters:
+*   None
+*
+* Return:
+*   None
+*
+*******************************************************************************/
+void LaunchActiveBank(void)
+{
+    const uint8 *activeRow = (const uint8 *) AB_ROW_ADDR(AB_ACTIVE_MD_ROW);
+    uint32 appAddr = AB_MD_GET32(&activeRow[AB_MD_APP_ADDR]);
+    uint32 firstAppRow = AB_MD_GET32(&activeRow[AB_MD_LAST_BTLDR_ROW]) + 1u;
+
+    if ((Bootloader_START_BTLDR != Bootloader_GET_RUN_TYPE) && (AB_ROW_ADDR(firstAppRow) != appAddr) &&
+        (CYRET_SUCCESS == ValidateBankImage(activeRow)))
+    {
+        DBG_PRINT_TEXT("> Starting the image of bank B\r\n");
+
+        Bootloader_LaunchApplication();
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: ValidateBankImage
+********************************************************************************
+*
+* Summary:
+*   Validates the image described by the metadata row: the two's complement of
+*   the 8 bit sum of the image from the metadata application address has to
+*   match the metadata checksum. Unlike Bootloader_ValidateBootloadable(), which
+*   sums from the row after the bootloader, this covers the images of both
+*   banks.
+*
+* Parameters:
+*   mdRow - metadata row of the image
+*
+* Return:
+*   CYRET_SUCCESS if the image is valid, CYRET_BAD_DATA otherwise.
+*
+*******************************************************************************/
+static cystatus ValidateBankImage(const uint8 mdRow[])
+{
+    uint32 appAddr = AB_MD_GET32(&mdRow[AB_MD_APP_ADDR]);
+    uint32 appLength = AB_MD_GET32(&mdRow[AB_MD_APP_LENGTH]);
+    const uint8 *appByte;
+    uint8 calcedChecksum = 0u;
+    cystatus status = CYRET_BAD_DATA;
+
+    if ((appAddr > CYDEV_FLASH_BASE) && (appAddr < AB_ROW_ADDR(AB_STANDBY_MD_ROW)) &&
+        (0u != appLength) && (appLength <= (AB_ROW_ADDR(AB_STANDBY_MD_ROW) - appAddr)))
+    {
+        for (appByte = (const uint8 *) appAddr; appLength > 0u; appLength--)
+        {
+            calcedChecksum += *appByte;
+            appByte++;
+        }
+
+        calcedChecksum = (uint8)1u + (uint8)(~calcedChecksum);
+        if (calcedChecksum == mdRow[AB_MD_CHECKSUM])
+        {
+            status = CYRET_SUCCESS;
+        }
+    }
+
+    return (status);
+}
+
+#endif /* (AB_UPDATE_ENABLED == YES) */
+
 /* [] END OF FILE */
@@ -17,6 +17,7 @@
 #define BLE_OTA_EP_OTA_OPTIONAL_H_
 
 #include <project.h>
+#include "options.h"
 
 /*WDT setup values*/
 #define WDT_COUNTER                         (CY_SYS_WDT_COUNTER1)
@@ -36,6 +37,19 @@
     #define LED_WRITE_MACRO(a)              (Advertising_LED_2_Write(a))
 #endif /* (LED_ADV_COLOR == LED_GREEN) */
 
+/* Bootloadable metadata rows of the active and the standby bank */
+#define AB_ACTIVE_MD_ROW                    (CY_FLASH_NUMBER_ROWS - 1u)
+#define AB_STANDBY_MD_ROW                   (CY_FLASH_NUMBER_ROWS - 2u)
+#define AB_ROW_ADDR(row)                    (CYDEV_FLASH_BASE + ((uint32)(row) * CY_FLASH_SIZEOF_ROW))
+#define AB_MD_BASE                          (CY_FLASH_SIZEOF_ROW - 64u)
+#define AB_MD_CHECKSUM                      (AB_MD_BASE + 0u)
+#define AB_MD_APP_ADDR                      (AB_MD_BASE + 1u)
+#define AB_MD_LAST_BTLDR_ROW                (AB_MD_BASE + 5u)
+#define AB_MD_APP_LENGTH                    (AB_MD_BASE + 9u)
+#define AB_MD_ACTIVE                        (AB_MD_BASE + 16u)
+#define AB_MD_GET32(field)                  ((uint32)(field)[0u]          | ((uint32)(field)[1u] << 8u) | \
+                                             ((uint32)(field)[2u] << 16u) | ((uint32)(field)[3u] << 24u))
+
 #define LED_TIMEOUT                         (1000u)   /* Сounts of 1 millisecond */
 #define LED_ON                              (0u)
 #define LED_OFF                             (1u)
@@ -47,6 +61,11 @@ void WDT_Start(void);
 void WDT_Stop(void);
 void HandleLeds(void);
 
+#if (AB_UPDATE_ENABLED == YES)
+    void RecoverActiveBank(void);
+    void LaunchActiveBank(void);
+#endif /* (AB_UPDATE_ENABLED == YES) */
+
 #endif /* BLE_OTA_EP_OTA_OPTIONAL_H_ */
 
 /* [] END OF FILE */
@@ -73,14 +73,16 @@ int main()
     
     S_LED_Write(LED_ON);
     
+    /* Caches the latest record of the metadata store */
+    MDS_Init();
+    
     /* Checks if Self Project Image is updated and Runs for the First time */
     AfterImageUpdate();
     
-    /* If application image is present and valid but no metadata flag is set.
+    /* If application image is present and valid but was not started yet.
      * Assuming it is first launch.
      */
-    if ((CYRET_SUCCESS == Loader_ValidateApp(1u)) && \
-                                (0u == (uint32) CY_GET_XTND_REG8((volatile uint8 *)APP_UPDATE_FLAG_OFFSET)))
+    if ((CYRET_SUCCESS == Loader_ValidateApp(1u)) && (0u != MDS_IsImageUpdated(MDS_IMAGE_APP)))
     {
         DBG_PRINT_TEXT("Application is ready to be launched. Doing so.\r\n");
         Bootloadable_SetActiveApplication(1u);
@@ -0,0 +1,84 @@
+/*******************************************************************************
+* File Name: md_store.h
+* Version 1.20
+*
+* Description:
+*  Contains the function prototypes and constants of the metadata store. The
+*  store keeps the update state shared by the Stack and Application projects
+*  in the journal of user SFLASH rows, which are not touched by the image load.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#ifndef BLE_OTA_EP_MD_STORE_H_
+#define BLE_OTA_EP_MD_STORE_H_
+
+#include <cytypes.h>
+#include <project.h>
+
+
+/*******************************************************************************
+* Journal layout. Every commit programs the next row of the ring, so the row
+* holding the previous record is never erased while the new one is written.
+* User SFLASH row 0 is reserved for BLE component. The main flash can not be
+* used: the rows below the metadata rows hold the checksum exclude section of
+* the Application and the rest is covered by the image checksums.
+*******************************************************************************/
+#define MDS_FIRST_ROW                   (1u)
+#define MDS_ROW_COUNT                   (3u)
+#define MDS_SFLASH_USER_BASE_ROW        (4u)    /* SFLASH row of the user row 0 */
+#define MDS_ROW_ADDR(row)               (CYDEV_SFLASH_BASE + \
+                                            (((uint32)(row) + MDS_SFLASH_USER_BASE_ROW) * CY_FLASH_SIZEOF_ROW))
+#define MDS_ROW_NONE                    (0xFFFFFFFFu)
+
+#define CY_FLASH_API_OPCODE_WRITE_SFLASH_ROW    (0x18u)
+
+#define MDS_MAGIC                       (0x3253444Du)   /* "MDS2" */
+
+/* Images known to the store, same as the bootloader application numbers */
+#define MDS_IMAGE_STACK                 (0u)
+#define MDS_IMAGE_APP                   (1u)
+#define MDS_IMAGE_COUNT                 (2u)
+
+/* Bootloader metadata of the image: checksum, address, last bootloader row
+* and length. These change with every image that is loaded.
+*/
+#define MDS_IMAGE_MD_SIZEOF             (64u)
+#define MDS_IMAGE_MD_ADDR(image)        (CYDEV_FLASH_BASE + (CYDEV_FLASH_SIZE - \
+                                            ((uint32)(image) * CY_FLASH_SIZEOF_ROW) - MDS_IMAGE_MD_SIZEOF))
+#define MDS_IMAGE_TAG_SIZE              (16u)
+
+/* Layout the bonding data of the image was stored with */
+typedef struct
+{
+    uint32 storageAddr;                 /* Address of cyBle_flashStorage */
+    uint16 keysSize;                    /* Size of the bonding keys of the stack */
+    uint8  cccdCount;                   /* Number of CCCD values per bonded device */
+    uint8  reserved;
+} MDS_BOND_LAYOUT_T;
+
+typedef struct
+{
+    uint32 magic;
+    uint32 sequence;                    /* Incremented by every commit */
+    uint16 imageTag[MDS_IMAGE_COUNT];   /* Tag of the image whose first start was handled */
+    MDS_BOND_LAYOUT_T bond[MDS_IMAGE_COUNT];
+    uint16 reserved;
+    uint16 crc;                         /* CRC-CCITT of the preceding fields */
+} MDS_RECORD_T;
+
+
+void     MDS_Init(void);
+uint32   MDS_IsImageUpdated(uint32 image);
+void     MDS_SetImageStarted(uint32 image);
+void     MDS_GetBondLayout(uint32 image, MDS_BOND_LAYOUT_T *layout);
+void     MDS_SetBondLayout(uint32 image, const MDS_BOND_LAYOUT_T *layout);
+cystatus MDS_Commit(void);
+
+#endif /* BLE_OTA_EP_MD_STORE_H_ */
+
+/* [] END OF FILE */
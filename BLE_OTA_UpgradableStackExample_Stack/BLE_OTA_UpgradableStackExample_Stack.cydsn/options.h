@@ -36,6 +36,12 @@
 #define DEBUG_UART_USE_PRINTF_FORMAT  (NO)
 #define PRINT_BOUNDING_DATA     (NO)
 
+/* YES - bonding keys are kept after the image update while the bonding data
+ * stays at the same address, only the CCCD values are cleared when their
+ * number changes. NO - all bonding data is cleared after every Stack update
+ * and after the Application update that changes the number of CCCD values. */
+#define BOND_MIGRATION          (YES)
+
 #endif /* BLE_OTA_EP_OPTIONS_H_ */
 
 /* [] END OF FILE */
@@ -48,17 +48,17 @@ void AfterImageUpdate()
         #endif
     #endif /* ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES)) */
     
-    if (0u == (uint32) CY_GET_XTND_REG8((volatile uint8 *)UPDATE_FLAG_OFFSET))
+    if (0u != MDS_IsImageUpdated(MDS_IMAGE_STACK))
     {
         DBG_PRINT_TEXT("Stack project was updated.");
         
         #if ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES))
-            /* Clean bounded device list. */
-            Clear_ROM_Array((uint8 *)&cyBle_flashStorage, sizeof(cyBle_flashStorage));
+            MigrateBondingData(MDS_IMAGE_STACK);
         #endif /* ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES)) */
             
-        /* Set byte in metadata row indicating that Stack project was started. */
-        Loader_SetFlashByte(UPDATE_FLAG_OFFSET, 1u);
+        /* Record in the metadata store that Stack project was started. */
+        MDS_SetImageStarted(MDS_IMAGE_STACK);
+        (void) MDS_Commit();
         
         DBG_PRINT_TEXT("\r\n");
         DBG_PRINT_TEXT("\r\n");
@@ -103,84 +103,6 @@ void AfterImageUpdate()
 }
 
 
-#if ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES))
-/*******************************************************************************
-* Function Name: Clear_ROM_Array
-********************************************************************************
-*
-* Summary:
-*   Clears specified area in ROM.
-*
-* Parameters:
-*   const uint8 eepromPtr[]:
-*        Pointer to ROM to be cleared
-*   uint32 byteCount:
-*        Size of area to be cleared in bytes
-*
-* Return:
-*   CYRET_UNKNOWN - On failure operation.
-*   CYRET_SUCCESS - Operation successfully completed.
-*
-*******************************************************************************/
-cystatus Clear_ROM_Array(const uint8 eepromPtr[], uint32 byteCount)
-{
-    uint8 writeBuffer[CY_FLASH_SIZEOF_ROW];
-    uint32 rowId;
-    uint32 dstIndex;
-    uint32 srcIndex;
-    cystatus rc;
-    uint32 dataOffset;
-    uint32 byteOffset;
-    
-    dataOffset = (uint32)eepromPtr;
-    
-    if (((uint32)eepromPtr + byteCount) < (CYDEV_FLASH_BASE+CYDEV_FLASH_SIZE))
-    {
-        rowId = (dataOffset / CY_FLASH_SIZEOF_ROW);
-        byteOffset = (CY_FLASH_SIZEOF_ROW * rowId);
-        srcIndex = 0u;
-
-        rc = CYRET_SUCCESS;
-
-        while ((srcIndex < byteCount) && (CYRET_SUCCESS == rc))
-        {
-            /* Fill only needed data with zeros. */
-            for (dstIndex = 0u; dstIndex < CY_FLASH_SIZEOF_ROW; dstIndex++)
-            {
-                if ((byteOffset >= dataOffset) && (srcIndex < byteCount))
-                {
-                    writeBuffer[dstIndex] = 0x00;
-                    srcIndex++;
-                }
-                else
-                {
-                    writeBuffer[dstIndex] = CY_GET_XTND_REG8(CYDEV_FLASH_BASE + byteOffset);
-                }
-                byteOffset++;
-            }
-
-            rc = CySysFlashWriteRow(rowId, writeBuffer);
-            
-            /* Go to the next row */
-            rowId++;
-        }
-    }
-    else
-    {
-        rc = CYRET_BAD_PARAM;
-    }
-    
-    /* Mask return codes from flash, if they are not supported */
-    if ((CYRET_SUCCESS != rc) && (CYRET_BAD_PARAM != rc))
-    {
-        rc = CYRET_UNKNOWN;
-    }
-    
-    return (rc);
-}
-#endif /* ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES)) */
-
-
 void TimeoutImplementation()
 {
     static uint16 counter = 1u;
@@ -0,0 +1,185 @@
+/*******************************************************************************
+* File Name: bonding.c
+*
+* Version: 1.20
+*
+* Description:
+*  Provides the handling of the bonding data on the first start of the updated
+*  Stack or Application image. The layout the bonding data was stored with is
+*  kept in the metadata store, so the image decides whether the stored bonds
+*  can be reused. The file is the same in the Stack and Application projects.
+*
+* Hardware Dependency:
+*  CY8CKIT-042 BLE
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include "bonding.h"
+#include "debug.h"
+
+
+#if ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES))
+/*******************************************************************************
+* Function Name: MigrateBondingData
+********************************************************************************
+*
+* Summary:
+*   Keeps the bonding data of the updated image if it can be reused and
+*   records its layout in the metadata store.
+*
+*   With BOND_MIGRATION == YES the bonding keys are kept while
+*   cyBle_flashStorage stays at the same address with the same keys size, and
+*   only the CCCD values are cleared when their number has changed. Otherwise
+*   all bonding data is cleared.
+*
+*   With BOND_MIGRATION == NO all bonding data is cleared after every Stack
+*   update, and after the Application update when the number of the CCCD
+*   values has changed.
+*
+* Parameters:
+*   uint32 image:
+*        MDS_IMAGE_STACK or MDS_IMAGE_APP
+*
+* Return:
+*   None
+*
+*******************************************************************************/
+void MigrateBondingData(uint32 image)
+{
+    MDS_BOND_LAYOUT_T stored;
+    MDS_BOND_LAYOUT_T current;
+    uint32 keepBonds;
+    
+    current.storageAddr = (uint32) &cyBle_flashStorage;
+    current.keysSize = (uint16) sizeof(cyBle_flashStorage.stackFlashptr);
+    current.cccdCount = (uint8) CYBLE_GATT_DB_CCCD_COUNT;
+    current.reserved = 0u;
+    
+    MDS_GetBondLayout(image, &stored);
+    
+#if (BOND_MIGRATION == YES)
+    keepBonds = ((stored.storageAddr == current.storageAddr) && (stored.keysSize == current.keysSize)) ? 1u : 0u;
+#else
+    keepBonds = ((MDS_IMAGE_APP == image) && (stored.cccdCount == current.cccdCount)) ? 1u : 0u;
+#endif /* (BOND_MIGRATION == YES) */
+    
+    if (0u != keepBonds)
+    {
+        if (stored.cccdCount == current.cccdCount)
+        {
+            DBG_PRINT_TEXT("Bonding data is kept.\r\n");
+        }
+        else
+        {
+            DBG_PRINT_TEXT("CCCD number has changed.\r\n");
+            DBG_PRINT_TEXT("Erasing CCCD values, bonding keys are kept...");
+            
+            (void) Clear_ROM_Array((const uint8 *)cyBle_flashStorage.attValuesCCCDFlashMemory, \
+                                                    sizeof(cyBle_flashStorage.attValuesCCCDFlashMemory));
+        }
+    }
+    else
+    {
+        DBG_PRINT_TEXT("Bonding data can not be reused.\r\n");
+        DBG_PRINT_TEXT("Erasing bounding data...");
+        
+        /* Clean bounded device list. */
+        (void) Clear_ROM_Array((const uint8 *)&cyBle_flashStorage, sizeof(cyBle_flashStorage));
+    }
+    
+    MDS_SetBondLayout(image, &current);
+}
+
+
+/*******************************************************************************
+* Function Name: Clear_ROM_Array
+********************************************************************************
+*
+* Summary:
+*   Clears specified area in ROM. Rows whose part of the area is already
+*   cleared are not programmed.
+*
+* Parameters:
+*   const uint8 eepromPtr[]:
+*        Pointer to ROM to be cleared
+*   uint32 byteCount:
+*        Size of area to be cleared in bytes
+*
+* Return:
+*   CYRET_UNKNOWN - On failure operation.
+*   CYRET_SUCCESS - Operation successfully completed.
+*
+*******************************************************************************/
+cystatus Clear_ROM_Array(const uint8 eepromPtr[], uint32 byteCount)
+{
+    uint8 writeBuffer[CY_FLASH_SIZEOF_ROW];
+    uint32 rowId;
+    uint32 dstIndex;
+    uint32 srcIndex;
+    cystatus rc;
+    uint32 dataOffset;
+    uint32 byteOffset;
+    uint32 rowChanged;
+    
+    dataOffset = (uint32)eepromPtr;
+    
+    if (((uint32)eepromPtr + byteCount) < (CYDEV_FLASH_BASE+CYDEV_FLASH_SIZE))
+    {
+        rowId = (dataOffset / CY_FLASH_SIZEOF_ROW);
+        byteOffset = (CY_FLASH_SIZEOF_ROW * rowId);
+        srcIndex = 0u;
+
+        rc = CYRET_SUCCESS;
+
+        while ((srcIndex < byteCount) && (CYRET_SUCCESS == rc))
+        {
+            rowChanged = 0u;
+            
+            /* Fill only needed data with zeros. */
+            for (dstIndex = 0u; dstIndex < CY_FLASH_SIZEOF_ROW; dstIndex++)
+            {
+                writeBuffer[dstIndex] = CY_GET_XTND_REG8(CYDEV_FLASH_BASE + byteOffset);
+                
+                if ((byteOffset >= dataOffset) && (srcIndex < byteCount))
+                {
+                    rowChanged |= writeBuffer[dstIndex];
+                    writeBuffer[dstIndex] = 0x00;
+                    srcIndex++;
+                }
+                byteOffset++;
+            }
+
+            /* Rows that are already cleared are not programmed again. */
+            if (0u != rowChanged)
+            {
+                rc = CySysFlashWriteRow(rowId, writeBuffer);
+            }
+            
+            /* Go to the next row */
+            rowId++;
+        }
+    }
+    else
+    {
+        rc = CYRET_BAD_PARAM;
+    }
+    
+    /* Mask return codes from flash, if they are not supported */
+    if ((CYRET_SUCCESS != rc) && (CYRET_BAD_PARAM != rc))
+    {
+        rc = CYRET_UNKNOWN;
+    }
+    
+    return (rc);
+}
+#endif /* ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES)) */
+
+/* [] END OF FILE */
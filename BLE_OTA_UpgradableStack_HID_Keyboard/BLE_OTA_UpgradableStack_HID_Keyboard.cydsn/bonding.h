@@ -0,0 +1,30 @@
+/*******************************************************************************
+* File Name: bonding.h
+* Version 1.20
+*
+* Description:
+*  Contains the function prototypes of the bonding data handling after the
+*  image update, shared by the Stack and Application projects.
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation.  All rights reserved.
+* You may use this file only in accordance with the license, terms, conditions,
+* disclaimers, and limitations in the end user license agreement accompanying
+* the software package with which this file was provided.
+*******************************************************************************/
+
+#ifndef BLE_OTA_EP_BONDING_H_
+#define BLE_OTA_EP_BONDING_H_
+
+#include <project.h>
+#include "options.h"
+#include "md_store.h"
+
+#if ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES))
+    void MigrateBondingData(uint32 image);
+    cystatus Clear_ROM_Array(const uint8 eepromPtr[], uint32 byteCount);
+#endif /* ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES)) */
+
+#endif /* BLE_OTA_EP_BONDING_H_ */
+
+/* [] END OF FILE */
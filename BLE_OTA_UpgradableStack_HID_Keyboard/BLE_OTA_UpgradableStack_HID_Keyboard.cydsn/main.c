@@ -75,6 +75,9 @@ int main()
 
     PrintProjectHeader();
 
+    /* Caches the latest record of the metadata store */
+    MDS_Init();
+
     /* Checks if Self Project Image is updated and Runs for the First time */
     AfterImageUpdate();
     
@@ -0,0 +1,471 @@
+/*******************************************************************************
+* File Name: md_store.c
+*
+* Version: 1.20
+*
+* Description:
+*  Provides the metadata store that keeps the update state of the Stack and
+*  Application images. Each commit appends the record with the next sequence
+*  number to the next user SFLASH row of the journal ring. The record is
+*  protected by CRC, so the row interrupted by the power loss is ignored and
+*  the previous record stays valid. The latest record is cached in RAM by
+*  MDS_Init().
+*
+* Hardware Dependency:
+*  CY8CKIT-042 BLE
+*
+********************************************************************************
+* Copyright 2014-2016, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "md_store.h"
+
+#define MDS_RECORD_CRC_SIZE             ((uint32) offsetof(MDS_RECORD_T, crc))
+#define MDS_CRC_INIT                    (0xFFFFu)
+#define MDS_CRC_POLY                    (0x8408u)   /* CRC-CCITT, reflected */
+
+/* Latest record with the changes that are not committed yet */
+static MDS_RECORD_T mdsRecord;
+static uint32 mdsRow = MDS_ROW_NONE;
+static uint32 mdsDirty = 0u;
+
+#if (CY_IP_SPCIF_SYNCHRONOUS)
+    static CY_SYS_FLASH_CLOCK_BACKUP_STRUCT mdsFlashBackup;
+#endif /* (CY_IP_SPCIF_SYNCHRONOUS) */
+
+static uint16 MDS_Crc(const uint8 data[], uint32 size);
+static uint16 MDS_GetImageTag(uint32 image);
+static uint32 MDS_WriteUserSFlashRow(uint32 rowNum, const uint32 rowData[]);
+static cystatus MDS_FlashClockBackup(void);
+static cystatus MDS_FlashClockConfig(void);
+static cystatus MDS_FlashClockRestore(void);
+
+
+/*******************************************************************************
+* Function Name: MDS_Init
+********************************************************************************
+*
+* Summary:
+*  Scans the journal rows and caches the valid record with the highest
+*  sequence number. When no valid record is found, the store starts empty and
+*  every image is reported as updated.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void MDS_Init(void)
+{
+    const MDS_RECORD_T *record;
+    uint32 row;
+
+    (void) memset(&mdsRecord, 0, sizeof(mdsRecord));
+    mdsRow = MDS_ROW_NONE;
+    mdsDirty = 0u;
+
+    for (row = 0u; row < MDS_ROW_COUNT; row++)
+    {
+        record = (const MDS_RECORD_T *) MDS_ROW_ADDR(MDS_FIRST_ROW + row);
+
+        if ((MDS_MAGIC == record->magic) &&
+            (record->crc == MDS_Crc((const uint8 *) record, MDS_RECORD_CRC_SIZE)) &&
+            ((MDS_ROW_NONE == mdsRow) || (0 < (int32) (record->sequence - mdsRecord.sequence))))
+        {
+            (void) memcpy(&mdsRecord, record, sizeof(mdsRecord));
+            mdsRow = row;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: MDS_IsImageUpdated
+********************************************************************************
+*
+* Summary:
+*  Checks whether the image was loaded after its first start was recorded by
+*  MDS_SetImageStarted().
+*
+* Parameters:
+*  uint32 image: MDS_IMAGE_STACK or MDS_IMAGE_APP.
+*
+* Return:
+*  Non-zero if the image has not been started since it was loaded.
+*
+*******************************************************************************/
+uint32 MDS_IsImageUpdated(uint32 image)
+{
+    return ((uint32) (mdsRecord.imageTag[image] != MDS_GetImageTag(image)));
+}
+
+
+/*******************************************************************************
+* Function Name: MDS_SetImageStarted
+********************************************************************************
+*
+* Summary:
+*  Records that the first start of the image currently in flash was handled.
+*  The change is kept in RAM until MDS_Commit() is called.
+*
+* Parameters:
+*  uint32 image: MDS_IMAGE_STACK or MDS_IMAGE_APP.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void MDS_SetImageStarted(uint32 image)
+{
+    uint16 tag = MDS_GetImageTag(image);
+
+    if (mdsRecord.imageTag[image] != tag)
+    {
+        mdsRecord.imageTag[image] = tag;
+        mdsDirty = 1u;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: MDS_GetBondLayout
+********************************************************************************
+*
+* Summary:
+*  Returns the layout the bonding data of the image was stored with. All
+*  fields are 0 if the layout was never recorded.
+*
+* Parameters:
+*  uint32 image:              MDS_IMAGE_STACK or MDS_IMAGE_APP.
+*  MDS_BOND_LAYOUT_T *layout: Receives the layout.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void MDS_GetBondLayout(uint32 image, MDS_BOND_LAYOUT_T *layout)
+{
+    (void) memcpy(layout, &mdsRecord.bond[image], sizeof(MDS_BOND_LAYOUT_T));
+}
+
+
+/*******************************************************************************
+* Function Name: MDS_SetBondLayout
+********************************************************************************
+*
+* Summary:
+*  Sets the layout the bonding data of the image is stored with. The change is
+*  kept in RAM until MDS_Commit() is called.
+*
+* Parameters:
+*  uint32 image:                    MDS_IMAGE_STACK or MDS_IMAGE_APP.
+*  const MDS_BOND_LAYOUT_T *layout: The layout.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void MDS_SetBondLayout(uint32 image, const MDS_BOND_LAYOUT_T *layout)
+{
+    if (0 != memcmp(&mdsRecord.bond[image], layout, sizeof(MDS_BOND_LAYOUT_T)))
+    {
+        (void) memcpy(&mdsRecord.bond[image], layout, sizeof(MDS_BOND_LAYOUT_T));
+        mdsDirty = 1u;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: MDS_Commit
+********************************************************************************
+*
+* Summary:
+*  Programs the changed record to the journal row that follows the row of the
+*  latest record. Nothing is programmed when the record is unchanged.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  CYRET_SUCCESS - Record is committed or unchanged.
+*  Other         - The same as CySysFlashWriteRow().
+*
+*******************************************************************************/
+cystatus MDS_Commit(void)
+{
+    uint32 writeBuffer[CY_FLASH_SIZEOF_ROW / sizeof(uint32)];
+    uint32 row;
+    cystatus rc = CYRET_SUCCESS;
+
+    if (0u != mdsDirty)
+    {
+        row = (MDS_ROW_NONE == mdsRow) ? 0u : ((mdsRow + 1u) % MDS_ROW_COUNT);
+
+        mdsRecord.magic = MDS_MAGIC;
+        mdsRecord.sequence++;
+        mdsRecord.crc = MDS_Crc((const uint8 *) &mdsRecord, MDS_RECORD_CRC_SIZE);
+
+        (void) memset(writeBuffer, 0, sizeof(writeBuffer));
+        (void) memcpy(writeBuffer, &mdsRecord, sizeof(mdsRecord));
+
+        rc = (cystatus) MDS_WriteUserSFlashRow(MDS_FIRST_ROW + row, writeBuffer);
+
+        if (CYRET_SUCCESS == rc)
+        {
+            mdsRow = row;
+            mdsDirty = 0u;
+        }
+    }
+
+    return (rc);
+}
+
+
+/*******************************************************************************
+* Function Name: MDS_Crc
+********************************************************************************
+*
+* Summary:
+*  Calculates the CRC-CCITT of the data.
+*
+* Parameters:
+*  const uint8 data[]: The data.
+*  uint32 size:        Size of the data.
+*
+* Return:
+*  The CRC.
+*
+*******************************************************************************/
+static uint16 MDS_Crc(const uint8 data[], uint32 size)
+{
+    uint32 crc = MDS_CRC_INIT;
+    uint32 i;
+    uint32 bit;
+
+    for (i = 0u; i < size; i++)
+    {
+        crc ^= data[i];
+        for (bit = 0u; bit < 8u; bit++)
+        {
+            crc = (0u != (crc & 1u)) ? ((crc >> 1u) ^ MDS_CRC_POLY) : (crc >> 1u);
+        }
+    }
+
+    return ((uint16) crc);
+}
+
+
+/*******************************************************************************
+* Function Name: MDS_GetImageTag
+********************************************************************************
+*
+* Summary:
+*  Returns the tag that identifies the image currently in flash. The tag is
+*  the CRC of the leading bootloader metadata fields of the image, the active
+*  and verified flags are not included.
+*
+* Parameters:
+*  uint32 image: MDS_IMAGE_STACK or MDS_IMAGE_APP.
+*
+* Return:
+*  The image tag.
+*
+*******************************************************************************/
+static uint16 MDS_GetImageTag(uint32 image)
+{
+    return (MDS_Crc((const uint8 *) MDS_IMAGE_MD_ADDR(image), MDS_IMAGE_TAG_SIZE));
+}
+
+
+/* Function created based on CyFlash.c ver. 4.20
+*  Modified: command in MDS_WriteUserSFlashRow to work with SFlash, removed
+*  unused defines.
+*/
+/*******************************************************************************
+* Function Name: MDS_WriteUserSFlashRow
+********************************************************************************
+*
+* Summary:
+*  Writes the user SFLASH row.
+*
+* Parameters:
+*  uint32 rowNum:          Number of the user SFLASH row.
+*  const uint32 rowData[]: Data of the row.
+*
+* Return:
+*  The same as CySysFlashWriteRow().
+*
+*******************************************************************************/
+static uint32 MDS_WriteUserSFlashRow(uint32 rowNum, const uint32 rowData[])
+{
+    volatile uint32 retValue = CY_SYS_FLASH_SUCCESS;
+    volatile uint32 clkCnfRetValue = CY_SYS_FLASH_SUCCESS;
+    volatile uint32 parameters[(CY_FLASH_SIZEOF_ROW + CY_FLASH_SRAM_ROM_DATA) / 4u];
+    uint8 interruptState;
+
+    if (rowNum < (MDS_FIRST_ROW + MDS_ROW_COUNT))
+    {
+        /* Load Flash Bytes */
+        parameters[0u] = (uint32) (CY_FLASH_GET_MACRO_FROM_ROW(rowNum)        << CY_FLASH_PARAM_MACRO_SEL_OFFSET) |
+                         (uint32) (CY_FLASH_PAGE_LATCH_START_ADDR             << CY_FLASH_PARAM_ADDR_OFFSET     ) |
+                         (uint32) (CY_FLASH_KEY_TWO(CY_FLASH_API_OPCODE_LOAD) << CY_FLASH_PARAM_KEY_TWO_OFFSET  ) |
+                         CY_FLASH_KEY_ONE;
+        parameters[1u] = CY_FLASH_SIZEOF_ROW - 1u;
+
+        (void) memcpy((void *) &parameters[2u], rowData, CY_FLASH_SIZEOF_ROW);
+        CY_FLASH_CPUSS_SYSARG_REG = (uint32) &parameters[0u];
+        CY_FLASH_CPUSS_SYSREQ_REG = CY_FLASH_CPUSS_REQ_START | CY_FLASH_API_OPCODE_LOAD;
+        retValue = CY_FLASH_API_RETURN;
+
+        if (retValue == CY_SYS_FLASH_SUCCESS)
+        {
+            /* Mask all the exceptions to guarantee that the row is written in
+            * the atomic way.
+            */
+            interruptState = CyEnterCriticalSection();
+
+            clkCnfRetValue = MDS_FlashClockBackup();
+
+            if (clkCnfRetValue == CY_SYS_FLASH_SUCCESS)
+            {
+                retValue = MDS_FlashClockConfig();
+            }
+
+            if (retValue == CY_SYS_FLASH_SUCCESS)
+            {
+                /* Write User SFlash Row */
+                parameters[0u] = (uint32) (((uint32) CY_FLASH_KEY_TWO(CY_FLASH_API_OPCODE_WRITE_SFLASH_ROW) <<
+                                            CY_FLASH_PARAM_KEY_TWO_OFFSET) | CY_FLASH_KEY_ONE);
+                parameters[1u] = (uint32) rowNum;
+
+                CY_FLASH_CPUSS_SYSARG_REG = (uint32) &parameters[0u];
+                CY_FLASH_CPUSS_SYSREQ_REG = CY_FLASH_CPUSS_REQ_START | CY_FLASH_API_OPCODE_WRITE_SFLASH_ROW;
+                retValue = CY_FLASH_API_RETURN;
+            }
+
+            if (clkCnfRetValue == CY_SYS_FLASH_SUCCESS)
+            {
+                clkCnfRetValue = MDS_FlashClockRestore();
+            }
+            CyExitCriticalSection(interruptState);
+        }
+    }
+    else
+    {
+        retValue = CY_SYS_FLASH_INVALID_ADDR;
+    }
+
+    return (retValue);
+}
+
+
+/*******************************************************************************
+* Function Name: MDS_FlashClockBackup
+********************************************************************************
+*
+* Summary:
+*  Backups the device clock configuration.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The same as CySysFlashWriteRow().
+*
+*******************************************************************************/
+static cystatus MDS_FlashClockBackup(void)
+{
+    cystatus retValue = CY_SYS_FLASH_SUCCESS;
+
+    #if (CY_IP_SPCIF_SYNCHRONOUS)
+        volatile uint32 parameters[2u];
+
+        parameters[0u] =
+                (uint32) ((CY_FLASH_KEY_TWO(CY_FLASH_API_OPCODE_CLK_BACKUP) <<  CY_FLASH_PARAM_KEY_TWO_OFFSET) |
+                        CY_FLASH_KEY_ONE);
+        parameters[1u] = (uint32) &mdsFlashBackup.clockSettings[0u];
+
+        CY_FLASH_CPUSS_SYSARG_REG = (uint32) &parameters[0u];
+        CY_FLASH_CPUSS_SYSREQ_REG = CY_FLASH_CPUSS_REQ_START | CY_FLASH_API_OPCODE_CLK_BACKUP;
+        retValue = CY_FLASH_API_RETURN;
+    #endif /* (CY_IP_SPCIF_SYNCHRONOUS) */
+
+    return (retValue);
+}
+
+
+/*******************************************************************************
+* Function Name: MDS_FlashClockConfig
+********************************************************************************
+*
+* Summary:
+*  Configures the device clocks for the flash writing.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The same as CySysFlashWriteRow().
+*
+*******************************************************************************/
+static cystatus MDS_FlashClockConfig(void)
+{
+    cystatus retValue;
+
+    /* FM-Lite Clock Configuration */
+    CY_FLASH_CPUSS_SYSARG_REG =
+        (uint32) ((CY_FLASH_KEY_TWO(CY_FLASH_API_OPCODE_CLK_CONFIG) <<  CY_FLASH_PARAM_KEY_TWO_OFFSET) |
+                    CY_FLASH_KEY_ONE);
+    CY_FLASH_CPUSS_SYSREQ_REG = CY_FLASH_CPUSS_REQ_START | CY_FLASH_API_OPCODE_CLK_CONFIG;
+    retValue = CY_FLASH_API_RETURN;
+
+    return (retValue);
+}
+
+
+/*******************************************************************************
+* Function Name: MDS_FlashClockRestore
+********************************************************************************
+*
+* Summary:
+*  Restores the device clock configuration.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The same as CySysFlashWriteRow().
+*
+*******************************************************************************/
+static cystatus MDS_FlashClockRestore(void)
+{
+    cystatus retValue = CY_SYS_FLASH_SUCCESS;
+
+    #if (CY_IP_SPCIF_SYNCHRONOUS)
+        volatile uint32 parameters[2u];
+
+        /* FM-Lite Clock Restore */
+        parameters[0u] =
+            (uint32) ((CY_FLASH_KEY_TWO(CY_FLASH_API_OPCODE_CLK_RESTORE) <<  CY_FLASH_PARAM_KEY_TWO_OFFSET) |
+                        CY_FLASH_KEY_ONE);
+        parameters[1u] = (uint32) &mdsFlashBackup.clockSettings[0u];
+        CY_FLASH_CPUSS_SYSARG_REG = (uint32) &parameters[0u];
+        CY_FLASH_CPUSS_SYSREQ_REG = CY_FLASH_CPUSS_REQ_START | CY_FLASH_API_OPCODE_CLK_RESTORE;
+        retValue = CY_FLASH_API_RETURN;
+    #endif /* (CY_IP_SPCIF_SYNCHRONOUS) */
+
+    return (retValue);
+}
+
+
+/* [] END OF FILE */
@@ -174,39 +174,172 @@ void InitializeBootloaderSRAM()
 
 
 /*******************************************************************************
-* Function Name: Bootloadable_WriteFlashByte
+* Function Name: Bootloadable_BatchStart
 ********************************************************************************
 *
 * Summary:
-*   This API writes to flash the specified data.
+*   Starts the batch of the flash byte updates. The updates are collected in
+*   RAM copies of their rows until Bootloadable_BatchCommit() is called, so
+*   several updates of the same row cost a single row program.
 *
 * Parameters:
+*    batchRow   - The Bootloadable_BATCH_ROWS rows of the batch.
+*
+* Return:
+*   None
+*
+*******************************************************************************/
+void Bootloadable_BatchStart(Bootloadable_BATCH_ROW_T batchRow[])
+{
+    uint32 slot;
+
+    for (slot = 0u; slot < Bootloadable_BATCH_ROWS; slot++)
+    {
+        batchRow[slot].rowNum = Bootloadable_BATCH_ROW_NONE;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Bootloadable_BatchWriteByte
+********************************************************************************
+*
+* Summary:
+*   Adds the byte update to the batch. The row is read from flash the first
+*   time it is updated in the batch. If the batch already holds
+*   Bootloadable_BATCH_ROWS other rows, they are programmed first.
+*
+* Parameters:
+*    batchRow   - The rows of the batch.
 *    address    - The address in flash.
 *    inputValue - One-byte data.
 *
 * Return:
-*   A status of the writing to flash procedure.
+*   A status of the writing to flash procedure, CYRET_SUCCESS if no row had to
+*   be programmed.
 *
 *******************************************************************************/
-cystatus Bootloadable_WriteFlashByte(const uint32 address, const uint8 inputValue)
+cystatus Bootloadable_BatchWriteByte(Bootloadable_BATCH_ROW_T batchRow[], const uint32 address,
+                                     const uint8 inputValue)
 {
     cystatus result = CYRET_SUCCESS;
-    uint32 flsAddr = address - CYDEV_FLASH_BASE;
-    uint8  rowData[CYDEV_FLS_ROW_SIZE];
+    uint32 rowNum = (address - CYDEV_FLASH_BASE) / CYDEV_FLS_ROW_SIZE;
+    uint32 baseAddr = address - (address % CYDEV_FLS_ROW_SIZE);
+    Bootloadable_BATCH_ROW_T *row = NULL;
+    uint32 slot;
+    uint32 idx;
+
+    for (slot = 0u; (slot < Bootloadable_BATCH_ROWS) && (NULL == row); slot++)
+    {
+        if (rowNum == batchRow[slot].rowNum)
+        {
+            row = &batchRow[slot];
+        }
+    }
 
-    uint16 rowNum = ( uint16 )(flsAddr / CYDEV_FLS_ROW_SIZE);
+    if (NULL == row)
+    {
+        for (slot = 0u; (slot < Bootloadable_BATCH_ROWS) && (NULL == row); slot++)
+        {
+            if (Bootloadable_BATCH_ROW_NONE == batchRow[slot].rowNum)
+            {
+                row = &batchRow[slot];
+            }
+        }
 
-    uint32 baseAddr = address - (address % CYDEV_FLS_ROW_SIZE);
-    uint16 idx;
+        if (NULL == row)
+        {
+            /* All rows are taken: program them and reuse the first one */
+            result = Bootloadable_BatchCommit(batchRow);
+            row = &batchRow[0u];
+        }
 
-    for(idx = 0u; idx < CYDEV_FLS_ROW_SIZE; idx++)
+        row->rowNum = rowNum;
+        for (idx = 0u; idx < CYDEV_FLS_ROW_SIZE; idx++)
+        {
+            row->rowData[idx] = (uint8)Bootloadable_GET_CODE_DATA(baseAddr + idx);
+        }
+    }
+
+    row->rowData[address % CYDEV_FLS_ROW_SIZE] = inputValue;
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: Bootloadable_BatchCommit
+********************************************************************************
+*
+* Summary:
+*   Programs every row of the batch once and ends the batch. The rows whose
+*   content has not changed are not programmed.
+*
+* Parameters:
+*    batchRow   - The rows of the batch.
+*
+* Return:
+*   A status of the writing to flash procedure.
+*
+*******************************************************************************/
+cystatus Bootloadable_BatchCommit(Bootloadable_BATCH_ROW_T batchRow[])
+{
+    cystatus result = CYRET_SUCCESS;
+    uint32 baseAddr;
+    uint32 slot;
+    uint32 idx;
+
+    for (slot = 0u; slot < Bootloadable_BATCH_ROWS; slot++)
     {
-        rowData[idx] = (uint8)Bootloadable_GET_CODE_DATA(baseAddr + idx);
+        if (Bootloadable_BATCH_ROW_NONE != batchRow[slot].rowNum)
+        {
+            baseAddr = CYDEV_FLASH_BASE + (batchRow[slot].rowNum * CYDEV_FLS_ROW_SIZE);
+
+            for (idx = 0u; idx < CYDEV_FLS_ROW_SIZE; idx++)
+            {
+                if (batchRow[slot].rowData[idx] != (uint8)Bootloadable_GET_CODE_DATA(baseAddr + idx))
+                {
+                    break;
+                }
+            }
+
+            if (idx < CYDEV_FLS_ROW_SIZE)
+            {
+                result |= CySysFlashWriteRow(batchRow[slot].rowNum, batchRow[slot].rowData);
+            }
+
+            batchRow[slot].rowNum = Bootloadable_BATCH_ROW_NONE;
+        }
     }
 
-    rowData[address % CYDEV_FLS_ROW_SIZE] = inputValue;
+    return (result);
+}
 
-    result = CySysFlashWriteRow((uint32) rowNum, rowData);
+
+/*******************************************************************************
+* Function Name: Bootloadable_WriteFlashByte
+********************************************************************************
+*
+* Summary:
+*   This API writes to flash the specified data. The row is not programmed if
+*   it already holds the value.
+*
+* Parameters:
+*    address    - The address in flash.
+*    inputValue - One-byte data.
+*
+* Return:
+*   A status of the writing to flash procedure.
+*
+*******************************************************************************/
+cystatus Bootloadable_WriteFlashByte(const uint32 address, const uint8 inputValue)
+{
+    cystatus result;
+    Bootloadable_BATCH_ROW_T batchRow[Bootloadable_BATCH_ROWS];
+
+    Bootloadable_BatchStart(batchRow);
+    result  = Bootloadable_BatchWriteByte(batchRow, address, inputValue);
+    result |= Bootloadable_BatchCommit(batchRow);
 
     return (result);
 }
@@ -249,6 +382,7 @@ cystatus Bootloadable_WriteFlashByte(const uint32 address, const uint8 inputValu
 cystatus Bootloadable_SetActiveApplication(uint8 appId)
 {
     cystatus result = CYRET_SUCCESS;
+    Bootloadable_BATCH_ROW_T batchRow[Bootloadable_BATCH_ROWS];
 
     uint8 CYDATA idx;
     
@@ -266,12 +400,14 @@ cystatus Bootloadable_SetActiveApplication(uint8 appId)
         }
         else
         {
-            /* Updating metadata section */
+            /* Updating metadata section, each metadata row is programmed once */
+            Bootloadable_BatchStart(batchRow);
             for(idx = 0u; idx < Bootloadable_MAX_NUM_OF_BTLDB; idx++)
             {
-                result |= Bootloadable_WriteFlashByte((uint32) Bootloadable_MD_BTLDB_ACTIVE_OFFSET(idx), \
+                result |= Bootloadable_BatchWriteByte(batchRow, (uint32) Bootloadable_MD_BTLDB_ACTIVE_OFFSET(idx), \
                                                                                             (uint8)(idx == appId));
             }
+            result |= Bootloadable_BatchCommit(batchRow);
         }
     }
     
@@ -299,38 +435,23 @@ cystatus Bootloadable_SetActiveApplication(uint8 appId)
 void AfterImageUpdate(void)
 {
     #if ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES))
-        CYBLE_GAP_BONDED_DEV_ADDR_LIST_T bondedDevList;
-    
         #if (PRINT_BOUNDING_DATA == YES)
             uint32 i;
             uint32 j;
         #endif
     #endif /* ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES)) */
         
-    if (0u == (uint32) CY_GET_XTND_REG8((volatile uint8 *)UPDATE_FLAG_OFFSET))
+    if (0u != MDS_IsImageUpdated(MDS_IMAGE_APP))
     {
         DBG_PRINT_TEXT("Application project was updated. ");
         
         #if ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES))
-            if (CYBLE_GATT_DB_CCCD_COUNT == (uint32) CY_GET_XTND_REG8((volatile uint8 *)STACK_UPDATE_FLAG_OFFSET))
-            {
-                DBG_PRINT_TEXT("CCCD number has not changed.\r\n");
-            }
-            else
-            {
-                DBG_PRINT_TEXT("CCCD number has changed.\r\n");
-                DBG_PRINT_TEXT("Erasing bounding data...");
-                
-                CyBle_GapGetBondedDevicesList(&bondedDevList);
-                
-                /* Clean bounded device list. */
-                Clear_ROM_Array((uint8 *)&cyBle_flashStorage, sizeof(cyBle_flashStorage));
-                
-                Bootloadable_SetFlashByte(STACK_UPDATE_FLAG_OFFSET, CYBLE_GATT_DB_CCCD_COUNT);
-            }
+            MigrateBondingData(MDS_IMAGE_APP);
         #endif /* ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES)) */
         
-        Bootloadable_SetFlashByte(UPDATE_FLAG_OFFSET, 1u);
+        /* Image tag and bonding layout are committed in one metadata store record */
+        MDS_SetImageStarted(MDS_IMAGE_APP);
+        (void) MDS_Commit();
         
         DBG_PRINT_TEXT("\r\n");
         DBG_PRINT_TEXT("\r\n");
@@ -374,81 +495,4 @@ void AfterImageUpdate(void)
     #endif /* ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES)) */
 }
 
-#if ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES))
-/*******************************************************************************
-* Function Name: Clear_ROM_Array
-********************************************************************************
-*
-* Summary:
-*   Clears specified area in ROM.
-*
-* Parameters:
-*   const uint8 eepromPtr[]:
-*        Pointer to ROM to be cleared
-*   uint32 byteCount:
-*        Size of area to be cleared in bytes
-*
-* Return:
-*   CYRET_UNKNOWN - On failure operation.
-*   CYRET_SUCCESS - Operation successfully completed.
-*
-*******************************************************************************/
-cystatus Clear_ROM_Array(const uint8 eepromPtr[], uint32 byteCount)
-{
-    uint8 writeBuffer[CY_FLASH_SIZEOF_ROW];
-    uint32 rowId;
-    uint32 dstIndex;
-    uint32 srcIndex;
-    cystatus rc;
-    uint32 dataOffset;
-    uint32 byteOffset;
-    
-    dataOffset = (uint32)eepromPtr;
-    
-    if (((uint32)eepromPtr + byteCount) < (CYDEV_FLASH_BASE+CYDEV_FLASH_SIZE))
-    {
-        rowId = (dataOffset / CY_FLASH_SIZEOF_ROW);
-        byteOffset = (CY_FLASH_SIZEOF_ROW * rowId);
-        srcIndex = 0u;
-
-        rc = CYRET_SUCCESS;
-
-        while ((srcIndex < byteCount) && (CYRET_SUCCESS == rc))
-        {
-            /* Fill only needed data with zeros. */
-            for (dstIndex = 0u; dstIndex < CY_FLASH_SIZEOF_ROW; dstIndex++)
-            {
-                if ((byteOffset >= dataOffset) && (srcIndex < byteCount))
-                {
-                    writeBuffer[dstIndex] = 0x00;
-                    srcIndex++;
-                }
-                else
-                {
-                    writeBuffer[dstIndex] = CY_GET_XTND_REG8(CYDEV_FLASH_BASE + byteOffset);
-                }
-                byteOffset++;
-            }
-
-            rc = CySysFlashWriteRow(rowId, writeBuffer);
-            
-            /* Go to the next row */
-            rowId++;
-        }
-    }
-    else
-    {
-        rc = CYRET_BAD_PARAM;
-    }
-    
-    /* Mask return codes from flash, if they are not supported */
-    if ((CYRET_SUCCESS != rc) && (CYRET_BAD_PARAM != rc))
-    {
-        rc = CYRET_UNKNOWN;
-    }
-    
-    return (rc);
-}
-#endif /* ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES)) */
-
 /* [] END OF FILE */
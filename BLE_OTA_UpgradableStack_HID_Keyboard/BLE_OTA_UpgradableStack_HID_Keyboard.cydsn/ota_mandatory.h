@@ -19,20 +19,12 @@
 #include <cytypes.h>
 #include <project.h>
 #include "debug.h"
+#include "md_store.h"
+#include "bonding.h"
 
 
 #define Loader_MD_SIZEOF                (64u)
 #define LENGHT_OF_UART_ROW              (20u)
-#define APP_FLAG_OFFSET                 (20u)
-
-#define APP_PRJ_MD_BASE_ADDR            (CYDEV_FLASH_BASE + \
-                                            (CYDEV_FLASH_SIZE - ((uint32)CYDEV_FLS_ROW_SIZE * 2u)))
-
-#define STACK_MD_BASE_ADDR              (CYDEV_FLASH_BASE + \
-                                            (CYDEV_FLASH_SIZE - ((uint32)CYDEV_FLS_ROW_SIZE)))
-
-#define STACK_UPDATE_FLAG_OFFSET        (STACK_MD_BASE_ADDR + APP_FLAG_OFFSET)
-#define UPDATE_FLAG_OFFSET              (APP_PRJ_MD_BASE_ADDR + APP_FLAG_OFFSET)
 
 #define LED_ON                          (0u)
 #define LED_OFF                         (1u)
@@ -42,15 +34,28 @@
 #define Bootloadable_MD_BASE_ADDR(appId)    (CYDEV_FLASH_BASE + (CYDEV_FLASH_SIZE - ((uint32)(appId) * CYDEV_FLS_ROW_SIZE) - \
                                                                         Bootloadable_MD_SIZEOF))
 #define Bootloadable_MD_BTLDB_ACTIVE_OFFSET(appId) (Bootloadable_MD_BASE_ADDR(appId) + 16u)
+
+/* Rows updated in one batch: the metadata rows of both applications. The
+* caller keeps the batch on its stack for the time of the update.
+*/
+#define Bootloadable_BATCH_ROWS             (2u)
+#define Bootloadable_BATCH_ROW_NONE         (0xFFFFFFFFu)
+
+typedef struct
+{
+    uint32 rowNum;                          /* Flash row or Bootloadable_BATCH_ROW_NONE */
+    uint8  rowData[CYDEV_FLS_ROW_SIZE];
+} Bootloadable_BATCH_ROW_T;
                                                                         
 
+void     Bootloadable_BatchStart(Bootloadable_BATCH_ROW_T batchRow[]);
+cystatus Bootloadable_BatchWriteByte(Bootloadable_BATCH_ROW_T batchRow[], const uint32 address,
+                                     const uint8 inputValue);
+cystatus Bootloadable_BatchCommit(Bootloadable_BATCH_ROW_T batchRow[]);
 cystatus Bootloadable_WriteFlashByte(const uint32 address, const uint8 inputValue);
 cystatus Bootloadable_SetActiveApplication(uint8 appId);
 
 void AfterImageUpdate(void);
-#if ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES))
-    cystatus Clear_ROM_Array(const uint8 eepromPtr[], uint32 byteCount);
-#endif /* ((CYBLE_GAP_ROLE_PERIPHERAL || CYBLE_GAP_ROLE_CENTRAL) && (CYBLE_BONDING_REQUIREMENT == CYBLE_BONDING_YES)) */
 
 #endif /* BLE_OTA_EP_OTA_MANDATORY_H_ */
 